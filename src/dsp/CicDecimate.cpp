@@ -0,0 +1,176 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "CicDecimate.h"
+
+#include "CmsisTypeFactory.h"
+#include "FirSource.h"
+#include "Instrument.h"
+#include "Ex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+  // Convert the 32 bit comb output to the output type.
+  template <typename T> T narrow(int32_t x, unsigned int shift);
+
+  template <> q31_t narrow<q31_t>(int32_t x, unsigned int shift) {
+    return x >> shift;
+  }
+
+  template <> q15_t narrow<q15_t>(int32_t x, unsigned int shift) {
+    return (q15_t)__SSAT(x >> shift, 16);
+  }
+
+  // The integrators and combs are uint32_t, unsigned arithmetic wraps
+  // around (signed overflow is undefined behaviour).
+  template <typename T> class CicDecimateStream : public DecimateStream<T> {
+
+    const std::string name;
+
+    const unsigned int order;
+
+    const unsigned int R;
+
+    // input and output shifts
+    const unsigned int preShift;
+    const unsigned int postShift;
+
+    std::vector<uint32_t> integrators;
+
+    // the combs' delayed samples
+    std::vector<uint32_t> combs;
+
+    // input samples since the last output
+    unsigned int count = 0;
+
+  public:
+
+    CicDecimateStream(const std::string& name, unsigned int order, unsigned int R, unsigned int preShift, unsigned int postShift)
+      : name(name),
+	order(order),
+	R(R),
+	preShift(preShift),
+	postShift(postShift),
+	integrators(order),
+	combs(order)
+    {}
+
+    virtual ~CicDecimateStream() {}
+
+    virtual const std::string& getName() const {
+      return name;
+    }
+
+    virtual unsigned int getM() const {
+      return R;
+    }
+
+    virtual unsigned int getOutputSize(unsigned int numSamples) const {
+      return (count + numSamples) / R;
+    }
+
+    virtual unsigned int process(const T* in, unsigned int numSamples, T* out) {
+      unsigned int outCount = 0;
+      uint32_t* integ = integrators.data();
+      uint32_t* comb = combs.data();
+
+      instrument::recordInput("cic", name, in, numSamples);
+
+      for (unsigned int n = 0; n < numSamples; n++) {
+	uint32_t v = (uint32_t)((int32_t)in[n] >> preShift);
+	for (unsigned int s = 0; s < order; s++) {
+	  integ[s] += v;
+	  v = integ[s];
+	}
+
+	if (++count == R) {
+	  count = 0;
+	  for (unsigned int s = 0; s < order; s++) {
+	    uint32_t delayed = comb[s];
+	    comb[s] = v;
+	    v -= delayed;
+	  }
+	  out[outCount++] = narrow<T>((int32_t)v, postShift);
+	}
+      }
+
+      instrument::recordOutput("cic", name, out, outCount);
+      return outCount;
+    }
+
+    virtual void reset() {
+      std::fill(integrators.begin(), integrators.end(), 0);
+      std::fill(combs.begin(), combs.end(), 0);
+      count = 0;
+    }
+  };
+
+  void checkCicParams(unsigned int order, unsigned int R) {
+    if (order == 0 || R == 0) {
+      throw Ex("invalid CIC order or rate");
+    }
+  }
+
+  template <typename T, typename F> std::unique_ptr<DecimateStream<T>> createCompensated(const std::string& name, std::unique_ptr<DecimateStream<T>> cic, const std::vector<double>& compensator, unsigned int maxBlockSize, std::vector<DecimateStageCost>* profile, F createStage) {
+    const unsigned int R = cic->getM();
+
+    CmsisTypeFactory firFactory(createFirSource(std::make_unique<std::vector<double>>(compensator)));
+
+    std::vector<std::unique_ptr<DecimateStream<T>>> stages;
+    stages.push_back(std::move(cic));
+    stages.push_back(createStage(firFactory, maxBlockSize / R + 1));
+
+    if (profile) {
+      profile->clear();
+      profile->push_back(DecimateStageCost{R, 0, 0.0, 0});
+      profile->push_back(DecimateStageCost{2, (unsigned int)compensator.size(), (double)compensator.size(), 0});
+    }
+
+    return createDecimateChain(name, std::move(stages), maxBlockSize, profile);
+  }
+
+} // namespace
+
+unsigned int cicBitGrowth(unsigned int order, unsigned int R) {
+  checkCicParams(order, R);
+  return (unsigned int)std::ceil(order * std::log2((double)R) - 1e-9);
+}
+
+std::unique_ptr<DecimateStream<q31_t>> createQ31CicDecimateStream(unsigned int order, unsigned int R) {
+  checkCicParams(order, R);
+  return std::unique_ptr<DecimateStream<q31_t>>(new CicDecimateStream<q31_t>("q31_cic", order, R, 0, 0));
+}
+
+std::unique_ptr<DecimateStream<q15_t>> createQ15CicDecimateStream(unsigned int order, unsigned int R) {
+  const unsigned int growth = cicBitGrowth(order, R);
+  const unsigned int preShift = growth > 16 ? growth - 16 : 0;
+  return std::unique_ptr<DecimateStream<q15_t>>(new CicDecimateStream<q15_t>("q15_cic", order, R, preShift, growth - preShift));
+}
+
+std::unique_ptr<Decimate> createQ31CicDecimate(unsigned int order, unsigned int R, std::unique_ptr<std::vector<q31_t>> waveform) {
+  unsigned int size = waveform->size();
+  return createBlockDecimate(createQ31CicDecimateStream(order, R), std::move(waveform), size);
+}
+
+std::unique_ptr<Decimate> createQ15CicDecimate(unsigned int order, unsigned int R, std::unique_ptr<std::vector<q15_t>> waveform) {
+  unsigned int size = waveform->size();
+  return createBlockDecimate(createQ15CicDecimateStream(order, R), std::move(waveform), size);
+}
+
+// The compensation filter input is the full scale CIC output, use
+// the arm_fir_decimate_{q15,q31} accumulator widths (not fast) which
+// need no further scaling.
+std::unique_ptr<DecimateStream<q31_t>> createQ31CicCompensatedDecimateStream(unsigned int order, unsigned int R, const std::vector<double>& compensator, unsigned int maxBlockSize, std::vector<DecimateStageCost>* profile) {
+  return createCompensated<q31_t>("q31_cic_comp", createQ31CicDecimateStream(order, R), compensator, maxBlockSize, profile, [](CmsisTypeFactory& fir, unsigned int blockSize) {
+    return createQ31DecimateStream(fir, 2, blockSize, false);
+  });
+}
+
+std::unique_ptr<DecimateStream<q15_t>> createQ15CicCompensatedDecimateStream(unsigned int order, unsigned int R, const std::vector<double>& compensator, unsigned int maxBlockSize, std::vector<DecimateStageCost>* profile) {
+  return createCompensated<q15_t>("q15_cic_comp", createQ15CicDecimateStream(order, R), compensator, maxBlockSize, profile, [](CmsisTypeFactory& fir, unsigned int blockSize) {
+    return createQ15DecimateStream(fir, 2, blockSize, false);
+  });
+}
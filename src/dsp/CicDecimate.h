@@ -0,0 +1,60 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_CICDECIMATE_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_CICDECIMATE_H_INCLUDED
+
+#include "CmsisDecimate.h"
+#include "DecimatePlanner.h"
+
+#include "arm_math.h"
+
+#include <memory>
+#include <vector>
+
+/**
+Cascaded integrator-comb (CIC) decimation.
+
+A CIC decimator of order N and rate R is N integrators at the input
+rate, decimation by R, and N combs (differential delay 1) at the
+output rate. It uses no multiplies, only 32 bit integer adds. The
+integrators overflow, but with two's complement wraparound arithmetic
+the comb output is correct as long as it fits in 32 bits. The DC gain
+is R^N, a bit growth of ceil(N*log2(R)) bits.
+
+The CIC response droops across the passband and aliases near the
+output Nyquist frequency. A CIC decimator is therefore followed by a
+short compensation filter that flattens the passband and decimates by
+a further factor of 2.
+*/
+
+// The CIC bit growth, ceil(order*log2(R)).
+unsigned int cicBitGrowth(unsigned int order, unsigned int R);
+
+// Create CIC decimation streams. The q31 stream requires input scaled
+// down by cicBitGrowth() bits (see CmsisTypeFactory::toQ31()), the
+// output is then at the input's unscaled level (exactly if R is a
+// power of 2). The q15 stream has 16 bits of headroom in its 32 bit
+// integrators, it shifts the input down by any bit growth beyond 16
+// bits and shifts the output back down to the input level. Throws Ex
+// if order or R is zero.
+std::unique_ptr<DecimateStream<q31_t>> createQ31CicDecimateStream(unsigned int order, unsigned int R);
+std::unique_ptr<DecimateStream<q15_t>> createQ15CicDecimateStream(unsigned int order, unsigned int R);
+
+// Create CIC decimators of a whole waveform, see above.
+std::unique_ptr<Decimate> createQ31CicDecimate(unsigned int order, unsigned int R, std::unique_ptr<std::vector<q31_t>> waveform);
+std::unique_ptr<Decimate> createQ15CicDecimate(unsigned int order, unsigned int R, std::unique_ptr<std::vector<q15_t>> waveform);
+
+// Create a CIC decimate by R stream followed by a decimate by 2
+// compensation filter (see designCicCompensator()), a total
+// decimation of 2*R. The compensation filter is a
+// create{Q15,Q31}DecimateStream stream. The compensation filter
+// boosts the upper passband, up to the inverse of the CIC droop. The
+// q31 chain doesn't saturate, its input must be scaled down by one
+// more bit than the q31 CIC stream requires. If profile is not null it
+// is filled with the CIC and the compensation stage costs, see
+// createDecimateChain().
+std::unique_ptr<DecimateStream<q31_t>> createQ31CicCompensatedDecimateStream(unsigned int order, unsigned int R, const std::vector<double>& compensator, unsigned int maxBlockSize, std::vector<DecimateStageCost>* profile = nullptr);
+std::unique_ptr<DecimateStream<q15_t>> createQ15CicCompensatedDecimateStream(unsigned int order, unsigned int R, const std::vector<double>& compensator, unsigned int maxBlockSize, std::vector<DecimateStageCost>* profile = nullptr);
+
+#endif
@@ -2,8 +2,13 @@
 //  SPDX-License-Identifier: Apache-2.0
 
 #include "CmsisDecimate.h"
+#include "CmsisTypeFactory.h"
+#include "Instrument.h"
 #include "Ex.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace {
 
   template <typename T> class CmsisDecimate : public Decimate {
@@ -113,7 +118,9 @@ namespace {
 
       checkArmInitStatus( arm_fir_decimate_init_q15(&init, numTaps, M, fir->data(), state.data(), blockSize) );
 
+      instrument::recordInput("decimate", name, waveform->data(), waveform->size());
       arm_fir_decimate_q15(&init, waveform->data(), result.data(), waveform->size());
+      instrument::recordOutput("decimate", name, result.data(), result.size());
     }
 
     void decimate_fast_q15() {
@@ -124,7 +131,9 @@ namespace {
 
       checkArmInitStatus( arm_fir_decimate_init_q15(&init, numTaps, M, fir->data(), state.data(), blockSize) );
 
+      instrument::recordInput("decimate", name, waveform->data(), waveform->size());
       arm_fir_decimate_fast_q15(&init, waveform->data(), result.data(), waveform->size());
+      instrument::recordOutput("decimate", name, result.data(), result.size());
     }
   
     virtual void execute() {
@@ -158,7 +167,9 @@ namespace {
 
       checkArmInitStatus( arm_fir_decimate_init_q31(&init, numTaps, M, fir->data(), state.data(), blockSize) );
 
+      instrument::recordInput("decimate", name, waveform->data(), waveform->size());
       arm_fir_decimate_q31(&init, waveform->data(), result.data(), waveform->size());
+      instrument::recordOutput("decimate", name, result.data(), result.size());
     }
 
     void decimate_fast_q31() {
@@ -169,7 +180,9 @@ namespace {
 
       checkArmInitStatus( arm_fir_decimate_init_q31(&init, numTaps, M, fir->data(), state.data(), blockSize) );
 
+      instrument::recordInput("decimate", name, waveform->data(), waveform->size());
       arm_fir_decimate_fast_q31(&init, waveform->data(), result.data(), waveform->size());
+      instrument::recordOutput("decimate", name, result.data(), result.size());
     }
   
     virtual void execute() {
@@ -182,6 +195,671 @@ namespace {
     }
   };
 
+  template <typename T, typename I> class CmsisDecimateStream : public DecimateStream<T> {
+
+  protected:
+    // the implementation name
+    const std::string name;
+
+    // the filter
+    std::unique_ptr<std::vector<T>> fir;
+
+    // the decimation factor
+    const unsigned int M;
+
+    // the largest arm_fir_decimate_* block size, a multiple of M
+    const unsigned int maxBlockSize;
+
+    // arm_fir_decimate_* state, numTaps+maxBlockSize-1 samples
+    std::vector<T> state;
+
+    // the arm_fir_decimate_* instance
+    I instance;
+
+    // input samples held until a group of M is complete
+    std::vector<T> pending;
+    unsigned int pendingCount = 0;
+
+    void checkArmInitStatus(arm_status status) {
+      if (status == ARM_MATH_LENGTH_ERROR ) {
+	throw Ex("arm " + name + " decimation blockSize is not a multple of M");
+      }
+      else if (status != ARM_MATH_SUCCESS) {
+	throw Ex("arm " + name + " decimatin init error");
+      }
+    }
+
+    // arm_fir_decimate_init_* (zeros the state)
+    virtual void init() = 0;
+
+    // arm_fir_decimate_*, blockSize is a multiple of M
+    virtual void decimate(const T* in, T* out, unsigned int blockSize) = 0;
+
+  public:
+
+    CmsisDecimateStream(const std::string& name, std::unique_ptr<std::vector<T>> fir, unsigned int M, unsigned int maxBlockSize)
+      : name(name),
+	fir(std::move(fir)),
+	M(M),
+	maxBlockSize(M > 0 ? (maxBlockSize / M) * M : 0),
+	state(this->fir->size() + this->maxBlockSize - 1),
+	pending(M)
+    {
+      if (this->maxBlockSize == 0) {
+	throw Ex("stream block size is less than decimation factor");
+      }
+    }
+
+    virtual ~CmsisDecimateStream() {}
+
+    virtual const std::string& getName() const {
+      return name;
+    }
+
+    virtual unsigned int getM() const {
+      return M;
+    }
+
+    virtual unsigned int getOutputSize(unsigned int numSamples) const {
+      return (pendingCount + numSamples) / M;
+    }
+
+    virtual unsigned int process(const T* in, unsigned int numSamples, T* out) {
+      unsigned int n = 0;
+      unsigned int outCount = 0;
+
+      // complete the held group of M samples
+      if (pendingCount > 0) {
+	while (pendingCount < M && n < numSamples) {
+	  pending[pendingCount++] = in[n++];
+	}
+
+	if (pendingCount < M) {
+	  return 0;
+	}
+
+	decimate(pending.data(), out, M);
+	pendingCount = 0;
+	outCount++;
+      }
+
+      // decimate whole groups directly from the input
+      while (numSamples - n >= M) {
+	unsigned int blockSize = std::min(maxBlockSize, ((numSamples - n) / M) * M);
+	decimate(in + n, out + outCount, blockSize);
+	n += blockSize;
+	outCount += blockSize / M;
+      }
+
+      // hold the remainder
+      while (n < numSamples) {
+	pending[pendingCount++] = in[n++];
+      }
+
+      return outCount;
+    }
+
+    virtual void reset() {
+      pendingCount = 0;
+      init();
+    }
+  };
+
+  class Float32DecimateStream : public CmsisDecimateStream<float32_t, arm_fir_decimate_instance_f32> {
+
+  protected:
+
+    virtual void init() {
+      checkArmInitStatus( arm_fir_decimate_init_f32(&instance, fir->size(), M, fir->data(), state.data(), maxBlockSize) );
+    }
+
+    virtual void decimate(const float32_t* in, float32_t* out, unsigned int blockSize) {
+      arm_fir_decimate_f32(&instance, in, out, blockSize);
+    }
+
+  public:
+
+    Float32DecimateStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int M, unsigned int maxBlockSize)
+      : CmsisDecimateStream<float32_t, arm_fir_decimate_instance_f32>("f32_stream", std::move(fir), M, maxBlockSize)
+    {
+      init();
+    }
+  };
+
+  class Q15DecimateStream : public CmsisDecimateStream<q15_t, arm_fir_decimate_instance_q15> {
+
+    bool fast;
+
+  protected:
+
+    virtual void init() {
+      checkArmInitStatus( arm_fir_decimate_init_q15(&instance, fir->size(), M, fir->data(), state.data(), maxBlockSize) );
+    }
+
+    virtual void decimate(const q15_t* in, q15_t* out, unsigned int blockSize) {
+      instrument::recordInput("decimate", name, in, blockSize);
+      if (fast) {
+	arm_fir_decimate_fast_q15(&instance, in, out, blockSize);
+      }
+      else {
+	arm_fir_decimate_q15(&instance, in, out, blockSize);
+      }
+      instrument::recordOutput("decimate", name, out, blockSize / M);
+    }
+
+  public:
+
+    Q15DecimateStream(std::unique_ptr<std::vector<q15_t>> fir, unsigned int M, unsigned int maxBlockSize, bool fast)
+      : CmsisDecimateStream<q15_t, arm_fir_decimate_instance_q15>(fast ? "q15_fast_stream" : "q15_stream", std::move(fir), M, maxBlockSize),
+	fast(fast)
+    {
+      init();
+    }
+  };
+
+  class Q31DecimateStream : public CmsisDecimateStream<q31_t, arm_fir_decimate_instance_q31> {
+
+    bool fast;
+
+  protected:
+
+    virtual void init() {
+      checkArmInitStatus( arm_fir_decimate_init_q31(&instance, fir->size(), M, fir->data(), state.data(), maxBlockSize) );
+    }
+
+    virtual void decimate(const q31_t* in, q31_t* out, unsigned int blockSize) {
+      instrument::recordInput("decimate", name, in, blockSize);
+      if (fast) {
+	arm_fir_decimate_fast_q31(&instance, in, out, blockSize);
+      }
+      else {
+	arm_fir_decimate_q31(&instance, in, out, blockSize);
+      }
+      instrument::recordOutput("decimate", name, out, blockSize / M);
+    }
+
+  public:
+
+    Q31DecimateStream(std::unique_ptr<std::vector<q31_t>> fir, unsigned int M, unsigned int maxBlockSize, bool fast)
+      : CmsisDecimateStream<q31_t, arm_fir_decimate_instance_q31>(fast ? "q31_fast_stream" : "q31_stream", std::move(fir), M, maxBlockSize),
+	fast(fast)
+    {
+      init();
+    }
+  };
+
+  // Folded symmetric filter coefficients. h[k] == h[N-1-k], so the
+  // samples of taps k and N-1-k are added before the multiply.
+  template <typename T> struct FoldedInstance {
+    // h[0..N/2-1]
+    std::vector<T> pairs;
+
+    // the center tap of an odd length filter
+    bool hasCenter;
+    T center;
+  };
+
+  // Folded symmetric FIR decimate by M. The state buffer is laid out
+  // the same as the arm_fir_decimate_* state, numTaps-1 history
+  // samples followed by the current block, so the output is aligned
+  // with arm_fir_decimate_*.
+  template <typename T> class FoldedDecimateStream : public CmsisDecimateStream<T, FoldedInstance<T>> {
+
+  protected:
+    using CmsisDecimateStream<T, FoldedInstance<T>>::fir;
+    using CmsisDecimateStream<T, FoldedInstance<T>>::M;
+    using CmsisDecimateStream<T, FoldedInstance<T>>::state;
+    using CmsisDecimateStream<T, FoldedInstance<T>>::instance;
+
+    // Filter numOutputs samples. x points at the oldest sample of the
+    // first output's window, x[k] and x[N-1-k] are the samples of
+    // pair k.
+    virtual void filter(const T* x, T* out, unsigned int numOutputs) = 0;
+
+    virtual void init() {
+      std::fill(state.begin(), state.end(), 0);
+    }
+
+    virtual void decimate(const T* in, T* out, unsigned int blockSize) {
+      const unsigned int history = fir->size() - 1;
+
+      instrument::recordInput("decimate", this->name, in, blockSize);
+      std::copy(in, in + blockSize, state.begin() + history);
+      filter(state.data(), out, blockSize / M);
+      std::copy(state.begin() + blockSize, state.begin() + blockSize + history, state.begin());
+      instrument::recordOutput("decimate", this->name, out, blockSize / M);
+    }
+
+  public:
+
+    FoldedDecimateStream(const std::string& name, std::unique_ptr<std::vector<T>> fir, unsigned int M, unsigned int maxBlockSize)
+      : CmsisDecimateStream<T, FoldedInstance<T>>(name, std::move(fir), M, maxBlockSize)
+    {
+      const std::vector<T>& h = *this->fir;
+      const unsigned int N = h.size();
+      if (N < 2) {
+	throw Ex("folded filter is too short");
+      }
+
+      for (unsigned int k = 0; k < N/2; k++) {
+	if (h[k] != h[N-1-k]) {
+	  throw Ex("folded filter is not symmetric");
+	}
+	instance.pairs.push_back(h[k]);
+      }
+      instance.hasCenter = (N % 2) == 1;
+      instance.center = instance.hasCenter ? h[N/2] : 0;
+
+      init();
+    }
+  };
+
+  class Float32FoldedDecimateStream : public FoldedDecimateStream<float32_t> {
+
+  protected:
+
+    virtual void filter(const float32_t* x, float32_t* out, unsigned int numOutputs) {
+      const unsigned int numPairs = instance.pairs.size();
+      const unsigned int last = fir->size() - 1;
+      const float32_t* pairs = instance.pairs.data();
+
+      for (unsigned int i = 0; i < numOutputs; i++, x += M) {
+	float32_t acc = instance.hasCenter ? instance.center * x[numPairs] : 0.0f;
+	const float32_t* pa = x;
+	const float32_t* pb = x + last;
+	for (unsigned int k = 0; k < numPairs; k++) {
+	  acc += pairs[k] * (*pa++ + *pb--);
+	}
+	*out++ = acc;
+      }
+    }
+
+  public:
+
+    Float32FoldedDecimateStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int M, unsigned int maxBlockSize)
+      : FoldedDecimateStream<float32_t>("f32_folded", std::move(fir), M, maxBlockSize)
+    {}
+  };
+
+  // The pair sums are formed in 32 bits so they can't overflow. The
+  // non fast variant accumulates in 64 bits like arm_fir_decimate_q15,
+  // the fast variant accumulates in 32 bits like
+  // arm_fir_decimate_fast_q15. Folding doesn't change the accumulator
+  // bound (sum |h[k]| |x|), so the scaling requirements are the same.
+  class Q15FoldedDecimateStream : public FoldedDecimateStream<q15_t> {
+
+    bool fast;
+
+    template <typename A> void filter(const q15_t* x, q15_t* out, unsigned int numOutputs) {
+      const unsigned int numPairs = instance.pairs.size();
+      const unsigned int last = fir->size() - 1;
+      const q15_t* pairs = instance.pairs.data();
+
+      for (unsigned int i = 0; i < numOutputs; i++, x += M) {
+	A acc = instance.hasCenter ? (q31_t)instance.center * x[numPairs] : 0;
+	const q15_t* pa = x;
+	const q15_t* pb = x + last;
+	for (unsigned int k = 0; k < numPairs; k++) {
+	  acc += (q31_t)pairs[k] * ((q31_t)*pa++ + *pb--);
+	}
+	*out++ = (q15_t)__SSAT((q31_t)(acc >> 15), 16);
+      }
+    }
+
+  protected:
+
+    virtual void filter(const q15_t* x, q15_t* out, unsigned int numOutputs) {
+      if (fast) {
+	filter<q31_t>(x, out, numOutputs);
+      }
+      else {
+	filter<q63_t>(x, out, numOutputs);
+      }
+    }
+
+  public:
+
+    Q15FoldedDecimateStream(std::unique_ptr<std::vector<q15_t>> fir, unsigned int M, unsigned int maxBlockSize, bool fast)
+      : FoldedDecimateStream<q15_t>(fast ? "q15_fast_folded" : "q15_folded", std::move(fir), M, maxBlockSize),
+	fast(fast)
+    {}
+  };
+
+  // The pair sums are formed in 64 bits so they can't overflow. The
+  // non fast variant accumulates in 64 bits like
+  // arm_fir_decimate_q31, and saturates the result (counted, see
+  // Instrument.h), the fast variant keeps the upper 32 bits of each
+  // product like arm_fir_decimate_fast_q31. A pair product is
+  // less than 2^63, and the accumulator is bounded by sum |h[k]| |x|
+  // as it is unfolded, so the scaling requirements are the same.
+  class Q31FoldedDecimateStream : public FoldedDecimateStream<q31_t> {
+
+    bool fast;
+
+    void filter_q31(const q31_t* x, q31_t* out, unsigned int numOutputs) {
+      const unsigned int numPairs = instance.pairs.size();
+      const unsigned int last = fir->size() - 1;
+      const q31_t* pairs = instance.pairs.data();
+
+      unsigned long numClipped = 0;
+      for (unsigned int i = 0; i < numOutputs; i++, x += M) {
+	q63_t acc = instance.hasCenter ? (q63_t)instance.center * x[numPairs] : 0;
+	const q31_t* pa = x;
+	const q31_t* pb = x + last;
+	for (unsigned int k = 0; k < numPairs; k++) {
+	  acc += (q63_t)pairs[k] * ((q63_t)*pa++ + *pb--);
+	}
+	*out++ = instrument::clipQ63ToQ31(acc >> 31, numClipped);
+      }
+      instrument::recordClipped("q63_to_q31", name, numClipped, numOutputs);
+    }
+
+    void filter_fast_q31(const q31_t* x, q31_t* out, unsigned int numOutputs) {
+      const unsigned int numPairs = instance.pairs.size();
+      const unsigned int last = fir->size() - 1;
+      const q31_t* pairs = instance.pairs.data();
+
+      for (unsigned int i = 0; i < numOutputs; i++, x += M) {
+	q31_t acc = instance.hasCenter ? (q31_t)(((q63_t)instance.center * x[numPairs]) >> 32) : 0;
+	const q31_t* pa = x;
+	const q31_t* pb = x + last;
+	for (unsigned int k = 0; k < numPairs; k++) {
+	  acc = (q31_t)((((q63_t)acc << 32) + (q63_t)pairs[k] * ((q63_t)*pa++ + *pb--)) >> 32);
+	}
+	*out++ = acc << 1;
+      }
+    }
+
+  protected:
+
+    virtual void filter(const q31_t* x, q31_t* out, unsigned int numOutputs) {
+      if (fast) {
+	filter_fast_q31(x, out, numOutputs);
+      }
+      else {
+	filter_q31(x, out, numOutputs);
+      }
+    }
+
+  public:
+
+    Q31FoldedDecimateStream(std::unique_ptr<std::vector<q31_t>> fir, unsigned int M, unsigned int maxBlockSize, bool fast)
+      : FoldedDecimateStream<q31_t>(fast ? "q31_fast_folded" : "q31_folded", std::move(fir), M, maxBlockSize),
+	fast(fast)
+    {}
+  };
+
+  // True if a half-band filter tap at an even, non zero, distance
+  // from the center tap is zero. Fixed point taps must be exactly
+  // zero, floating point taps may carry the design's rounding error
+  // relative to the center tap.
+  bool isHalfBandZero(float32_t h, float32_t center) {
+    return std::fabs(h) <= 1e-6f * std::fabs(center);
+  }
+
+  bool isHalfBandZero(q15_t h, q15_t) {
+    return h == 0;
+  }
+
+  bool isHalfBandZero(q31_t h, q31_t) {
+    return h == 0;
+  }
+
+  // Folded half-band filter coefficients. Taps at an even, non zero,
+  // distance from the center tap are zero and are skipped.
+  // The symmetric taps at odd distance d from the center are folded
+  // into pairs that share one coefficient.
+  template <typename T> struct HalfBandInstance {
+    // the center tap
+    T center;
+
+    // the pair coefficients h[c-d] for d = 1, 3, 5, ...
+    std::vector<T> pairs;
+  };
+
+  // Half-band decimate by 2. The state buffer is laid out the same as
+  // the arm_fir_decimate_* state: numTaps-1 history samples followed
+  // by the current block, so output i has the same alignment as
+  // arm_fir_decimate_* with M=2.
+  template <typename T> class HalfBandDecimateStream : public CmsisDecimateStream<T, HalfBandInstance<T>> {
+
+  protected:
+    using CmsisDecimateStream<T, HalfBandInstance<T>>::fir;
+    using CmsisDecimateStream<T, HalfBandInstance<T>>::state;
+    using CmsisDecimateStream<T, HalfBandInstance<T>>::instance;
+
+    // the center tap index
+    const unsigned int c;
+
+    // Filter numOutputs samples. x points at the center tap sample of
+    // the first output, x[-d] and x[d] are the samples of pair d.
+    virtual void filter(const T* x, T* out, unsigned int numOutputs) = 0;
+
+    virtual void init() {
+      std::fill(state.begin(), state.end(), 0);
+    }
+
+    virtual void decimate(const T* in, T* out, unsigned int blockSize) {
+      const unsigned int history = fir->size() - 1;
+
+      instrument::recordInput("decimate", this->name, in, blockSize);
+      std::copy(in, in + blockSize, state.begin() + history);
+      filter(state.data() + c, out, blockSize / 2);
+      std::copy(state.begin() + blockSize, state.begin() + blockSize + history, state.begin());
+      instrument::recordOutput("decimate", this->name, out, blockSize / 2);
+    }
+
+  public:
+
+    HalfBandDecimateStream(const std::string& name, std::unique_ptr<std::vector<T>> fir, unsigned int maxBlockSize)
+      : CmsisDecimateStream<T, HalfBandInstance<T>>(name, std::move(fir), 2, maxBlockSize),
+	c(this->fir->size() / 2)
+    {
+      const std::vector<T>& h = *this->fir;
+      if (h.size() % 2 == 0) {
+	throw Ex("half-band filter length is not odd");
+      }
+
+      instance.center = h[c];
+      for (unsigned int d = 1; d <= c; d++) {
+	if (h[c-d] != h[c+d]) {
+	  throw Ex("half-band filter is not symmetric");
+	}
+	if (d % 2 == 1) {
+	  instance.pairs.push_back(h[c-d]);
+	}
+	else if (!isHalfBandZero(h[c-d], h[c])) {
+	  throw Ex("half-band filter tap at an even distance from the center is not zero");
+	}
+      }
+
+      init();
+    }
+  };
+
+  class Float32HalfBandDecimateStream : public HalfBandDecimateStream<float32_t> {
+
+  protected:
+
+    virtual void filter(const float32_t* x, float32_t* out, unsigned int numOutputs) {
+      const unsigned int numPairs = instance.pairs.size();
+      const float32_t* pairs = instance.pairs.data();
+
+      for (unsigned int i = 0; i < numOutputs; i++, x += 2) {
+	float32_t acc = instance.center * x[0];
+	const float32_t* pa = x - 1;
+	const float32_t* pb = x + 1;
+	for (unsigned int j = 0; j < numPairs; j++, pa -= 2, pb += 2) {
+	  acc += pairs[j] * (*pa + *pb);
+	}
+	*out++ = acc;
+      }
+    }
+
+  public:
+
+    Float32HalfBandDecimateStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int maxBlockSize)
+      : HalfBandDecimateStream<float32_t>("f32_halfband", std::move(fir), maxBlockSize)
+    {}
+  };
+
+  // The pair sums are formed in 32 bits so they can't overflow. The
+  // non fast variant accumulates in 64 bits like
+  // arm_fir_decimate_q15, the fast variant accumulates in 32 bits like
+  // arm_fir_decimate_fast_q15 and has the same scaling requirements.
+  class Q15HalfBandDecimateStream : public HalfBandDecimateStream<q15_t> {
+
+    bool fast;
+
+    template <typename A> void filter(const q15_t* x, q15_t* out, unsigned int numOutputs) {
+      const unsigned int numPairs = instance.pairs.size();
+      const q15_t* pairs = instance.pairs.data();
+
+      for (unsigned int i = 0; i < numOutputs; i++, x += 2) {
+	A acc = (q31_t)instance.center * x[0];
+	const q15_t* pa = x - 1;
+	const q15_t* pb = x + 1;
+	for (unsigned int j = 0; j < numPairs; j++, pa -= 2, pb += 2) {
+	  acc += (q31_t)pairs[j] * ((q31_t)*pa + *pb);
+	}
+	*out++ = (q15_t)__SSAT((q31_t)(acc >> 15), 16);
+      }
+    }
+
+  protected:
+
+    virtual void filter(const q15_t* x, q15_t* out, unsigned int numOutputs) {
+      if (fast) {
+	filter<q31_t>(x, out, numOutputs);
+      }
+      else {
+	filter<q63_t>(x, out, numOutputs);
+      }
+    }
+
+  public:
+
+    Q15HalfBandDecimateStream(std::unique_ptr<std::vector<q15_t>> fir, unsigned int maxBlockSize, bool fast)
+      : HalfBandDecimateStream<q15_t>(fast ? "q15_fast_halfband" : "q15_halfband", std::move(fir), maxBlockSize),
+	fast(fast)
+    {}
+  };
+
+  // The pair sums are formed in 64 bits so they can't overflow. The
+  // non fast variant accumulates in 64 bits like
+  // arm_fir_decimate_q31, and saturates the result (counted, see
+  // Instrument.h), the fast variant keeps the upper 32 bits of each
+  // product like arm_fir_decimate_fast_q31. Neither adds an
+  // input range limit to the scaling requirements of the equivalent
+  // arm function.
+  class Q31HalfBandDecimateStream : public HalfBandDecimateStream<q31_t> {
+
+    bool fast;
+
+    void filter_q31(const q31_t* x, q31_t* out, unsigned int numOutputs) {
+      const unsigned int numPairs = instance.pairs.size();
+      const q31_t* pairs = instance.pairs.data();
+
+      unsigned long numClipped = 0;
+      for (unsigned int i = 0; i < numOutputs; i++, x += 2) {
+	q63_t acc = (q63_t)instance.center * x[0];
+	const q31_t* pa = x - 1;
+	const q31_t* pb = x + 1;
+	for (unsigned int j = 0; j < numPairs; j++, pa -= 2, pb += 2) {
+	  acc += (q63_t)pairs[j] * ((q63_t)*pa + *pb);
+	}
+	*out++ = instrument::clipQ63ToQ31(acc >> 31, numClipped);
+      }
+      instrument::recordClipped("q63_to_q31", name, numClipped, numOutputs);
+    }
+
+    void filter_fast_q31(const q31_t* x, q31_t* out, unsigned int numOutputs) {
+      const unsigned int numPairs = instance.pairs.size();
+      const q31_t* pairs = instance.pairs.data();
+
+      for (unsigned int i = 0; i < numOutputs; i++, x += 2) {
+	q31_t acc = (q31_t)(((q63_t)instance.center * x[0]) >> 32);
+	const q31_t* pa = x - 1;
+	const q31_t* pb = x + 1;
+	for (unsigned int j = 0; j < numPairs; j++, pa -= 2, pb += 2) {
+	  acc = (q31_t)((((q63_t)acc << 32) + (q63_t)pairs[j] * ((q63_t)*pa + *pb)) >> 32);
+	}
+	*out++ = acc << 1;
+      }
+    }
+
+  protected:
+
+    virtual void filter(const q31_t* x, q31_t* out, unsigned int numOutputs) {
+      if (fast) {
+	filter_fast_q31(x, out, numOutputs);
+      }
+      else {
+	filter_q31(x, out, numOutputs);
+      }
+    }
+
+  public:
+
+    Q31HalfBandDecimateStream(std::unique_ptr<std::vector<q31_t>> fir, unsigned int maxBlockSize, bool fast)
+      : HalfBandDecimateStream<q31_t>(fast ? "q31_fast_halfband" : "q31_halfband", std::move(fir), maxBlockSize),
+	fast(fast)
+    {}
+  };
+
+  // Run a stream over an owned waveform in fixed size blocks.
+  template <typename T> class BlockDecimate : public Decimate {
+
+    std::unique_ptr<DecimateStream<T>> stream;
+
+    std::unique_ptr<std::vector<T>> waveform;
+
+    const unsigned int blockSize;
+
+    std::vector<T> result;
+
+  public:
+
+    BlockDecimate(std::unique_ptr<DecimateStream<T>> stream, std::unique_ptr<std::vector<T>> waveform, unsigned int blockSize)
+      : stream(std::move(stream)),
+	waveform(std::move(waveform)),
+	blockSize(blockSize),
+	result(this->waveform->size() / this->stream->getM())
+    {
+      if ( blockSize == 0 ) {
+	throw Ex("block size is zero");
+      }
+    }
+
+    virtual ~BlockDecimate() {}
+
+    virtual void execute() {
+      const T* in = waveform->data();
+      T* out = result.data();
+      unsigned int remaining = waveform->size();
+      while (remaining > 0) {
+	unsigned int n = std::min(blockSize, remaining);
+	out += stream->process(in, n, out);
+	in += n;
+	remaining -= n;
+      }
+    }
+
+    virtual const std::string& getName() const {
+      return stream->getName();
+    }
+
+    virtual unsigned int getM() {
+      return stream->getM();
+    }
+
+    const std::unique_ptr<std::vector<float>> getResult() const {
+      auto floatResult = std::make_unique<std::vector<float>>(result.size());
+      std::copy(result.cbegin(), result.cend(), floatResult->begin());
+      return floatResult;
+    }
+  };
+
 } // namespace
 
 std::unique_ptr<Decimate> createFloat32Decimate(std::unique_ptr<std::vector<float32_t>> fir, std::unique_ptr<std::vector<float32_t>> waveform, unsigned int M) {
@@ -195,3 +873,83 @@ std::unique_ptr<Decimate> createQ15Decimate(std::unique_ptr<std::vector<q15_t>>
 std::unique_ptr<Decimate> createQ31Decimate(std::unique_ptr<std::vector<q31_t>> fir, std::unique_ptr<std::vector<q31_t>> waveform, unsigned int M, bool fast) {
   return std::unique_ptr<Decimate>(new Q31Decimate(std::move(fir), std::move(waveform), M, fast));
 }
+
+std::unique_ptr<DecimateStream<float32_t>> createFloat32DecimateStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int M, unsigned int maxBlockSize) {
+  return std::unique_ptr<DecimateStream<float32_t>>(new Float32DecimateStream(std::move(fir), M, maxBlockSize));
+}
+
+std::unique_ptr<DecimateStream<q15_t>> createQ15DecimateStream(std::unique_ptr<std::vector<q15_t>> fir, unsigned int M, unsigned int maxBlockSize, bool fast) {
+  return std::unique_ptr<DecimateStream<q15_t>>(new Q15DecimateStream(std::move(fir), M, maxBlockSize, fast));
+}
+
+std::unique_ptr<DecimateStream<q31_t>> createQ31DecimateStream(std::unique_ptr<std::vector<q31_t>> fir, unsigned int M, unsigned int maxBlockSize, bool fast) {
+  return std::unique_ptr<DecimateStream<q31_t>>(new Q31DecimateStream(std::move(fir), M, maxBlockSize, fast));
+}
+
+std::unique_ptr<DecimateStream<float32_t>> createFloat32FoldedDecimateStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int M, unsigned int maxBlockSize) {
+  return std::unique_ptr<DecimateStream<float32_t>>(new Float32FoldedDecimateStream(std::move(fir), M, maxBlockSize));
+}
+
+std::unique_ptr<DecimateStream<q15_t>> createQ15FoldedDecimateStream(std::unique_ptr<std::vector<q15_t>> fir, unsigned int M, unsigned int maxBlockSize, bool fast) {
+  return std::unique_ptr<DecimateStream<q15_t>>(new Q15FoldedDecimateStream(std::move(fir), M, maxBlockSize, fast));
+}
+
+std::unique_ptr<DecimateStream<q31_t>> createQ31FoldedDecimateStream(std::unique_ptr<std::vector<q31_t>> fir, unsigned int M, unsigned int maxBlockSize, bool fast) {
+  return std::unique_ptr<DecimateStream<q31_t>>(new Q31FoldedDecimateStream(std::move(fir), M, maxBlockSize, fast));
+}
+
+std::unique_ptr<DecimateStream<float32_t>> createFloat32DecimateStream(CmsisTypeFactory& fir, unsigned int M, unsigned int maxBlockSize) {
+  if (fir.isSymmetric()) {
+    return createFloat32FoldedDecimateStream(fir.toFloat32(), M, maxBlockSize);
+  }
+  return createFloat32DecimateStream(fir.toFloat32(), M, maxBlockSize);
+}
+
+std::unique_ptr<DecimateStream<q15_t>> createQ15DecimateStream(CmsisTypeFactory& fir, unsigned int M, unsigned int maxBlockSize, bool fast) {
+  if (fir.isSymmetric()) {
+    return createQ15FoldedDecimateStream(fir.toQ15(), M, maxBlockSize, fast);
+  }
+  return createQ15DecimateStream(fir.toQ15(), M, maxBlockSize, fast);
+}
+
+std::unique_ptr<DecimateStream<q31_t>> createQ31DecimateStream(CmsisTypeFactory& fir, unsigned int M, unsigned int maxBlockSize, bool fast) {
+  if (fir.isSymmetric()) {
+    return createQ31FoldedDecimateStream(fir.toQ31(), M, maxBlockSize, fast);
+  }
+  return createQ31DecimateStream(fir.toQ31(), M, maxBlockSize, fast);
+}
+
+std::unique_ptr<DecimateStream<float32_t>> createFloat32HalfBandDecimateStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int maxBlockSize) {
+  return std::unique_ptr<DecimateStream<float32_t>>(new Float32HalfBandDecimateStream(std::move(fir), maxBlockSize));
+}
+
+std::unique_ptr<DecimateStream<q15_t>> createQ15HalfBandDecimateStream(std::unique_ptr<std::vector<q15_t>> fir, unsigned int maxBlockSize, bool fast) {
+  return std::unique_ptr<DecimateStream<q15_t>>(new Q15HalfBandDecimateStream(std::move(fir), maxBlockSize, fast));
+}
+
+std::unique_ptr<DecimateStream<q31_t>> createQ31HalfBandDecimateStream(std::unique_ptr<std::vector<q31_t>> fir, unsigned int maxBlockSize, bool fast) {
+  return std::unique_ptr<DecimateStream<q31_t>>(new Q31HalfBandDecimateStream(std::move(fir), maxBlockSize, fast));
+}
+
+std::unique_ptr<Decimate> createFloat32HalfBandDecimate(std::unique_ptr<std::vector<float32_t>> fir, std::unique_ptr<std::vector<float32_t>> waveform) {
+  unsigned int size = waveform->size();
+  return createBlockDecimate(createFloat32HalfBandDecimateStream(std::move(fir), size), std::move(waveform), size);
+}
+
+std::unique_ptr<Decimate> createQ15HalfBandDecimate(std::unique_ptr<std::vector<q15_t>> fir, std::unique_ptr<std::vector<q15_t>> waveform, bool fast) {
+  unsigned int size = waveform->size();
+  return createBlockDecimate(createQ15HalfBandDecimateStream(std::move(fir), size, fast), std::move(waveform), size);
+}
+
+std::unique_ptr<Decimate> createQ31HalfBandDecimate(std::unique_ptr<std::vector<q31_t>> fir, std::unique_ptr<std::vector<q31_t>> waveform, bool fast) {
+  unsigned int size = waveform->size();
+  return createBlockDecimate(createQ31HalfBandDecimateStream(std::move(fir), size, fast), std::move(waveform), size);
+}
+
+template <typename T> std::unique_ptr<Decimate> createBlockDecimate(std::unique_ptr<DecimateStream<T>> stream, std::unique_ptr<std::vector<T>> waveform, unsigned int blockSize) {
+  return std::unique_ptr<Decimate>(new BlockDecimate<T>(std::move(stream), std::move(waveform), blockSize));
+}
+
+template std::unique_ptr<Decimate> createBlockDecimate<float32_t>(std::unique_ptr<DecimateStream<float32_t>> stream, std::unique_ptr<std::vector<float32_t>> waveform, unsigned int blockSize);
+template std::unique_ptr<Decimate> createBlockDecimate<q15_t>(std::unique_ptr<DecimateStream<q15_t>> stream, std::unique_ptr<std::vector<q15_t>> waveform, unsigned int blockSize);
+template std::unique_ptr<Decimate> createBlockDecimate<q31_t>(std::unique_ptr<DecimateStream<q31_t>> stream, std::unique_ptr<std::vector<q31_t>> waveform, unsigned int blockSize);
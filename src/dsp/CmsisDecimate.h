@@ -4,12 +4,16 @@
 #ifndef PICO_CMSIS_SANDBOX_CMSISDECIMATE_H_INCLUDED
 #define PICO_CMSIS_SANDBOX_CMSISDECIMATE_H_INCLUDED
 
+#include "Span.h"
+
 #include "arm_math.h"
 
 #include <string>
 #include <memory>
 #include <vector>
 
+class CmsisTypeFactory;
+
 class Decimate {
  public:
 
@@ -26,6 +30,52 @@ class Decimate {
   virtual const std::unique_ptr<std::vector<float>> getResult() const = 0;
 };
 
+// Streaming decimator. The CMSIS-DSP decimation instance and its
+// state buffer are initialized once, at construction. process()
+// accepts blocks of any size. Filter history is kept between calls,
+// and input samples that don't complete a group of M samples are held
+// until the next call. The output is bit for bit the same as a single
+// decimation of the concatenated blocks.
+//
+// The streams created below can decimate in place, the output may be
+// written over the input (out == in). An output sample is written
+// only after the input samples it depends on have been consumed into
+// the filter state.
+template <typename T> class DecimateStream {
+ public:
+
+  virtual ~DecimateStream() {}
+
+  // the name of the decimator implementation
+  virtual const std::string& getName() const = 0;
+
+  // get the decimation factor
+  virtual unsigned int getM() const = 0;
+
+  // The number of output samples the next process() call will produce
+  // for numSamples input samples.
+  virtual unsigned int getOutputSize(unsigned int numSamples) const = 0;
+
+  // Decimate numSamples input samples. The out buffer must have room
+  // for getOutputSize(numSamples) samples. Returns the number of
+  // samples written to out.
+  virtual unsigned int process(const T* in, unsigned int numSamples, T* out) = 0;
+
+  // Decimate the in span into the out span, e.g. DMA buffers, without
+  // copies or heap allocation. Throws Ex if out has less room than
+  // getOutputSize(in.size()). Returns the number of samples written
+  // to out.
+  unsigned int process(Span<const T> in, Span<T> out) {
+    if (out.size() < getOutputSize(in.size())) {
+      throw Ex(getName() + " output span is too small");
+    }
+    return process(in.data(), in.size(), out.data());
+  }
+
+  // Clear the filter history and any held input samples.
+  virtual void reset() = 0;
+};
+
 
 // Create floating point decimator.  Implememented using arm_fir_decimate_f32.
 std::unique_ptr<Decimate> createFloat32Decimate(std::unique_ptr<std::vector<float32_t>> fir, std::unique_ptr<std::vector<float32_t>> waveform, unsigned int M);
@@ -42,5 +92,64 @@ std::unique_ptr<Decimate> createQ15Decimate(std::unique_ptr<std::vector<q15_t>>
 // understant scaling requirments.
 std::unique_ptr<Decimate> createQ31Decimate(std::unique_ptr<std::vector<q31_t>> fir, std::unique_ptr<std::vector<q31_t>> waveform, unsigned int M, bool fast);
 
+// Create streaming decimators. maxBlockSize is the largest number of
+// samples passed to a single arm_fir_decimate_* call, it sizes the
+// state buffer (numTaps+maxBlockSize-1) and is rounded down to a
+// multiple of M. Larger process() blocks are processed in
+// maxBlockSize pieces.
+std::unique_ptr<DecimateStream<float32_t>> createFloat32DecimateStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int M, unsigned int maxBlockSize);
+std::unique_ptr<DecimateStream<q15_t>> createQ15DecimateStream(std::unique_ptr<std::vector<q15_t>> fir, unsigned int M, unsigned int maxBlockSize, bool fast);
+std::unique_ptr<DecimateStream<q31_t>> createQ31DecimateStream(std::unique_ptr<std::vector<q31_t>> fir, unsigned int M, unsigned int maxBlockSize, bool fast);
+
+// Create folded symmetric (linear phase) FIR decimation streams. The
+// samples of taps k and N-1-k are added before they are multiplied by
+// the shared coefficient, so each output sample costs (numTaps+1)/2
+// multiplies instead of numTaps. The output has the same alignment
+// as arm_fir_decimate_*. The pair sums are formed wider than the
+// samples (32 bits for q15, 64 bits for q31), so folding adds no
+// input overflow, and the fixed point variants have the same
+// accumulator widths and scaling requirements as the equivalent
+// arm_fir_decimate_* function, the output is bounded by
+// sum |h[k]| |x| (see Headroom.h). Throws Ex if the filter is not
+// symmetric.
+std::unique_ptr<DecimateStream<float32_t>> createFloat32FoldedDecimateStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int M, unsigned int maxBlockSize);
+std::unique_ptr<DecimateStream<q15_t>> createQ15FoldedDecimateStream(std::unique_ptr<std::vector<q15_t>> fir, unsigned int M, unsigned int maxBlockSize, bool fast);
+std::unique_ptr<DecimateStream<q31_t>> createQ31FoldedDecimateStream(std::unique_ptr<std::vector<q31_t>> fir, unsigned int M, unsigned int maxBlockSize, bool fast);
+
+// Create a decimation stream from filter coefficients loaded through
+// a CmsisTypeFactory. A folded stream is created if the filter is
+// symmetric, otherwise an arm_fir_decimate_* stream.
+std::unique_ptr<DecimateStream<float32_t>> createFloat32DecimateStream(CmsisTypeFactory& fir, unsigned int M, unsigned int maxBlockSize);
+std::unique_ptr<DecimateStream<q15_t>> createQ15DecimateStream(CmsisTypeFactory& fir, unsigned int M, unsigned int maxBlockSize, bool fast);
+std::unique_ptr<DecimateStream<q31_t>> createQ31DecimateStream(CmsisTypeFactory& fir, unsigned int M, unsigned int maxBlockSize, bool fast);
+
+// Create half-band decimate by 2 streams. The filter must be an odd
+// length symmetric half-band filter, e.g. designHalfBandLowpass()
+// (FirDesign.h). Taps at an even, non zero, distance from the center
+// tap must be zero (exactly for q15/q31, within 1e-6 of the center
+// tap for float32). They are skipped, and the symmetric taps are
+// folded into pairs, so a 31 tap filter costs 9 multiplies per output
+// sample instead of 31. The output has the same alignment as
+// arm_fir_decimate_* with M=2. The pair sums are formed wider than
+// the samples, as in the folded streams, so the fixed point variants
+// have the same scaling requirements as the equivalent
+// arm_fir_decimate_* function. Throws Ex if the filter is not an odd
+// length symmetric half-band filter.
+std::unique_ptr<DecimateStream<float32_t>> createFloat32HalfBandDecimateStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int maxBlockSize);
+std::unique_ptr<DecimateStream<q15_t>> createQ15HalfBandDecimateStream(std::unique_ptr<std::vector<q15_t>> fir, unsigned int maxBlockSize, bool fast);
+std::unique_ptr<DecimateStream<q31_t>> createQ31HalfBandDecimateStream(std::unique_ptr<std::vector<q31_t>> fir, unsigned int maxBlockSize, bool fast);
+
+// Create half-band decimate by 2 decimators of a whole waveform, see
+// above.
+std::unique_ptr<Decimate> createFloat32HalfBandDecimate(std::unique_ptr<std::vector<float32_t>> fir, std::unique_ptr<std::vector<float32_t>> waveform);
+std::unique_ptr<Decimate> createQ15HalfBandDecimate(std::unique_ptr<std::vector<q15_t>> fir, std::unique_ptr<std::vector<q15_t>> waveform, bool fast);
+std::unique_ptr<Decimate> createQ31HalfBandDecimate(std::unique_ptr<std::vector<q31_t>> fir, std::unique_ptr<std::vector<q31_t>> waveform, bool fast);
+
+// Create a Decimate that feeds the waveform to a stream in blockSize
+// sample blocks (the last block may be shorter). Used to profile
+// streaming decimation with the same Decimate test harness. T is one
+// of float32_t, q15_t, or q31_t.
+template <typename T> std::unique_ptr<Decimate> createBlockDecimate(std::unique_ptr<DecimateStream<T>> stream, std::unique_ptr<std::vector<T>> waveform, unsigned int blockSize);
+
 #endif
 
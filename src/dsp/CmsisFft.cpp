@@ -3,54 +3,267 @@
 
 #include "CmsisFft.h"
 
+#include "FftPlan.h"
+#include "Instrument.h"
 #include "Ex.h"
 
+#include "Platform.h"
+
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 #include <cmath>
+#include <cstdlib>
 
 namespace {
 
+  void cmplxMag(const float64_t* x, float64_t* out, unsigned int n) {
+    arm_cmplx_mag_f64(x, out, n);
+  }
+
+  void cmplxMag(const float32_t* x, float32_t* out, unsigned int n) {
+    arm_cmplx_mag_f32(x, out, n);
+  }
+
+  void cmplxMag(const q31_t* x, q31_t* out, unsigned int n) {
+    arm_cmplx_mag_q31(x, out, n);
+  }
+
+  void cmplxMag(const q15_t* x, q15_t* out, unsigned int n) {
+    arm_cmplx_mag_q15(x, out, n);
+  }
+
+  void cmplxMagSquared(const float64_t* x, float64_t* out, unsigned int n) {
+    arm_cmplx_mag_squared_f64(x, out, n);
+  }
+
+  void cmplxMagSquared(const float32_t* x, float32_t* out, unsigned int n) {
+    arm_cmplx_mag_squared_f32(x, out, n);
+  }
+
+  void cmplxMagSquared(const q31_t* x, q31_t* out, unsigned int n) {
+    arm_cmplx_mag_squared_q31(x, out, n);
+  }
+
+  void cmplxMagSquared(const q15_t* x, q15_t* out, unsigned int n) {
+    arm_cmplx_mag_squared_q15(x, out, n);
+  }
+
+  // The alpha max plus beta min coefficients that minimize the peak
+  // magnitude error (3.96%).
+  const double ambmAlpha = 0.96043387;
+  const double ambmBeta = 0.39782473;
+
+  template <typename T> void approxMagFloat(const T* x, T* out, unsigned int n) {
+    const T alpha = ambmAlpha;
+    const T beta = ambmBeta;
+    for (unsigned int i = 0; i < n; i++) {
+      const T re = std::fabs(x[2*i]);
+      const T im = std::fabs(x[2*i + 1]);
+      out[i] = re > im ? alpha * re + beta * im : alpha * im + beta * re;
+    }
+  }
+
+  void approxMag(const float64_t* x, float64_t* out, unsigned int n) {
+    approxMagFloat(x, out, n);
+  }
+
+  void approxMag(const float32_t* x, float32_t* out, unsigned int n) {
+    approxMagFloat(x, out, n);
+  }
+
+  // The fixed point approximation is scaled down by 2, as
+  // arm_cmplx_mag_q{15,31}, i.e. the coefficients are Q1.15 or Q1.31
+  // and the product is shifted down by 16 or 32.
+  void approxMag(const q31_t* x, q31_t* out, unsigned int n) {
+    const int64_t alpha = std::llround(ambmAlpha * 2147483648.0);
+    const int64_t beta = std::llround(ambmBeta * 2147483648.0);
+    for (unsigned int i = 0; i < n; i++) {
+      const int64_t re = std::abs((int64_t)x[2*i]);
+      const int64_t im = std::abs((int64_t)x[2*i + 1]);
+      const int64_t a = re > im ? alpha * re + beta * im : alpha * im + beta * re;
+      out[i] = (q31_t)(a >> 32);
+    }
+  }
+
+  void approxMag(const q15_t* x, q15_t* out, unsigned int n) {
+    const int32_t alpha = std::lround(ambmAlpha * 32768.0);
+    const int32_t beta = std::lround(ambmBeta * 32768.0);
+    for (unsigned int i = 0; i < n; i++) {
+      const int32_t re = std::abs((int32_t)x[2*i]);
+      const int32_t im = std::abs((int32_t)x[2*i + 1]);
+      const int32_t a = re > im ? alpha * re + beta * im : alpha * im + beta * re;
+      out[i] = (q15_t)(a >> 16);
+    }
+  }
+
+  // 10*log10(2), dB per octave of power
+  const double decibelsPerLog2 = 3.0102999566398120;
+
+  // The floating point dB value of zero power.
+  const double decibelFloor = -300.0;
+
+  // The log2 table has 2^log2TableBits segments.
+  const unsigned int log2TableBits = 6;
+
+  // log2(1 + i/64) in Q16, 0 <= i <= 64. Linear interpolation between
+  // entries is accurate to 1e-4 dB.
+  const std::vector<int32_t>& getLog2Table() {
+    static std::vector<int32_t> table;
+    if (table.empty()) {
+      const unsigned int size = 1 << log2TableBits;
+      for (unsigned int i = 0; i <= size; i++) {
+	table.push_back(std::lround(65536.0 * std::log2(1.0 + (double)i / size)));
+      }
+    }
+    return table;
+  }
+
+  // Convert the power to dB in place.
+  template <typename T> void decibelFloat(T* x, unsigned int n) {
+    const std::vector<int32_t>& table = getLog2Table();
+    const T segments = 1 << log2TableBits;
+    for (unsigned int i = 0; i < n; i++) {
+      if (!(x[i] > 0)) {
+	x[i] = decibelFloor;
+	continue;
+      }
+
+      // x = m * 2^e, 0.5 <= m < 1
+      int e;
+      const T m = std::frexp(x[i], &e);
+      const T t = (2*m - 1) * segments;
+      const unsigned int j = (unsigned int)t;
+      const T log2m = (table[j] + (table[j+1] - table[j]) * (t - j)) / T(65536.0);
+      x[i] = (e - 1 + log2m) * T(decibelsPerLog2);
+    }
+  }
+
+  void decibel(float64_t* x, unsigned int n) {
+    decibelFloat(x, n);
+  }
+
+  void decibel(float32_t* x, unsigned int n) {
+    decibelFloat(x, n);
+  }
+
+  // Convert the fixed point power to dBFS/256 in place. The log2 of
+  // the power is the position of the leading one bit plus the table
+  // lookup (interpolated) of the following bits.
+  template <typename T> void decibelFixed(T* x, unsigned int n) {
+    const int bits = 8*sizeof(T);
+    const std::vector<int32_t>& table = getLog2Table();
+
+    // dB per log2 step scaled to the output format (2^(bits-9) per
+    // dB), Q8
+    const int64_t scale = std::llround(decibelsPerLog2 * ::pow(2.0, bits - 9) * 256.0);
+    const int64_t minValue = -(int64_t(1) << (bits - 1));
+
+    for (unsigned int i = 0; i < n; i++) {
+      if (x[i] <= 0) {
+	x[i] = (T)minValue;
+	continue;
+      }
+
+      const uint32_t v = x[i];
+      const int e = 31 - __builtin_clz(v);
+
+      // the bits following the leading one, Q32
+      const uint32_t f = e == 0 ? 0 : v << (32 - e);
+      const uint32_t j = f >> (32 - log2TableBits);
+      const uint32_t r = (f >> (16 - log2TableBits)) & 0xffff;
+      const int32_t log2m = table[j] + (((table[j+1] - table[j]) * r) >> 16);
+
+      // log2 of the value as a fraction of full scale, Q16
+      const int64_t log2v = ((int64_t)(e - (bits - 1)) << 16) + log2m;
+      x[i] = (T)std::max(minValue, (log2v * scale) >> 24);
+    }
+  }
+
+  void decibel(q31_t* x, unsigned int n) {
+    decibelFixed(x, n);
+  }
+
+  void decibel(q15_t* x, unsigned int n) {
+    decibelFixed(x, n);
+  }
+
+  // the fft name suffix of the output mode
+  const char* outputSuffix(FftOutput output) {
+    switch (output) {
+    case FftOutput::MAGNITUDE_SQUARED:
+      return "_magsq";
+    case FftOutput::ALPHA_MAX_BETA_MIN:
+      return "_ambm";
+    case FftOutput::DECIBEL:
+      return "_db";
+    default:
+      return "";
+    }
+  }
+
   template <typename T> class CmsisFft : public FFT {
 
     CmsisFft();
 
   protected:
 
-    // arm_rfft* inverse fft flag
-    const uint8_t ifftFlag = 0;
-
-    // arm_rfft* bit reverse flag
-    const uint32_t bitReverseFlag = 1;
-
     // the data type name
     const std::string name;
 
-    // the waveform length
+    // the frame length
     const unsigned int length;
+
+    // the number of frames
+    const unsigned int batchSize;
   
-    // the input vector, it will be modified by fft processing
+    // the input frames, back to back, they will be modified by fft
+    // processing
     std::unique_ptr<std::vector<T>> waveform;
 
-    CmsisFft(const char* name, std::unique_ptr<std::vector<T>> waveform)
+    // the cached forward fft plan (owned by the plan registry), shared
+    // by all frames of the batch
+    FftPlan<T>* plan = nullptr;
+
+    static unsigned int frameLength(unsigned int waveformSize, unsigned int batchSize) {
+      if (batchSize == 0 || waveformSize % batchSize != 0) {
+	throw Ex("fft waveform size is not a multiple of the batch size");
+      }
+      return waveformSize / batchSize;
+    }
+
+    CmsisFft(const std::string& name, std::unique_ptr<std::vector<T>> waveform, unsigned int batchSize)
       : name(name),
-	waveform(std::move(waveform)),
-	length(waveform->size())
+	length(frameLength(waveform->size(), batchSize)),
+	batchSize(batchSize),
+	waveform(std::move(waveform))
     {}
 
-    void checkArmInitStatus(arm_status status) {
-      if (status == ARM_MATH_ARGUMENT_ERROR) {
-	throw Ex("arm " + name + " fft length not supported");
-      }
-      else if (status != ARM_MATH_SUCCESS) {
-	throw Ex("arm " + name + " fft init error");
-      }
+    FftPlan<T>& getPlan() {
+      prepare();
+      return *plan;
     }
 
     virtual std::string toString(const T& val) const = 0;
 
+    void checkFrame(unsigned int frame) const {
+      if (frame >= batchSize) {
+	throw Ex(name + " frame index out of range");
+      }
+    }
+
   public:
 
+    virtual void prepare() {
+      if (plan == nullptr) {
+	plan = &getFftPlan<T>(length, FftDirection::FORWARD);
+      }
+    }
+
+    virtual unsigned long getPlanInitTime() const {
+      return plan == nullptr ? 0 : plan->getInitTime();
+    }
+
     virtual void deleteWaveform() {
       waveform.reset();
     }
@@ -58,6 +271,10 @@ namespace {
     virtual unsigned int getLength() const {
       return length;
     }
+
+    virtual unsigned int getBatchSize() const {
+      return batchSize;
+    }
   
     virtual const std::string& getName() const {
       return name;
@@ -72,54 +289,85 @@ namespace {
 
     enum FftOutputWidth { HALF=1, FULL=2 };
 
-    // This is the ouput buffer passed to the arm_rfft* call.
+    // This is the ouput buffer passed to the arm_rfft* call. It's
+    // scratch space shared by all frames of the batch.
     std::vector<T> fft;
 
-    // This is the output array passed to the arm_mag* call.
+    // This is the output matrix passed to the arm_mag* calls, one row
+    // of magSize values per frame.
     std::vector<T> mag;
 
+    // The magnitude row size, half the size of the fft output buffer.
+    const unsigned int magSize;
+
     // The FFT output width, full or half.
     FftOutputWidth fftOutputWidth;
 
+    // The output computed from the spectrum.
+    const FftOutput output;
+
     // Allocate fft and magnitude output buffers. Set fftOutputWidth to
-    // FULL to allcoate fft ouput buffer space for waveform->size()
-    // complex pairs in the fft output buffer. Set fftOutputWidth to
-    // HALF to allocate space for waveform->size() complex pairs in the
-    // fft output buffer. The magnitude buffer is always half the size
-    // of the fft output buffer.
-    RealFft(const char* name, std::unique_ptr<std::vector<T>> waveform, FftOutputWidth fftOutputWidth)
-      : CmsisFft<T>(name, std::move(waveform)),
-	fft(this->waveform->size() * fftOutputWidth),
-	mag(this->fft.size() / 2),
-	fftOutputWidth(fftOutputWidth)
+    // FULL to allcoate fft ouput buffer space for length complex pairs
+    // in the fft output buffer. Set fftOutputWidth to HALF to allocate
+    // space for length/2 complex pairs in the fft output buffer. The
+    // magnitude row is always half the size of the fft output buffer.
+    RealFft(const char* name, std::unique_ptr<std::vector<T>> waveform, unsigned int batchSize, FftOutputWidth fftOutputWidth, FftOutput output)
+      : CmsisFft<T>(std::string(name) + outputSuffix(output), std::move(waveform), batchSize),
+	fft(this->length * fftOutputWidth),
+	mag(this->batchSize * this->fft.size() / 2),
+	magSize(this->fft.size() / 2),
+	fftOutputWidth(fftOutputWidth),
+	output(output)
     {}
 
+    // Compute the output over the fft buffer into the magnitude row of
+    // a frame.
+    void computeOutput(unsigned int frame) {
+      T* row = mag.data() + frame*magSize;
+      switch (output) {
+      case FftOutput::MAGNITUDE:
+	cmplxMag(fft.data(), row, magSize);
+	break;
+      case FftOutput::MAGNITUDE_SQUARED:
+	cmplxMagSquared(fft.data(), row, magSize);
+	break;
+      case FftOutput::ALPHA_MAX_BETA_MIN:
+	approxMag(fft.data(), row, magSize);
+	break;
+      case FftOutput::DECIBEL:
+	cmplxMagSquared(fft.data(), row, magSize);
+	decibel(row, magSize);
+	break;
+      }
+    }
+
   public:
 
-    virtual std::unique_ptr<std::vector<float>> getNormalizedWaveform() const {
-      auto normalizedWaveform = std::make_unique<std::vector<float>>(this->waveform->size());
-      int i = 0;
-      for (auto x: *this->waveform) {
-	normalizedWaveform->at(i++) = x;
-      }
-      return normalizedWaveform;
+    virtual unsigned int getPeakBytes() const {
+      return (this->length * this->batchSize + fft.size() + mag.size()) * sizeof(T);
+    }
+
+    virtual std::unique_ptr<std::vector<float>> getNormalizedWaveform(unsigned int frame) const {
+      this->checkFrame(frame);
+      auto begin = this->waveform->cbegin() + frame * this->length;
+      return std::make_unique<std::vector<float>>(begin, begin + this->length);
     }
 
     virtual void dump() const {
       for( int i = 0; i < mag.size(); i++ ) {
-	printf("%s mag[%d] %s %s\n", this->name.c_str(), i, this->toString(mag[i]).c_str());
+	printf("%s mag[%d] %s\n", this->name.c_str(), i, this->toString(mag[i]).c_str());
       }
       printf("\n");
     }
 
-    // Return the output of arm_rfft_{f32,f64,q15,q31}. The values are
-    // packed complex pairs.
+    // Return the output of arm_rfft_{f32,f64,q15,q31} for the last
+    // frame of the batch. The values are packed complex pairs.
     const std::vector<T>& getFFT() const {
       return fft;
     }
 
     // Get the output of arm_cmplx_mag_{f32,f64,q15,q31) computed over
-    // the arm_rfft_{f32,f64,q15,q31} output (as provided by getFFT()).
+    // the arm_rfft_{f32,f64,q15,q31} output, one row per frame.
     const std::vector<T>& getMagnitude() const {
       return mag;
     }
@@ -137,43 +385,69 @@ namespace {
 
   protected:
 
-    // The N/2 FFT component that was encoded in the
+    // The N/2 FFT component of each frame that was encoded in the
     // arm_rfft_fast_f{32,64} output buffer at index 1.
-    T nyquistFrequencyComponent = 0;
+    std::vector<T> nyquistFrequencyComponents;
 
   public:
   
-    RealFloatFft(const char* name, std::unique_ptr<std::vector<T>> waveform)
-      : RealFft<T>(name, std::move(waveform), RealFft<T>::FftOutputWidth::HALF)
+    RealFloatFft(const char* name, std::unique_ptr<std::vector<T>> waveform, unsigned int batchSize, FftOutput output)
+      : RealFft<T>(name, std::move(waveform), batchSize, RealFft<T>::FftOutputWidth::HALF, output),
+	nyquistFrequencyComponents(this->batchSize)
     {}
 
+    // The magnitude of an output value.
+    float toMagnitude(T value) const {
+      switch (this->output) {
+      case FftOutput::MAGNITUDE_SQUARED:
+	return std::sqrt(value);
+      case FftOutput::DECIBEL:
+	return std::pow(10.0, value / 20.0);
+      default:
+	return value;
+      }
+    }
+
     // Nothing to do for the floating point implementation. Just copy
     // the data and allow the compiler to do implicity double to float
     // if necessary.
-    virtual std::unique_ptr<std::vector<float>> getNormalizedMagnitude() const {
-      unsigned int len = 2*this->mag.size();
+    virtual std::unique_ptr<std::vector<float>> getNormalizedMagnitude(unsigned int frame) const {
+      this->checkFrame(frame);
+      const T* row = this->mag.data() + frame * this->magSize;
+
+      unsigned int len = 2*this->magSize;
       auto scaledMag = std::make_unique<std::vector<float>>(len);
 
       // frequency range 0 <= n < N/2
       int n = 0;
       for (; n < len/2; n++) {
-	scaledMag->at(n) = this->mag.at(n);
+	scaledMag->at(n) = toMagnitude(row[n]);
       }
 
       // nyquist frequency n = N/2
-      scaledMag->at(n++) = nyquistFrequencyComponent;
+      scaledMag->at(n++) = nyquistFrequencyComponents.at(frame);
 
       // symmetric frequency range N/2 < n <= N-1
-      for (int j=this->mag.size()-1; j > 1; j--) {
-	scaledMag->at(n++) = this->mag.at(j);
+      for (int j=this->magSize-1; j > 1; j--) {
+	scaledMag->at(n++) = toMagnitude(row[j]);
       }
     
       return scaledMag;
     }
 
-    // The Nyquist frequency component value (the N/2 real value).
-    T getNyquistFrequencyComponent() const {
-      return nyquistFrequencyComponent;
+    // The Nyquist frequency component value (the N/2 real value) of a
+    // frame.
+    T getNyquistFrequencyComponent(unsigned int frame = 0) const {
+      return nyquistFrequencyComponents.at(frame);
+    }
+
+    virtual unsigned int getPeakBytes() const {
+      return RealFft<T>::getPeakBytes() + nyquistFrequencyComponents.size() * sizeof(T);
+    }
+
+    virtual int getExponent(unsigned int frame) const {
+      this->checkFrame(frame);
+      return 0;
     }
   };
 
@@ -181,20 +455,33 @@ namespace {
 
     RealFixedFft();
 
+  protected:
+
+    RealFixedFft(const char* name, std::unique_ptr<std::vector<T>> waveform, unsigned int batchSize, typename RealFft<T>::FftOutputWidth fftOutputWidth, FftOutput output)
+      : RealFft<T>(name, std::move(waveform), batchSize, fftOutputWidth, output)
+    {}
+
   public:
   
-    RealFixedFft(const char* name, std::unique_ptr<std::vector<T>> waveform)
-      : RealFft<T>(name, std::move(waveform), RealFft<T>::FftOutputWidth::FULL)
+    RealFixedFft(const char* name, std::unique_ptr<std::vector<T>> waveform, unsigned int batchSize, FftOutput output)
+      : RealFixedFft<T>(name, std::move(waveform), batchSize, RealFft<T>::FftOutputWidth::FULL, output)
     {}
 
+    // arm_rfft_q{15,31} scales the spectrum down by N.
+    virtual int getExponent(unsigned int frame) const {
+      this->checkFrame(frame);
+      return std::lround(std::log2(this->length));
+    }
+
     // The scale of fixed point q15_t and q31_t types is is 2^15 and
     // q31_t is 2^31. Which can be calculated as 2^(8*sizeof(T)-1).
-    virtual std::unique_ptr<std::vector<float>> getNormalizedWaveform() const {
-      auto normalizedWaveform = std::make_unique<std::vector<float>>(this->waveform->size());
+    virtual std::unique_ptr<std::vector<float>> getNormalizedWaveform(unsigned int frame) const {
+      this->checkFrame(frame);
+      auto normalizedWaveform = std::make_unique<std::vector<float>>(this->length);
       float scale = ::powf(2.0, 8*sizeof(T)-1);
-      int i = 0;
-      for (auto x: *this->waveform) {
-	normalizedWaveform->at(i++) = x / scale;
+      const T* x = this->waveform->data() + frame * this->length;
+      for (unsigned int i = 0; i < this->length; i++) {
+	normalizedWaveform->at(i) = x[i] / scale;
       }
       return normalizedWaveform;
     }
@@ -232,16 +519,40 @@ namespace {
     // Such that:
     //
     // scaledMagnitude = fixedPointMagnitude / scale
+    //
+    // The spectrum values are the scaledMagnitude divided by N (as a
+    // fraction of full scale), and scaled up by 2 in the magnitude.
+    // The arm_cmplx_mag_squared_q{15,31} power is Q3.13 or Q3.29 of the
+    // spectrum values, so:
+    //
+    // scaledMagnitude = sqrt(fixedPointPower / 2^(8*sizeof(T)-3)) * N
+    //
+    // The DECIBEL output is the dBFS/256 of the fixed point power, the
+    // same magnitude as a fraction of full scale is:
+    //
+    // scaledMagnitude = 2 * N * 10^(dB/20)
   
-    virtual std::unique_ptr<std::vector<float>> getNormalizedMagnitude() const {
+    virtual std::unique_ptr<std::vector<float>> getNormalizedMagnitude(unsigned int frame) const {
+      this->checkFrame(frame);
       float m = 2.0 + log2(this->length);
       float n = 8.0*sizeof(T) - m;
       float scale = ::powf(2.0, n);
-
-      auto scaledMag = std::make_unique<std::vector<float>>(this->mag.size());
-      int i = 0;
-      for(auto x: this->mag) {
-	scaledMag->at(i++) = x / scale;
+      float fullScale = ::powf(2.0, 8*sizeof(T)-1);
+
+      auto scaledMag = std::make_unique<std::vector<float>>(this->magSize);
+      const T* row = this->mag.data() + frame * this->magSize;
+      for (unsigned int i = 0; i < this->magSize; i++) {
+	switch (this->output) {
+	case FftOutput::MAGNITUDE_SQUARED:
+	  scaledMag->at(i) = std::sqrt(4.0f * row[i] / fullScale) * this->length;
+	  break;
+	case FftOutput::DECIBEL:
+	  scaledMag->at(i) = 2.0f * this->length * std::pow(10.0f, row[i] * 256.0f / fullScale / 20.0f);
+	  break;
+	default:
+	  scaledMag->at(i) = row[i] / scale;
+	  break;
+	}
       }
 
       return scaledMag;
@@ -254,25 +565,25 @@ namespace {
   
   public:
   
-    Float64Fft(std::unique_ptr<std::vector<float64_t>> waveform)
-      : RealFloatFft<float64_t>("f64", std::move(waveform))
+    Float64Fft(std::unique_ptr<std::vector<float64_t>> waveform, unsigned int batchSize, FftOutput output)
+      : RealFloatFft<float64_t>("f64", std::move(waveform), batchSize, output)
     {}
 
     virtual void execute() {
       // sanity check the fft output buffer size
-      if (fft.size() != waveform->size()) {
+      if (fft.size() != length) {
 	throw Ex("f64 sanity");
       }
     
-      arm_rfft_fast_instance_f64 inst;    
+      FftPlan<float64_t>& plan = getPlan();
 
-      checkArmInitStatus( arm_rfft_fast_init_f64(&inst, waveform->size()) );
-    
-      arm_rfft_fast_f64(&inst, waveform->data(), fft.data(), ifftFlag);
-      nyquistFrequencyComponent = fft[1];
-      fft[1] = 0.0;
+      for (unsigned int i = 0; i < batchSize; i++) {
+	arm_rfft_fast_f64(&plan.getInstance(), waveform->data() + i*length, fft.data(), plan.getIfftFlag());
+	nyquistFrequencyComponents[i] = fft[1];
+	fft[1] = 0.0;
 
-      arm_cmplx_mag_f64(fft.data(), mag.data(), mag.size());
+	computeOutput(i);
+      }
     }
 
     virtual std::string toString(const float64_t& val) const {
@@ -288,25 +599,25 @@ namespace {
   
   public:
   
-    Float32Fft(std::unique_ptr<std::vector<float32_t>> waveform)
-      : RealFloatFft<float32_t>("f32", std::move(waveform))
+    Float32Fft(std::unique_ptr<std::vector<float32_t>> waveform, unsigned int batchSize, FftOutput output)
+      : RealFloatFft<float32_t>("f32", std::move(waveform), batchSize, output)
     {}
   
     virtual void execute() {
       // sanity check the fft output buffer size
-      if (fft.size() != waveform->size()) {
+      if (fft.size() != length) {
 	throw Ex("f32 sanity");
       }
 
-      arm_rfft_fast_instance_f32 inst;    
+      FftPlan<float32_t>& plan = getPlan();
 
-      checkArmInitStatus( arm_rfft_fast_init_f32(&inst, waveform->size()) );
+      for (unsigned int i = 0; i < batchSize; i++) {
+	arm_rfft_fast_f32(&plan.getInstance(), waveform->data() + i*length, fft.data(), plan.getIfftFlag());
+	nyquistFrequencyComponents[i] = fft[1];
+	fft[1] = 0.0;
 
-      arm_rfft_fast_f32(&inst, waveform->data(), fft.data(), ifftFlag);
-      nyquistFrequencyComponent = fft[1];
-      fft[1] = 0.0;
-
-      arm_cmplx_mag_f32(fft.data(), mag.data(), mag.size());
+	computeOutput(i);
+      }
     }
 
     virtual std::string toString(const float32_t& val) const {
@@ -322,23 +633,25 @@ namespace {
   
   public:
   
-    Q31Fft(std::unique_ptr<std::vector<q31_t>> waveform)
-      : RealFixedFft<q31_t>("q31", std::move(waveform))
+    Q31Fft(std::unique_ptr<std::vector<q31_t>> waveform, unsigned int batchSize, FftOutput output)
+      : RealFixedFft<q31_t>("q31", std::move(waveform), batchSize, output)
     {}
   
     virtual void execute() {
       // sanity check the fft output buffer size
-      if (fft.size() != 2*waveform->size()) {
+      if (fft.size() != 2*length) {
 	throw Ex("q31 sanity");
       }
 
-      arm_rfft_instance_q31 inst;
+      FftPlan<q31_t>& plan = getPlan();
 
-      checkArmInitStatus(arm_rfft_init_q31(&inst, waveform->size(), ifftFlag, bitReverseFlag));
+      for (unsigned int i = 0; i < batchSize; i++) {
+	instrument::recordInput("rfft", name, waveform->data() + i*length, length);
+	arm_rfft_q31(&plan.getInstance(), waveform->data() + i*length, fft.data());
+	instrument::recordOutput("rfft", name, fft.data(), 2*length);
 
-      arm_rfft_q31(&inst, waveform->data(), fft.data());
-
-      arm_cmplx_mag_q31(fft.data(), mag.data(), mag.size());
+	computeOutput(i);
+      }
     }
 
     virtual std::string toString(const q31_t& val) const {
@@ -355,23 +668,25 @@ namespace {
   
   public:
   
-    Q15Fft(std::unique_ptr<std::vector<q15_t>> waveform)
-      : RealFixedFft<q15_t>("q15", std::move(waveform))
+    Q15Fft(std::unique_ptr<std::vector<q15_t>> waveform, unsigned int batchSize, FftOutput output)
+      : RealFixedFft<q15_t>("q15", std::move(waveform), batchSize, output)
     {}
   
     virtual void execute() {
       // sanity check the fft output buffer size
-      if (fft.size() != 2*waveform->size()) {
+      if (fft.size() != 2*length) {
 	throw Ex("q15 sanity");
       }
 
-      arm_rfft_instance_q15 inst;
-
-      checkArmInitStatus(arm_rfft_init_q15(&inst, waveform->size(), ifftFlag, bitReverseFlag));
+      FftPlan<q15_t>& plan = getPlan();
 
-      arm_rfft_q15(&inst, waveform->data(), fft.data());
+      for (unsigned int i = 0; i < batchSize; i++) {
+	instrument::recordInput("rfft", name, waveform->data() + i*length, length);
+	arm_rfft_q15(&plan.getInstance(), waveform->data() + i*length, fft.data());
+	instrument::recordOutput("rfft", name, fft.data(), 2*length);
 
-      arm_cmplx_mag_q15(fft.data(), mag.data(), mag.size());
+	computeOutput(i);
+      }
     }
 
     virtual std::string toString(const q15_t& val) const {
@@ -381,20 +696,918 @@ namespace {
     }
   };
 
+  void cfft(const arm_cfft_instance_f64& instance, float64_t* x) {
+    arm_cfft_f64(&instance, x, 0, 1);
+  }
+
+  void cfft(const arm_cfft_instance_f32& instance, float32_t* x) {
+    arm_cfft_f32(&instance, x, 0, 1);
+  }
+
+  void cfft(const arm_cfft_instance_q31& instance, q31_t* x) {
+    arm_cfft_q31(&instance, x, 0, 1);
+  }
+
+  void cfft(const arm_cfft_instance_q15& instance, q15_t* x) {
+    arm_cfft_q15(&instance, x, 0, 1);
+  }
+
+  // The in-place real fft. Each frame of N real values is transformed
+  // as N/2 complex values z[n] = x[2n] + j*x[2n+1] by arm_cfft_f{32,64}
+  // (in place), then split into the real fft spectrum X[0..N/2], packed
+  // as arm_rfft_fast_f{32,64} packs it, and finally the magnitude of
+  // bins 0..N/2-1 is written over the start of the frame.
+  template <typename T> class InPlaceFloatFft : public CmsisFft<T> {
+
+    InPlaceFloatFft();
+
+    // the cached N/2 point complex fft plan (owned by the plan registry)
+    ComplexFftPlan<T>* cfftPlan = nullptr;
+
+    // The split step twiddle factors, shared by the complex fft plan
+    // (see ComplexFftPlan::getSplitTwiddle()).
+    const T* twiddle = nullptr;
+
+    // The N/2 FFT component of each frame, packed at index 1 by the
+    // split step.
+    std::vector<T> nyquistFrequencyComponents;
+
+    // the number of magnitudes per frame, N/2
+    const unsigned int magSize;
+
+    // N/2 must be a complex fft length, 16 to 4096.
+    static unsigned int checkLength(unsigned int length) {
+      if (length < 32 || length > 8192 || (length & (length - 1)) != 0) {
+	throw Ex("in-place fft size not supported");
+      }
+      return length;
+    }
+
+    // Unpack the real fft spectrum from the complex fft Z of the even
+    // and odd samples, in place. With E[k] = (Z[k] + conj(Z[N/2-k]))/2
+    // and O[k] = (Z[k] - conj(Z[N/2-k]))/2j, X[k] = E[k] + W^k*O[k]
+    // and X[N/2-k] = conj(E[k] - W^k*O[k]), so each pair of bins is
+    // computed from the same pair of inputs.
+    void split(T* x) const {
+      const unsigned int m = this->length / 2;
+
+      // X[0] and X[N/2] are real, packed as the first pair
+      const T z0Re = x[0];
+      const T z0Im = x[1];
+      x[0] = z0Re + z0Im;
+      x[1] = z0Re - z0Im;
+
+      // X[N/4] = conj(Z[N/4])
+      x[m + 1] = -x[m + 1];
+
+      for (unsigned int k = 1; k < m / 2; k++) {
+	T* a = x + 2*k;
+	T* b = x + 2*(m - k);
+
+	const T eRe = (a[0] + b[0]) * T(0.5);
+	const T eIm = (a[1] - b[1]) * T(0.5);
+	const T oRe = (a[1] + b[1]) * T(0.5);
+	const T oIm = (b[0] - a[0]) * T(0.5);
+
+	const T c = twiddle[2*k];
+	const T s = twiddle[2*k + 1];
+	const T tRe = oRe * c + oIm * s;
+	const T tIm = oIm * c - oRe * s;
+
+	a[0] = eRe + tRe;
+	a[1] = eIm + tIm;
+	b[0] = eRe - tRe;
+	b[1] = tIm - eIm;
+      }
+    }
+
+  protected:
+
+    virtual std::string toString(const T& val) const {
+      std::stringstream ss;
+      ss << val;
+      return ss.str();
+    }
+
+  public:
+
+    InPlaceFloatFft(const char* name, std::unique_ptr<std::vector<T>> waveform, unsigned int batchSize)
+      : CmsisFft<T>(name, std::move(waveform), batchSize),
+	nyquistFrequencyComponents(this->batchSize),
+	magSize(this->length / 2)
+    {
+      checkLength(this->length);
+    }
+
+    virtual void prepare() {
+      if (cfftPlan == nullptr) {
+	cfftPlan = &getComplexFftPlan<T>(this->length / 2);
+	twiddle = cfftPlan->getSplitTwiddle().data();
+      }
+    }
+
+    virtual unsigned long getPlanInitTime() const {
+      return cfftPlan == nullptr ? 0 : cfftPlan->getInitTime() + cfftPlan->getSplitTwiddleInitTime();
+    }
+
+    virtual void execute() {
+      prepare();
+
+      for (unsigned int i = 0; i < this->batchSize; i++) {
+	T* x = this->waveform->data() + i*this->length;
+
+	instrument::recordInput("cfft", this->name, x, this->length);
+	cfft(cfftPlan->getInstance(), x);
+	instrument::recordOutput("cfft", this->name, x, this->length);
+	split(x);
+
+	nyquistFrequencyComponents[i] = x[1];
+	x[1] = 0.0;
+
+	// arm_cmplx_mag_f{32,64} reads ahead of where it writes, so the
+	// magnitude can overwrite the spectrum
+	cmplxMag(x, x, magSize);
+      }
+    }
+
+    // the waveform buffer holds the magnitudes
+    virtual void deleteWaveform() {
+    }
+
+    virtual unsigned int getPeakBytes() const {
+      return (this->length * this->batchSize + this->length / 2 + this->batchSize) * sizeof(T);
+    }
+
+    virtual int getExponent(unsigned int frame) const {
+      this->checkFrame(frame);
+      return 0;
+    }
+
+    virtual std::unique_ptr<std::vector<float>> getNormalizedWaveform(unsigned int frame) const {
+      this->checkFrame(frame);
+      auto begin = this->waveform->cbegin() + frame * this->length;
+      return std::make_unique<std::vector<float>>(begin, begin + this->length);
+    }
+
+    // The full band magnitude, as RealFloatFft.
+    virtual std::unique_ptr<std::vector<float>> getNormalizedMagnitude(unsigned int frame) const {
+      this->checkFrame(frame);
+      const T* row = this->waveform->data() + frame * this->length;
+
+      auto scaledMag = std::make_unique<std::vector<float>>(this->length);
+
+      // frequency range 0 <= n < N/2
+      unsigned int n = 0;
+      for (; n < magSize; n++) {
+	scaledMag->at(n) = row[n];
+      }
+
+      // nyquist frequency n = N/2
+      scaledMag->at(n++) = nyquistFrequencyComponents.at(frame);
+
+      // symmetric frequency range N/2 < n <= N-1
+      for (unsigned int j = magSize - 1; j >= 1; j--) {
+	scaledMag->at(n++) = row[j];
+      }
+
+      return scaledMag;
+    }
+
+    virtual void dump() const {
+      for (unsigned int i = 0; i < this->batchSize; i++) {
+	const T* row = this->waveform->data() + i * this->length;
+	for (unsigned int j = 0; j < magSize; j++) {
+	  printf("%s mag[%d] %s\n", this->name.c_str(), i * magSize + j, toString(row[j]).c_str());
+	}
+      }
+      printf("\n");
+    }
+  };
+
+  // The product and sum type of the block floating point fft, wide
+  // enough for a full product of two values.
+  template <typename T> struct BfpWide;
+  template <> struct BfpWide<q15_t> { typedef int32_t type; };
+  template <> struct BfpWide<q31_t> { typedef int64_t type; };
+
+  // The block floating point real fft, a RealFixedFft with its own
+  // transform and scaling. Each frame is copied into the
+  // fft buffer as N/2 complex values z[n] = x[2n] + j*x[2n+1] in bit
+  // reversed order, shifted up to the block limit, then transformed by
+  // log2(N/2) radix-2 decimation in time stages and split into the
+  // real fft spectrum (as InPlaceFloatFft::split()), packed as
+  // arm_rfft_fast_f{32,64} packs it.
+  //
+  // Before each stage the block is shifted down by the fewest bits
+  // that bring its peak component below the limit, 0.4 of full scale.
+  // A butterfly output component is at most (1 + sqrt(2)) times the
+  // peak, 0.966 of full scale, so the stage can't overflow. The peak
+  // of the next stage is tracked as the butterflies are computed. The
+  // initial shift up counts down the exponent, each shift down counts
+  // it up.
+  template <typename T> class BfpFft : public RealFixedFft<T> {
+
+    BfpFft();
+
+    typedef typename BfpWide<T>::type Wide;
+
+    static constexpr unsigned int fracBits = 8*sizeof(T) - 1;
+
+    // the block peak limit, 0.4 of full scale
+    static constexpr Wide limit = (Wide(1) << fracBits) * 2 / 5;
+
+    // W^k = exp(-2*pi*j*k/N) for 0 <= k < N/2, stored as (cos, sin)
+    // pairs. The N/2 point complex fft stages use the even entries.
+    std::vector<T> twiddle;
+
+    // the bit reversed index of each complex fft input
+    std::vector<uint16_t> bitReverse;
+
+    // the time to build the tables (us)
+    unsigned long tableInitTime = 0;
+
+    // the block exponent of each frame
+    std::vector<int> exponents;
+
+    // The N/2 FFT component of each frame, packed at index 1 by the
+    // split step.
+    std::vector<T> nyquistFrequencyComponents;
+
+    static unsigned int checkLength(unsigned int length) {
+      if (length < 32 || length > 8192 || (length & (length - 1)) != 0) {
+	throw Ex("bfp fft size not supported");
+      }
+      return length;
+    }
+
+    // the shift down that brings the peak below the limit
+    static unsigned int headroomShift(Wide peak) {
+      unsigned int shift = 0;
+      while ((peak >> shift) >= limit) {
+	shift++;
+      }
+      return shift;
+    }
+
+    // rounding shift down
+    static Wide shiftDown(Wide x, unsigned int shift) {
+      return shift == 0 ? x : (x + (Wide(1) << (shift - 1))) >> shift;
+    }
+
+    // the rounded fixed point product sum (a*c + b*s)
+    static Wide mulAdd(Wide a, Wide c, Wide b, Wide s) {
+      return (a * c + b * s + (Wide(1) << (fracBits - 1))) >> fracBits;
+    }
+
+    static Wide absolute(Wide x) {
+      return x < 0 ? -x : x;
+    }
+
+    // Transform one frame into the fft buffer, return the block
+    // exponent.
+    int transform(const T* in, T* x) const {
+      const unsigned int m = this->length / 2;
+
+      Wide peak = 0;
+      for (unsigned int n = 0; n < this->length; n++) {
+	peak = std::max(peak, absolute(in[n]));
+      }
+
+      unsigned int up = 0;
+      if (peak > 0) {
+	while ((peak << (up + 1)) < limit) {
+	  up++;
+	}
+      }
+      int exponent = -(int)up;
+
+      for (unsigned int n = 0; n < m; n++) {
+	const unsigned int k = bitReverse[n];
+	x[2*k] = Wide(in[2*n]) * (Wide(1) << up);
+	x[2*k + 1] = Wide(in[2*n + 1]) * (Wide(1) << up);
+      }
+      peak <<= up;
+
+      for (unsigned int size = 2; size <= m; size *= 2) {
+	const unsigned int shift = headroomShift(peak);
+	exponent += shift;
+	peak = 0;
+
+	const unsigned int half = size / 2;
+	const unsigned int stride = this->length / size;
+	for (unsigned int j = 0; j < half; j++) {
+	  const Wide c = twiddle[2*j*stride];
+	  const Wide s = twiddle[2*j*stride + 1];
+	  for (unsigned int start = j; start < m; start += size) {
+	    T* a = x + 2*start;
+	    T* b = a + 2*half;
+
+	    const Wide aRe = shiftDown(a[0], shift);
+	    const Wide aIm = shiftDown(a[1], shift);
+	    const Wide bRe = shiftDown(b[0], shift);
+	    const Wide bIm = shiftDown(b[1], shift);
+
+	    // t = b*W, W = c - j*s
+	    const Wide tRe = mulAdd(bRe, c, bIm, s);
+	    const Wide tIm = mulAdd(bIm, c, -bRe, s);
+
+	    a[0] = aRe + tRe;
+	    a[1] = aIm + tIm;
+	    b[0] = aRe - tRe;
+	    b[1] = aIm - tIm;
+
+	    peak = std::max({peak, absolute(a[0]), absolute(a[1]), absolute(b[0]), absolute(b[1])});
+	  }
+	}
+      }
+
+      const unsigned int shift = headroomShift(peak);
+      exponent += shift;
+      split(x, shift);
+
+      return exponent;
+    }
+
+    // The split step, as InPlaceFloatFft::split(), with the block shift.
+    // E and O are kept doubled until the final rounding.
+    void split(T* x, unsigned int shift) const {
+      const unsigned int m = this->length / 2;
+
+      // X[0] and X[N/2] are real, packed as the first pair
+      const Wide z0Re = shiftDown(x[0], shift);
+      const Wide z0Im = shiftDown(x[1], shift);
+      x[0] = z0Re + z0Im;
+      x[1] = z0Re - z0Im;
+
+      // X[N/4] = conj(Z[N/4])
+      x[m] = shiftDown(x[m], shift);
+      x[m + 1] = -shiftDown(x[m + 1], shift);
+
+      for (unsigned int k = 1; k < m / 2; k++) {
+	T* a = x + 2*k;
+	T* b = x + 2*(m - k);
+
+	const Wide aRe = shiftDown(a[0], shift);
+	const Wide aIm = shiftDown(a[1], shift);
+	const Wide bRe = shiftDown(b[0], shift);
+	const Wide bIm = shiftDown(b[1], shift);
+
+	const Wide eRe = aRe + bRe;
+	const Wide eIm = aIm - bIm;
+	const Wide oRe = aIm + bIm;
+	const Wide oIm = bRe - aRe;
+
+	const Wide c = twiddle[2*k];
+	const Wide s = twiddle[2*k + 1];
+	const Wide tRe = mulAdd(oRe, c, oIm, s);
+	const Wide tIm = mulAdd(oIm, c, -oRe, s);
+
+	a[0] = (eRe + tRe + 1) >> 1;
+	a[1] = (eIm + tIm + 1) >> 1;
+	b[0] = (eRe - tRe + 1) >> 1;
+	b[1] = (tIm - eIm + 1) >> 1;
+      }
+    }
+
+  protected:
+
+    virtual std::string toString(const T& val) const {
+      std::stringstream ss;
+      ss << "0x" << std::setfill('0') << std::setw(2*sizeof(T)) << std::hex << val;
+      return ss.str();
+    }
+
+  public:
+
+    BfpFft(const char* name, std::unique_ptr<std::vector<T>> waveform)
+      : RealFixedFft<T>(name, std::move(waveform), 1, RealFft<T>::FftOutputWidth::HALF, FftOutput::MAGNITUDE),
+	exponents(this->batchSize),
+	nyquistFrequencyComponents(this->batchSize)
+    {
+      checkLength(this->length);
+    }
+
+    virtual void prepare() {
+      if (twiddle.empty()) {
+	platform::profiling_time_t start = platform::get_profiling_time();
+
+	const double fullScale = ::pow(2.0, fracBits);
+	const double maxValue = fullScale - 1.0;
+	twiddle.resize(this->length);
+	for (unsigned int k = 0; k < this->length / 2; k++) {
+	  const double phase = 2.0 * M_PI * k / this->length;
+	  twiddle[2*k] = std::min(maxValue, std::round(std::cos(phase) * fullScale));
+	  twiddle[2*k + 1] = std::min(maxValue, std::round(std::sin(phase) * fullScale));
+	}
+
+	const unsigned int m = this->length / 2;
+	const unsigned int bits = std::lround(std::log2(m));
+	bitReverse.resize(m);
+	for (unsigned int n = 0; n < m; n++) {
+	  unsigned int r = 0;
+	  for (unsigned int b = 0; b < bits; b++) {
+	    r |= ((n >> b) & 1) << (bits - 1 - b);
+	  }
+	  bitReverse[n] = r;
+	}
+
+	platform::profiling_time_t end = platform::get_profiling_time();
+	tableInitTime = platform::profiling_time_diff(start, end);
+      }
+    }
+
+    virtual unsigned long getPlanInitTime() const {
+      return tableInitTime;
+    }
+
+    virtual void execute() {
+      prepare();
+
+      for (unsigned int i = 0; i < this->batchSize; i++) {
+	instrument::recordInput("rfft", this->name, this->waveform->data() + i*this->length, this->length);
+	exponents[i] = transform(this->waveform->data() + i*this->length, this->fft.data());
+	instrument::recordOutput("rfft", this->name, this->fft.data(), this->fft.size());
+
+	nyquistFrequencyComponents[i] = this->fft[1];
+	this->fft[1] = 0;
+
+	this->computeOutput(i);
+      }
+    }
+
+    virtual int getExponent(unsigned int frame) const {
+      this->checkFrame(frame);
+      return exponents[frame];
+    }
+
+    virtual unsigned int getPeakBytes() const {
+      return RealFft<T>::getPeakBytes()
+	+ (twiddle.size() + nyquistFrequencyComponents.size()) * sizeof(T)
+	+ bitReverse.size() * sizeof(uint16_t)
+	+ exponents.size() * sizeof(int);
+    }
+
+    // The magnitude is arm_cmplx_mag_q{15,31} of the spectrum, Q2.14
+    // or Q2.30, i.e. half the spectrum magnitude as a fraction of full
+    // scale, so the normalized magnitude is the fixed point value as a
+    // fraction of full scale times 2^(exponent+1). The full band as
+    // RealFloatFft.
+    virtual std::unique_ptr<std::vector<float>> getNormalizedMagnitude(unsigned int frame) const {
+      this->checkFrame(frame);
+      const T* row = this->mag.data() + frame * this->magSize;
+      const float fullScale = ::powf(2.0, fracBits);
+      const float scale = ::powf(2.0, exponents[frame] + 1) / fullScale;
+
+      auto scaledMag = std::make_unique<std::vector<float>>(this->length);
+
+      // frequency range 0 <= n < N/2
+      unsigned int n = 0;
+      for (; n < this->magSize; n++) {
+	scaledMag->at(n) = row[n] * scale;
+      }
+
+      // nyquist frequency n = N/2
+      scaledMag->at(n++) = std::fabs(nyquistFrequencyComponents.at(frame) * scale / 2.0f);
+
+      // symmetric frequency range N/2 < n <= N-1
+      for (unsigned int j = this->magSize - 1; j >= 1; j--) {
+	scaledMag->at(n++) = row[j] * scale;
+      }
+
+      return scaledMag;
+    }
+  };
+
+  // The complex fft of interleaved (I, Q) frames, arm_cfft_* in place
+  // over the waveform buffer, then the magnitude of every bin in place
+  // over the spectrum. A complex input spectrum has no symmetry, all N
+  // bins are computed.
+  template <typename T> class ComplexFft : public CmsisFft<T> {
+
+    ComplexFft();
+
+    // the number of complex values per frame
+    const unsigned int points;
+
+    // the cached complex fft plan (owned by the plan registry)
+    ComplexFftPlan<T>* cfftPlan = nullptr;
+
+    // N, the number of (I, Q) pairs, must be a power of two from 16
+    // to 4096.
+    static unsigned int checkFrameValues(unsigned int frameValues) {
+      if (frameValues % 2 != 0) {
+	throw Ex("complex fft waveform size is odd");
+      }
+      const unsigned int points = frameValues / 2;
+      if (points < 16 || points > 4096 || (points & (points - 1)) != 0) {
+	throw Ex("complex fft size not supported");
+      }
+      return points;
+    }
+
+  protected:
+
+    virtual std::string toString(const T& val) const {
+      std::stringstream ss;
+      ss << val;
+      return ss.str();
+    }
+
+    // the normalized magnitude of a magnitude value
+    virtual float toMagnitude(T value) const = 0;
+
+    // a waveform value as a real number
+    virtual float toReal(T value) const = 0;
+
+  public:
+
+    ComplexFft(const char* name, std::unique_ptr<std::vector<T>> waveform)
+      : CmsisFft<T>(name, std::move(waveform), 1),
+	points(checkFrameValues(this->length))
+    {}
+
+    virtual void prepare() {
+      if (cfftPlan == nullptr) {
+	cfftPlan = &getComplexFftPlan<T>(points);
+      }
+    }
+
+    virtual unsigned long getPlanInitTime() const {
+      return cfftPlan == nullptr ? 0 : cfftPlan->getInitTime();
+    }
+
+    virtual void execute() {
+      prepare();
+
+      for (unsigned int i = 0; i < this->batchSize; i++) {
+	T* x = this->waveform->data() + i*this->length;
+
+	instrument::recordInput("cfft", this->name, x, this->length);
+	cfft(cfftPlan->getInstance(), x);
+	instrument::recordOutput("cfft", this->name, x, this->length);
+
+	// arm_cmplx_mag_* reads ahead of where it writes, so the
+	// magnitude can overwrite the spectrum
+	cmplxMag(x, x, points);
+      }
+    }
+
+    // the number of complex values per frame
+    virtual unsigned int getLength() const {
+      return points;
+    }
+
+    // the waveform buffer holds the magnitudes
+    virtual void deleteWaveform() {
+    }
+
+    virtual unsigned int getPeakBytes() const {
+      return this->length * this->batchSize * sizeof(T);
+    }
+
+    // The interleaved (I, Q) values, 2*N per frame.
+    virtual std::unique_ptr<std::vector<float>> getNormalizedWaveform(unsigned int frame) const {
+      this->checkFrame(frame);
+      const T* x = this->waveform->data() + frame * this->length;
+      auto normalizedWaveform = std::make_unique<std::vector<float>>(this->length);
+      for (unsigned int i = 0; i < this->length; i++) {
+	normalizedWaveform->at(i) = toReal(x[i]);
+      }
+      return normalizedWaveform;
+    }
+
+    // The magnitude of bins 0 to N-1.
+    virtual std::unique_ptr<std::vector<float>> getNormalizedMagnitude(unsigned int frame) const {
+      this->checkFrame(frame);
+      const T* row = this->waveform->data() + frame * this->length;
+      auto scaledMag = std::make_unique<std::vector<float>>(points);
+      for (unsigned int i = 0; i < points; i++) {
+	scaledMag->at(i) = toMagnitude(row[i]);
+      }
+      return scaledMag;
+    }
+
+    virtual void dump() const {
+      for (unsigned int i = 0; i < this->batchSize; i++) {
+	const T* row = this->waveform->data() + i * this->length;
+	for (unsigned int j = 0; j < points; j++) {
+	  printf("%s mag[%d] %s\n", this->name.c_str(), i * points + j, toString(row[j]).c_str());
+	}
+      }
+      printf("\n");
+    }
+  };
+
+  template <typename T> class ComplexFloatFft : public ComplexFft<T> {
+
+    ComplexFloatFft();
+
+  protected:
+
+    virtual float toMagnitude(T value) const {
+      return value;
+    }
+
+    virtual float toReal(T value) const {
+      return value;
+    }
+
+  public:
+
+    ComplexFloatFft(const char* name, std::unique_ptr<std::vector<T>> waveform)
+      : ComplexFft<T>(name, std::move(waveform))
+    {}
+
+    virtual int getExponent(unsigned int frame) const {
+      this->checkFrame(frame);
+      return 0;
+    }
+  };
+
+  // arm_cfft_q{15,31} scales the spectrum down by N, as
+  // arm_rfft_q{15,31}, and arm_cmplx_mag_q{15,31} is Q2.14 or Q2.30,
+  // so the normalized magnitude is the fixed point value as a fraction
+  // of full scale times 2*N (see RealFixedFft).
+  template <typename T> class ComplexFixedFft : public ComplexFft<T> {
+
+    ComplexFixedFft();
+
+    const float fullScale = ::powf(2.0, 8*sizeof(T) - 1);
+
+  protected:
+
+    virtual float toMagnitude(T value) const {
+      return value / fullScale * 2.0f * this->getLength();
+    }
+
+    virtual float toReal(T value) const {
+      return value / fullScale;
+    }
+
+  public:
+
+    ComplexFixedFft(const char* name, std::unique_ptr<std::vector<T>> waveform)
+      : ComplexFft<T>(name, std::move(waveform))
+    {}
+
+    virtual int getExponent(unsigned int frame) const {
+      this->checkFrame(frame);
+      return std::lround(std::log2(this->getLength()));
+    }
+  };
+
+  template <typename T> class CmsisSpanFft : public SpanFft<T> {
+
+    CmsisSpanFft();
+
+  protected:
+
+    // the data type name
+    const std::string name;
+
+    const unsigned int length;
+
+    const unsigned int spectrumSize;
+
+    // the cached forward fft plan (owned by the plan registry)
+    FftPlan<T>& plan;
+
+    // the cached inverse fft plan
+    FftPlan<T>& inversePlan;
+
+    virtual void rfft(T* in, T* out) = 0;
+
+    virtual void irfft(T* spectrum, T* out) = 0;
+
+    virtual void mag(T* spectrum, T* out) = 0;
+
+    void checkSize(const char* what, unsigned int actual, unsigned int expected) const {
+      if (actual != expected) {
+	throw Ex(name + " " + what + " span size error");
+      }
+    }
+
+  public:
+
+    CmsisSpanFft(const std::string& name, unsigned int length, unsigned int fftOutputWidth)
+      : name(name),
+	length(length),
+	spectrumSize(length * fftOutputWidth),
+	plan(getFftPlan<T>(length, FftDirection::FORWARD)),
+	inversePlan(getFftPlan<T>(length, FftDirection::INVERSE))
+    {}
+
+    virtual const std::string& getName() const {
+      return name;
+    }
+
+    virtual unsigned int getLength() const {
+      return length;
+    }
+
+    virtual unsigned int getSpectrumSize() const {
+      return spectrumSize;
+    }
+
+    virtual unsigned int getMagnitudeSize() const {
+      return length / 2;
+    }
+
+    virtual void spectrum(Span<T> in, Span<T> out) {
+      checkSize("input", in.size(), length);
+      checkSize("spectrum", out.size(), spectrumSize);
+      instrument::recordInput("rfft", name, in.data(), length);
+      rfft(in.data(), out.data());
+      instrument::recordOutput("rfft", name, out.data(), spectrumSize);
+    }
+
+    virtual void magnitude(Span<T> in, Span<T> scratch, Span<T> out) {
+      checkSize("input", in.size(), length);
+      checkSize("scratch", scratch.size(), spectrumSize);
+      checkSize("magnitude", out.size(), getMagnitudeSize());
+      instrument::recordInput("rfft", name, in.data(), length);
+      rfft(in.data(), scratch.data());
+      instrument::recordOutput("rfft", name, scratch.data(), spectrumSize);
+      mag(scratch.data(), out.data());
+    }
+
+    virtual void inverse(Span<T> spectrum, Span<T> out) {
+      checkSize("spectrum", spectrum.size(), spectrumSize);
+      checkSize("output", out.size(), length);
+      instrument::recordInput("irfft", name, spectrum.data(), spectrumSize);
+      irfft(spectrum.data(), out.data());
+      instrument::recordOutput("irfft", name, out.data(), length);
+    }
+  };
+
+  class Float64SpanFft : public CmsisSpanFft<float64_t> {
+  public:
+
+    Float64SpanFft(unsigned int length)
+      : CmsisSpanFft<float64_t>("f64_span", length, 1)
+    {}
+
+  protected:
+
+    virtual void rfft(float64_t* in, float64_t* out) {
+      arm_rfft_fast_f64(&plan.getInstance(), in, out, plan.getIfftFlag());
+    }
+
+    virtual void irfft(float64_t* spectrum, float64_t* out) {
+      arm_rfft_fast_f64(&inversePlan.getInstance(), spectrum, out, inversePlan.getIfftFlag());
+    }
+
+    virtual void mag(float64_t* spectrum, float64_t* out) {
+      spectrum[1] = 0.0;
+      arm_cmplx_mag_f64(spectrum, out, getMagnitudeSize());
+    }
+  };
+
+  class Float32SpanFft : public CmsisSpanFft<float32_t> {
+  public:
+
+    Float32SpanFft(unsigned int length)
+      : CmsisSpanFft<float32_t>("f32_span", length, 1)
+    {}
+
+  protected:
+
+    virtual void rfft(float32_t* in, float32_t* out) {
+      arm_rfft_fast_f32(&plan.getInstance(), in, out, plan.getIfftFlag());
+    }
+
+    virtual void irfft(float32_t* spectrum, float32_t* out) {
+      arm_rfft_fast_f32(&inversePlan.getInstance(), spectrum, out, inversePlan.getIfftFlag());
+    }
+
+    virtual void mag(float32_t* spectrum, float32_t* out) {
+      spectrum[1] = 0.0f;
+      arm_cmplx_mag_f32(spectrum, out, getMagnitudeSize());
+    }
+  };
+
+  class Q31SpanFft : public CmsisSpanFft<q31_t> {
+  public:
+
+    Q31SpanFft(unsigned int length)
+      : CmsisSpanFft<q31_t>("q31_span", length, 2)
+    {}
+
+  protected:
+
+    virtual void rfft(q31_t* in, q31_t* out) {
+      arm_rfft_q31(&plan.getInstance(), in, out);
+    }
+
+    virtual void irfft(q31_t* spectrum, q31_t* out) {
+      arm_rfft_q31(&inversePlan.getInstance(), spectrum, out);
+    }
+
+    virtual void mag(q31_t* spectrum, q31_t* out) {
+      arm_cmplx_mag_q31(spectrum, out, getMagnitudeSize());
+    }
+  };
+
+  class Q15SpanFft : public CmsisSpanFft<q15_t> {
+  public:
+
+    Q15SpanFft(unsigned int length)
+      : CmsisSpanFft<q15_t>("q15_span", length, 2)
+    {}
+
+  protected:
+
+    virtual void rfft(q15_t* in, q15_t* out) {
+      arm_rfft_q15(&plan.getInstance(), in, out);
+    }
+
+    virtual void irfft(q15_t* spectrum, q15_t* out) {
+      arm_rfft_q15(&inversePlan.getInstance(), spectrum, out);
+    }
+
+    virtual void mag(q15_t* spectrum, q15_t* out) {
+      arm_cmplx_mag_q15(spectrum, out, getMagnitudeSize());
+    }
+  };
+
 } // namespace
   
-std::unique_ptr<FFT> createFloat64Fft(std::unique_ptr<std::vector<float64_t>> waveform) {
-  return std::unique_ptr<FFT>(new Float64Fft(std::move(waveform)));
+std::unique_ptr<FFT> createFloat64Fft(std::unique_ptr<std::vector<float64_t>> waveform, FftOutput output) {
+  return createFloat64FftBatch(std::move(waveform), 1, output);
+}
+
+std::unique_ptr<FFT> createFloat32Fft(std::unique_ptr<std::vector<float32_t>> waveform, FftOutput output) {
+  return createFloat32FftBatch(std::move(waveform), 1, output);
+}
+
+std::unique_ptr<FFT> createQ31Fft(std::unique_ptr<std::vector<q31_t>> waveform, FftOutput output) {
+  return createQ31FftBatch(std::move(waveform), 1, output);
+}
+
+std::unique_ptr<FFT> createQ15Fft(std::unique_ptr<std::vector<q15_t>> waveform, FftOutput output) {
+  return createQ15FftBatch(std::move(waveform), 1, output);
+}
+
+std::unique_ptr<FFT> createFloat64FftBatch(std::unique_ptr<std::vector<float64_t>> waveform, unsigned int batchSize, FftOutput output) {
+  return std::unique_ptr<FFT>(new Float64Fft(std::move(waveform), batchSize, output));
+}
+
+std::unique_ptr<FFT> createFloat32FftBatch(std::unique_ptr<std::vector<float32_t>> waveform, unsigned int batchSize, FftOutput output) {
+  return std::unique_ptr<FFT>(new Float32Fft(std::move(waveform), batchSize, output));
+}
+
+std::unique_ptr<FFT> createQ31FftBatch(std::unique_ptr<std::vector<q31_t>> waveform, unsigned int batchSize, FftOutput output) {
+  return std::unique_ptr<FFT>(new Q31Fft(std::move(waveform), batchSize, output));
+}
+
+std::unique_ptr<FFT> createQ15FftBatch(std::unique_ptr<std::vector<q15_t>> waveform, unsigned int batchSize, FftOutput output) {
+  return std::unique_ptr<FFT>(new Q15Fft(std::move(waveform), batchSize, output));
+}
+
+std::unique_ptr<FFT> createFloat64InPlaceFft(std::unique_ptr<std::vector<float64_t>> waveform) {
+  return std::unique_ptr<FFT>(new InPlaceFloatFft<float64_t>("f64_inplace", std::move(waveform), 1));
+}
+
+std::unique_ptr<FFT> createFloat32InPlaceFft(std::unique_ptr<std::vector<float32_t>> waveform) {
+  return std::unique_ptr<FFT>(new InPlaceFloatFft<float32_t>("f32_inplace", std::move(waveform), 1));
+}
+
+std::unique_ptr<FFT> createQ31BfpFft(std::unique_ptr<std::vector<q31_t>> waveform) {
+  return std::unique_ptr<FFT>(new BfpFft<q31_t>("q31_bfp", std::move(waveform)));
+}
+
+std::unique_ptr<FFT> createQ15BfpFft(std::unique_ptr<std::vector<q15_t>> waveform) {
+  return std::unique_ptr<FFT>(new BfpFft<q15_t>("q15_bfp", std::move(waveform)));
+}
+
+std::unique_ptr<FFT> createFloat64ComplexFft(std::unique_ptr<std::vector<float64_t>> waveform) {
+  return std::unique_ptr<FFT>(new ComplexFloatFft<float64_t>("f64_cfft", std::move(waveform)));
+}
+
+std::unique_ptr<FFT> createFloat32ComplexFft(std::unique_ptr<std::vector<float32_t>> waveform) {
+  return std::unique_ptr<FFT>(new ComplexFloatFft<float32_t>("f32_cfft", std::move(waveform)));
+}
+
+std::unique_ptr<FFT> createQ31ComplexFft(std::unique_ptr<std::vector<q31_t>> waveform) {
+  return std::unique_ptr<FFT>(new ComplexFixedFft<q31_t>("q31_cfft", std::move(waveform)));
+}
+
+std::unique_ptr<FFT> createQ15ComplexFft(std::unique_ptr<std::vector<q15_t>> waveform) {
+  return std::unique_ptr<FFT>(new ComplexFixedFft<q15_t>("q15_cfft", std::move(waveform)));
+}
+
+std::unique_ptr<SpanFft<float64_t>> createFloat64SpanFft(unsigned int length) {
+  return std::unique_ptr<SpanFft<float64_t>>(new Float64SpanFft(length));
 }
 
-std::unique_ptr<FFT> createFloat32Fft(std::unique_ptr<std::vector<float32_t>> waveform) {
-  return std::unique_ptr<FFT>(new Float32Fft(std::move(waveform)));
+std::unique_ptr<SpanFft<float32_t>> createFloat32SpanFft(unsigned int length) {
+  return std::unique_ptr<SpanFft<float32_t>>(new Float32SpanFft(length));
 }
 
-std::unique_ptr<FFT> createQ31Fft(std::unique_ptr<std::vector<q31_t>> waveform) {
-  return std::unique_ptr<FFT>(new Q31Fft(std::move(waveform)));
+std::unique_ptr<SpanFft<q31_t>> createQ31SpanFft(unsigned int length) {
+  return std::unique_ptr<SpanFft<q31_t>>(new Q31SpanFft(length));
 }
 
-std::unique_ptr<FFT> createQ15Fft(std::unique_ptr<std::vector<q15_t>> waveform) {
-  return std::unique_ptr<FFT>(new Q15Fft(std::move(waveform)));
+std::unique_ptr<SpanFft<q15_t>> createQ15SpanFft(unsigned int length) {
+  return std::unique_ptr<SpanFft<q15_t>>(new Q15SpanFft(length));
 }
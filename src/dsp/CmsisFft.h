@@ -4,6 +4,8 @@
 #ifndef PICO_CMSIS_SANDBOX_CMSISFFT_H_INCLUDED
 #define PICO_CMSIS_SANDBOX_CMSISFFT_H_INCLUDED
 
+#include "Span.h"
+
 #include "arm_math.h"
 
 #include <memory>
@@ -42,43 +44,227 @@ frequency component (i.e. the Nyquist frequency) and the complex value
 is implicitly zero. This wrapper explicitly overwrites the index 1
 value with a zero. The prior value is saved to
 "nyquistFrequencyComponent", and this is available via a getter.
+
+An FFT transforms a batch of one or more frames of the same length.
+The frames are contiguous in the waveform vector. A batch shares one
+plan (hence one set of twiddle tables), one fft output scratch buffer
+that each frame is transformed into, and one contiguous magnitude
+matrix with a row per frame. execute() transforms the whole batch in
+one call.
+
+The in-place ffts (f32_inplace and f64_inplace) are the memory
+budgeted alternative. They compute the N point real fft as an N/2
+point complex fft (arm_cfft_f{32,64}) over the waveform buffer itself,
+followed by a split step that unpacks the real fft spectrum in place,
+and then the magnitude in place over the spectrum. The only other
+buffer is the N/4 complex split twiddle factors, held by the cached
+N/2 point complex fft plan and shared by every in-place fft of the
+same length (see FftPlan.h). This takes 1.5*N values of working
+memory rather than the 2.5*N values of the out of place fft, and
+because arm_cfft_f{32,64} supports up to
+4096 complex points it reaches N = 8192, which arm_rfft_fast_f{32,64}
+does not. After execute() the waveform buffer holds the magnitudes, so
+deleteWaveform() does nothing.
+
+The block floating point ffts (q15_bfp and q31_bfp) replace the fixed
+log2(N) bit scale down of arm_rfft_q{15,31} with a shift only where
+it's needed. The input block is first shifted up to use the full
+headroom, then before each radix-2 stage of the N/2 point complex fft
+(and the split step) the block is shifted down only as far as its peak
+requires for the stage not to overflow. The shifts are counted in a
+block exponent per frame, see getExponent(). A quiet input, or a noise
+like input that grows by less than one bit per stage, keeps more
+fractional bits than the fixed scaling.
+
+The complex ffts (f64_cfft, f32_cfft, q31_cfft and q15_cfft) transform
+quadrature (I/Q) frames with arm_cfft_*, using the cached complex fft
+plan (see FftPlan.h). The waveform holds N interleaved (I, Q) pairs,
+getLength() is N, and the magnitude of all N bins is computed in place
+over the waveform buffer, a complex spectrum has no symmetry. Bins
+N/2 to N-1 are the negative frequencies. The magnitudes have the same
+normalization as the real ffts: for a real input (Q = 0) they match
+the real fft magnitude over the full band.
 */
 
 
+/**
+The output computed from the fft spectrum of each frame, bins 0 to
+N/2-1. MAGNITUDE is arm_cmplx_mag_*, which takes a square root per
+bin. The other modes avoid the square root:
+
+MAGNITUDE_SQUARED is the power, arm_cmplx_mag_squared_*. The fixed
+point output is Q3.13 (q15) or Q3.29 (q31) of the spectrum values.
+
+ALPHA_MAX_BETA_MIN approximates the magnitude as alpha*max(|re|,|im|)
++ beta*min(|re|,|im|), with the minimum peak error coefficients (the
+error is at most 4%). It has the same scaling as MAGNITUDE.
+
+DECIBEL is the power in dB (10*log10) by way of a log2 lookup table,
+no log function calls. The floating point output is dB. The fixed
+point output is dB relative to the fixed point power value (dBFS)
+divided by 256, i.e. Q8.7 (q15) or Q8.23 (q31) dB. Zero power is the
+minimum value (-256 dB), or -300 dB for floating point.
+
+getNormalizedMagnitude() converts every mode back to a magnitude.
+*/
+enum class FftOutput { MAGNITUDE, MAGNITUDE_SQUARED, ALPHA_MAX_BETA_MIN, DECIBEL };
+
 class FFT {
 
 public:
 
   virtual ~FFT() {}
 
-  // execute fft processing (note, waveform is modified)
+  // Fetch the cached fft plan, building it if this is the first fft
+  // of this type, length and direction (see FftPlan.h). Optional,
+  // execute() calls it if necessary. Call it before execute() to keep
+  // the plan init cost out of execute().
+  virtual void prepare() = 0;
+
+  // execute fft processing of every frame of the batch (note, waveform
+  // is modified)
   virtual void execute() = 0;
 
+  // The time taken to build the fft plan in us (after prepare() or
+  // execute()). This is the one time cost incurred by the first fft
+  // of this shape.
+  virtual unsigned long getPlanInitTime() const = 0;
+
   // the name of the FFT implementation
   virtual const std::string& getName() const = 0;
 
-  // the waveform length (valid before and after execute())
+  // the frame length, the fft size (valid before and after execute())
   virtual unsigned int getLength() const = 0;
 
-  // get the normalized waveform, fixed point values are scaled to
-  // real (before execute)
-  virtual std::unique_ptr<std::vector<float>> getNormalizedWaveform() const = 0;
+  // the number of frames in the batch
+  virtual unsigned int getBatchSize() const = 0;
+
+  // get the normalized waveform of a frame, fixed point values are
+  // scaled to real (before execute)
+  virtual std::unique_ptr<std::vector<float>> getNormalizedWaveform(unsigned int frame = 0) const = 0;
 
-  // get the fft magnitude normalized such that fixed point magnitude
-  // matches scale of the real fftover the full frequency band (after
-  // execute())
-  virtual std::unique_ptr<std::vector<float>> getNormalizedMagnitude() const = 0;
+  // get the fft magnitude of a frame normalized such that fixed point
+  // magnitude matches scale of the real fftover the full frequency
+  // band (after execute())
+  virtual std::unique_ptr<std::vector<float>> getNormalizedMagnitude(unsigned int frame = 0) const = 0;
+
+  // The spectrum exponent of a frame (after execute()): a spectrum
+  // value is the fixed point value as a fraction of full scale times
+  // 2^exponent. log2(N) for arm_rfft_q{15,31}, the accumulated block
+  // exponent for the block floating point ffts, and 0 for floating
+  // point.
+  virtual int getExponent(unsigned int frame = 0) const = 0;
 
   // Delete the waveform to free memory (optionally, after execute());
   virtual void deleteWaveform() = 0;
+
+  // The peak working memory of execute() in bytes: the waveform and
+  // the buffers the fft allocates (fft output, magnitudes, twiddles).
+  // The CMSIS-DSP constant tables are in flash and are not counted.
+  virtual unsigned int getPeakBytes() const = 0;
   
   // dump the fft magnitudes (after execute())
   virtual void dump() const = 0;
 };
 
-std::unique_ptr<FFT> createFloat64Fft(std::unique_ptr<std::vector<float64_t>> waveform);
-std::unique_ptr<FFT> createFloat32Fft(std::unique_ptr<std::vector<float32_t>> waveform);
-std::unique_ptr<FFT> createQ31Fft(std::unique_ptr<std::vector<q31_t>> waveform);
-std::unique_ptr<FFT> createQ15Fft(std::unique_ptr<std::vector<q15_t>> waveform);
+// Create ffts. The name of an fft with an output other than MAGNITUDE
+// has an output suffix, e.g. f32_magsq, f32_ambm, f32_db.
+std::unique_ptr<FFT> createFloat64Fft(std::unique_ptr<std::vector<float64_t>> waveform, FftOutput output = FftOutput::MAGNITUDE);
+std::unique_ptr<FFT> createFloat32Fft(std::unique_ptr<std::vector<float32_t>> waveform, FftOutput output = FftOutput::MAGNITUDE);
+std::unique_ptr<FFT> createQ31Fft(std::unique_ptr<std::vector<q31_t>> waveform, FftOutput output = FftOutput::MAGNITUDE);
+std::unique_ptr<FFT> createQ15Fft(std::unique_ptr<std::vector<q15_t>> waveform, FftOutput output = FftOutput::MAGNITUDE);
+
+// Create batched ffts of batchSize frames, the waveform holds the
+// frames back to back. The waveform size must be a multiple of
+// batchSize, the frame length is waveform->size()/batchSize. Throws Ex
+// if not.
+std::unique_ptr<FFT> createFloat64FftBatch(std::unique_ptr<std::vector<float64_t>> waveform, unsigned int batchSize, FftOutput output = FftOutput::MAGNITUDE);
+std::unique_ptr<FFT> createFloat32FftBatch(std::unique_ptr<std::vector<float32_t>> waveform, unsigned int batchSize, FftOutput output = FftOutput::MAGNITUDE);
+std::unique_ptr<FFT> createQ31FftBatch(std::unique_ptr<std::vector<q31_t>> waveform, unsigned int batchSize, FftOutput output = FftOutput::MAGNITUDE);
+std::unique_ptr<FFT> createQ15FftBatch(std::unique_ptr<std::vector<q15_t>> waveform, unsigned int batchSize, FftOutput output = FftOutput::MAGNITUDE);
+
+// Create in-place ffts, the waveform size is the fft size, a power of
+// two from 32 to 8192. Throws Ex if the size is not supported.
+std::unique_ptr<FFT> createFloat64InPlaceFft(std::unique_ptr<std::vector<float64_t>> waveform);
+std::unique_ptr<FFT> createFloat32InPlaceFft(std::unique_ptr<std::vector<float32_t>> waveform);
+
+// Create block floating point ffts, the waveform size is the fft size,
+// a power of two from 32 to 8192. Throws Ex if the size is not
+// supported.
+std::unique_ptr<FFT> createQ31BfpFft(std::unique_ptr<std::vector<q31_t>> waveform);
+std::unique_ptr<FFT> createQ15BfpFft(std::unique_ptr<std::vector<q15_t>> waveform);
+
+// Create complex ffts, the waveform holds N interleaved (I, Q) pairs, N
+// is a power of two from 16 to 4096. Throws Ex if the waveform size is
+// odd or N is not supported.
+std::unique_ptr<FFT> createFloat64ComplexFft(std::unique_ptr<std::vector<float64_t>> waveform);
+std::unique_ptr<FFT> createFloat32ComplexFft(std::unique_ptr<std::vector<float32_t>> waveform);
+std::unique_ptr<FFT> createQ31ComplexFft(std::unique_ptr<std::vector<q31_t>> waveform);
+std::unique_ptr<FFT> createQ15ComplexFft(std::unique_ptr<std::vector<q15_t>> waveform);
+
+/**
+Zero copy real fft over caller-owned buffers, e.g. DMA buffers. The
+input, output and scratch buffers are passed as spans, a SpanFft
+holds only the cached fft plan. spectrum() and magnitude() do no heap
+allocation and no copies, they throw Ex if a span has the wrong size.
+
+The input span is used as working memory by arm_rfft_* and is
+modified. arm_rfft_* is not in-place, the input and the spectrum must
+not overlap. arm_cmplx_mag_* is in-place, the magnitude can be written
+over the start of the spectrum.
+
+inverse() transforms a spectrum back to a real waveform with the
+inverse plan of the same length (see FftPlan.h), both plans are
+fetched when the span fft is created. The floating point inverse is
+the inverse DFT, arm_rfft_fast_f* scales it by 1/length, so the
+round trip of spectrum() and inverse() is the identity. The fixed
+point inverse is the inverse DFT of the spectrum values as fractions
+of full scale, and the fixed point forward transform scales down by
+length, so the fixed point round trip is the waveform scaled down by
+length.
+*/
+template <typename T> class SpanFft {
+ public:
+
+  virtual ~SpanFft() {}
+
+  // the name of the FFT implementation
+  virtual const std::string& getName() const = 0;
+
+  // the fft length
+  virtual unsigned int getLength() const = 0;
+
+  // The number of values in the packed spectrum (the arm_rfft_*
+  // output): length for the floating point and 2*length for the fixed
+  // point ffts.
+  virtual unsigned int getSpectrumSize() const = 0;
+
+  // The number of magnitude values, bins 0 to length/2-1.
+  virtual unsigned int getMagnitudeSize() const = 0;
+
+  // Transform the getLength() samples of in into the getSpectrumSize()
+  // values of out, packed as arm_rfft_* packs them.
+  virtual void spectrum(Span<T> in, Span<T> out) = 0;
+
+  // Transform in into scratch (getSpectrumSize() values) and write the
+  // getMagnitudeSize() magnitudes to out. out may be the start of
+  // scratch. The magnitudes have the same scaling as the FFT class
+  // magnitudes, the floating point DC bin excludes the Nyquist
+  // component arm_rfft_fast_f* packs with it.
+  virtual void magnitude(Span<T> in, Span<T> scratch, Span<T> out) = 0;
+
+  // Inverse transform the getSpectrumSize() values of spectrum, packed
+  // as spectrum() packs them, into the getLength() samples of out.
+  // Only bins 0 to length/2 are read. The spectrum span is used as
+  // working memory and is modified.
+  virtual void inverse(Span<T> spectrum, Span<T> out) = 0;
+};
+
+// Create span ffts of the given length, see FftPlan.h regarding
+// supported lengths.
+std::unique_ptr<SpanFft<float64_t>> createFloat64SpanFft(unsigned int length);
+std::unique_ptr<SpanFft<float32_t>> createFloat32SpanFft(unsigned int length);
+std::unique_ptr<SpanFft<q31_t>> createQ31SpanFft(unsigned int length);
+std::unique_ptr<SpanFft<q15_t>> createQ15SpanFft(unsigned int length);
 
 #endif
@@ -0,0 +1,486 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "CmsisResample.h"
+#include "CmsisDecimate.h"
+#include "Instrument.h"
+#include "Ex.h"
+
+#include <algorithm>
+
+namespace {
+
+  template <typename T, typename I> class CmsisInterpolateStream : public ResampleStream<T> {
+
+  protected:
+    // the implementation name
+    const std::string name;
+
+    // the filter
+    std::unique_ptr<std::vector<T>> fir;
+
+    // the interpolation factor
+    const unsigned int L;
+
+    // the largest arm_fir_interpolate_* block size
+    const unsigned int maxBlockSize;
+
+    // arm_fir_interpolate_* state, numTaps/L+maxBlockSize-1 samples
+    std::vector<T> state;
+
+    // the arm_fir_interpolate_* instance
+    I instance;
+
+    void checkArmInitStatus(arm_status status) {
+      if (status == ARM_MATH_LENGTH_ERROR ) {
+	throw Ex("arm " + name + " interpolation filter length is not a multiple of L");
+      }
+      else if (status != ARM_MATH_SUCCESS) {
+	throw Ex("arm " + name + " interpolation init error");
+      }
+    }
+
+    // arm_fir_interpolate_init_* (zeros the state)
+    virtual void init() = 0;
+
+    // arm_fir_interpolate_*
+    virtual void interpolate(const T* in, T* out, unsigned int blockSize) = 0;
+
+  public:
+
+    CmsisInterpolateStream(const std::string& name, std::unique_ptr<std::vector<T>> fir, unsigned int L, unsigned int maxBlockSize)
+      : name(name),
+	fir(std::move(fir)),
+	L(L),
+	maxBlockSize(maxBlockSize),
+	state(L > 0 ? this->fir->size() / L + maxBlockSize - 1 : 0)
+    {
+      // arm_fir_interpolate_instance_* L is uint8_t
+      if (L < 1 || L > 255) {
+	throw Ex("interpolation factor out of range");
+      }
+      if (maxBlockSize == 0) {
+	throw Ex("stream block size is zero");
+      }
+    }
+
+    virtual ~CmsisInterpolateStream() {}
+
+    virtual const std::string& getName() const {
+      return name;
+    }
+
+    virtual unsigned int getL() const {
+      return L;
+    }
+
+    virtual unsigned int getM() const {
+      return 1;
+    }
+
+    virtual unsigned int getOutputSize(unsigned int numSamples) const {
+      return L * numSamples;
+    }
+
+    virtual unsigned int process(const T* in, unsigned int numSamples, T* out) {
+      instrument::recordInput("interpolate", name, in, numSamples);
+      unsigned int n = 0;
+      while (n < numSamples) {
+	unsigned int blockSize = std::min(maxBlockSize, numSamples - n);
+	interpolate(in + n, out + L*n, blockSize);
+	n += blockSize;
+      }
+      instrument::recordOutput("interpolate", name, out, L * numSamples);
+      return L * numSamples;
+    }
+
+    virtual void reset() {
+      init();
+    }
+  };
+
+  class Float32InterpolateStream : public CmsisInterpolateStream<float32_t, arm_fir_interpolate_instance_f32> {
+
+  protected:
+
+    virtual void init() {
+      checkArmInitStatus( arm_fir_interpolate_init_f32(&instance, L, fir->size(), fir->data(), state.data(), maxBlockSize) );
+    }
+
+    virtual void interpolate(const float32_t* in, float32_t* out, unsigned int blockSize) {
+      arm_fir_interpolate_f32(&instance, in, out, blockSize);
+    }
+
+  public:
+
+    Float32InterpolateStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int L, unsigned int maxBlockSize)
+      : CmsisInterpolateStream<float32_t, arm_fir_interpolate_instance_f32>("f32_interp", std::move(fir), L, maxBlockSize)
+    {
+      init();
+    }
+  };
+
+  class Q15InterpolateStream : public CmsisInterpolateStream<q15_t, arm_fir_interpolate_instance_q15> {
+
+  protected:
+
+    virtual void init() {
+      checkArmInitStatus( arm_fir_interpolate_init_q15(&instance, L, fir->size(), fir->data(), state.data(), maxBlockSize) );
+    }
+
+    virtual void interpolate(const q15_t* in, q15_t* out, unsigned int blockSize) {
+      arm_fir_interpolate_q15(&instance, in, out, blockSize);
+    }
+
+  public:
+
+    Q15InterpolateStream(std::unique_ptr<std::vector<q15_t>> fir, unsigned int L, unsigned int maxBlockSize)
+      : CmsisInterpolateStream<q15_t, arm_fir_interpolate_instance_q15>("q15_interp", std::move(fir), L, maxBlockSize)
+    {
+      init();
+    }
+  };
+
+  class Q31InterpolateStream : public CmsisInterpolateStream<q31_t, arm_fir_interpolate_instance_q31> {
+
+  protected:
+
+    virtual void init() {
+      checkArmInitStatus( arm_fir_interpolate_init_q31(&instance, L, fir->size(), fir->data(), state.data(), maxBlockSize) );
+    }
+
+    virtual void interpolate(const q31_t* in, q31_t* out, unsigned int blockSize) {
+      arm_fir_interpolate_q31(&instance, in, out, blockSize);
+    }
+
+  public:
+
+    Q31InterpolateStream(std::unique_ptr<std::vector<q31_t>> fir, unsigned int L, unsigned int maxBlockSize)
+      : CmsisInterpolateStream<q31_t, arm_fir_interpolate_instance_q31>("q31_interp", std::move(fir), L, maxBlockSize)
+    {
+      init();
+    }
+  };
+
+  // Polyphase branch dot products, x and c are phaseLength long. The
+  // accumulator widths match arm_fir_interpolate_*. The q31 result is
+  // saturated and counted in numClipped, record() reports the count
+  // (see Instrument.h).
+  struct Float32Dot {
+    static float32_t dot(const float32_t* x, const float32_t* c, unsigned int n, unsigned long&) {
+      float32_t acc = 0.0f;
+      for (unsigned int i = 0; i < n; i++) {
+	acc += *x++ * *c++;
+      }
+      return acc;
+    }
+
+    static void record(const std::string&, unsigned long, unsigned int) {}
+  };
+
+  struct Q15Dot {
+    static q15_t dot(const q15_t* x, const q15_t* c, unsigned int n, unsigned long&) {
+      q63_t acc = 0;
+      for (unsigned int i = 0; i < n; i++) {
+	acc += (q31_t)*x++ * *c++;
+      }
+      return (q15_t)__SSAT((q31_t)(acc >> 15), 16);
+    }
+
+    static void record(const std::string&, unsigned long, unsigned int) {}
+  };
+
+  struct Q31Dot {
+    static q31_t dot(const q31_t* x, const q31_t* c, unsigned int n, unsigned long& numClipped) {
+      q63_t acc = 0;
+      for (unsigned int i = 0; i < n; i++) {
+	acc += (q63_t)*x++ * *c++;
+      }
+      return instrument::clipQ63ToQ31(acc >> 31, numClipped);
+    }
+
+    static void record(const std::string& name, unsigned long numClipped, unsigned int n) {
+      instrument::recordClipped("q63_to_q31", name, numClipped, n);
+    }
+  };
+
+  // Polyphase rational resampler. Output sample j is at upsampled
+  // time t = j*M. Its newest input sample is x[t/L] and it's computed
+  // with polyphase branch t%L, h[t%L + i*L] for i = 0..phaseLength-1.
+  // The input samples in between are never multiplied by the zeros of
+  // the upsampled waveform, and the output samples that a decimator
+  // would discard are never computed.
+  template <typename T, typename D> class PolyphaseResampleStream : public ResampleStream<T> {
+
+    // the implementation name
+    const std::string name;
+
+    // the interpolation and decimation factors
+    const unsigned int L;
+    const unsigned int M;
+
+    // the polyphase branch length, numTaps/L
+    const unsigned int phaseLength;
+
+    // the largest block of input samples processed at once
+    const unsigned int maxBlockSize;
+
+    // The polyphase branches, branch p is at p*phaseLength. A branch
+    // is in time order (oldest sample first), so the dot product with
+    // the state is sequential.
+    std::vector<T> phases;
+
+    // phaseLength-1 history samples followed by the current block
+    std::vector<T> state;
+
+    // the newest input sample of the next output, relative to the
+    // start of the next block
+    unsigned int next = 0;
+
+    // the polyphase branch of the next output
+    unsigned int phase = 0;
+
+    unsigned int resample(const T* in, unsigned int numSamples, T* out, unsigned long& numClipped) {
+      const unsigned int history = phaseLength - 1;
+      std::copy(in, in + numSamples, state.begin() + history);
+
+      unsigned int outCount = 0;
+      while (next < numSamples) {
+	out[outCount++] = D::dot(state.data() + next, phases.data() + phase*phaseLength, phaseLength, numClipped);
+	phase += M;
+	next += phase / L;
+	phase %= L;
+      }
+      next -= numSamples;
+
+      std::copy(state.begin() + numSamples, state.begin() + numSamples + history, state.begin());
+
+      return outCount;
+    }
+
+  public:
+
+    PolyphaseResampleStream(const std::string& name, const std::vector<T>& fir, unsigned int L, unsigned int M, unsigned int maxBlockSize)
+      : name(name),
+	L(L),
+	M(M),
+	phaseLength(L > 0 ? fir.size() / L : 0),
+	maxBlockSize(maxBlockSize),
+	phases(fir.size()),
+	state(phaseLength + maxBlockSize - 1)
+    {
+      if (L == 0 || M == 0) {
+	throw Ex("resample factor is zero");
+      }
+      if (phaseLength == 0 || fir.size() % L != 0) {
+	throw Ex("resample filter length is not a multiple of L");
+      }
+      if (maxBlockSize == 0) {
+	throw Ex("stream block size is zero");
+      }
+
+      for (unsigned int p = 0; p < L; p++) {
+	for (unsigned int m = 0; m < phaseLength; m++) {
+	  phases[p*phaseLength + m] = fir[p + (phaseLength - 1 - m)*L];
+	}
+      }
+    }
+
+    virtual ~PolyphaseResampleStream() {}
+
+    virtual const std::string& getName() const {
+      return name;
+    }
+
+    virtual unsigned int getL() const {
+      return L;
+    }
+
+    virtual unsigned int getM() const {
+      return M;
+    }
+
+    virtual unsigned int getOutputSize(unsigned int numSamples) const {
+      // upsampled time of the next output and the end of the input
+      unsigned long long t = (unsigned long long)next * L + phase;
+      unsigned long long end = (unsigned long long)numSamples * L;
+      return t < end ? (unsigned int)((end - t + M - 1) / M) : 0;
+    }
+
+    virtual unsigned int process(const T* in, unsigned int numSamples, T* out) {
+      instrument::recordInput("resample", name, in, numSamples);
+      unsigned int n = 0;
+      unsigned int outCount = 0;
+      unsigned long numClipped = 0;
+      while (n < numSamples) {
+	unsigned int blockSize = std::min(maxBlockSize, numSamples - n);
+	outCount += resample(in + n, blockSize, out + outCount, numClipped);
+	n += blockSize;
+      }
+      D::record(name, numClipped, outCount);
+      instrument::recordOutput("resample", name, out, outCount);
+      return outCount;
+    }
+
+    virtual void reset() {
+      std::fill(state.begin(), state.end(), 0);
+      next = 0;
+      phase = 0;
+    }
+  };
+
+  // Zero stuff then decimate, see createFloat32UpDownResampleStream.
+  class Float32UpDownResampleStream : public ResampleStream<float32_t> {
+
+    const std::string name = "f32_updown";
+
+    const unsigned int L;
+
+    const unsigned int maxBlockSize;
+
+    std::unique_ptr<DecimateStream<float32_t>> decimator;
+
+    // the zero stuffed input block
+    std::vector<float32_t> upsampled;
+
+  public:
+
+    Float32UpDownResampleStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int L, unsigned int M, unsigned int maxBlockSize)
+      : L(L),
+	maxBlockSize(maxBlockSize),
+	decimator(createFloat32DecimateStream(std::move(fir), M, L*maxBlockSize)),
+	upsampled(L*maxBlockSize)
+    {}
+
+    virtual ~Float32UpDownResampleStream() {}
+
+    virtual const std::string& getName() const {
+      return name;
+    }
+
+    virtual unsigned int getL() const {
+      return L;
+    }
+
+    virtual unsigned int getM() const {
+      return decimator->getM();
+    }
+
+    virtual unsigned int getOutputSize(unsigned int numSamples) const {
+      return decimator->getOutputSize(L * numSamples);
+    }
+
+    virtual unsigned int process(const float32_t* in, unsigned int numSamples, float32_t* out) {
+      unsigned int n = 0;
+      unsigned int outCount = 0;
+      while (n < numSamples) {
+	unsigned int blockSize = std::min(maxBlockSize, numSamples - n);
+	std::fill(upsampled.begin(), upsampled.begin() + L*blockSize, 0.0f);
+	for (unsigned int i = 0; i < blockSize; i++) {
+	  upsampled[i*L] = in[n + i];
+	}
+	outCount += decimator->process(upsampled.data(), L*blockSize, out + outCount);
+	n += blockSize;
+      }
+      return outCount;
+    }
+
+    virtual void reset() {
+      decimator->reset();
+    }
+  };
+
+  // Run a stream over an owned waveform in fixed size blocks.
+  template <typename T> class BlockResample : public Resample {
+
+    std::unique_ptr<ResampleStream<T>> stream;
+
+    std::unique_ptr<std::vector<T>> waveform;
+
+    const unsigned int blockSize;
+
+    std::vector<T> result;
+
+  public:
+
+    BlockResample(std::unique_ptr<ResampleStream<T>> stream, std::unique_ptr<std::vector<T>> waveform, unsigned int blockSize)
+      : stream(std::move(stream)),
+	waveform(std::move(waveform)),
+	blockSize(blockSize),
+	result(this->stream->getOutputSize(this->waveform->size()))
+    {
+      if ( blockSize == 0 ) {
+	throw Ex("block size is zero");
+      }
+    }
+
+    virtual ~BlockResample() {}
+
+    virtual void execute() {
+      const T* in = waveform->data();
+      T* out = result.data();
+      unsigned int remaining = waveform->size();
+      while (remaining > 0) {
+	unsigned int n = std::min(blockSize, remaining);
+	out += stream->process(in, n, out);
+	in += n;
+	remaining -= n;
+      }
+    }
+
+    virtual const std::string& getName() const {
+      return stream->getName();
+    }
+
+    virtual unsigned int getL() {
+      return stream->getL();
+    }
+
+    virtual unsigned int getM() {
+      return stream->getM();
+    }
+
+    const std::unique_ptr<std::vector<float>> getResult() const {
+      auto floatResult = std::make_unique<std::vector<float>>(result.size());
+      std::copy(result.cbegin(), result.cend(), floatResult->begin());
+      return floatResult;
+    }
+  };
+
+} // namespace
+
+std::unique_ptr<ResampleStream<float32_t>> createFloat32InterpolateStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int L, unsigned int maxBlockSize) {
+  return std::unique_ptr<ResampleStream<float32_t>>(new Float32InterpolateStream(std::move(fir), L, maxBlockSize));
+}
+
+std::unique_ptr<ResampleStream<q15_t>> createQ15InterpolateStream(std::unique_ptr<std::vector<q15_t>> fir, unsigned int L, unsigned int maxBlockSize) {
+  return std::unique_ptr<ResampleStream<q15_t>>(new Q15InterpolateStream(std::move(fir), L, maxBlockSize));
+}
+
+std::unique_ptr<ResampleStream<q31_t>> createQ31InterpolateStream(std::unique_ptr<std::vector<q31_t>> fir, unsigned int L, unsigned int maxBlockSize) {
+  return std::unique_ptr<ResampleStream<q31_t>>(new Q31InterpolateStream(std::move(fir), L, maxBlockSize));
+}
+
+std::unique_ptr<ResampleStream<float32_t>> createFloat32ResampleStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int L, unsigned int M, unsigned int maxBlockSize) {
+  return std::unique_ptr<ResampleStream<float32_t>>(new PolyphaseResampleStream<float32_t, Float32Dot>("f32_resample", *fir, L, M, maxBlockSize));
+}
+
+std::unique_ptr<ResampleStream<q15_t>> createQ15ResampleStream(std::unique_ptr<std::vector<q15_t>> fir, unsigned int L, unsigned int M, unsigned int maxBlockSize) {
+  return std::unique_ptr<ResampleStream<q15_t>>(new PolyphaseResampleStream<q15_t, Q15Dot>("q15_resample", *fir, L, M, maxBlockSize));
+}
+
+std::unique_ptr<ResampleStream<q31_t>> createQ31ResampleStream(std::unique_ptr<std::vector<q31_t>> fir, unsigned int L, unsigned int M, unsigned int maxBlockSize) {
+  return std::unique_ptr<ResampleStream<q31_t>>(new PolyphaseResampleStream<q31_t, Q31Dot>("q31_resample", *fir, L, M, maxBlockSize));
+}
+
+std::unique_ptr<ResampleStream<float32_t>> createFloat32UpDownResampleStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int L, unsigned int M, unsigned int maxBlockSize) {
+  return std::unique_ptr<ResampleStream<float32_t>>(new Float32UpDownResampleStream(std::move(fir), L, M, maxBlockSize));
+}
+
+template <typename T> std::unique_ptr<Resample> createBlockResample(std::unique_ptr<ResampleStream<T>> stream, std::unique_ptr<std::vector<T>> waveform, unsigned int blockSize) {
+  return std::unique_ptr<Resample>(new BlockResample<T>(std::move(stream), std::move(waveform), blockSize));
+}
+
+template std::unique_ptr<Resample> createBlockResample<float32_t>(std::unique_ptr<ResampleStream<float32_t>> stream, std::unique_ptr<std::vector<float32_t>> waveform, unsigned int blockSize);
+template std::unique_ptr<Resample> createBlockResample<q15_t>(std::unique_ptr<ResampleStream<q15_t>> stream, std::unique_ptr<std::vector<q15_t>> waveform, unsigned int blockSize);
+template std::unique_ptr<Resample> createBlockResample<q31_t>(std::unique_ptr<ResampleStream<q31_t>> stream, std::unique_ptr<std::vector<q31_t>> waveform, unsigned int blockSize);
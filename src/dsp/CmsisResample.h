@@ -0,0 +1,100 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_CMSISRESAMPLE_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_CMSISRESAMPLE_H_INCLUDED
+
+#include "arm_math.h"
+
+#include <string>
+#include <memory>
+#include <vector>
+
+class Resample {
+ public:
+
+  virtual ~Resample() {}
+
+  virtual void execute() = 0;
+
+  // the name of the resampler implementation
+  virtual const std::string& getName() const = 0;
+
+  // get the interpolation factor
+  virtual unsigned int getL() = 0;
+
+  // get the decimation factor
+  virtual unsigned int getM() = 0;
+
+  virtual const std::unique_ptr<std::vector<float>> getResult() const = 0;
+};
+
+// Streaming sample rate converter, the output rate is L/M times the
+// input rate. process() accepts blocks of any size and the filter
+// history is kept between calls. The output is bit for bit the same
+// as a single conversion of the concatenated blocks.
+template <typename T> class ResampleStream {
+ public:
+
+  virtual ~ResampleStream() {}
+
+  // the name of the resampler implementation
+  virtual const std::string& getName() const = 0;
+
+  // get the interpolation factor
+  virtual unsigned int getL() const = 0;
+
+  // get the decimation factor
+  virtual unsigned int getM() const = 0;
+
+  // The number of output samples the next process() call will produce
+  // for numSamples input samples.
+  virtual unsigned int getOutputSize(unsigned int numSamples) const = 0;
+
+  // Resample numSamples input samples. The out buffer must have room
+  // for getOutputSize(numSamples) samples. Returns the number of
+  // samples written to out.
+  virtual unsigned int process(const T* in, unsigned int numSamples, T* out) = 0;
+
+  // Clear the filter history.
+  virtual void reset() = 0;
+};
+
+// The filters below are lowpass filters at the upsampled rate L times
+// the input rate, with a gain of L (to make up for the L-1 zeros
+// stuffed between input samples). For the fixed point variants each
+// polyphase branch, rather than the whole filter, must have a gain
+// that fits the fixed point range.
+
+// Create interpolate by L streams. Implemented using
+// arm_fir_interpolate_{f32,q15,q31}. The filter length must be a
+// multiple of L. maxBlockSize is the largest number of input samples
+// passed to a single arm_fir_interpolate_* call, it sizes the state
+// buffer. See the arm_fir_interpolate_q31 documentation regarding
+// scaling requirements.
+std::unique_ptr<ResampleStream<float32_t>> createFloat32InterpolateStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int L, unsigned int maxBlockSize);
+std::unique_ptr<ResampleStream<q15_t>> createQ15InterpolateStream(std::unique_ptr<std::vector<q15_t>> fir, unsigned int L, unsigned int maxBlockSize);
+std::unique_ptr<ResampleStream<q31_t>> createQ31InterpolateStream(std::unique_ptr<std::vector<q31_t>> fir, unsigned int L, unsigned int maxBlockSize);
+
+// Create polyphase rational L/M resampler streams (e.g. 3/2 or
+// 160/147). Only the output samples that are kept are computed, each
+// with one polyphase branch of numTaps/L taps. The filter length must
+// be a multiple of L. The fixed point variants have the same
+// accumulator widths and scaling requirements as
+// arm_fir_interpolate_{q15,q31}.
+std::unique_ptr<ResampleStream<float32_t>> createFloat32ResampleStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int L, unsigned int M, unsigned int maxBlockSize);
+std::unique_ptr<ResampleStream<q15_t>> createQ15ResampleStream(std::unique_ptr<std::vector<q15_t>> fir, unsigned int L, unsigned int M, unsigned int maxBlockSize);
+std::unique_ptr<ResampleStream<q31_t>> createQ31ResampleStream(std::unique_ptr<std::vector<q31_t>> fir, unsigned int L, unsigned int M, unsigned int maxBlockSize);
+
+// Create an L/M resampler stream that stuffs L-1 zeros between input
+// samples and decimates the result by M with arm_fir_decimate_f32.
+// It computes every filter tap of every kept output sample, it's the
+// baseline the polyphase resampler is compared to.
+std::unique_ptr<ResampleStream<float32_t>> createFloat32UpDownResampleStream(std::unique_ptr<std::vector<float32_t>> fir, unsigned int L, unsigned int M, unsigned int maxBlockSize);
+
+// Create a Resample that feeds the waveform to a stream in blockSize
+// sample blocks (the last block may be shorter). T is one of
+// float32_t, q15_t, or q31_t.
+template <typename T> std::unique_ptr<Resample> createBlockResample(std::unique_ptr<ResampleStream<T>> stream, std::unique_ptr<std::vector<T>> waveform, unsigned int blockSize);
+
+#endif
@@ -4,9 +4,88 @@
 #include "CmsisTypeFactory.h"
 
 #include "Source.h"
+#include "Span.h"
+#include "Instrument.h"
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+
+namespace {
+
+  // The float32_t bit pattern.
+  inline uint32_t bitsOf(float32_t x) {
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return bits;
+  }
+
+  // The float32_t x scaled by 2^fracBits and truncated towards zero,
+  // saturated to [-2^fracBits, 2^fracBits - 1], i.e. the value of
+  // (int)(x * 2^fracBits) clipped to the fixed point range.
+  //
+  // x is (-1)^sign * mantissa * 2^(exponent - 150), with the implicit
+  // leading one in bit 23 of the mantissa, so the scaled magnitude is
+  // the mantissa shifted left by exponent - 150 + fracBits. Any x with
+  // |x| >= 1 (exponent >= 127, incl. inf and nan) saturates, and x too
+  // small to reach bit 0 (incl. denormals and zero) is 0.
+  template <unsigned int fracBits> inline int32_t toFixed(float32_t x) {
+    const uint32_t bits = bitsOf(x);
+    const int exponent = (bits >> 23) & 0xff;
+    const bool negative = (bits >> 31) != 0;
+
+    if (exponent >= 127) {
+      return negative ? -(int32_t)((1u << fracBits) - 1) - 1 : (int32_t)((1u << fracBits) - 1);
+    }
+
+    const int shift = exponent - 150 + (int)fracBits;
+    const uint32_t mantissa = (bits & 0x7fffff) | 0x800000;
+    uint32_t magnitude;
+    if (shift >= 0) {
+      magnitude = mantissa << shift;
+    }
+    else if (shift > -24) {
+      magnitude = mantissa >> -shift;
+    }
+    else {
+      magnitude = 0;
+    }
+
+    return negative ? -(int32_t)magnitude : (int32_t)magnitude;
+  }
+
+  // Centered 12 bit ADC sample, -2048..2047.
+  inline int32_t fromAdc12(uint16_t adc) {
+    return (int32_t)(adc & 0xfff) - 2048;
+  }
+
+} // namespace
+
+void convertFloat32ToQ31(const float32_t* in, q31_t* out, unsigned int n, unsigned int rshift) {
+  instrument::recordClipped("f32_to_q31", in, n);
+  for (unsigned int i = 0; i < n; i++) {
+    out[i] = toFixed<31>(in[i]) >> rshift;
+  }
+}
+
+void convertFloat32ToQ15(const float32_t* in, q15_t* out, unsigned int n, unsigned int rshift) {
+  instrument::recordClipped("f32_to_q15", in, n);
+  for (unsigned int i = 0; i < n; i++) {
+    out[i] = (q15_t)(toFixed<15>(in[i]) >> rshift);
+  }
+}
+
+void convertAdc12ToQ31(const uint16_t* in, q31_t* out, unsigned int n, unsigned int rshift) {
+  for (unsigned int i = 0; i < n; i++) {
+    out[i] = (fromAdc12(in[i]) * (1 << 20)) >> rshift;
+  }
+}
+
+void convertAdc12ToQ15(const uint16_t* in, q15_t* out, unsigned int n, unsigned int rshift) {
+  for (unsigned int i = 0; i < n; i++) {
+    out[i] = (q15_t)((fromAdc12(in[i]) * (1 << 4)) >> rshift);
+  }
+}
 
 CmsisTypeFactory::CmsisTypeFactory() {}
 
@@ -18,21 +97,50 @@ const Source& CmsisTypeFactory::getSource() {
   return *source;
 }
   
+bool CmsisTypeFactory::isSymmetric() {
+  std::unique_ptr<std::vector<float64_t>> s = toFloat64();
+  if (s->empty()) {
+    return false;
+  }
+
+  double maxAbs = 0.0;
+  std::for_each(s->begin(), s->end(), [&](double x) { maxAbs = std::max(maxAbs, std::fabs(x)); });
+
+  const double tolerance = 1e-12 * maxAbs;
+  for (unsigned int k = 0, j = s->size() - 1; k < j; k++, j--) {
+    if ( std::fabs(s->at(k) - s->at(j)) > tolerance ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+double CmsisTypeFactory::getPeak() {
+  std::unique_ptr<std::vector<float64_t>> s = toFloat64();
+  double peak = 0.0;
+  std::for_each(s->begin(), s->end(), [&](double x) { peak = std::max(peak, std::fabs(x)); });
+  return peak;
+}
+
+Headroom CmsisTypeFactory::getHeadroom(CmsisTypeFactory& fir) {
+  return getHeadroom(fir, getPeak());
+}
+
+Headroom CmsisTypeFactory::getHeadroom(CmsisTypeFactory& fir, double peak) {
+  return computeHeadroom(getL1Norm(*fir.toFloat64()), peak);
+}
+
 std::unique_ptr<std::vector<float64_t>> CmsisTypeFactory::toFloat64() {
   auto f64 = std::make_unique<std::vector<float64_t>>(source->size());
   source->reset();
-  for(int i = 0; !source->isEnd(); i++) {
-    f64->at(i) = source->next();
-  }
+  source->fill(Span<float64_t>(*f64));
   return f64;
 }
 
 std::unique_ptr<std::vector<float32_t>> CmsisTypeFactory::toFloat32() {
-  auto f32 = std::make_unique<std::vector<float32_t>>(source->size(), 0);
+  auto f32 = std::make_unique<std::vector<float32_t>>(source->size());
   source->reset();
-  for(int i = 0; !source->isEnd(); i++) {
-    f32->at(i) = source->next();
-  }
+  source->fill(Span<float32_t>(*f32));
   return f32;
 }
 
@@ -41,38 +149,16 @@ std::unique_ptr<std::vector<float32_t>> CmsisTypeFactory::toFloat32() {
 std::unique_ptr<std::vector<q31_t>> CmsisTypeFactory::toQ31(unsigned int rshift) {
   auto q31 = std::make_unique<std::vector<q31_t>>(source->size());
   source->reset();
-  for(int i = 0; !source->isEnd(); i++) {
-    float s = source->next();
-    q31_t v = clip_q63_to_q31((q63_t) (s * 2147483648.0f));
-    q31->at(i) = v;
-    // printf("toQ31 %f 0x%016llx 0x%08x q31=%ld\n", s, (q63_t)(s * 2147483648.0f), v, q31->at(i));
-  }
-
-  if (rshift > 0) {
-    std::for_each(q31->begin(), q31->end(), [rshift](q31_t& x) {x = x >> rshift;});
-  }
-
+  source->fill(Span<q31_t>(*q31), rshift);
   return q31;
 }
 
-#if 0
-// clip_q63_to_q15 appears to be broken
-// TODO - investigate separately and report a bug if confirmed.
-std::unique_ptr<std::vector<q15_t>> CmsisTypeFactory::toQ15() {
-  auto q15 = std::make_unique<std::vector<q15_t>>(source->size());
-  source->reset();
-  for(int i = 0; !source->isEnd(); i++) {
-    float32_t s = source->next();
-    q15_t v = clip_q63_to_q15((q63_t) (s * 32768.0f));
-    q15->at(i) = v;
-    printf("toQ15 %f 0x%016llx 0x%04hx q15=%d\n", s, (q63_t)(s * 32768.0f), v, q15->at(i));
-  }
-  return q15;
+std::unique_ptr<std::vector<q31_t>> CmsisTypeFactory::toQ31(const Headroom& headroom) {
+  return toQ31(headroom.rshift);
 }
-#else
-// The alternative is to allocate a float32_t array and use
-// arm_float_to_q15 (which is not implemented with
-// clip_q63_to_q15()).
+
+// The source converts the samples with convertFloat32ToQ15 (see
+// Source.h), clip_q63_to_q15() appears to be broken.
 //
 // Optionally right shift by rshift bits to satisfy overflow
 // limitations of functions such as
@@ -80,20 +166,12 @@ std::unique_ptr<std::vector<q15_t>> CmsisTypeFactory::toQ15() {
 // data is used hence only the caller can determine the need for
 // right shift and the amount of right shift.
 std::unique_ptr<std::vector<q15_t>> CmsisTypeFactory::toQ15(unsigned int rshift) {
-  std::vector<float32_t> f32(source->size());
-
-  source->reset();
-  for(int i = 0; !source->isEnd(); i++) {
-    f32.at(i) = source->next();
-  }
-
   auto q15 = std::make_unique<std::vector<q15_t>>(source->size());
-  arm_float_to_q15(f32.data(), q15->data(), f32.size());
-
-  if (rshift > 0) {
-    std::for_each(q15->begin(), q15->end(), [rshift](q15_t& x) {x = x >> rshift;});
-  }
-    
+  source->reset();
+  source->fill(Span<q15_t>(*q15), rshift);
   return q15;
 }
-#endif
+
+std::unique_ptr<std::vector<q15_t>> CmsisTypeFactory::toQ15(const Headroom& headroom) {
+  return toQ15(headroom.rshift);
+}
@@ -4,8 +4,11 @@
 #ifndef PICO_CMSIS_SANDBOX_CMSISTYPEFACTORY_INCLUDED
 #define PICO_CMSIS_SANDBOX_CMSISTYPEFACTORY_INCLUDED
 
+#include "Headroom.h"
+
 #include "arm_math.h"
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -23,6 +26,21 @@ public:
 
   const Source& getSource();
 
+  // True if the source is symmetric, s[k] == s[N-1-k] within double
+  // precision rounding, e.g. a linear phase FIR filter. The fixed
+  // point conversions of a symmetric source are exactly symmetric.
+  bool isSymmetric();
+
+  // The largest |s| of the source samples.
+  double getPeak();
+
+  // The fixed point input scaling (see Headroom.h) of this source,
+  // e.g. a signal, for the fir filter, from the l1 norm of the fir
+  // source coefficients and the observed peak of this source, or a
+  // declared peak, e.g. the full scale of an ADC.
+  Headroom getHeadroom(CmsisTypeFactory& fir);
+  Headroom getHeadroom(CmsisTypeFactory& fir, double peak);
+
   std::unique_ptr<std::vector<float64_t>> toFloat64();
 
   std::unique_ptr<std::vector<float32_t>> toFloat32();
@@ -30,14 +48,41 @@ public:
   // Convert source to q31_t fixed point with optional right shift
   // scaling. See arm_fir_decimate_q31 and arm_fir_decimate_fast_q31
   // documentation regarding scaling requirements. Scaling is done
-  // after thre real to fixed point conversion.
+  // after the real to fixed point conversion, in the same pass (see
+  // convertFloat32ToQ31()).
   std::unique_ptr<std::vector<q31_t>> toQ31(unsigned int rshift = 0);
 
+  // Convert source to q31_t fixed point scaled by the headroom right
+  // shift.
+  std::unique_ptr<std::vector<q31_t>> toQ31(const Headroom& headroom);
+
   // Convert source to q15_t fixed point with optional right shift
   // scaling. See arm_fir_decimate_fast_q15 documentation regarding
   // scaling requirements. Scaling is done after the real to fixed
-  // point conversion.
+  // point conversion, in the same pass (see convertFloat32ToQ15()).
   std::unique_ptr<std::vector<q15_t>> toQ15(unsigned int rshift = 0);
+
+  // Convert source to q15_t fixed point scaled by the headroom right
+  // shift.
+  std::unique_ptr<std::vector<q15_t>> toQ15(const Headroom& headroom);
 };
 
+// Convert n float32_t samples to q31_t/q15_t and arithmetic right
+// shift by rshift bits, in one pass. The values are the same as
+// arm_float_to_q{31,15} (truncated towards zero and saturated)
+// followed by a right shift, but are computed from the float32_t bit
+// pattern with integer operations only, no soft float multiply or
+// float to integer conversion.
+void convertFloat32ToQ31(const float32_t* in, q31_t* out, unsigned int n, unsigned int rshift = 0);
+void convertFloat32ToQ15(const float32_t* in, q15_t* out, unsigned int n, unsigned int rshift = 0);
+
+// Convert n 12 bit ADC samples, offset binary in the least
+// significant bits of 16 bit words (the RP2040 ADC FIFO format, the
+// upper bits are ignored), to q31_t/q15_t, i.e. (adc - 2048) / 2048
+// full scale, and arithmetic right shift by rshift bits. Integer
+// only. The 12 bit samples fit with 4 bits of q15_t headroom, an
+// rshift of 4 keeps the raw ADC scale.
+void convertAdc12ToQ31(const uint16_t* in, q31_t* out, unsigned int n, unsigned int rshift = 0);
+void convertAdc12ToQ15(const uint16_t* in, q15_t* out, unsigned int n, unsigned int rshift = 0);
+
 #endif
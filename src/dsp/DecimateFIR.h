@@ -4,11 +4,21 @@
 #ifndef PICO_CMSIS_SANDBOX_DECIMATIONFIR_H_INCLUDED
 #define PICO_CMSIS_SANDBOX_DECIMATIONFIR_H_INCLUDED
 
+#include "FirDesign.h"
+
 #include <memory>
 #include <vector>
 
-// Get decimation FIR for decimation factor M. M={2,4,8} are
-// supported.
-std::unique_ptr<std::vector<double>> getDecimationFIR(unsigned int M);
+// The numTaps decimation FIR spec for decimation factor M. The default
+// is a Hamming window design with cutoff 1/M, the same as the Octave
+// command fir1(numTaps-1, 1/M), the Kaiser and equiripple designs need
+// a transition width and attenuation. See FirDesign.h, and
+// createFirSource(const FirSpec&) (FirSource.h) for its float32_t and
+// fixed point coefficients.
+FirSpec getDecimationFirSpec(unsigned int M, unsigned int numTaps = 31, FirMethod method = FirMethod::HAMMING, double transitionWidth = 0.0, double attenuation = 60.0);
+
+// Get a numTaps decimation FIR for decimation factor M, a copy of the
+// getDecimationFirSpec() design.
+std::unique_ptr<std::vector<double>> getDecimationFIR(unsigned int M, unsigned int numTaps = 31, FirMethod method = FirMethod::HAMMING, double transitionWidth = 0.0, double attenuation = 60.0);
 
 #endif
@@ -0,0 +1,306 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "DecimatePlanner.h"
+
+#include "CmsisTypeFactory.h"
+#include "FirDesign.h"
+#include "FirSource.h"
+#include "Ex.h"
+
+#include "Platform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+  // arm_fir_decimate_* take an 8 bit decimation factor
+  const unsigned int maxStageFactor = 255;
+
+  // Attenuation bound by coefficient quantization, roughly 6 dB per
+  // bit less a margin for the accumulated rounding error.
+  template <typename T> double maxAttenuation();
+  template <> double maxAttenuation<float32_t>() { return 140.0; }
+  template <> double maxAttenuation<q31_t>() { return 170.0; }
+  template <> double maxAttenuation<q15_t>() { return 80.0; }
+
+  // Append all ordered factorizations of M into at most maxStages
+  // factors.
+  void factorize(unsigned int M, unsigned int maxStages, std::vector<unsigned int>& factors, std::vector<std::vector<unsigned int>>& result) {
+    if (M == 1) {
+      if (!factors.empty()) {
+	result.push_back(factors);
+      }
+      return;
+    }
+
+    if (factors.size() == maxStages) {
+      return;
+    }
+
+    for (unsigned int f = 2; f <= std::min(M, maxStageFactor); f++) {
+      if (M % f == 0) {
+	factors.push_back(f);
+	factorize(M / f, maxStages, factors, result);
+	factors.pop_back();
+      }
+    }
+  }
+
+  // Stage filter parameters for a cascade. Stage i decimates its input
+  // rate F(i-1) to F(i). Its passband is the final passband, and its
+  // stopband starts at F(i) - fs, the lowest frequency that aliases
+  // into the final band [0, fs].
+  DecimationPlan designCascade(const DecimationSpec& spec, const std::vector<unsigned int>& factors, double attenuation, bool withFir) {
+    // frequencies in cycles per input sample
+    const double outputRate = 1.0 / spec.M;
+    const double fp = spec.passband * outputRate / 2.0;
+    const double fs = spec.stopband * outputRate / 2.0;
+
+    DecimationPlan plan;
+    double inputRate = 1.0;
+
+    for (unsigned int i = 0; i < factors.size(); i++) {
+      double stageOutputRate = inputRate / factors[i];
+      double stopEdge = stageOutputRate - fs;
+      double nyquist = inputRate / 2.0;
+
+      unsigned int numTaps = kaiserNumTaps(attenuation, (stopEdge - fp) / nyquist);
+
+      // outputs of this stage per final output sample
+      double outputsPerOutput = 1.0;
+      for (unsigned int j = i + 1; j < factors.size(); j++) {
+	outputsPerOutput *= factors[j];
+      }
+
+      DecimationStage stage;
+      stage.M = factors[i];
+      stage.cutoff = (stopEdge + fp) / 2.0 / nyquist;
+      stage.macsPerOutput = numTaps * outputsPerOutput;
+      if (withFir) {
+	stage.fir = *designKaiserLowpass(numTaps, stage.cutoff, kaiserBeta(attenuation));
+      }
+      else {
+	stage.fir.resize(numTaps);
+      }
+
+      plan.macsPerOutput += stage.macsPerOutput;
+      plan.stages.push_back(std::move(stage));
+
+      inputRate = stageOutputRate;
+    }
+
+    return plan;
+  }
+
+  template <typename T> class DecimateChain : public DecimateStream<T> {
+
+    const std::string name;
+
+    std::vector<std::unique_ptr<DecimateStream<T>>> stages;
+
+    // stage output buffers (except the last stage, which writes to the
+    // caller's output)
+    std::vector<std::vector<T>> buffers;
+
+    const unsigned int maxBlockSize;
+
+    std::vector<DecimateStageCost>* profile;
+
+  public:
+
+    DecimateChain(const std::string& name, std::vector<std::unique_ptr<DecimateStream<T>>> stages, const std::vector<unsigned int>& bufferSizes, unsigned int maxBlockSize, std::vector<DecimateStageCost>* profile)
+      : name(name),
+	stages(std::move(stages)),
+	maxBlockSize(maxBlockSize),
+	profile(profile)
+    {
+      for (unsigned int i = 0; i + 1 < this->stages.size(); i++) {
+	buffers.emplace_back(bufferSizes[i]);
+      }
+    }
+
+    virtual ~DecimateChain() {}
+
+    virtual const std::string& getName() const {
+      return name;
+    }
+
+    virtual unsigned int getM() const {
+      unsigned int M = 1;
+      for (auto& stage: stages) {
+	M *= stage->getM();
+      }
+      return M;
+    }
+
+    virtual unsigned int getOutputSize(unsigned int numSamples) const {
+      for (auto& stage: stages) {
+	numSamples = stage->getOutputSize(numSamples);
+      }
+      return numSamples;
+    }
+
+    virtual unsigned int process(const T* in, unsigned int numSamples, T* out) {
+      unsigned int outCount = 0;
+
+      while (numSamples > 0) {
+	unsigned int blockSize = std::min(numSamples, maxBlockSize);
+
+	const T* stageIn = in;
+	unsigned int stageCount = blockSize;
+
+	for (unsigned int i = 0; i < stages.size(); i++) {
+	  T* stageOut = (i + 1 == stages.size()) ? out + outCount : buffers[i].data();
+
+	  if (profile) {
+	    platform::profiling_time_t start = platform::get_profiling_time();
+	    stageCount = stages[i]->process(stageIn, stageCount, stageOut);
+	    platform::profiling_time_t end = platform::get_profiling_time();
+	    (*profile)[i].elapsedTime += platform::profiling_time_diff(start, end);
+	  }
+	  else {
+	    stageCount = stages[i]->process(stageIn, stageCount, stageOut);
+	  }
+
+	  stageIn = stageOut;
+	}
+
+	outCount += stageCount;
+	in += blockSize;
+	numSamples -= blockSize;
+      }
+
+      return outCount;
+    }
+
+    virtual void reset() {
+      for (auto& stage: stages) {
+	stage->reset();
+      }
+    }
+  };
+
+  // Build the chain. createStage(fir, M, maxBlockSize) creates one
+  // stage stream from the double precision stage filter.
+  template <typename T, typename F> std::unique_ptr<DecimateStream<T>> createChain(const std::string& name, const DecimationPlan& plan, unsigned int maxBlockSize, std::vector<DecimateStageCost>* profile, F createStage) {
+    if (plan.stages.empty()) {
+      throw Ex("empty decimation plan");
+    }
+
+    std::vector<std::unique_ptr<DecimateStream<T>>> stages;
+
+    if (profile) {
+      profile->clear();
+    }
+
+    // see createDecimateChain()
+    unsigned int blockSize = maxBlockSize;
+    for (const DecimationStage& stage: plan.stages) {
+      blockSize = std::max(blockSize, stage.M);
+      CmsisTypeFactory firFactory(createFirSource(std::make_unique<std::vector<double>>(stage.fir)));
+      stages.push_back(createStage(firFactory, stage.M, blockSize));
+      blockSize = blockSize / stage.M + 1;
+
+      if (profile) {
+	profile->push_back(DecimateStageCost{stage.M, (unsigned int)stage.fir.size(), stage.macsPerOutput, 0});
+      }
+    }
+
+    return createDecimateChain(name, std::move(stages), maxBlockSize, profile);
+  }
+
+} // namespace
+
+std::string DecimationPlan::describe() const {
+  std::stringstream ss;
+  for (unsigned int i = 0; i < stages.size(); i++) {
+    ss << (i > 0 ? "x" : "") << stages[i].M;
+  }
+  return ss.str();
+}
+
+template <typename T> DecimationPlan planDecimation(const DecimationSpec& spec, unsigned int maxStages) {
+  if ( spec.M < 2 || !(spec.passband > 0.0 && spec.passband < spec.stopband && spec.stopband <= 1.0) ) {
+    throw Ex("invalid decimation specification");
+  }
+
+  // Split the passband ripple over the stages, and take the stricter
+  // of the passband and stopband attenuation requirement.
+  auto stageAttenuation = [&spec](unsigned int numStages) {
+    double g = std::pow(10.0, spec.passbandRipple / 20.0);
+    double passbandDelta = (g - 1.0) / (g + 1.0) / numStages;
+    double attenuation = std::max(spec.stopbandAttenuation, -20.0 * std::log10(passbandDelta));
+    return std::min(attenuation, maxAttenuation<T>());
+  };
+
+  std::vector<std::vector<unsigned int>> cascades;
+  std::vector<unsigned int> factors;
+  factorize(spec.M, maxStages, factors, cascades);
+
+  if (cascades.empty()) {
+    throw Ex("decimation factor can't be factored into stages");
+  }
+
+  // Estimate the cost of every cascade (without designing the
+  // filters), prefer fewer stages on a tie.
+  const std::vector<unsigned int>* best = nullptr;
+  double bestCost = 0.0;
+  for (auto& cascade: cascades) {
+    double cost = designCascade(spec, cascade, stageAttenuation(cascade.size()), false).macsPerOutput;
+    if ( best == nullptr || cost < bestCost || (cost == bestCost && cascade.size() < best->size()) ) {
+      best = &cascade;
+      bestCost = cost;
+    }
+  }
+
+  return designCascade(spec, *best, stageAttenuation(best->size()), true);
+}
+
+template DecimationPlan planDecimation<float32_t>(const DecimationSpec& spec, unsigned int maxStages);
+template DecimationPlan planDecimation<q15_t>(const DecimationSpec& spec, unsigned int maxStages);
+template DecimationPlan planDecimation<q31_t>(const DecimationSpec& spec, unsigned int maxStages);
+
+template <typename T> std::unique_ptr<DecimateStream<T>> createDecimateChain(const std::string& name, std::vector<std::unique_ptr<DecimateStream<T>>> stages, unsigned int maxBlockSize, std::vector<DecimateStageCost>* profile) {
+  if (stages.empty()) {
+    throw Ex("empty decimation chain");
+  }
+  if (profile && profile->size() != stages.size()) {
+    throw Ex("decimation chain profile size != number of stages");
+  }
+
+  // A stage holds fewer than M samples between calls, so it outputs
+  // at most blockSize/M+1 samples per call.
+  std::vector<unsigned int> bufferSizes;
+  unsigned int blockSize = maxBlockSize;
+  for (auto& stage: stages) {
+    blockSize = std::max(blockSize, stage->getM()) / stage->getM() + 1;
+    bufferSizes.push_back(blockSize);
+  }
+
+  return std::unique_ptr<DecimateStream<T>>(new DecimateChain<T>(name, std::move(stages), bufferSizes, maxBlockSize, profile));
+}
+
+template std::unique_ptr<DecimateStream<float32_t>> createDecimateChain<float32_t>(const std::string& name, std::vector<std::unique_ptr<DecimateStream<float32_t>>> stages, unsigned int maxBlockSize, std::vector<DecimateStageCost>* profile);
+template std::unique_ptr<DecimateStream<q15_t>> createDecimateChain<q15_t>(const std::string& name, std::vector<std::unique_ptr<DecimateStream<q15_t>>> stages, unsigned int maxBlockSize, std::vector<DecimateStageCost>* profile);
+template std::unique_ptr<DecimateStream<q31_t>> createDecimateChain<q31_t>(const std::string& name, std::vector<std::unique_ptr<DecimateStream<q31_t>>> stages, unsigned int maxBlockSize, std::vector<DecimateStageCost>* profile);
+
+std::unique_ptr<DecimateStream<float32_t>> createFloat32DecimateChain(const DecimationPlan& plan, unsigned int maxBlockSize, std::vector<DecimateStageCost>* profile) {
+  return createChain<float32_t>("f32_chain", plan, maxBlockSize, profile, [](CmsisTypeFactory& fir, unsigned int M, unsigned int blockSize) {
+    return createFloat32DecimateStream(fir, M, blockSize);
+  });
+}
+
+std::unique_ptr<DecimateStream<q15_t>> createQ15DecimateChain(const DecimationPlan& plan, unsigned int maxBlockSize, bool fast, std::vector<DecimateStageCost>* profile) {
+  return createChain<q15_t>(fast ? "q15_fast_chain" : "q15_chain", plan, maxBlockSize, profile, [fast](CmsisTypeFactory& fir, unsigned int M, unsigned int blockSize) {
+    return createQ15DecimateStream(fir, M, blockSize, fast);
+  });
+}
+
+std::unique_ptr<DecimateStream<q31_t>> createQ31DecimateChain(const DecimationPlan& plan, unsigned int maxBlockSize, bool fast, std::vector<DecimateStageCost>* profile) {
+  return createChain<q31_t>(fast ? "q31_fast_chain" : "q31_chain", plan, maxBlockSize, profile, [fast](CmsisTypeFactory& fir, unsigned int M, unsigned int blockSize) {
+    return createQ31DecimateStream(fir, M, blockSize, fast);
+  });
+}
@@ -0,0 +1,120 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_DECIMATEPLANNER_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_DECIMATEPLANNER_H_INCLUDED
+
+#include "CmsisDecimate.h"
+
+#include "arm_math.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+Multistage decimation planner.
+
+A single stage decimate by M filter needs a transition band that is
+narrow relative to its input rate, hence a large number of taps. A
+cascade of smaller decimation factors relaxes the transition band of
+the early stages (aliasing into the final transition band is allowed)
+so the total cost is much lower. For example, decimating by 64 with a
+0.8 passband and 60 dB attenuation needs a 2000+ tap single stage
+filter, versus roughly 400 multiply-accumulates (MACs) per output
+sample for an 8x4x2 cascade.
+
+The planner enumerates the ordered factorizations of M, estimates
+each stage's Kaiser window filter length, and picks the cascade with
+the fewest multiply-accumulates per output sample. The passband
+ripple is split evenly over the stages.
+
+Frequencies in DecimationSpec are normalized to the Nyquist frequency
+of the decimated output. A stopband of 1.0 means nothing aliases
+below the output Nyquist frequency.
+*/
+
+struct DecimationSpec {
+  // the total decimation factor
+  unsigned int M;
+
+  // passband edge
+  double passband;
+
+  // stopband edge
+  double stopband;
+
+  // peak to peak passband ripple (dB)
+  double passbandRipple;
+
+  // stopband attenuation (dB)
+  double stopbandAttenuation;
+
+  DecimationSpec(unsigned int M, double passband, double stopband, double passbandRipple, double stopbandAttenuation)
+    : M(M),
+      passband(passband),
+      stopband(stopband),
+      passbandRipple(passbandRipple),
+      stopbandAttenuation(stopbandAttenuation)
+  {}
+};
+
+struct DecimationStage {
+  // the stage decimation factor
+  unsigned int M;
+
+  // the stage filter (cutoff is normalized to the stage input Nyquist
+  // frequency)
+  std::vector<double> fir;
+  double cutoff;
+
+  // the stage multiply-accumulates per final output sample
+  double macsPerOutput;
+};
+
+struct DecimationPlan {
+  std::vector<DecimationStage> stages;
+
+  // total multiply-accumulates per final output sample
+  double macsPerOutput = 0.0;
+
+  // the stage factors, e.g. "2x2x4"
+  std::string describe() const;
+};
+
+// Plan a cascade of at most maxStages stages. T is the data type of
+// the decimation chain (float32_t, q15_t, or q31_t), it bounds the
+// attenuation to what the coefficient quantization can realize. Throws
+// Ex if the specification is invalid.
+template <typename T> DecimationPlan planDecimation(const DecimationSpec& spec, unsigned int maxStages = 4);
+
+// Per stage profile of a decimation chain.
+struct DecimateStageCost {
+  unsigned int M;
+  unsigned int numTaps;
+  double macsPerOutput;
+
+  // accumulated stage process() time (us)
+  unsigned long elapsedTime;
+};
+
+// Create a streaming decimation chain of the stages. maxBlockSize
+// bounds the chain's input block and sizes the intermediate buffers.
+// If profile is not null then it must
+// have one entry per stage, the stage process() times are accumulated
+// into it (it must outlive the chain). T is one of float32_t, q15_t,
+// or q31_t.
+template <typename T> std::unique_ptr<DecimateStream<T>> createDecimateChain(const std::string& name, std::vector<std::unique_ptr<DecimateStream<T>>> stages, unsigned int maxBlockSize, std::vector<DecimateStageCost>* profile = nullptr);
+
+// Create a streaming decimation chain for the plan. Each stage is a
+// stream created by create{Float32,Q15,Q31}DecimateStream, i.e. a
+// folded stream since the Kaiser window stage filters are symmetric.
+// maxBlockSize bounds the chain's input block and sizes the
+// intermediate buffers. If profile is not null then it's filled with
+// one entry per stage and the stage process() times are accumulated
+// into it (it must outlive the chain).
+std::unique_ptr<DecimateStream<float32_t>> createFloat32DecimateChain(const DecimationPlan& plan, unsigned int maxBlockSize, std::vector<DecimateStageCost>* profile = nullptr);
+std::unique_ptr<DecimateStream<q15_t>> createQ15DecimateChain(const DecimationPlan& plan, unsigned int maxBlockSize, bool fast, std::vector<DecimateStageCost>* profile = nullptr);
+std::unique_ptr<DecimateStream<q31_t>> createQ31DecimateChain(const DecimationPlan& plan, unsigned int maxBlockSize, bool fast, std::vector<DecimateStageCost>* profile = nullptr);
+
+#endif
@@ -4,12 +4,18 @@
 #include "DecimateTest.h"
 
 #include "CmsisDecimate.h"
-#include "CmsisFFT.h"
+#include "Headroom.h"
+#include "CmsisFft.h"
 #include "WindowFunction.h"
+#include "StreamTest.h"
 #include "Ex.h"
 
 #include "Platform.h"
 
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+
 namespace {
 
   class DecimateTest {
@@ -79,15 +85,91 @@ namespace {
 
       verify();
 
-      printf("%s %ld us\n", decimator->getName().c_str(), elapsedTime);
+      printf("%s %lu us\n", decimator->getName().c_str(), elapsedTime);
 
       return DecimateTestResult(decimator->getName(), elapsedTime);
     }
   };
 
+  template <typename T> void verifyStream(DecimateStream<T>& stream, DecimateStream<T>& reference, const std::vector<T>& waveform) {
+    verifyStreamBlocks(stream, reference, waveform);
+
+    std::vector<T> expected(reference.getOutputSize(waveform.size()));
+    const unsigned int expectedSize = reference.process(waveform.data(), waveform.size(), expected.data());
+
+    // Decimate in place through the span API, in the same irregular
+    // blocks, writing the output over the consumed input.
+    std::vector<T> buffer(waveform);
+    Span<T> span(buffer);
+    const unsigned int inPlaceSize = processInBlocks(buffer.size(), [&](unsigned int n, unsigned int blockSize, unsigned int numOutputs) {
+      return stream.process(span.subspan(n, blockSize), span.subspan(numOutputs, span.size() - numOutputs));
+    });
+
+    verifySameOutput(stream.getName(), "in place stream result", inPlaceSize, buffer.data(), expectedSize, expected);
+
+    stream.reset();
+    reference.reset();
+  }
+
+  double fullScale(q31_t) {
+    return 2147483648.0;
+  }
+
+  double fullScale(q15_t) {
+    return 32768.0;
+  }
+
+  template <typename T> double executeHeadroom(DecimateStream<T>& stream, const std::vector<T>& waveform, const Headroom& headroom, const std::vector<float64_t>& fir, const std::vector<float64_t>& signal) {
+    const unsigned int M = stream.getM();
+    std::vector<T> out(stream.getOutputSize(waveform.size()));
+    stream.reset();
+    const unsigned int numOutputs = stream.process(waveform.data(), waveform.size(), out.data());
+    stream.reset();
+
+    compensate(Span<T>(out.data(), numOutputs), headroom);
+
+    // y[n] = b[0]*x[n*M] + b[1]*x[n*M-1] ..., the coefficients are
+    // time reversed
+    double signalPower = 0.0;
+    double noisePower = 0.0;
+    for (unsigned int n = 0; n < numOutputs; n++) {
+      double y = 0.0;
+      for (unsigned int k = 0; k < fir.size() && k <= n*M; k++) {
+	y += fir[fir.size() - 1 - k] * signal[n*M - k];
+      }
+      const double e = out[n] / fullScale(T()) - y;
+      signalPower += y*y;
+      noisePower += e*e;
+    }
+
+    const double snr = noisePower > 0.0 ? 10.0 * std::log10(signalPower / noisePower) : INFINITY;
+    printf("%s rshift %d, l1 norm %.4f, peak %.4f, snr %.1f dB\n", stream.getName().c_str(), headroom.rshift, headroom.l1Norm, headroom.inputPeak, snr);
+    return snr;
+  }
+
 } // namespace
 
 DecimateTestResult executeDecimateTest(unsigned int k, std::unique_ptr<Decimate> decimator) {
   return DecimateTest(k, std::move(decimator)).execute();
 }
 
+
+void verifyDecimateStream(DecimateStream<float32_t>& stream, DecimateStream<float32_t>& reference, const std::vector<float32_t>& waveform) {
+  verifyStream(stream, reference, waveform);
+}
+
+void verifyDecimateStream(DecimateStream<q15_t>& stream, DecimateStream<q15_t>& reference, const std::vector<q15_t>& waveform) {
+  verifyStream(stream, reference, waveform);
+}
+
+void verifyDecimateStream(DecimateStream<q31_t>& stream, DecimateStream<q31_t>& reference, const std::vector<q31_t>& waveform) {
+  verifyStream(stream, reference, waveform);
+}
+
+double executeHeadroomTest(DecimateStream<q31_t>& stream, const std::vector<q31_t>& waveform, const Headroom& headroom, const std::vector<float64_t>& fir, const std::vector<float64_t>& signal) {
+  return executeHeadroom(stream, waveform, headroom, fir, signal);
+}
+
+double executeHeadroomTest(DecimateStream<q15_t>& stream, const std::vector<q15_t>& waveform, const Headroom& headroom, const std::vector<float64_t>& fir, const std::vector<float64_t>& signal) {
+  return executeHeadroom(stream, waveform, headroom, fir, signal);
+}
@@ -4,10 +4,15 @@
 #ifndef PICO_CMSIS_SANDBOX_DECIMATEST_H_INCLUDED
 #define PICO_CMSIS_SANDBOX_DECIMATEST_H_INCLUDED
 
+#include "arm_math.h"
+
 #include <memory>
 #include <string>
+#include <vector>
 
+struct Headroom;
 class Decimate;
+template <typename T> class DecimateStream;
 
 struct DecimateTestResult {
   const std::string name;
@@ -21,4 +26,20 @@ struct DecimateTestResult {
 
 DecimateTestResult executeDecimateTest(unsigned int k, std::unique_ptr<Decimate> decimator);
 
+// Verify that the stream, fed the waveform in irregular block sizes,
+// produces bit for bit the same output as the reference stream
+// decimating the whole waveform in one block, both into a separate
+// buffer and in place through the span API. Throws Fail if not.
+void verifyDecimateStream(DecimateStream<float32_t>& stream, DecimateStream<float32_t>& reference, const std::vector<float32_t>& waveform);
+void verifyDecimateStream(DecimateStream<q15_t>& stream, DecimateStream<q15_t>& reference, const std::vector<q15_t>& waveform);
+void verifyDecimateStream(DecimateStream<q31_t>& stream, DecimateStream<q31_t>& reference, const std::vector<q31_t>& waveform);
+
+// Decimate the waveform, the signal converted to fixed point and
+// scaled down by the headroom right shift, with the stream, compensate
+// the output (see Headroom.h), and return its SNR (dB) against the
+// double precision decimation of the signal by the fir filter (arm_fir
+// coefficient order).
+double executeHeadroomTest(DecimateStream<q31_t>& stream, const std::vector<q31_t>& waveform, const Headroom& headroom, const std::vector<float64_t>& fir, const std::vector<float64_t>& signal);
+double executeHeadroomTest(DecimateStream<q15_t>& stream, const std::vector<q15_t>& waveform, const Headroom& headroom, const std::vector<float64_t>& fir, const std::vector<float64_t>& signal);
+
 #endif
@@ -8,12 +8,18 @@
 #include "CmsisTypeFactory.h"
 #include "FirSource.h"
 #include "DecimateFIR.h"
+#include "DecimatePlanner.h"
+#include "CicDecimate.h"
+#include "FirDesign.h"
 #include "Signal.h"
+#include "Generator.h"
 #include "Ex.h"
 
 #include <arm_math.h>
 
 #include <algorithm>
+#include <cmath>
+#include <utility>
 
 using namespace decimate;
 
@@ -29,45 +35,205 @@ namespace {
   // know the range of their q15_5 data, if scaling is necessary, and
   // how much scaling is necessary. This test uses a real test signal
   // with range [-1.0,1.0], therefore uses the full range of the q15
-  // fixed point. Hence must be scalled down by the full log2(numBits).
+  // fixed point. The log2(numTaps) bound assumes every coefficient
+  // may be full scale, the single stage decimators are instead scaled
+  // by the headroom shift (see Headroom.h), from the filter's l1 norm
+  // and the signal's peak. The full scale signal needs 1 bit for
+  // these filters, runHeadroomPeak() checks a signal peak that needs
+  // no shift at all.
   //
   // The decimated result retains this scaling. So, if the original
-  // waveform is scaled down by 32 (5 bits), then the decimate result
-  // will have the same scaling.
+  // waveform is scaled down by 2 (1 bit), then the decimate result
+  // will have the same scaling. The headroom SNR test compares the
+  // compensated output of both scalings.
   //
   // Note that in the Pico Pi uses cases, 12 bit adc values are stored
   // in the least significant bits of 16 bit word. Hence, that use case
-  // would only need 1 bit of scaling to avoid decimation overflow.
+  // would only need 1 bit of scaling to avoid decimation overflow. See
+  // convertAdc12ToQ15() (CmsisTypeFactory.h), rshift 4 keeps the raw
+  // adc scale.
 
   class DecimateTestRunner {
 
     const std::vector<unsigned int> sizes = {512, 1024, 2048, 4096, 8192};
     const std::vector<unsigned int> decimationFactors = {2, 4, 8};
 
-    std::unique_ptr<NameToFactorElapsedTimeMap> resultMap = std::make_unique<NameToFactorElapsedTimeMap>();
+    // Streaming decimation input block size, e.g. an ADC DMA block.
+    const unsigned int streamBlockSize = 64;
+
+    // Filter length and block size sweep. The waveform is decimated
+    // in blocks of each size by streams sized for that block, the
+    // largest block is the whole waveform.
+    const unsigned int sweepM = 4;
+    const unsigned int sweepWaveformSize = 8192;
+    const std::vector<unsigned int> sweepTaps = {15, 31, 63, 127, 255};
+    const std::vector<unsigned int> sweepBlockSizes = {32, 128, 512, 2048, 8192};
+
+    // Allowed headroom scaling SNR loss (dB), rounding noise.
+    const double snrTolerance = 1.0;
+
+    // The no shift headroom test signal amplitude, and the smallest
+    // SNR (dB) that rules out an overflow (it costs tens of dB).
+    const double peakSignalAmplitude = 0.6;
+    const double minPeakSnrQ31 = 100.0;
+    const double minPeakSnrQ15 = 60.0;
+
+    // The designed decimation filters, the equiripple design and a
+    // Kaiser design of the estimated length must meet the ripple (dB)
+    // and attenuation (dB), q15 coefficient rounding may cost some of
+    // the attenuation.
+    const unsigned int designM = 4;
+    const unsigned int equirippleTaps = 63;
+    const double designTransitionWidth = 0.1;
+    const double designAttenuation = 60.0;
+    const double maxPassbandRipple = 0.1;
+    const double q15AttenuationLoss = 2.0;
+
+    // Multistage decimation factors, and the decimated waveform sizes
+    // (the input waveform is M times larger).
+    const std::vector<unsigned int> multistageFactors = {16, 32, 64, 96};
+    const std::vector<unsigned int> multistageOutputSizes = {32, 64, 128};
+
+    // Multistage decimation chain input block size.
+    const unsigned int chainBlockSize = 1024;
+
+    // CIC decimator order, the CIC decimates by M/2 and is followed by
+    // a decimate by 2 compensation filter.
+    const unsigned int cicOrder = 4;
+
+    std::unique_ptr<Results> results = std::make_unique<Results>();
 
     void addResult(unsigned int waveformSize, unsigned int M, const DecimateTestResult& result) {
-      resultMap->try_emplace(result.name);
-      (*resultMap)[result.name].try_emplace(M);
-      (*resultMap)[result.name][M][waveformSize] = result.elapsedTime;
+      results->executeTime[result.name][M][waveformSize] = result.elapsedTime;
+    }
+
+    // Profile a decimation chain and record its per stage cost.
+    template <typename T> void runChain(unsigned int waveformSize, unsigned int k, std::unique_ptr<DecimateStream<T>> chain, std::unique_ptr<std::vector<T>> waveform, const std::vector<DecimateStageCost>& profile) {
+      unsigned int M = chain->getM();
+      std::string name = chain->getName();
+
+      auto decimator = createBlockDecimate(std::move(chain), std::move(waveform), chainBlockSize);
+      addResult( waveformSize, M, executeDecimateTest(k, std::move(decimator)) );
+
+      results->stageCost[name][M] = profile;
+    }
+
+    // Verify the stream against a single block reference, then profile
+    // it decimating the waveform in streamBlockSize blocks.
+    template <typename T> void runStream(unsigned int waveformSize, unsigned int k, std::unique_ptr<DecimateStream<T>> stream, std::unique_ptr<DecimateStream<T>> reference, std::unique_ptr<std::vector<T>> waveform) {
+      verifyDecimateStream(*stream, *reference, *waveform);
+
+      unsigned int M = stream->getM();
+      auto decimator = createBlockDecimate(std::move(stream), std::move(waveform), streamBlockSize);
+      addResult( waveformSize, M, executeDecimateTest(k, std::move(decimator)) );
     }
     
+    // Verify the stream in irregular blocks against a single block
+    // reference, then profile the reference decimating the whole
+    // waveform in one block (as the arm_fir_decimate_* rows do).
+    template <typename T> void runWhole(unsigned int waveformSize, unsigned int k, std::unique_ptr<DecimateStream<T>> stream, std::unique_ptr<DecimateStream<T>> reference, std::unique_ptr<std::vector<T>> waveform) {
+      verifyDecimateStream(*stream, *reference, *waveform);
+
+      unsigned int M = reference->getM();
+      auto decimator = createBlockDecimate(std::move(reference), std::move(waveform), waveformSize);
+      addResult( waveformSize, M, executeDecimateTest(k, std::move(decimator)) );
+    }
+
+    // The filters are symmetric, time the folded decimators next to
+    // the arm_fir_decimate_* functions.
+    void runFolded(unsigned int waveformSize, unsigned int k, unsigned int M, CmsisTypeFactory& firFactory, CmsisTypeFactory& signalFactory, unsigned int rshift) {
+      runWhole(waveformSize, k,
+	       createFloat32FoldedDecimateStream(firFactory.toFloat32(), M, streamBlockSize),
+	       createFloat32FoldedDecimateStream(firFactory.toFloat32(), M, waveformSize),
+	       signalFactory.toFloat32());
+
+      runWhole(waveformSize, k,
+	       createQ31FoldedDecimateStream(firFactory.toQ31(), M, streamBlockSize, false),
+	       createQ31FoldedDecimateStream(firFactory.toQ31(), M, waveformSize, false),
+	       signalFactory.toQ31(rshift));
+
+      runWhole(waveformSize, k,
+	       createQ31FoldedDecimateStream(firFactory.toQ31(), M, streamBlockSize, true),
+	       createQ31FoldedDecimateStream(firFactory.toQ31(), M, waveformSize, true),
+	       signalFactory.toQ31(rshift));
+
+      runWhole(waveformSize, k,
+	       createQ15FoldedDecimateStream(firFactory.toQ15(), M, streamBlockSize, false),
+	       createQ15FoldedDecimateStream(firFactory.toQ15(), M, waveformSize, false),
+	       signalFactory.toQ15());
+
+      runWhole(waveformSize, k,
+	       createQ15FoldedDecimateStream(firFactory.toQ15(), M, streamBlockSize, true),
+	       createQ15FoldedDecimateStream(firFactory.toQ15(), M, waveformSize, true),
+	       signalFactory.toQ15(rshift));
+    }
+
+    template <typename F> static void verifyHalfBandRejected(F create) {
+      try {
+	create();
+      }
+      catch (const Ex&) {
+	return;
+      }
+      printf("FAIL half-band decimator accepted a filter that is not half-band\n");
+      throw Fail("half-band filter not rejected");
+    }
+
+    // Time the half-band decimators next to the arm_fir_decimate_*
+    // functions, with a half-band design of the same length as the
+    // M=2 filter.
+    void runHalfBands(unsigned int waveformSize, unsigned int k, unsigned int numTaps, CmsisTypeFactory& signalFactory) {
+      CmsisTypeFactory firFactory(createFirSource(designHalfBandLowpass(numTaps)));
+      const unsigned int rshift = signalFactory.getHeadroom(firFactory).rshift;
+
+      // The M=4 filter is not a half-band filter, its taps at an even
+      // distance from the center aren't zero.
+      CmsisTypeFactory notHalfBand(createFirSource(getDecimationFirSpec(4, numTaps)));
+      verifyHalfBandRejected([&]() { createFloat32HalfBandDecimateStream(notHalfBand.toFloat32(), streamBlockSize); });
+      verifyHalfBandRejected([&]() { createQ31HalfBandDecimateStream(notHalfBand.toQ31(), streamBlockSize, false); });
+      verifyHalfBandRejected([&]() { createQ15HalfBandDecimateStream(notHalfBand.toQ15(), streamBlockSize, false); });
+
+      runWhole(waveformSize, k,
+	       createFloat32HalfBandDecimateStream(firFactory.toFloat32(), streamBlockSize),
+	       createFloat32HalfBandDecimateStream(firFactory.toFloat32(), waveformSize),
+	       signalFactory.toFloat32());
+
+      runWhole(waveformSize, k,
+	       createQ31HalfBandDecimateStream(firFactory.toQ31(), streamBlockSize, false),
+	       createQ31HalfBandDecimateStream(firFactory.toQ31(), waveformSize, false),
+	       signalFactory.toQ31(rshift));
+
+      runWhole(waveformSize, k,
+	       createQ31HalfBandDecimateStream(firFactory.toQ31(), streamBlockSize, true),
+	       createQ31HalfBandDecimateStream(firFactory.toQ31(), waveformSize, true),
+	       signalFactory.toQ31(rshift));
+
+      runWhole(waveformSize, k,
+	       createQ15HalfBandDecimateStream(firFactory.toQ15(), streamBlockSize, false),
+	       createQ15HalfBandDecimateStream(firFactory.toQ15(), waveformSize, false),
+	       signalFactory.toQ15());
+
+      runWhole(waveformSize, k,
+	       createQ15HalfBandDecimateStream(firFactory.toQ15(), streamBlockSize, true),
+	       createQ15HalfBandDecimateStream(firFactory.toQ15(), waveformSize, true),
+	       signalFactory.toQ15(rshift));
+    }
+
     void run(unsigned int waveformSize, unsigned int decimationFactor) {
       unsigned int k = 2*decimationFactor;
       unsigned int M = decimationFactor;
 
-      CmsisTypeFactory firFactory(std::move(createFirSource(std::move(getDecimationFIR(M)))));
-
-      // Scaling for arm_fir_decimate_* that require scaling to avoid
-      // overflow.
-      const unsigned int numTaps = firFactory.getSource().size();
-      const unsigned int rshift = (unsigned int)std::ceil(std::log2(numTaps));
+      CmsisTypeFactory firFactory(createFirSource(getDecimationFirSpec(M)));
 
       printf("\ndecimate waveform size %d, filter size %d, M=%d\n", waveformSize, firFactory.getSource().size(), M);
     
       auto signal = std::make_unique<Signal>(waveformSize, (double)k, false);
       CmsisTypeFactory signalFactory(std::move(signal));
 
+      // Scaling for arm_fir_decimate_* that require scaling to avoid
+      // overflow.
+      const unsigned int rshift = signalFactory.getHeadroom(firFactory).rshift;
+
       {
 	auto decimator = createFloat32Decimate(std::move(firFactory.toFloat32()), std::move(signalFactory.toFloat32()), M);
 	addResult( waveformSize, M, executeDecimateTest(k, std::move(decimator)) );
@@ -96,23 +262,339 @@ namespace {
 	auto decimator = createQ15Decimate(std::move(firFactory.toQ15()), std::move(signalFactory.toQ15(rshift)), M, true);
 	addResult( waveformSize, M, executeDecimateTest(k, std::move(decimator)) );
       }
+
+      // Streaming decimation, same scaling requirements as above.
+      runStream(waveformSize, k,
+		createFloat32DecimateStream(firFactory.toFloat32(), M, streamBlockSize),
+		createFloat32DecimateStream(firFactory.toFloat32(), M, waveformSize),
+		signalFactory.toFloat32());
+
+      runStream(waveformSize, k,
+		createQ31DecimateStream(firFactory.toQ31(), M, streamBlockSize, false),
+		createQ31DecimateStream(firFactory.toQ31(), M, waveformSize, false),
+		signalFactory.toQ31(rshift));
+
+      runStream(waveformSize, k,
+		createQ31DecimateStream(firFactory.toQ31(), M, streamBlockSize, true),
+		createQ31DecimateStream(firFactory.toQ31(), M, waveformSize, true),
+		signalFactory.toQ31(rshift));
+
+      runStream(waveformSize, k,
+		createQ15DecimateStream(firFactory.toQ15(), M, streamBlockSize, false),
+		createQ15DecimateStream(firFactory.toQ15(), M, waveformSize, false),
+		signalFactory.toQ15());
+
+      runStream(waveformSize, k,
+		createQ15DecimateStream(firFactory.toQ15(), M, streamBlockSize, true),
+		createQ15DecimateStream(firFactory.toQ15(), M, waveformSize, true),
+		signalFactory.toQ15(rshift));
+
+      if (firFactory.isSymmetric()) {
+	runFolded(waveformSize, k, M, firFactory, signalFactory, rshift);
+      }
+
+      if (M == 2) {
+	runHalfBands(waveformSize, k, firFactory.getSource().size(), signalFactory);
+      }
     }
   
+    template <typename T> void runSweep(unsigned int numTaps, unsigned int blockSize, unsigned int k, std::unique_ptr<DecimateStream<T>> stream, std::unique_ptr<std::vector<T>> waveform) {
+      auto decimator = createBlockDecimate(std::move(stream), std::move(waveform), blockSize);
+      DecimateTestResult result = executeDecimateTest(k, std::move(decimator));
+      results->sweep.elapsedTime[result.name][numTaps][blockSize] = result.elapsedTime;
+    }
+
+    // Time the streaming decimators for each block size, same scaling
+    // requirements as the single stage decimators above.
+    void runSweep(unsigned int numTaps) {
+      const unsigned int M = sweepM;
+      const unsigned int k = 2*M;
+
+      CmsisTypeFactory firFactory(createFirSource(getDecimationFirSpec(M, numTaps)));
+      CmsisTypeFactory signalFactory(std::make_unique<Signal>(sweepWaveformSize, (double)k, false));
+      const unsigned int rshift = signalFactory.getHeadroom(firFactory).rshift;
+
+      for (unsigned int blockSize: sweepBlockSizes) {
+	printf("\ndecimate sweep waveform size %d, filter size %d, block size %d, M=%d\n", sweepWaveformSize, numTaps, blockSize, M);
+
+	runSweep(numTaps, blockSize, k, createFloat32DecimateStream(firFactory.toFloat32(), M, blockSize), signalFactory.toFloat32());
+	runSweep(numTaps, blockSize, k, createQ31DecimateStream(firFactory.toQ31(), M, blockSize, false), signalFactory.toQ31(rshift));
+	runSweep(numTaps, blockSize, k, createQ31DecimateStream(firFactory.toQ31(), M, blockSize, true), signalFactory.toQ31(rshift));
+	runSweep(numTaps, blockSize, k, createQ15DecimateStream(firFactory.toQ15(), M, blockSize, false), signalFactory.toQ15());
+	runSweep(numTaps, blockSize, k, createQ15DecimateStream(firFactory.toQ15(), M, blockSize, true), signalFactory.toQ15(rshift));
+
+	runSweep(numTaps, blockSize, k, createFloat32FoldedDecimateStream(firFactory.toFloat32(), M, blockSize), signalFactory.toFloat32());
+	runSweep(numTaps, blockSize, k, createQ31FoldedDecimateStream(firFactory.toQ31(), M, blockSize, false), signalFactory.toQ31(rshift));
+	runSweep(numTaps, blockSize, k, createQ15FoldedDecimateStream(firFactory.toQ15(), M, blockSize, false), signalFactory.toQ15());
+      }
+    }
+
+    static std::unique_ptr<std::vector<q31_t>> toFixed(CmsisTypeFactory& factory, const Headroom& headroom, q31_t) {
+      return factory.toQ31(headroom);
+    }
+
+    static std::unique_ptr<std::vector<q15_t>> toFixed(CmsisTypeFactory& factory, const Headroom& headroom, q15_t) {
+      return factory.toQ15(headroom);
+    }
+
+    template <typename T> void runHeadroom(unsigned int numTaps, std::unique_ptr<DecimateStream<T>> stream, const Headroom& worstCase, const Headroom& headroom, CmsisTypeFactory& firFactory, CmsisTypeFactory& signalFactory) {
+      auto fir = firFactory.toFloat64();
+      auto signal = signalFactory.toFloat64();
+
+      HeadroomSnr& snr = results->headroomSnr[stream->getName()][numTaps];
+      snr.l1Norm = headroom.l1Norm;
+      snr.worstCaseShift = worstCase.rshift;
+      snr.worstCaseSnr = executeHeadroomTest(*stream, *toFixed(signalFactory, worstCase, T()), worstCase, *fir, *signal);
+      snr.headroomShift = headroom.rshift;
+      snr.headroomSnr = executeHeadroomTest(*stream, *toFixed(signalFactory, headroom, T()), headroom, *fir, *signal);
+
+      // the headroom shift is no larger, it can't lose precision
+      // unless the output overflows (tens of dB). The q31 snr is
+      // limited by the float32_t signal precision for either shift,
+      // allow for rounding noise.
+      if (snr.headroomSnr < snr.worstCaseSnr - snrTolerance) {
+	printf("FAIL %s headroom snr %.1f dB < worst case snr %.1f dB\n", stream->getName().c_str(), snr.headroomSnr, snr.worstCaseSnr);
+	throw Fail("headroom snr error");
+      }
+    }
+
+    // Compare the SNR of the fixed point streaming decimators with the
+    // worst case log2(numTaps) input scaling and the headroom scaling.
+    void runHeadroom(unsigned int numTaps) {
+      const unsigned int M = sweepM;
+      const unsigned int k = 2*M;
+
+      CmsisTypeFactory firFactory(createFirSource(getDecimationFirSpec(M, numTaps)));
+      CmsisTypeFactory signalFactory(std::make_unique<Signal>(sweepWaveformSize, (double)k, false));
+
+      Headroom headroom = signalFactory.getHeadroom(firFactory);
+      Headroom worstCase = headroom;
+      worstCase.rshift = (unsigned int)std::ceil(std::log2(numTaps));
+
+      printf("\ndecimate headroom waveform size %d, filter size %d, M=%d\n", sweepWaveformSize, numTaps, M);
+
+      runHeadroom(numTaps, createQ31DecimateStream(firFactory.toQ31(), M, sweepWaveformSize, false), worstCase, headroom, firFactory, signalFactory);
+      runHeadroom(numTaps, createQ31DecimateStream(firFactory.toQ31(), M, sweepWaveformSize, true), worstCase, headroom, firFactory, signalFactory);
+      runHeadroom(numTaps, createQ15DecimateStream(firFactory.toQ15(), M, sweepWaveformSize, true), worstCase, headroom, firFactory, signalFactory);
+    }
+
+    template <typename T> void verifyHeadroomSnr(std::unique_ptr<DecimateStream<T>> stream, const Headroom& headroom, CmsisTypeFactory& firFactory, CmsisTypeFactory& signalFactory, double minSnr) {
+      const double snr = executeHeadroomTest(*stream, *toFixed(signalFactory, headroom, T()), headroom, *firFactory.toFloat64(), *signalFactory.toFloat64());
+      if (snr < minSnr) {
+	printf("FAIL %s headroom snr %.1f dB < %.1f dB\n", stream->getName().c_str(), snr, minSnr);
+	throw Fail("headroom snr error");
+      }
+    }
+
+    // Decimate a signal whose peak needs no headroom shift, yet is
+    // large enough for the sum of a symmetric tap pair to exceed full
+    // scale, with the folded and half-band streams.
+    void runHeadroomPeak() {
+      const unsigned int M = sweepM;
+      const unsigned int numTaps = 31;
+
+      CmsisTypeFactory signalFactory(createMultitoneSource(sweepWaveformSize, {{1.0 / (4.0*M), peakSignalAmplitude}}));
+      CmsisTypeFactory folded(createFirSource(getDecimationFirSpec(M, numTaps)));
+      CmsisTypeFactory halfBand(createFirSource(designHalfBandLowpass(numTaps)));
+
+      printf("\ndecimate headroom waveform size %d, filter size %d, peak %.2f\n", sweepWaveformSize, numTaps, signalFactory.getPeak());
+
+      Headroom foldedHeadroom = signalFactory.getHeadroom(folded);
+      Headroom halfBandHeadroom = signalFactory.getHeadroom(halfBand);
+      if (foldedHeadroom.rshift != 0 || halfBandHeadroom.rshift != 0) {
+	printf("FAIL headroom rshift %d, %d != 0\n", foldedHeadroom.rshift, halfBandHeadroom.rshift);
+	throw Fail("headroom rshift error");
+      }
+
+      verifyHeadroomSnr(createQ31FoldedDecimateStream(folded.toQ31(), M, sweepWaveformSize, false), foldedHeadroom, folded, signalFactory, minPeakSnrQ31);
+      verifyHeadroomSnr(createQ31FoldedDecimateStream(folded.toQ31(), M, sweepWaveformSize, true), foldedHeadroom, folded, signalFactory, minPeakSnrQ31);
+      verifyHeadroomSnr(createQ15FoldedDecimateStream(folded.toQ15(), M, sweepWaveformSize, true), foldedHeadroom, folded, signalFactory, minPeakSnrQ15);
+      verifyHeadroomSnr(createQ31HalfBandDecimateStream(halfBand.toQ31(), sweepWaveformSize, false), halfBandHeadroom, halfBand, signalFactory, minPeakSnrQ31);
+      verifyHeadroomSnr(createQ31HalfBandDecimateStream(halfBand.toQ31(), sweepWaveformSize, true), halfBandHeadroom, halfBand, signalFactory, minPeakSnrQ31);
+      verifyHeadroomSnr(createQ15HalfBandDecimateStream(halfBand.toQ15(), sweepWaveformSize, true), halfBandHeadroom, halfBand, signalFactory, minPeakSnrQ15);
+    }
+
+    // The largest passband deviation (dB) from unity gain and the
+    // smallest stopband attenuation (dB) of the fir, the coefficients
+    // scaled by 1/scale.
+    template <typename T> static std::pair<double, double> measureFir(const std::vector<T>& coefficients, double scale, const FirSpec& spec) {
+      std::vector<double> fir(coefficients.size());
+      std::transform(coefficients.cbegin(), coefficients.cend(), fir.begin(), [scale](T x) { return (double)x / scale; });
+
+      const unsigned int points = 1000;
+      double ripple = 0.0;
+      double attenuation = HUGE_VAL;
+      for (unsigned int i = 0; i <= points; i++) {
+	const double passband = spec.passband * i / points;
+	const double stopband = spec.stopband + (1.0 - spec.stopband) * i / points;
+	ripple = std::max(ripple, std::fabs(20.0 * std::log10(firMagnitude(fir, passband))));
+	attenuation = std::min(attenuation, -20.0 * std::log10(firMagnitude(fir, stopband)));
+      }
+      return std::make_pair(ripple, attenuation);
+    }
+
+    template <typename T> void verifyFir(const char* type, const std::vector<T>& coefficients, double scale, const FirSpec& spec, double minAttenuation) {
+      const std::pair<double, double> measured = measureFir(coefficients, scale, spec);
+      printf("%s fir, %d taps, passband ripple %.3f dB, stopband attenuation %.1f dB\n", type, spec.numTaps, measured.first, measured.second);
+      if (measured.first > maxPassbandRipple || measured.second < minAttenuation) {
+	printf("FAIL %s fir ripple %.3f dB > %.3f dB or attenuation %.1f dB < %.1f dB\n", type, measured.first, maxPassbandRipple, measured.second, minAttenuation);
+	throw Fail("fir design error");
+      }
+    }
+
+    // Check the designed filter and its quantizations against the
+    // spec, then verify the streaming decimators with the quantized
+    // coefficients (createFirSource(const FirSpec&)).
+    void runDesign(FirMethod method, unsigned int numTaps) {
+      const unsigned int M = designM;
+      const FirSpec spec = getDecimationFirSpec(M, numTaps, method, designTransitionWidth, designAttenuation);
+
+      printf("\ndecimate fir design method %d, filter size %d, M=%d\n", (int)method, numTaps, M);
+
+      verifyFir("float64", getFir(spec), 1.0, spec, designAttenuation);
+      verifyFir("float32", getQuantizedFir<float32_t>(spec), 1.0, spec, designAttenuation);
+      verifyFir("q31", getQuantizedFir<q31_t>(spec), std::ldexp(1.0, 31), spec, designAttenuation);
+      verifyFir("q15", getQuantizedFir<q15_t>(spec), std::ldexp(1.0, 15), spec, designAttenuation - q15AttenuationLoss);
+
+      CmsisTypeFactory firFactory(createFirSource(spec));
+      CmsisTypeFactory signalFactory(std::make_unique<Signal>(sweepWaveformSize, (double)(2*M), false));
+      const unsigned int rshift = signalFactory.getHeadroom(firFactory).rshift;
+
+      auto q31 = signalFactory.toQ31(rshift);
+      verifyDecimateStream(*createQ31DecimateStream(firFactory.toQ31(), M, streamBlockSize, false), *createQ31DecimateStream(firFactory.toQ31(), M, sweepWaveformSize, false), *q31);
+      verifyDecimateStream(*createQ31FoldedDecimateStream(firFactory.toQ31(), M, streamBlockSize, false), *createQ31FoldedDecimateStream(firFactory.toQ31(), M, sweepWaveformSize, false), *q31);
+
+      auto q15 = signalFactory.toQ15(rshift);
+      verifyDecimateStream(*createQ15DecimateStream(firFactory.toQ15(), M, streamBlockSize, true), *createQ15DecimateStream(firFactory.toQ15(), M, sweepWaveformSize, true), *q15);
+      verifyDecimateStream(*createQ15FoldedDecimateStream(firFactory.toQ15(), M, streamBlockSize, true), *createQ15FoldedDecimateStream(firFactory.toQ15(), M, sweepWaveformSize, true), *q15);
+    }
+
+    // Decimate by a large factor with a chain planned by
+    // planDecimation().
+    void runMultistage(unsigned int outputSize, unsigned int M) {
+      const unsigned int waveformSize = M * outputSize;
+      const unsigned int k = 2*M;
+
+      // The test signal is at half the output nyquist frequency.
+      const DecimationSpec spec(M, 0.8, 1.0, 0.1, 60.0);
+
+      printf("\nmultistage decimate waveform size %d, M=%d\n", waveformSize, M);
+
+      CmsisTypeFactory signalFactory(std::make_unique<Signal>(waveformSize, (double)k, false));
+
+      std::vector<DecimateStageCost> profile;
+
+      {
+	DecimationPlan plan = planDecimation<float32_t>(spec);
+	printf("plan %s, %.0f MACs per output\n", plan.describe().c_str(), plan.macsPerOutput);
+	runChain(waveformSize, k, createFloat32DecimateChain(plan, chainBlockSize, &profile), signalFactory.toFloat32(), profile);
+	results->passbandDroop[M]["fir_chain"] = chainPassbandGain(plan, spec);
+      }
+
+      // Scale fixed point input for the largest stage filter, same
+      // scaling requirements as the single stage decimators above.
+      {
+	DecimationPlan plan = planDecimation<q31_t>(spec);
+	const unsigned int rshift = maxStageRShift(plan);
+	runChain(waveformSize, k, createQ31DecimateChain(plan, chainBlockSize, false, &profile), signalFactory.toQ31(rshift), profile);
+	runChain(waveformSize, k, createQ31DecimateChain(plan, chainBlockSize, true, &profile), signalFactory.toQ31(rshift), profile);
+      }
+
+      {
+	DecimationPlan plan = planDecimation<q15_t>(spec);
+	const unsigned int rshift = maxStageRShift(plan);
+	runChain(waveformSize, k, createQ15DecimateChain(plan, chainBlockSize, false, &profile), signalFactory.toQ15(), profile);
+	runChain(waveformSize, k, createQ15DecimateChain(plan, chainBlockSize, true, &profile), signalFactory.toQ15(rshift), profile);
+      }
+
+      if (M % 2 == 0) {
+	runCic(waveformSize, k, spec, signalFactory);
+      }
+
+      results->singleStageMacsPerOutput[M] = planDecimation<float32_t>(spec, 1).macsPerOutput;
+    }
+
+    // CIC decimate by M/2 and a compensation filter with the
+    // specification's transition band (normalized to the compensation
+    // filter input Nyquist frequency the final passband and stopband
+    // are halved).
+    void runCic(unsigned int waveformSize, unsigned int k, const DecimationSpec& spec, CmsisTypeFactory& signalFactory) {
+      const unsigned int R = spec.M / 2;
+      const double passband = spec.passband / 2.0;
+      const double stopband = spec.stopband / 2.0;
+
+      auto compensator = designCicCompensator(kaiserNumTaps(spec.stopbandAttenuation, stopband - passband), (passband + stopband) / 2.0, kaiserBeta(spec.stopbandAttenuation), cicOrder, R);
+
+      // See createQ31CicCompensatedDecimateStream() scaling
+      // requirements.
+      const unsigned int rshift = cicBitGrowth(cicOrder, R) + 1;
+
+      auto q31 = createQ31CicCompensatedDecimateStream(cicOrder, R, *compensator, chainBlockSize);
+      addResult( waveformSize, spec.M, executeDecimateTest(k, createBlockDecimate(std::move(q31), signalFactory.toQ31(rshift), chainBlockSize)) );
+
+      auto q15 = createQ15CicCompensatedDecimateStream(cicOrder, R, *compensator, chainBlockSize);
+      addResult( waveformSize, spec.M, executeDecimateTest(k, createBlockDecimate(std::move(q15), signalFactory.toQ15(), chainBlockSize)) );
+
+      const double cicGain = cicMagnitude(cicOrder, R, passband);
+      results->passbandDroop[spec.M]["cic"] = 20.0 * std::log10(cicGain);
+      results->passbandDroop[spec.M]["cic_comp"] = 20.0 * std::log10(cicGain * firMagnitude(*compensator, passband));
+    }
+
+    // The gain (dB) of the decimation chain at the passband edge, the
+    // product of the stage filter gains at their input rates.
+    static double chainPassbandGain(const DecimationPlan& plan, const DecimationSpec& spec) {
+      double f = spec.passband / spec.M;
+      double gain = 1.0;
+      for (auto& stage: plan.stages) {
+	gain *= firMagnitude(stage.fir, f);
+	f *= stage.M;
+      }
+      return 20.0 * std::log10(gain);
+    }
+
+    static unsigned int maxStageRShift(const DecimationPlan& plan) {
+      unsigned int numTaps = 0;
+      for (auto& stage: plan.stages) {
+	numTaps = std::max(numTaps, (unsigned int)stage.fir.size());
+      }
+      return (unsigned int)std::ceil(std::log2(numTaps));
+    }
+
   public:
 
-    std::unique_ptr<NameToFactorElapsedTimeMap> runAll() {
+    std::unique_ptr<Results> runAll() {
       for(unsigned int size: sizes) {
 	for (unsigned int M: decimationFactors) {
 	  run(size, M);
 	}
       }
 
-      return std::move(resultMap);
+      results->sweep.M = sweepM;
+      results->sweep.waveformSize = sweepWaveformSize;
+      for (unsigned int numTaps: sweepTaps) {
+	runSweep(numTaps);
+      }
+
+      for (unsigned int numTaps: sweepTaps) {
+	runHeadroom(numTaps);
+      }
+      runHeadroomPeak();
+
+      runDesign(FirMethod::EQUIRIPPLE, equirippleTaps);
+      runDesign(FirMethod::KAISER, kaiserNumTaps(designAttenuation, designTransitionWidth));
+
+      for (unsigned int size: multistageOutputSizes) {
+	for (unsigned int M: multistageFactors) {
+	  runMultistage(size, M);
+	}
+      }
+
+      return std::move(results);
     }
   };
 
 } // namespace
 
-std::unique_ptr<NameToFactorElapsedTimeMap> runAllDecimateTests() {
+std::unique_ptr<Results> runAllDecimateTests() {
   return DecimateTestRunner().runAll();
 }
@@ -4,8 +4,12 @@
 #ifndef PICO_CMSIS_SANDBOX_DECIMATETESTRUNNER_H_INCLUDED
 #define PICO_CMSIS_SANDBOX_DECIMATETESTRUNNER_H_INCLUDED
 
+#include "DecimatePlanner.h"
+
 #include <memory>
 #include <map>
+#include <string>
+#include <vector>
 
 namespace decimate {
   // map size to elapsed time
@@ -16,8 +20,73 @@ namespace decimate {
 
   // map decimation factor to elapsed time map
   typedef std::map<std::string, FactorToElapsedTimeMap> NameToFactorElapsedTimeMap;
+
+  // map decimation factor to the per stage cost of a decimation chain
+  typedef std::map<unsigned int, std::vector<DecimateStageCost>> FactorToStageCostMap;
+
+  // map decimation chain name to stage cost map
+  typedef std::map<std::string, FactorToStageCostMap> NameToFactorStageCostMap;
+
+  // map processing block size to elapsed time
+  typedef std::map<unsigned int, unsigned long> BlockSizeToElapsedTimeMap;
+
+  // map filter length (taps) to block size map
+  typedef std::map<unsigned int, BlockSizeToElapsedTimeMap> TapsToElapsedTimeMap;
+
+  // map decimator name to filter length map
+  typedef std::map<std::string, TapsToElapsedTimeMap> NameToTapsElapsedTimeMap;
+
+  // The SNR of a fixed point decimator with the input scaled down by
+  // the worst case log2(numTaps) bits, and by the headroom shift (see
+  // Headroom.h), the outputs compensated by the same shift.
+  struct HeadroomSnr {
+    double l1Norm = 0.0;
+    unsigned int worstCaseShift = 0;
+    double worstCaseSnr = 0.0;
+    unsigned int headroomShift = 0;
+    double headroomSnr = 0.0;
+  };
+
+  // map filter length (taps) to headroom snr
+  typedef std::map<unsigned int, HeadroomSnr> TapsToHeadroomSnrMap;
+
+  // map decimator name to filter length map
+  typedef std::map<std::string, TapsToHeadroomSnrMap> NameToTapsHeadroomSnrMap;
+
+  // Filter length and processing block size sweep of the streaming
+  // decimators, at one decimation factor and waveform size.
+  struct Sweep {
+    unsigned int M = 0;
+    unsigned int waveformSize = 0;
+    NameToTapsElapsedTimeMap elapsedTime;
+  };
+
+  struct Results {
+    // decimation execution time
+    NameToFactorElapsedTimeMap executeTime;
+
+    // multistage decimation chain stage costs (largest waveform size)
+    NameToFactorStageCostMap stageCost;
+
+    // single stage MACs per output sample for the multistage
+    // decimation specification, by decimation factor
+    std::map<unsigned int, double> singleStageMacsPerOutput;
+
+    // passband edge gain (dB) of the multistage decimators, by
+    // decimation factor and decimator ("fir_chain", "cic",
+    // "cic_comp")
+    std::map<unsigned int, std::map<std::string, double>> passbandDroop;
+
+    // streaming decimator execution time by filter length and block
+    // size
+    Sweep sweep;
+
+    // fixed point decimator SNR by input scaling, at the sweep
+    // decimation factor and waveform size
+    NameToTapsHeadroomSnrMap headroomSnr;
+  };
 }
 
-std::unique_ptr<decimate::NameToFactorElapsedTimeMap> runAllDecimateTests();
+std::unique_ptr<decimate::Results> runAllDecimateTests();
 
 #endif
@@ -6,7 +6,17 @@
 #include "MemDebug.h"
 #include "FftTestRunner.h"
 #include "DecimateTestRunner.h"
+#include "ResampleTestRunner.h"
+#include "StftTestRunner.h"
+#include "GoertzelTestRunner.h"
+#include "WelchTestRunner.h"
+#include "FastFirTestRunner.h"
+#include "SourceTestRunner.h"
 #include "Report.h"
+#include "Instrument.h"
+#include "FftPlan.h"
+#include "FirDesign.h"
+#include "Goertzel.h"
 #include "Ex.h"
 
 #include <iostream>
@@ -16,11 +26,24 @@ int dsp_main() {
   int rc = 0;
   
   try {
-    std::unique_ptr<fft::NameToElapsedTimeMap> fftResultMap = runAllFftTests();
-    std::unique_ptr<decimate::NameToFactorElapsedTimeMap> decimateResultMap = runAllDecimateTests();
+    std::unique_ptr<fft::Results> fftResults = runAllFftTests();
+    std::unique_ptr<decimate::Results> decimateResults = runAllDecimateTests();
+    std::unique_ptr<resample::NameToRatioElapsedTimeMap> resampleResultMap = runAllResampleTests();
+    std::unique_ptr<stft::Results> stftResults = runAllStftTests();
+    std::unique_ptr<goertzel::Results> goertzelResults = runAllGoertzelTests();
+    std::unique_ptr<welch::Results> welchResults = runAllWelchTests();
+    std::unique_ptr<fastfir::Results> fastFirResults = runAllFastFirTests();
+    std::unique_ptr<source::Results> sourceResults = runAllSourceTests();
 
-    reportFftResults(*fftResultMap);
-    reportDecimateResults(*decimateResultMap);
+    reportFftResults(*fftResults);
+    reportDecimateResults(*decimateResults);
+    reportResampleResults(*resampleResultMap);
+    reportStftResults(*stftResults);
+    reportGoertzelResults(*goertzelResults);
+    reportWelchResults(*welchResults);
+    reportFastFirResults(*fastFirResults);
+    reportSourceResults(*sourceResults);
+    reportInstrumentResults(instrument::getResults());
 
     std::cout << std::endl << "SUCCESS" << std::endl;
   }
@@ -33,6 +56,11 @@ int dsp_main() {
     rc = 1;
   }
   
+  clearFftPlanCache();
+  clearFirDesignCache();
+  clearBinDetectorCostCache();
+  instrument::reset();
+
   memDebugReport("allocated memory at exit:");
 
   return rc;
@@ -0,0 +1,383 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "FastFir.h"
+
+#include "CmsisFft.h"
+#include "Instrument.h"
+#include "Ex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+  const unsigned int minFftLength = 64;
+  const unsigned int maxFftLength = 4096;
+
+  // Map the data type to the type of its fft pipeline, q15 filters run
+  // a q31 pipeline (see FastFir.h).
+  template <typename T> struct FastFirWork { typedef T type; };
+  template <> struct FastFirWork<q15_t> { typedef q31_t type; };
+
+  // A filter coefficient as a real number.
+  double fromCoefficient(float32_t c) {
+    return c;
+  }
+
+  double fromCoefficient(q31_t c) {
+    return c / 2147483648.0;
+  }
+
+  double fromCoefficient(q15_t c) {
+    return c / 32768.0;
+  }
+
+  std::string methodName(FastFirMethod method) {
+    return method == FastFirMethod::OVERLAP_SAVE ? "ols" : "ola";
+  }
+
+  // The block size, fftLength - numTaps + 1. Throws Ex if there are
+  // no taps, or as many taps as the fft length.
+  unsigned int toBlockSize(const std::string& name, unsigned int numTaps, unsigned int fftLength) {
+    if (numTaps == 0 || numTaps >= fftLength) {
+      throw Ex(name + " number of taps must be less than the fft length");
+    }
+    return fftLength - numTaps + 1;
+  }
+
+  template <typename T> class CmsisFastFir : public FastFir<T> {
+
+    CmsisFastFir();
+
+  protected:
+
+    typedef typename FastFirWork<T>::type W;
+
+    // the implementation name
+    const std::string name;
+
+    const FastFirMethod method;
+
+    const unsigned int numTaps;
+
+    const unsigned int fftLength;
+
+    const unsigned int blockSize;
+
+    std::unique_ptr<SpanFft<W>> fft;
+
+    // The filter spectrum, the first getMultiplySize() values of the
+    // span fft spectrum layout.
+    std::vector<W> filterSpectrum;
+
+    // Overlap save, the last numTaps-1 input samples followed by the
+    // block. Unused by overlap add.
+    std::vector<W> frame;
+
+    // the fft input, and the inverse fft output
+    std::vector<W> fftIn;
+
+    std::vector<W> spectrum;
+
+    // Overlap add, the last numTaps-1 inverse samples of the previous
+    // block. Unused by overlap save.
+    std::vector<W> tail;
+
+    // The impulse response padded to fftLength as real numbers, the
+    // input to initFilterSpectrum(). The coefficients are time
+    // reversed, as arm_fir_* coefficients are.
+    static std::vector<float64_t> toPaddedFilter(const std::vector<T>& fir, unsigned int fftLength) {
+      std::vector<float64_t> padded(fftLength);
+      std::transform(fir.crbegin(), fir.crend(), padded.begin(), [](T c) { return fromCoefficient(c); });
+      return padded;
+    }
+
+    // The number of spectrum values multiplied by the filter spectrum.
+    virtual unsigned int getMultiplySize() const = 0;
+
+    // Convert the arm_rfft_fast_f64 packed spectrum of the padded
+    // filter to the filter spectrum.
+    virtual void initFilterSpectrum(const std::vector<float64_t>& packed) = 0;
+
+    // Multiply the spectrum by the filter spectrum, in place.
+    virtual void multiply() = 0;
+
+    virtual void toWork(const T* in, W* out, unsigned int n) = 0;
+
+    virtual void fromWork(const W* in, T* out, unsigned int n) = 0;
+
+  private:
+
+    void processOverlapSave(const T* in, T* out) {
+      const unsigned int history = numTaps - 1;
+      toWork(in, frame.data() + history, blockSize);
+      std::copy(frame.cbegin(), frame.cend(), fftIn.begin());
+
+      fft->spectrum(fftIn, spectrum);
+      multiply();
+      fft->inverse(spectrum, fftIn);
+
+      fromWork(fftIn.data() + history, out, blockSize);
+      std::copy(frame.cbegin() + blockSize, frame.cend(), frame.begin());
+    }
+
+    void processOverlapAdd(const T* in, T* out) {
+      const unsigned int history = numTaps - 1;
+      toWork(in, fftIn.data(), blockSize);
+      std::fill(fftIn.begin() + blockSize, fftIn.end(), 0);
+
+      fft->spectrum(fftIn, spectrum);
+      multiply();
+      fft->inverse(spectrum, fftIn);
+
+      for (unsigned int i = 0; i < history; i++) {
+	fftIn[i] += tail[i];
+      }
+      fromWork(fftIn.data(), out, blockSize);
+      std::copy(fftIn.cbegin() + blockSize, fftIn.cend(), tail.begin());
+    }
+
+  public:
+
+    CmsisFastFir(const std::string& name, const std::vector<T>& fir, unsigned int fftLength, FastFirMethod method, std::unique_ptr<SpanFft<W>> fft)
+      : name(name + "_" + methodName(method)),
+	method(method),
+	numTaps(fir.size()),
+	fftLength(fftLength),
+	blockSize(toBlockSize(this->name, numTaps, fftLength)),
+	fft(std::move(fft)),
+	frame(method == FastFirMethod::OVERLAP_SAVE ? fftLength : 0),
+	fftIn(fftLength),
+	spectrum(this->fft->getSpectrumSize()),
+	tail(method == FastFirMethod::OVERLAP_ADD ? numTaps - 1 : 0)
+    {}
+
+    // Compute the filter spectrum. Not done by the constructor, it
+    // calls virtual functions.
+    void init(const std::vector<T>& fir) {
+      std::vector<float64_t> padded = toPaddedFilter(fir, fftLength);
+      std::vector<float64_t> packed(fftLength);
+      createFloat64SpanFft(fftLength)->spectrum(padded, packed);
+      filterSpectrum.resize(getMultiplySize());
+      initFilterSpectrum(packed);
+    }
+
+    virtual const std::string& getName() const {
+      return name;
+    }
+
+    virtual FastFirMethod getMethod() const {
+      return method;
+    }
+
+    virtual unsigned int getNumTaps() const {
+      return numTaps;
+    }
+
+    virtual unsigned int getFftLength() const {
+      return fftLength;
+    }
+
+    virtual unsigned int getBlockSize() const {
+      return blockSize;
+    }
+
+    virtual void process(const T* in, unsigned int numSamples, T* out) {
+      if (numSamples % blockSize != 0) {
+	throw Ex(name + " number of samples is not a multiple of the block size");
+      }
+      instrument::recordInput("fast_fir", name, in, numSamples);
+      for (unsigned int i = 0; i < numSamples; i += blockSize) {
+	if (method == FastFirMethod::OVERLAP_SAVE) {
+	  processOverlapSave(in + i, out + i);
+	}
+	else {
+	  processOverlapAdd(in + i, out + i);
+	}
+      }
+      instrument::recordOutput("fast_fir", name, out, numSamples);
+    }
+
+    virtual void reset() {
+      std::fill(frame.begin(), frame.end(), 0);
+      std::fill(tail.begin(), tail.end(), 0);
+    }
+  };
+
+  // The arm_rfft_fast_f32 pipeline. The packed spectrum holds the real
+  // DC and Nyquist values in its first complex pair, they're multiplied
+  // separately.
+  class Float32FastFir : public CmsisFastFir<float32_t> {
+
+    Float32FastFir();
+
+  protected:
+
+    virtual unsigned int getMultiplySize() const {
+      return fftLength;
+    }
+
+    virtual void initFilterSpectrum(const std::vector<float64_t>& packed) {
+      std::copy(packed.cbegin(), packed.cend(), filterSpectrum.begin());
+    }
+
+    virtual void multiply() {
+      const float32_t dc = spectrum[0] * filterSpectrum[0];
+      const float32_t nyquist = spectrum[1] * filterSpectrum[1];
+      arm_cmplx_mult_cmplx_f32(spectrum.data(), filterSpectrum.data(), spectrum.data(), fftLength / 2);
+      spectrum[0] = dc;
+      spectrum[1] = nyquist;
+    }
+
+    virtual void toWork(const float32_t* in, float32_t* out, unsigned int n) {
+      std::copy(in, in + n, out);
+    }
+
+    virtual void fromWork(const float32_t* in, float32_t* out, unsigned int n) {
+      std::copy(in, in + n, out);
+    }
+
+  public:
+
+    Float32FastFir(const std::vector<float32_t>& fir, unsigned int fftLength, FastFirMethod method)
+      : CmsisFastFir<float32_t>("f32", fir, fftLength, method, createFloat32SpanFft(fftLength))
+    {}
+  };
+
+  // The arm_rfft_q31 pipeline, bins 0 to fftLength/2 are multiplied.
+  //
+  // The forward fft scales the input down by fftLength, the filter
+  // spectrum is scaled by 2^filterShift (the largest power of two
+  // that keeps its peak magnitude below 1.0), and
+  // arm_cmplx_mult_cmplx_q31 output is Q3.29. Therefore the inverse
+  // fft output is the filter output scaled by
+  // 2^(filterShift - 2) / fftLength, and it's shifted up by
+  // log2(fftLength) + 2 - filterShift.
+  template <typename T> class FixedFastFir : public CmsisFastFir<T> {
+
+    FixedFastFir();
+
+  protected:
+
+    // the output shift, computed by initFilterSpectrum()
+    int outputShift = 0;
+
+    virtual unsigned int getMultiplySize() const {
+      return this->fftLength + 2;
+    }
+
+    virtual void initFilterSpectrum(const std::vector<float64_t>& packed) {
+      const unsigned int n = this->fftLength;
+
+      // unpack the DC and Nyquist values
+      std::vector<float64_t> unpacked(n + 2);
+      std::copy(packed.cbegin() + 2, packed.cend(), unpacked.begin() + 2);
+      unpacked[0] = packed[0];
+      unpacked[n] = packed[1];
+
+      double peak = 0.0;
+      for (unsigned int k = 0; k <= n/2; k++) {
+	peak = std::max(peak, std::hypot(unpacked[2*k], unpacked[2*k + 1]));
+      }
+      const int filterShift = -(int)std::floor(std::log2(peak)) - 1;
+      outputShift = std::lround(std::log2(n)) + 2 - filterShift;
+
+      const double scale = std::ldexp(2147483648.0, filterShift);
+      std::transform(unpacked.cbegin(), unpacked.cend(), this->filterSpectrum.begin(), [scale](float64_t v) {
+	return (q31_t)std::clamp(std::llround(v * scale), -2147483648LL, 2147483647LL);
+      });
+    }
+
+    virtual void multiply() {
+      arm_cmplx_mult_cmplx_q31(this->spectrum.data(), this->filterSpectrum.data(), this->spectrum.data(), this->fftLength / 2 + 1);
+    }
+
+  public:
+
+    FixedFastFir(const std::string& name, const std::vector<T>& fir, unsigned int fftLength, FastFirMethod method)
+      : CmsisFastFir<T>(name, fir, fftLength, method, createQ31SpanFft(fftLength))
+    {}
+  };
+
+  class Q31FastFir : public FixedFastFir<q31_t> {
+
+    Q31FastFir();
+
+  protected:
+
+    virtual void toWork(const q31_t* in, q31_t* out, unsigned int n) {
+      std::copy(in, in + n, out);
+    }
+
+    virtual void fromWork(const q31_t* in, q31_t* out, unsigned int n) {
+      arm_shift_q31(in, outputShift, out, n);
+    }
+
+  public:
+
+    Q31FastFir(const std::vector<q31_t>& fir, unsigned int fftLength, FastFirMethod method)
+      : FixedFastFir<q31_t>("q31", fir, fftLength, method)
+    {}
+  };
+
+  // q15 input is shifted up to q31, the q31 output is rounded to q15
+  // and saturated.
+  class Q15FastFir : public FixedFastFir<q15_t> {
+
+    Q15FastFir();
+
+  protected:
+
+    virtual void toWork(const q15_t* in, q31_t* out, unsigned int n) {
+      for (unsigned int i = 0; i < n; i++) {
+	out[i] = (q31_t)in[i] << 16;
+      }
+    }
+
+    virtual void fromWork(const q31_t* in, q15_t* out, unsigned int n) {
+      const int shift = outputShift - 16;
+      const q63_t round = shift < 0 ? (q63_t)1 << (-shift - 1) : 0;
+      for (unsigned int i = 0; i < n; i++) {
+	const q63_t v = shift < 0 ? ((q63_t)in[i] + round) >> -shift : (q63_t)in[i] << shift;
+	out[i] = (q15_t)std::clamp(v, (q63_t)-32768, (q63_t)32767);
+      }
+    }
+
+  public:
+
+    Q15FastFir(const std::vector<q15_t>& fir, unsigned int fftLength, FastFirMethod method)
+      : FixedFastFir<q15_t>("q15", fir, fftLength, method)
+    {}
+  };
+
+  template <typename F, typename T> std::unique_ptr<FastFir<T>> create(std::unique_ptr<std::vector<T>> fir, unsigned int fftLength, FastFirMethod method) {
+    auto fastFir = std::make_unique<F>(*fir, fftLength, method);
+    fastFir->init(*fir);
+    return fastFir;
+  }
+
+} // namespace
+
+unsigned int getFastFirLength(unsigned int numTaps) {
+  unsigned int length = minFftLength;
+  while (length < 4 * numTaps) {
+    length *= 2;
+  }
+  if (length > maxFftLength) {
+    throw Ex("fast fir number of taps is too large");
+  }
+  return length;
+}
+
+std::unique_ptr<FastFir<float32_t>> createFloat32FastFir(std::unique_ptr<std::vector<float32_t>> fir, unsigned int fftLength, FastFirMethod method) {
+  return create<Float32FastFir>(std::move(fir), fftLength, method);
+}
+
+std::unique_ptr<FastFir<q31_t>> createQ31FastFir(std::unique_ptr<std::vector<q31_t>> fir, unsigned int fftLength, FastFirMethod method) {
+  return create<Q31FastFir>(std::move(fir), fftLength, method);
+}
+
+std::unique_ptr<FastFir<q15_t>> createQ15FastFir(std::unique_ptr<std::vector<q15_t>> fir, unsigned int fftLength, FastFirMethod method) {
+  return create<Q15FastFir>(std::move(fir), fftLength, method);
+}
@@ -0,0 +1,103 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_FASTFIR_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_FASTFIR_H_INCLUDED
+
+#include "Span.h"
+
+#include "arm_math.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+FFT fast convolution FIR filter. The filter of numTaps taps is applied
+in blocks of B = fftLength - numTaps + 1 samples. Each block is
+transformed with a span fft (see CmsisFft.h), multiplied by the filter
+spectrum, and inverse transformed. The filter spectrum is computed
+once, at construction, so a block costs two ffts and fftLength/2 + 1
+complex multiplies, i.e. O(log2(fftLength)) per output sample rather
+than the numTaps of a direct form FIR.
+
+Two block methods are implemented:
+
+OVERLAP_SAVE transforms the last numTaps - 1 input samples followed
+by the B new samples. The first numTaps - 1 inverse samples are
+circular wrap around and are discarded, the remaining B are the
+output.
+
+OVERLAP_ADD transforms the B new samples zero padded to fftLength.
+The first B inverse samples plus the tail saved from the previous
+block are the output, the last numTaps - 1 samples are saved as the
+next tail.
+
+Both produce the same output as arm_fir_* of the same filter, aligned
+the same (no delay beyond the filter's own).
+
+The fixed point filters run a q31 pipeline, q15 input is shifted up
+to q31 and the output is rounded back to q15. The fixed point forward
+fft scales down by fftLength, and the complex multiply output is
+Q3.29, so the q15 fft would leave only 15 - log2(fftLength) - 3 bits
+of output precision. The filter spectrum is scaled by a power of two
+to use the full q31 range, and the inverse is shifted back up by the
+sum of these scales with saturation.
+
+The fixed point input must be scaled such that the filter output
+doesn't saturate. Unlike arm_fir_fast_q{15,31}, there's no accumulator
+that can overflow.
+*/
+enum class FastFirMethod { OVERLAP_SAVE = 0, OVERLAP_ADD = 1 };
+
+template <typename T> class FastFir {
+ public:
+
+  virtual ~FastFir() {}
+
+  // the name of the fast FIR implementation
+  virtual const std::string& getName() const = 0;
+
+  virtual FastFirMethod getMethod() const = 0;
+
+  virtual unsigned int getNumTaps() const = 0;
+
+  virtual unsigned int getFftLength() const = 0;
+
+  // The number of samples filtered by one fft (fftLength - numTaps + 1).
+  virtual unsigned int getBlockSize() const = 0;
+
+  // Filter numSamples input samples, a multiple of getBlockSize(),
+  // into out (numSamples samples). Filter history is kept between
+  // calls. The output may be written over the input (out == in).
+  // Throws Ex if numSamples is not a multiple of the block size.
+  virtual void process(const T* in, unsigned int numSamples, T* out) = 0;
+
+  // Filter the in span into the out span, e.g. DMA buffers. Throws Ex
+  // if the spans differ in size or their size is not a multiple of the
+  // block size.
+  void process(Span<const T> in, Span<T> out) {
+    if (out.size() != in.size()) {
+      throw Ex(getName() + " output span size error");
+    }
+    process(in.data(), in.size(), out.data());
+  }
+
+  // Clear the filter history.
+  virtual void reset() = 0;
+};
+
+// The fft length for a filter of numTaps taps, a power of two of at
+// least 4*numTaps (the fewest operations per output sample for the
+// usual filter lengths), from 64 to 4096. Throws Ex if numTaps is too
+// large.
+unsigned int getFastFirLength(unsigned int numTaps);
+
+// Create fast FIR filters. The coefficients are in arm_fir_* order,
+// time reversed. The fft length is a supported span fft length (see
+// FftPlan.h) larger than the number of taps. Throws Ex if not.
+std::unique_ptr<FastFir<float32_t>> createFloat32FastFir(std::unique_ptr<std::vector<float32_t>> fir, unsigned int fftLength, FastFirMethod method);
+std::unique_ptr<FastFir<q31_t>> createQ31FastFir(std::unique_ptr<std::vector<q31_t>> fir, unsigned int fftLength, FastFirMethod method);
+std::unique_ptr<FastFir<q15_t>> createQ15FastFir(std::unique_ptr<std::vector<q15_t>> fir, unsigned int fftLength, FastFirMethod method);
+
+#endif
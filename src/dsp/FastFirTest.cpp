@@ -0,0 +1,244 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "FastFirTest.h"
+
+#include "FastFir.h"
+#include "CmsisDecimate.h"
+#include "Ex.h"
+
+#include "Platform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+
+namespace {
+
+  // Map the data type to its arm_fir_* instance type.
+  template <typename T> struct FirInstance;
+  template <> struct FirInstance<float32_t> { typedef arm_fir_instance_f32 type; };
+  template <> struct FirInstance<q31_t> { typedef arm_fir_instance_q31 type; };
+  template <> struct FirInstance<q15_t> { typedef arm_fir_instance_q15 type; };
+
+  // The arm_fir_* state size, arm_fir_q15 needs one more sample.
+  template <typename T> unsigned int firStateSize(unsigned int numTaps, unsigned int blockSize) {
+    return numTaps + blockSize - 1;
+  }
+
+  template <> unsigned int firStateSize<q15_t>(unsigned int numTaps, unsigned int blockSize) {
+    return numTaps + blockSize;
+  }
+
+  void firInit(arm_fir_instance_f32* instance, const std::vector<float32_t>& fir, float32_t* state, unsigned int blockSize) {
+    arm_fir_init_f32(instance, fir.size(), fir.data(), state, blockSize);
+  }
+
+  void firInit(arm_fir_instance_q31* instance, const std::vector<q31_t>& fir, q31_t* state, unsigned int blockSize) {
+    arm_fir_init_q31(instance, fir.size(), fir.data(), state, blockSize);
+  }
+
+  void firInit(arm_fir_instance_q15* instance, const std::vector<q15_t>& fir, q15_t* state, unsigned int blockSize) {
+    if (arm_fir_init_q15(instance, fir.size(), fir.data(), state, blockSize) != ARM_MATH_SUCCESS) {
+      throw Ex("arm q15 fir init error");
+    }
+  }
+
+  void fir(const arm_fir_instance_f32* instance, const float32_t* in, float32_t* out, unsigned int n, bool fast) {
+    arm_fir_f32(instance, in, out, n);
+  }
+
+  void fir(const arm_fir_instance_q31* instance, const q31_t* in, q31_t* out, unsigned int n, bool fast) {
+    if (fast) {
+      arm_fir_fast_q31(instance, in, out, n);
+    }
+    else {
+      arm_fir_q31(instance, in, out, n);
+    }
+  }
+
+  void fir(const arm_fir_instance_q15* instance, const q15_t* in, q15_t* out, unsigned int n, bool fast) {
+    if (fast) {
+      arm_fir_fast_q15(instance, in, out, n);
+    }
+    else {
+      arm_fir_q15(instance, in, out, n);
+    }
+  }
+
+  const char* typeName(float32_t) {
+    return "f32";
+  }
+
+  const char* typeName(q31_t) {
+    return "q31";
+  }
+
+  const char* typeName(q15_t) {
+    return "q15";
+  }
+
+  // The maximum absolute difference of the first n values, % of the
+  // reference peak.
+  template <typename T> float maxError(const T* actual, const T* reference, unsigned int n) {
+    double peak = 0.0;
+    double error = 0.0;
+    for (unsigned int i = 0; i < n; i++) {
+      peak = std::max(peak, std::fabs((double)reference[i]));
+      error = std::max(error, std::fabs((double)actual[i] - (double)reference[i]));
+    }
+    return peak > 0.0 ? 100.0 * error / peak : 0.0;
+  }
+
+  void checkError(const std::string& name, float error, float tolerance) {
+    if (error > tolerance) {
+      printf("FAIL %s error %.6f%% > %.6f%%\n", name.c_str(), error, tolerance);
+      throw Fail("fast fir error");
+    }
+  }
+
+  template <typename T> FastFirTestResult executeDirect(std::vector<T> fir, const std::vector<T>& waveform, unsigned int numSamples, unsigned int blockSize, bool fast, std::vector<T>& out) {
+    // the coefficients are time reversed, the zero is b[numTaps]
+    if (sizeof(T) == sizeof(q15_t) && fir.size() % 2 != 0) {
+      fir.insert(fir.begin(), 0);
+    }
+
+    typename FirInstance<T>::type instance;
+    std::vector<T> state(firStateSize<T>(fir.size(), blockSize));
+    firInit(&instance, fir, state.data(), blockSize);
+    out.resize(numSamples);
+
+    platform::profiling_time_t start = platform::get_profiling_time();
+    for (unsigned int i = 0; i < numSamples; i += blockSize) {
+      ::fir(&instance, waveform.data() + i, out.data() + i, std::min(blockSize, numSamples - i), fast);
+    }
+    platform::profiling_time_t end = platform::get_profiling_time();
+    unsigned long elapsedTime = profiling_time_diff(start,end);
+
+    const std::string name = std::string(typeName(T())) + (fast ? "_fir_fast" : "_fir");
+    printf("%s taps %d block %d, %d samples %lu us\n", name.c_str(), (unsigned int)fir.size(), blockSize, numSamples, elapsedTime);
+
+    return FastFirTestResult(name, numSamples, elapsedTime, 0.0);
+  }
+
+  template <typename T> FastFirTestResult executeFast(FastFir<T>& fir, const std::vector<T>& waveform, unsigned int numSamples, const std::vector<T>& reference, float tolerance) {
+    std::vector<T> out(numSamples);
+    fir.reset();
+
+    platform::profiling_time_t start = platform::get_profiling_time();
+    fir.process(waveform.data(), numSamples, out.data());
+    platform::profiling_time_t end = platform::get_profiling_time();
+    unsigned long elapsedTime = profiling_time_diff(start,end);
+
+    const float error = maxError(out.data(), reference.data(), numSamples);
+    printf("%s taps %d fft %d block %d, %d samples %lu us, error %.6f%%\n",
+	   fir.getName().c_str(), fir.getNumTaps(), fir.getFftLength(), fir.getBlockSize(), numSamples, elapsedTime, error);
+    checkError(fir.getName(), error, tolerance);
+
+    return FastFirTestResult(fir.getName(), numSamples, elapsedTime, error);
+  }
+
+  // Every Mth reference sample, starting at sample 0, the
+  // arm_fir_decimate_* alignment y[n] = b[0]*x[n*M] + b[1]*x[n*M-1] ...
+  template <typename T> std::vector<T> decimateReference(const std::vector<T>& reference, unsigned int M, unsigned int numSamples) {
+    std::vector<T> decimated((numSamples + M - 1) / M);
+    for (unsigned int i = 0; i < decimated.size(); i++) {
+      decimated[i] = reference[i*M];
+    }
+    return decimated;
+  }
+
+  template <typename T> FastFirTestResult executeStreamDecimate(DecimateStream<T>& stream, const std::vector<T>& waveform, unsigned int numSamples, const std::vector<T>& reference, float tolerance) {
+    std::vector<T> out(stream.getOutputSize(numSamples));
+    stream.reset();
+
+    platform::profiling_time_t start = platform::get_profiling_time();
+    const unsigned int numOutputs = stream.process(waveform.data(), numSamples, out.data());
+    platform::profiling_time_t end = platform::get_profiling_time();
+    unsigned long elapsedTime = profiling_time_diff(start,end);
+
+    const std::vector<T> decimated = decimateReference(reference, stream.getM(), numSamples);
+    const float error = maxError(out.data(), decimated.data(), std::min(numOutputs, (unsigned int)decimated.size()));
+    printf("%s M=%d, %d samples %lu us, error %.6f%%\n", stream.getName().c_str(), stream.getM(), numSamples, elapsedTime, error);
+    checkError(stream.getName(), error, tolerance);
+
+    return FastFirTestResult(stream.getName(), numSamples, elapsedTime, error);
+  }
+
+  template <typename T> FastFirTestResult executeFastDecimate(FastFir<T>& fir, unsigned int M, const std::vector<T>& waveform, unsigned int numSamples, const std::vector<T>& reference, float tolerance) {
+    const unsigned int blockSize = fir.getBlockSize();
+    std::vector<T> block(blockSize);
+    std::vector<T> out((numSamples + M - 1) / M);
+    fir.reset();
+
+    platform::profiling_time_t start = platform::get_profiling_time();
+    unsigned int phase = 0;
+    unsigned int numOutputs = 0;
+    for (unsigned int i = 0; i < numSamples; i += blockSize) {
+      fir.process(waveform.data() + i, blockSize, block.data());
+      for (; phase < blockSize; phase += M) {
+	out[numOutputs++] = block[phase];
+      }
+      phase -= blockSize;
+    }
+    platform::profiling_time_t end = platform::get_profiling_time();
+    unsigned long elapsedTime = profiling_time_diff(start,end);
+
+    const std::string name = fir.getName() + "_decimate";
+    const std::vector<T> decimated = decimateReference(reference, M, numSamples);
+    const float error = maxError(out.data(), decimated.data(), numOutputs);
+    printf("%s M=%d, %d samples %lu us, error %.6f%%\n", name.c_str(), M, numSamples, elapsedTime, error);
+    checkError(name, error, tolerance);
+
+    return FastFirTestResult(name, numSamples, elapsedTime, error);
+  }
+
+} // namespace
+
+FastFirTestResult executeDirectFirTest(const std::vector<float32_t>& fir, const std::vector<float32_t>& waveform, unsigned int numSamples, unsigned int blockSize, std::vector<float32_t>& out) {
+  return executeDirect(fir, waveform, numSamples, blockSize, false, out);
+}
+
+FastFirTestResult executeDirectFirTest(const std::vector<q31_t>& fir, const std::vector<q31_t>& waveform, unsigned int numSamples, unsigned int blockSize, bool fast, std::vector<q31_t>& out) {
+  return executeDirect(fir, waveform, numSamples, blockSize, fast, out);
+}
+
+FastFirTestResult executeDirectFirTest(const std::vector<q15_t>& fir, const std::vector<q15_t>& waveform, unsigned int numSamples, unsigned int blockSize, bool fast, std::vector<q15_t>& out) {
+  return executeDirect(fir, waveform, numSamples, blockSize, fast, out);
+}
+
+FastFirTestResult executeFastFirTest(FastFir<float32_t>& fir, const std::vector<float32_t>& waveform, unsigned int numSamples, const std::vector<float32_t>& reference, float tolerance) {
+  return executeFast(fir, waveform, numSamples, reference, tolerance);
+}
+
+FastFirTestResult executeFastFirTest(FastFir<q31_t>& fir, const std::vector<q31_t>& waveform, unsigned int numSamples, const std::vector<q31_t>& reference, float tolerance) {
+  return executeFast(fir, waveform, numSamples, reference, tolerance);
+}
+
+FastFirTestResult executeFastFirTest(FastFir<q15_t>& fir, const std::vector<q15_t>& waveform, unsigned int numSamples, const std::vector<q15_t>& reference, float tolerance) {
+  return executeFast(fir, waveform, numSamples, reference, tolerance);
+}
+
+FastFirTestResult executeDecimateTest(DecimateStream<float32_t>& stream, const std::vector<float32_t>& waveform, unsigned int numSamples, const std::vector<float32_t>& reference, float tolerance) {
+  return executeStreamDecimate(stream, waveform, numSamples, reference, tolerance);
+}
+
+FastFirTestResult executeDecimateTest(DecimateStream<q31_t>& stream, const std::vector<q31_t>& waveform, unsigned int numSamples, const std::vector<q31_t>& reference, float tolerance) {
+  return executeStreamDecimate(stream, waveform, numSamples, reference, tolerance);
+}
+
+FastFirTestResult executeDecimateTest(DecimateStream<q15_t>& stream, const std::vector<q15_t>& waveform, unsigned int numSamples, const std::vector<q15_t>& reference, float tolerance) {
+  return executeStreamDecimate(stream, waveform, numSamples, reference, tolerance);
+}
+
+FastFirTestResult executeFastDecimateTest(FastFir<float32_t>& fir, unsigned int M, const std::vector<float32_t>& waveform, unsigned int numSamples, const std::vector<float32_t>& reference, float tolerance) {
+  return executeFastDecimate(fir, M, waveform, numSamples, reference, tolerance);
+}
+
+FastFirTestResult executeFastDecimateTest(FastFir<q31_t>& fir, unsigned int M, const std::vector<q31_t>& waveform, unsigned int numSamples, const std::vector<q31_t>& reference, float tolerance) {
+  return executeFastDecimate(fir, M, waveform, numSamples, reference, tolerance);
+}
+
+FastFirTestResult executeFastDecimateTest(FastFir<q15_t>& fir, unsigned int M, const std::vector<q15_t>& waveform, unsigned int numSamples, const std::vector<q15_t>& reference, float tolerance) {
+  return executeFastDecimate(fir, M, waveform, numSamples, reference, tolerance);
+}
@@ -0,0 +1,69 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_FASTFIRTEST_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_FASTFIRTEST_H_INCLUDED
+
+#include "arm_math.h"
+
+#include <string>
+#include <vector>
+
+template <typename T> class FastFir;
+template <typename T> class DecimateStream;
+
+struct FastFirTestResult {
+  const std::string name;
+
+  // the number of input samples filtered
+  const unsigned int numSamples;
+
+  // elapsed time (us)
+  const unsigned long elapsedTime;
+
+  // maximum absolute difference from the reference output, % of the
+  // reference peak (0 for the reference itself)
+  const float error;
+
+  FastFirTestResult(const std::string& name, unsigned int numSamples, unsigned long elapsedTime, float error)
+    : name(name),
+      numSamples(numSamples),
+      elapsedTime(elapsedTime),
+      error(error)
+  {}
+};
+
+// Filter the first numSamples samples of the waveform with
+// arm_fir_{f32,q31,q15} (arm_fir_fast_q{31,15} if fast) in blockSize
+// blocks, and profile it. The output is written to out. The q15 filter
+// is padded with a zero tap if it's odd length, arm_fir_q15 requires
+// an even number of taps.
+FastFirTestResult executeDirectFirTest(const std::vector<float32_t>& fir, const std::vector<float32_t>& waveform, unsigned int numSamples, unsigned int blockSize, std::vector<float32_t>& out);
+FastFirTestResult executeDirectFirTest(const std::vector<q31_t>& fir, const std::vector<q31_t>& waveform, unsigned int numSamples, unsigned int blockSize, bool fast, std::vector<q31_t>& out);
+FastFirTestResult executeDirectFirTest(const std::vector<q15_t>& fir, const std::vector<q15_t>& waveform, unsigned int numSamples, unsigned int blockSize, bool fast, std::vector<q15_t>& out);
+
+// Profile the fast FIR filter of the first numSamples samples of the
+// waveform, a multiple of its block size, and compare the output with
+// the reference (the direct form output). The fast FIR is reset
+// first. Throws Fail if the error exceeds the tolerance (%).
+FastFirTestResult executeFastFirTest(FastFir<float32_t>& fir, const std::vector<float32_t>& waveform, unsigned int numSamples, const std::vector<float32_t>& reference, float tolerance);
+FastFirTestResult executeFastFirTest(FastFir<q31_t>& fir, const std::vector<q31_t>& waveform, unsigned int numSamples, const std::vector<q31_t>& reference, float tolerance);
+FastFirTestResult executeFastFirTest(FastFir<q15_t>& fir, const std::vector<q15_t>& waveform, unsigned int numSamples, const std::vector<q15_t>& reference, float tolerance);
+
+// Profile decimation by M of the first numSamples samples of the
+// waveform with a stream (arm_fir_decimate_*), and compare the output
+// with every Mth sample of the reference, starting at sample 0 (the
+// arm_fir_decimate_* alignment).
+// Throws Fail if the error exceeds the tolerance (%).
+FastFirTestResult executeDecimateTest(DecimateStream<float32_t>& stream, const std::vector<float32_t>& waveform, unsigned int numSamples, const std::vector<float32_t>& reference, float tolerance);
+FastFirTestResult executeDecimateTest(DecimateStream<q31_t>& stream, const std::vector<q31_t>& waveform, unsigned int numSamples, const std::vector<q31_t>& reference, float tolerance);
+FastFirTestResult executeDecimateTest(DecimateStream<q15_t>& stream, const std::vector<q15_t>& waveform, unsigned int numSamples, const std::vector<q15_t>& reference, float tolerance);
+
+// The same for a fast FIR filter followed by keeping every Mth output
+// sample, the output of each block is filtered in place and then
+// decimated.
+FastFirTestResult executeFastDecimateTest(FastFir<float32_t>& fir, unsigned int M, const std::vector<float32_t>& waveform, unsigned int numSamples, const std::vector<float32_t>& reference, float tolerance);
+FastFirTestResult executeFastDecimateTest(FastFir<q31_t>& fir, unsigned int M, const std::vector<q31_t>& waveform, unsigned int numSamples, const std::vector<q31_t>& reference, float tolerance);
+FastFirTestResult executeFastDecimateTest(FastFir<q15_t>& fir, unsigned int M, const std::vector<q15_t>& waveform, unsigned int numSamples, const std::vector<q15_t>& reference, float tolerance);
+
+#endif
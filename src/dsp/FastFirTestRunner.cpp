@@ -0,0 +1,146 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "FastFirTestRunner.h"
+
+#include "FastFirTest.h"
+#include "FastFir.h"
+#include "CmsisDecimate.h"
+#include "CmsisTypeFactory.h"
+#include "DecimateFIR.h"
+#include "FirSource.h"
+#include "Signal.h"
+
+#include <vector>
+
+using namespace fastfir;
+
+namespace {
+
+  class FastFirTestRunner {
+
+    const std::vector<unsigned int> taps = {15, 31, 63, 127, 255};
+
+    const unsigned int waveformSize = 4096;
+
+    // The filters are the decimate by M filters, the test signal is at
+    // half their cutoff.
+    const unsigned int M = 4;
+    const unsigned int k = 2*M;
+
+    // The fixed point input is scaled down by 1 bit, the filter output
+    // is within full scale without the log2(numTaps) scaling that
+    // avoids arm_fir_fast_q{15,31} accumulator overflow for any
+    // input.
+    const unsigned int rshift = 1;
+
+    // Maximum error tolerance, % of the direct form output peak.
+    const float floatTolerance = 0.01;
+    const float q31Tolerance = 0.01;
+    const float q15Tolerance = 0.05;
+
+    std::unique_ptr<Results> results = std::make_unique<Results>();
+
+    void addResult(NameToTapsMeasurementMap& map, unsigned int numTaps, const FastFirTestResult& result) {
+      Measurement& measurement = map[result.name][numTaps];
+      measurement.numSamples = result.numSamples;
+      measurement.elapsedTime = result.elapsedTime;
+      measurement.error = result.error;
+    }
+
+    // The number of samples filtered, a multiple of the fast FIR block
+    // size.
+    template <typename T> unsigned int getNumSamples(const FastFir<T>& fir) {
+      return (waveformSize / fir.getBlockSize()) * fir.getBlockSize();
+    }
+
+    void runFloat32(unsigned int numTaps, unsigned int fftLength, CmsisTypeFactory& firFactory, CmsisTypeFactory& signalFactory) {
+      auto fir = firFactory.toFloat32();
+      auto waveform = signalFactory.toFloat32();
+      auto ols = createFloat32FastFir(firFactory.toFloat32(), fftLength, FastFirMethod::OVERLAP_SAVE);
+      auto ola = createFloat32FastFir(firFactory.toFloat32(), fftLength, FastFirMethod::OVERLAP_ADD);
+      const unsigned int numSamples = getNumSamples(*ols);
+      const unsigned int blockSize = ols->getBlockSize();
+
+      std::vector<float32_t> reference;
+      addResult(results->filter, numTaps, executeDirectFirTest(*fir, *waveform, numSamples, blockSize, reference));
+      addResult(results->filter, numTaps, executeFastFirTest(*ols, *waveform, numSamples, reference, floatTolerance));
+      addResult(results->filter, numTaps, executeFastFirTest(*ola, *waveform, numSamples, reference, floatTolerance));
+
+      auto decimate = createFloat32DecimateStream(firFactory.toFloat32(), M, blockSize);
+      addResult(results->decimate, numTaps, executeDecimateTest(*decimate, *waveform, numSamples, reference, floatTolerance));
+      addResult(results->decimate, numTaps, executeFastDecimateTest(*ols, M, *waveform, numSamples, reference, floatTolerance));
+    }
+
+    void runQ31(unsigned int numTaps, unsigned int fftLength, CmsisTypeFactory& firFactory, CmsisTypeFactory& signalFactory) {
+      auto fir = firFactory.toQ31();
+      auto waveform = signalFactory.toQ31(rshift);
+      auto ols = createQ31FastFir(firFactory.toQ31(), fftLength, FastFirMethod::OVERLAP_SAVE);
+      auto ola = createQ31FastFir(firFactory.toQ31(), fftLength, FastFirMethod::OVERLAP_ADD);
+      const unsigned int numSamples = getNumSamples(*ols);
+      const unsigned int blockSize = ols->getBlockSize();
+
+      std::vector<q31_t> reference;
+      std::vector<q31_t> fastOut;
+      addResult(results->filter, numTaps, executeDirectFirTest(*fir, *waveform, numSamples, blockSize, false, reference));
+      addResult(results->filter, numTaps, executeDirectFirTest(*fir, *waveform, numSamples, blockSize, true, fastOut));
+      addResult(results->filter, numTaps, executeFastFirTest(*ols, *waveform, numSamples, reference, q31Tolerance));
+      addResult(results->filter, numTaps, executeFastFirTest(*ola, *waveform, numSamples, reference, q31Tolerance));
+
+      auto decimate = createQ31DecimateStream(firFactory.toQ31(), M, blockSize, true);
+      addResult(results->decimate, numTaps, executeDecimateTest(*decimate, *waveform, numSamples, reference, q31Tolerance));
+      addResult(results->decimate, numTaps, executeFastDecimateTest(*ols, M, *waveform, numSamples, reference, q31Tolerance));
+    }
+
+    void runQ15(unsigned int numTaps, unsigned int fftLength, CmsisTypeFactory& firFactory, CmsisTypeFactory& signalFactory) {
+      auto fir = firFactory.toQ15();
+      auto waveform = signalFactory.toQ15(rshift);
+      auto ols = createQ15FastFir(firFactory.toQ15(), fftLength, FastFirMethod::OVERLAP_SAVE);
+      auto ola = createQ15FastFir(firFactory.toQ15(), fftLength, FastFirMethod::OVERLAP_ADD);
+      const unsigned int numSamples = getNumSamples(*ols);
+      const unsigned int blockSize = ols->getBlockSize();
+
+      std::vector<q15_t> reference;
+      std::vector<q15_t> fastOut;
+      addResult(results->filter, numTaps, executeDirectFirTest(*fir, *waveform, numSamples, blockSize, false, reference));
+      addResult(results->filter, numTaps, executeDirectFirTest(*fir, *waveform, numSamples, blockSize, true, fastOut));
+      addResult(results->filter, numTaps, executeFastFirTest(*ols, *waveform, numSamples, reference, q15Tolerance));
+      addResult(results->filter, numTaps, executeFastFirTest(*ola, *waveform, numSamples, reference, q15Tolerance));
+
+      auto decimate = createQ15DecimateStream(firFactory.toQ15(), M, blockSize, true);
+      addResult(results->decimate, numTaps, executeDecimateTest(*decimate, *waveform, numSamples, reference, q15Tolerance));
+      addResult(results->decimate, numTaps, executeFastDecimateTest(*ols, M, *waveform, numSamples, reference, q15Tolerance));
+    }
+
+    void run(unsigned int numTaps) {
+      const unsigned int fftLength = getFastFirLength(numTaps);
+      results->fftLength[numTaps] = fftLength;
+
+      printf("\nfast fir waveform size %d, filter size %d, fft length %d, M=%d\n", waveformSize, numTaps, fftLength, M);
+
+      CmsisTypeFactory firFactory(createFirSource(getDecimationFirSpec(M, numTaps)));
+      CmsisTypeFactory signalFactory(std::make_unique<Signal>(waveformSize, (double)k, false));
+
+      runFloat32(numTaps, fftLength, firFactory, signalFactory);
+      runQ31(numTaps, fftLength, firFactory, signalFactory);
+      runQ15(numTaps, fftLength, firFactory, signalFactory);
+    }
+
+  public:
+
+    std::unique_ptr<Results> runAll() {
+      results->M = M;
+
+      for (unsigned int numTaps: taps) {
+	run(numTaps);
+      }
+
+      return std::move(results);
+    }
+  };
+
+} // namespace
+
+std::unique_ptr<Results> runAllFastFirTests() {
+  return FastFirTestRunner().runAll();
+}
@@ -0,0 +1,46 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_FASTFIRTESTRUNNER_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_FASTFIRTESTRUNNER_H_INCLUDED
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace fastfir {
+  struct Measurement {
+    // the number of input samples filtered
+    unsigned int numSamples;
+
+    // elapsed time in us
+    unsigned long elapsedTime;
+
+    // maximum error, % of the direct form output peak
+    float error;
+  };
+
+  // map filter length (taps) to measurement
+  typedef std::map<unsigned int, Measurement> TapsToMeasurementMap;
+
+  // map filter name to filter length map
+  typedef std::map<std::string, TapsToMeasurementMap> NameToTapsMeasurementMap;
+
+  struct Results {
+    // the decimation factor
+    unsigned int M = 0;
+
+    // map filter length to fast FIR fft length
+    std::map<unsigned int, unsigned int> fftLength;
+
+    // direct form and fast FIR filters
+    NameToTapsMeasurementMap filter;
+
+    // arm_fir_decimate_* and fast FIR decimators
+    NameToTapsMeasurementMap decimate;
+  };
+}
+
+std::unique_ptr<fastfir::Results> runAllFastFirTests();
+
+#endif
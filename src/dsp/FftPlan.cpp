@@ -0,0 +1,161 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "FftPlan.h"
+
+#include "Ex.h"
+
+#include "Platform.h"
+
+#include <cmath>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace {
+
+  // arm_rfft_q{15,31} bit reverse flag
+  const uint32_t bitReverseFlag = 1;
+
+  template <typename T> using PlanMap = std::map<std::pair<unsigned int, FftDirection>, std::unique_ptr<FftPlan<T>>>;
+
+  // One registry per data type, the map key is (length, direction).
+  template <typename T> PlanMap<T>& getRegistry() {
+    static PlanMap<T> registry;
+    return registry;
+  }
+
+  template <typename T> using ComplexPlanMap = std::map<unsigned int, std::unique_ptr<ComplexFftPlan<T>>>;
+
+  // One complex registry per data type, the map key is the length.
+  template <typename T> ComplexPlanMap<T>& getComplexRegistry() {
+    static ComplexPlanMap<T> registry;
+    return registry;
+  }
+
+  void checkArmInitStatus(const std::string& name, arm_status status) {
+    if (status == ARM_MATH_ARGUMENT_ERROR) {
+      throw Ex("arm " + name + " fft length not supported");
+    }
+    else if (status != ARM_MATH_SUCCESS) {
+      throw Ex("arm " + name + " fft init error");
+    }
+  }
+
+} // namespace
+
+template <> void FftPlan<float64_t>::init() {
+  checkArmInitStatus("f64", arm_rfft_fast_init_f64(&instance, length));
+}
+
+template <> void FftPlan<float32_t>::init() {
+  checkArmInitStatus("f32", arm_rfft_fast_init_f32(&instance, length));
+}
+
+template <> void FftPlan<q31_t>::init() {
+  checkArmInitStatus("q31", arm_rfft_init_q31(&instance, length, getIfftFlag(), bitReverseFlag));
+}
+
+template <> void FftPlan<q15_t>::init() {
+  checkArmInitStatus("q15", arm_rfft_init_q15(&instance, length, getIfftFlag(), bitReverseFlag));
+}
+
+template <> void ComplexFftPlan<float64_t>::init() {
+  checkArmInitStatus("cfft f64", arm_cfft_init_f64(&instance, length));
+}
+
+template <> void ComplexFftPlan<float32_t>::init() {
+  checkArmInitStatus("cfft f32", arm_cfft_init_f32(&instance, length));
+}
+
+template <> void ComplexFftPlan<q31_t>::init() {
+  checkArmInitStatus("cfft q31", arm_cfft_init_q31(&instance, length));
+}
+
+template <> void ComplexFftPlan<q15_t>::init() {
+  checkArmInitStatus("cfft q15", arm_cfft_init_q15(&instance, length));
+}
+
+template <typename T> FftPlan<T>::FftPlan(unsigned int length, FftDirection direction)
+  : length(length),
+    direction(direction)
+{
+  platform::profiling_time_t start = platform::get_profiling_time();
+  init();
+  platform::profiling_time_t end = platform::get_profiling_time();
+  initTime = platform::profiling_time_diff(start, end);
+}
+
+template <typename T> FftPlan<T>& getFftPlan(unsigned int length, FftDirection direction) {
+  PlanMap<T>& registry = getRegistry<T>();
+  auto key = std::make_pair(length, direction);
+
+  auto it = registry.find(key);
+  if (it == registry.end()) {
+    it = registry.emplace(key, std::make_unique<FftPlan<T>>(length, direction)).first;
+  }
+
+  return *it->second;
+}
+
+template <typename T> ComplexFftPlan<T>::ComplexFftPlan(unsigned int length)
+  : length(length)
+{
+  platform::profiling_time_t start = platform::get_profiling_time();
+  init();
+  platform::profiling_time_t end = platform::get_profiling_time();
+  initTime = platform::profiling_time_diff(start, end);
+}
+
+template <typename T> const std::vector<T>& ComplexFftPlan<T>::getSplitTwiddle() {
+  if (splitTwiddle.empty()) {
+    platform::profiling_time_t start = platform::get_profiling_time();
+    const unsigned int n = 2 * length;
+    splitTwiddle.resize(n / 2);
+    for (unsigned int k = 0; k < n / 4; k++) {
+      const double phase = 2.0 * M_PI * k / n;
+      splitTwiddle[2*k] = std::cos(phase);
+      splitTwiddle[2*k + 1] = std::sin(phase);
+    }
+    platform::profiling_time_t end = platform::get_profiling_time();
+    splitTwiddleInitTime = platform::profiling_time_diff(start, end);
+  }
+
+  return splitTwiddle;
+}
+
+template <typename T> ComplexFftPlan<T>& getComplexFftPlan(unsigned int length) {
+  ComplexPlanMap<T>& registry = getComplexRegistry<T>();
+
+  auto it = registry.find(length);
+  if (it == registry.end()) {
+    it = registry.emplace(length, std::make_unique<ComplexFftPlan<T>>(length)).first;
+  }
+
+  return *it->second;
+}
+
+void clearFftPlanCache() {
+  getRegistry<float64_t>().clear();
+  getRegistry<float32_t>().clear();
+  getRegistry<q31_t>().clear();
+  getRegistry<q15_t>().clear();
+  getComplexRegistry<float64_t>().clear();
+  getComplexRegistry<float32_t>().clear();
+  getComplexRegistry<q31_t>().clear();
+  getComplexRegistry<q15_t>().clear();
+}
+
+template FftPlan<float64_t>& getFftPlan<float64_t>(unsigned int length, FftDirection direction);
+template FftPlan<float32_t>& getFftPlan<float32_t>(unsigned int length, FftDirection direction);
+template FftPlan<q31_t>& getFftPlan<q31_t>(unsigned int length, FftDirection direction);
+template FftPlan<q15_t>& getFftPlan<q15_t>(unsigned int length, FftDirection direction);
+
+template ComplexFftPlan<float64_t>& getComplexFftPlan<float64_t>(unsigned int length);
+template ComplexFftPlan<float32_t>& getComplexFftPlan<float32_t>(unsigned int length);
+template ComplexFftPlan<q31_t>& getComplexFftPlan<q31_t>(unsigned int length);
+template ComplexFftPlan<q15_t>& getComplexFftPlan<q15_t>(unsigned int length);
+
+template const std::vector<float64_t>& ComplexFftPlan<float64_t>::getSplitTwiddle();
+template const std::vector<float32_t>& ComplexFftPlan<float32_t>::getSplitTwiddle();
@@ -0,0 +1,176 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_FFTPLAN_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_FFTPLAN_H_INCLUDED
+
+#include "arm_math.h"
+
+#include <vector>
+
+/**
+An FFT plan is an initialized CMSIS-DSP real fft instance
+(arm_rfft_fast_instance_f{32,64} or arm_rfft_instance_q{15,31}) for
+one combination of data type, fft length and direction.
+
+Plans are built on first use and cached in a registry that lives for
+the life of the program. Every fft of the same shape shares the same
+plan, so the arm_rfft_*_init_* cost is paid once rather than on every
+execution. The plan records the time it took to build so that the
+benchmark can report init cost separately from the steady state
+execution cost.
+
+The CMSIS-DSP instances only reference constant twiddle and bit
+reversal tables, hence plans are small.
+
+A ComplexFftPlan is the same for the CMSIS-DSP complex fft instance
+(arm_cfft_instance_*), one per data type and length. The arm_cfft_*
+direction is a per call argument, hence it's not part of the plan.
+The supported lengths are 16 to 4096. A floating point complex plan
+also holds the split step twiddle factors of the real fft of twice
+its length (see the in-place ffts in CmsisFft.h), built on first use
+and shared by every in-place fft of that length.
+*/
+
+enum class FftDirection { FORWARD = 0, INVERSE = 1 };
+
+// Map the data type to its CMSIS-DSP real fft instance type.
+template <typename T> struct RealFftInstance;
+template <> struct RealFftInstance<float64_t> { typedef arm_rfft_fast_instance_f64 type; };
+template <> struct RealFftInstance<float32_t> { typedef arm_rfft_fast_instance_f32 type; };
+template <> struct RealFftInstance<q31_t> { typedef arm_rfft_instance_q31 type; };
+template <> struct RealFftInstance<q15_t> { typedef arm_rfft_instance_q15 type; };
+
+template <typename T> class FftPlan {
+
+public:
+
+  typedef typename RealFftInstance<T>::type Instance;
+
+private:
+
+  const unsigned int length;
+
+  const FftDirection direction;
+
+  Instance instance;
+
+  // time to initialize the instance (us)
+  unsigned long initTime = 0;
+
+  void init();
+
+  FftPlan();
+  FftPlan(const FftPlan&);
+  FftPlan& operator=(const FftPlan&);
+
+public:
+
+  // Initialize the CMSIS-DSP instance. Throws Ex if the length is not
+  // supported for the data type.
+  FftPlan(unsigned int length, FftDirection direction);
+
+  // The initialized instance. Non-const because arm_rfft_fast_f64
+  // takes a non-const instance.
+  Instance& getInstance() {
+    return instance;
+  }
+
+  unsigned int getLength() const {
+    return length;
+  }
+
+  FftDirection getDirection() const {
+    return direction;
+  }
+
+  // arm_rfft* inverse fft flag
+  uint8_t getIfftFlag() const {
+    return direction == FftDirection::INVERSE ? 1 : 0;
+  }
+
+  // The time it took to initialize the instance (us).
+  unsigned long getInitTime() const {
+    return initTime;
+  }
+};
+
+// Map the data type to its CMSIS-DSP complex fft instance type.
+template <typename T> struct ComplexFftInstance;
+template <> struct ComplexFftInstance<float64_t> { typedef arm_cfft_instance_f64 type; };
+template <> struct ComplexFftInstance<float32_t> { typedef arm_cfft_instance_f32 type; };
+template <> struct ComplexFftInstance<q31_t> { typedef arm_cfft_instance_q31 type; };
+template <> struct ComplexFftInstance<q15_t> { typedef arm_cfft_instance_q15 type; };
+
+template <typename T> class ComplexFftPlan {
+
+public:
+
+  typedef typename ComplexFftInstance<T>::type Instance;
+
+private:
+
+  // the number of complex values
+  const unsigned int length;
+
+  Instance instance;
+
+  // time to initialize the instance (us)
+  unsigned long initTime = 0;
+
+  // The split step twiddle factors, empty until first use.
+  std::vector<T> splitTwiddle;
+
+  // time to build the split step twiddle factors (us)
+  unsigned long splitTwiddleInitTime = 0;
+
+  void init();
+
+  ComplexFftPlan();
+  ComplexFftPlan(const ComplexFftPlan&);
+  ComplexFftPlan& operator=(const ComplexFftPlan&);
+
+public:
+
+  // Initialize the CMSIS-DSP instance. Throws Ex if the length is not
+  // supported for the data type.
+  ComplexFftPlan(unsigned int length);
+
+  const Instance& getInstance() const {
+    return instance;
+  }
+
+  unsigned int getLength() const {
+    return length;
+  }
+
+  // The time it took to initialize the instance (us).
+  unsigned long getInitTime() const {
+    return initTime;
+  }
+
+  // The real fft split step twiddle factors W^k = exp(-2*pi*j*k/N) for
+  // N = 2*length and 0 <= k < N/4, stored as (cos, sin) pairs. Built on
+  // the first call. Floating point types only.
+  const std::vector<T>& getSplitTwiddle();
+
+  // The time it took to build the split step twiddle factors (us), 0
+  // before the first getSplitTwiddle().
+  unsigned long getSplitTwiddleInitTime() const {
+    return splitTwiddleInitTime;
+  }
+};
+
+// Get the cached plan for (T, length, direction), building it on first
+// use.
+template <typename T> FftPlan<T>& getFftPlan(unsigned int length, FftDirection direction);
+
+// Get the cached complex fft plan for (T, length), building it on first
+// use.
+template <typename T> ComplexFftPlan<T>& getComplexFftPlan(unsigned int length);
+
+// Release all cached plans. Plan references obtained prior to this
+// call are invalidated.
+void clearFftPlanCache();
+
+#endif
@@ -1,9 +1,9 @@
 //  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
 //  SPDX-License-Identifier: Apache-2.0
 
-#include "FFTTest.h"
+#include "FftTest.h"
 
-#include "CmsisFFT.h"
+#include "CmsisFft.h"
 #include "Ex.h"
 
 #include "Platform.h"
@@ -11,6 +11,7 @@
 #include <cmath>
 #include <memory>
 #include <algorithm>
+#include <iterator>
 #include <vector>
 
 #include <stdio.h>
@@ -92,32 +93,208 @@ namespace {
     FftTestResult execute() {
 
       // Do this first because the fft modifies the waveform in place.
-      float waveformPower = sumsq(*fft->getNormalizedWaveform());
-        
+      std::vector<float> waveformPower(fft->getBatchSize());
+      for (unsigned int frame = 0; frame < fft->getBatchSize(); frame++) {
+	waveformPower[frame] = sumsq(*fft->getNormalizedWaveform(frame));
+      }
+
+      // Build (or fetch the cached) fft plan outside of the profiled
+      // code. The plan init time is reported separately.
+      fft->prepare();
+
       platform::profiling_time_t start = platform::get_profiling_time();
       fft->execute();
       platform::profiling_time_t end = platform::get_profiling_time();
       unsigned long elapsedTime = profiling_time_diff(start,end);
 
+      // before the waveform is deleted
+      unsigned int peakBytes = fft->getPeakBytes();
+
       // don't need the waveform anymore, get the memory back
       fft->deleteWaveform();
 
-	// Get the normalized fft magnitude.
-      std::unique_ptr<std::vector<float>> normMag = fft->getNormalizedMagnitude();
-      
-      float fftPower= sumsq(*normMag)/fft->getLength();    
-      verifyParsevalEquality(waveformPower, fftPower);
+      // Verify the normalized fft magnitude of every frame.
+      for (unsigned int frame = 0; frame < fft->getBatchSize(); frame++) {
+	std::unique_ptr<std::vector<float>> normMag = fft->getNormalizedMagnitude(frame);
 
-      verifyFrequencyPeaks(*normMag);
+	float fftPower= sumsq(*normMag)/fft->getLength();
+	verifyParsevalEquality(waveformPower[frame], fftPower);
 
-      printf("%s %d us\n", fft->getName().c_str(), (unsigned long)elapsedTime);
+	verifyFrequencyPeaks(*normMag);
+      }
+
+      if (fft->getBatchSize() > 1) {
+	printf("%s batch %d %lu us (plan init %lu us)\n", fft->getName().c_str(), fft->getBatchSize(), elapsedTime, fft->getPlanInitTime());
+      }
+      else {
+	printf("%s %lu us (plan init %lu us, %u bytes)\n", fft->getName().c_str(), elapsedTime, fft->getPlanInitTime(), peakBytes);
+      }
 
-      return FftTestResult(fft->getName(), elapsedTime);
+      return FftTestResult(fft->getName(), elapsedTime, fft->getPlanInitTime(), peakBytes);
     }
   };
 
+  // The inverse round trip scale and error tolerance, see SpanFft. The
+  // floating point tolerance is relative to the waveform peak, the
+  // fixed point tolerance is in output LSBs.
+  template <typename T> double roundTripScale(unsigned int length) {
+    return 1.0;
+  }
+
+  template <> double roundTripScale<q31_t>(unsigned int length) {
+    return 1.0 / length;
+  }
+
+  template <> double roundTripScale<q15_t>(unsigned int length) {
+    return 1.0 / length;
+  }
+
+  template <typename T> double roundTripTolerance(double peak) {
+    return 1e-5 * peak;
+  }
+
+  template <> double roundTripTolerance<q31_t>(double peak) {
+    return 2.0;
+  }
+
+  template <> double roundTripTolerance<q15_t>(double peak) {
+    return 2.0;
+  }
+
+  // Transform the waveform and inverse transform its spectrum, the
+  // result must be the scaled waveform. Throws Fail if not.
+  template <typename T> void verifySpanInverse(SpanFft<T>& fft, const std::vector<T>& waveform) {
+    std::vector<T> in(waveform);
+    std::vector<T> spectrum(fft.getSpectrumSize());
+    std::vector<T> out(fft.getLength());
+    fft.spectrum(in, spectrum);
+    fft.inverse(spectrum, out);
+
+    const double scale = roundTripScale<T>(fft.getLength());
+    double peak = 0.0;
+    double maxError = 0.0;
+    for (unsigned int i = 0; i < out.size(); i++) {
+      peak = std::max(peak, std::fabs((double)waveform[i]));
+      maxError = std::max(maxError, std::fabs(out[i] - waveform[i] * scale));
+    }
+
+    if ( maxError > roundTripTolerance<T>(peak) ) {
+      printf("fail: %s inverse round trip error %g\n", fft.getName().c_str(), maxError);
+      throw Fail("span fft inverse round trip error");
+    }
+  }
+
+  template <typename T> void verifySpan(SpanFft<T>& fft, const std::vector<T>& waveform) {
+    std::vector<T> in(waveform);
+    std::vector<T> scratch(fft.getSpectrumSize());
+    std::vector<T> mag(fft.getMagnitudeSize());
+    fft.magnitude(in, scratch, mag);
+
+    // in place, over the start of the scratch span
+    in = waveform;
+    Span<T> scratchSpan(scratch);
+    fft.magnitude(in, scratchSpan, scratchSpan.subspan(0, fft.getMagnitudeSize()));
+
+    if ( !std::equal(mag.cbegin(), mag.cend(), scratch.cbegin()) ) {
+      printf("fail: %s in place magnitude differs\n", fft.getName().c_str());
+      throw Fail("span fft in place magnitude differs");
+    }
+
+    unsigned int peakIndex = std::distance(mag.cbegin(), std::max_element(mag.cbegin(), mag.cend()));
+    if ( peakIndex != fft.getLength() / 4 ) {
+      printf("fail: %s peak index %d != %d\n", fft.getName().c_str(), peakIndex, fft.getLength() / 4);
+      throw Fail("span fft peak index error");
+    }
+
+    verifySpanInverse(fft, waveform);
+  }
+
 } // end namespace
 
 FftTestResult executeFftTest(FftTestParams params, std::unique_ptr<FFT> fft) {
   return FftTest( params, std::move(fft) ).execute();
 }
+
+void verifyComplexFftTone(FftTestParams params, std::unique_ptr<FFT> fft) {
+  fft->execute();
+  auto mag = fft->getNormalizedMagnitude(0);
+
+  const unsigned int peakIndex = fft->getLength() / 4;
+  const float expectedPeak = params.amplitude * fft->getLength();
+
+  float peakError = 100.0*std::fabs((mag->at(peakIndex) - expectedPeak)/expectedPeak);
+  if ( peakError > params.tolerance.amplitude ) {
+    printf("fail: %s tone peak error=%.9g%% (%f vs %f)\n", fft->getName().c_str(), peakError, mag->at(peakIndex), expectedPeak);
+    throw Fail("complex fft tone peak error");
+  }
+
+  for (unsigned int i = 0; i < mag->size(); i++) {
+    if ( i != peakIndex ) {
+      float zeroError = 100.0*std::fabs(mag->at(i)/expectedPeak);
+      if ( zeroError > params.tolerance.zero ) {
+	printf("fail: %s tone zero error at bin %d (%.9g%%)\n", fft->getName().c_str(), i, zeroError);
+	throw Fail("complex fft tone zero error");
+      }
+    }
+  }
+}
+
+std::unique_ptr<std::vector<float>> computeFftMagnitude(std::unique_ptr<FFT> fft) {
+  fft->execute();
+  return fft->getNormalizedMagnitude(0);
+}
+
+float magnitudeError(const std::vector<float>& reference, const std::vector<float>& magnitude) {
+  if (reference.size() != magnitude.size()) {
+    throw Fail("magnitude size mismatch");
+  }
+
+  float peak = 0.0;
+  float error = 0.0;
+  for (unsigned int i = 0; i < reference.size(); i++) {
+    peak = std::max(peak, std::fabs(reference[i]));
+    error = std::max(error, std::fabs(reference[i] - magnitude[i]));
+  }
+
+  if ( !(peak > 0.0) ) {
+    throw Fail("magnitude error reference sanity");
+  }
+
+  return 100.0 * error / peak;
+}
+
+float magnitudeSnr(const std::vector<float>& reference, const std::vector<float>& magnitude) {
+  if (reference.size() != magnitude.size()) {
+    throw Fail("magnitude size mismatch");
+  }
+
+  double signal = 0.0;
+  double noise = 0.0;
+  for (unsigned int i = 0; i < reference.size() / 2; i++) {
+    double error = (double)magnitude[i] - reference[i];
+    signal += (double)reference[i] * reference[i];
+    noise += error * error;
+  }
+
+  if ( !(signal > 0.0) ) {
+    throw Fail("magnitude snr reference sanity");
+  }
+
+  return 10.0 * std::log10(signal / std::max(noise, signal * 1e-30));
+}
+
+void verifySpanFft(SpanFft<float64_t>& fft, const std::vector<float64_t>& waveform) {
+  verifySpan(fft, waveform);
+}
+
+void verifySpanFft(SpanFft<float32_t>& fft, const std::vector<float32_t>& waveform) {
+  verifySpan(fft, waveform);
+}
+
+void verifySpanFft(SpanFft<q31_t>& fft, const std::vector<q31_t>& waveform) {
+  verifySpan(fft, waveform);
+}
+
+void verifySpanFft(SpanFft<q15_t>& fft, const std::vector<q15_t>& waveform) {
+  verifySpan(fft, waveform);
+}
@@ -4,10 +4,14 @@
 #ifndef PICO_CMSIS_SANDBOX_FFTTEST_INCLUDED
 #define PICO_CMSIS_SANDBOX_FFTTEST_INCLUDED
 
+#include "arm_math.h"
+
 #include <memory>
 #include <string>
+#include <vector>
 
 class FFT;
+template <typename T> class SpanFft;
 
 class FftTestParams {
 public:
@@ -47,14 +51,59 @@ public:
 
 struct FftTestResult {
   const std::string name;
+
+  // steady state fft execution time (us)
   const unsigned long elapsedTime;
 
-  FftTestResult(const std::string& name, unsigned long elapsedTime)
+  // one time fft plan init time (us)
+  const unsigned long initTime;
+
+  // peak fft working memory (bytes)
+  const unsigned int peakBytes;
+
+  FftTestResult(const std::string& name, unsigned long elapsedTime, unsigned long initTime, unsigned int peakBytes)
     :  name(name),
-       elapsedTime(elapsedTime)
+       elapsedTime(elapsedTime),
+       initTime(initTime),
+       peakBytes(peakBytes)
   {}
 };
 
+// Profile the fft execution (every frame of the batch) and verify the
+// result of every frame. Throws Fail if a frame is not as expected.
 FftTestResult executeFftTest(FftTestParams params, std::unique_ptr<FFT> fft);
 
+// Execute the complex fft of an analytic tone, the waveform is the test
+// signal amplitude times exp(j*pi*n/2), and verify its single peak of
+// amplitude*N at bin N/4. Every other bin, including the negative
+// frequency bin 3N/4, must be zero within the zero tolerance. Throws
+// Fail if not.
+void verifyComplexFftTone(FftTestParams params, std::unique_ptr<FFT> fft);
+
+// Execute the fft (not profiled) and return the normalized magnitude
+// of the first frame.
+std::unique_ptr<std::vector<float>> computeFftMagnitude(std::unique_ptr<FFT> fft);
+
+// The maximum absolute difference between two normalized magnitudes as
+// a percentage of the peak reference magnitude.
+float magnitudeError(const std::vector<float>& reference, const std::vector<float>& magnitude);
+
+// The signal to noise ratio of a normalized magnitude against the
+// reference magnitude of the same waveform in dB, the reference power
+// over the power of the difference, at most 300 dB. Only bins 0 to
+// N/2-1 are compared, the upper half mirrors them and the floating
+// point Nyquist component is signed.
+float magnitudeSnr(const std::vector<float>& reference, const std::vector<float>& magnitude);
+
+// Verify the span fft magnitude of the waveform, the clean test signal
+// with a peak at length/4. The magnitude is computed into a separate
+// span and in place over the scratch span, the two must be bit for bit
+// the same and peak at length/4. The inverse of the spectrum must be
+// the waveform, scaled down by the length for the fixed point ffts.
+// Throws Fail if not.
+void verifySpanFft(SpanFft<float64_t>& fft, const std::vector<float64_t>& waveform);
+void verifySpanFft(SpanFft<float32_t>& fft, const std::vector<float32_t>& waveform);
+void verifySpanFft(SpanFft<q31_t>& fft, const std::vector<q31_t>& waveform);
+void verifySpanFft(SpanFft<q15_t>& fft, const std::vector<q15_t>& waveform);
+
 #endif
@@ -8,6 +8,7 @@
 #include "CmsisFft.h"
 #include "FftTest.h"
 
+#include <cmath>
 #include <vector>
 
 using namespace fft;
@@ -21,12 +22,105 @@ namespace {
   
     const std::vector<unsigned int> sizes = {32, 64, 128, 256, 512, 1024, 2048, 4096, 8192};
 
-    std::unique_ptr<NameToElapsedTimeMap> resultMap = std::make_unique<NameToElapsedTimeMap>();
+    // The quiet signal is the noisy signal 8 bits (48 dB) below full
+    // scale.
+    const unsigned int quietShift = 8;
+
+    // Batched fft sizes and batch sizes. Batches are limited to
+    // maxBatchSamples samples, the size of the largest single fft.
+    const std::vector<unsigned int> batchFftSizes = {32, 64, 128, 256, 512};
+    const std::vector<unsigned int> batchSizes = {1, 4, 16, 64};
+    const unsigned int maxBatchSamples = 8192;
+
+    // The output modes, and their verification tolerance. The alpha max
+    // plus beta min magnitude error is up to 4%, hence up to 8% power.
+    // The q15 dB resolution is 1/128 dB, a 0.18% power step.
+    const std::vector<FftOutput> outputs = {FftOutput::MAGNITUDE, FftOutput::MAGNITUDE_SQUARED, FftOutput::ALPHA_MAX_BETA_MIN, FftOutput::DECIBEL};
+    const FftTestParams::Tolerance approxMagTestTolerance = FftTestParams::Tolerance(8.5, 4.0, 0.1);
+    const FftTestParams::Tolerance decibelTestTolerance = FftTestParams::Tolerance(0.5, 0.5, 0.1);
+
+    const FftTestParams::Tolerance& outputTestTolerance(FftOutput output) const {
+      switch (output) {
+      case FftOutput::ALPHA_MAX_BETA_MIN:
+	return approxMagTestTolerance;
+      case FftOutput::DECIBEL:
+	return decibelTestTolerance;
+      default:
+	return withoutNoiseTestTolerance;
+      }
+    }
+
+    std::unique_ptr<Results> results = std::make_unique<Results>();
     
-    void addResult( unsigned int fftSize, bool addNoise, const FftTestResult& result ) {
+    // The waveform as normalized f64 values, the input of the snr
+    // reference fft.
+    static std::unique_ptr<std::vector<float64_t>> toReference(const std::vector<float64_t>& waveform) {
+      return std::make_unique<std::vector<float64_t>>(waveform);
+    }
+
+    static std::unique_ptr<std::vector<float64_t>> toReference(const std::vector<float32_t>& waveform) {
+      return std::make_unique<std::vector<float64_t>>(waveform.cbegin(), waveform.cend());
+    }
+
+    template <typename T> static std::unique_ptr<std::vector<float64_t>> toReference(const std::vector<T>& waveform) {
+      auto reference = std::make_unique<std::vector<float64_t>>(waveform.size());
+      const double scale = ::pow(2.0, 8*sizeof(T) - 1);
+      for (unsigned int i = 0; i < waveform.size(); i++) {
+	reference->at(i) = waveform[i] / scale;
+      }
+      return reference;
+    }
+
+    // The magnitude snr of an fft against the f64 fft of the same
+    // (quantized) waveform, i.e. the error of the fft arithmetic alone.
+    // The reference is the f64 in-place fft, or the f64 complex fft for
+    // the complex ffts.
+    template <typename T, typename Create> float measureSnr(const std::vector<T>& waveform, Create create, bool complex = false) {
+      auto reference = computeFftMagnitude(complex ? createFloat64ComplexFft(toReference(waveform)) : createFloat64InPlaceFft(toReference(waveform)));
+      return magnitudeSnr(*reference, *computeFftMagnitude(create(std::make_unique<std::vector<T>>(waveform))));
+    }
+
+    // The real waveform as complex (I, Q) pairs, Q = 0.
+    template <typename T> static std::unique_ptr<std::vector<T>> toIq(std::unique_ptr<std::vector<T>> waveform) {
+      auto iq = std::make_unique<std::vector<T>>(2 * waveform->size());
+      for (unsigned int n = 0; n < waveform->size(); n++) {
+	iq->at(2*n) = waveform->at(n);
+      }
+      return iq;
+    }
+
+    // The analytic tone exp(j*pi*n/2) from N+1 samples of the clean
+    // signal s[n] = sin(pi*n/2): I[n] = s[n+1] = cos(pi*n/2), Q[n] =
+    // s[n].
+    template <typename T> static std::unique_ptr<std::vector<T>> toToneIq(std::unique_ptr<std::vector<T>> signal) {
+      const unsigned int length = signal->size() - 1;
+      auto iq = std::make_unique<std::vector<T>>(2 * length);
+      for (unsigned int n = 0; n < length; n++) {
+	iq->at(2*n) = signal->at(n + 1);
+	iq->at(2*n + 1) = signal->at(n);
+      }
+      return iq;
+    }
+
+    void addResult( unsigned int fftSize, bool addNoise, const FftTestResult& result, float snr ) {
       std::string key = (addNoise ? "noisy_" : "clean_") + result.name;
-      resultMap->try_emplace(key);
-      (*resultMap)[key][fftSize] = result.elapsedTime;
+      results->executeTime[key][fftSize] = result.elapsedTime;
+      results->initTime[key][fftSize] = result.initTime;
+      results->peakBytes[key][fftSize] = result.peakBytes;
+      results->snr[key][fftSize] = snr;
+    }
+
+    // Time and verify an fft of the waveform, and measure its snr.
+    template <typename T, typename Create> void runFft(unsigned int fftSize, bool addNoise, const FftTestParams& params, std::unique_ptr<std::vector<T>> waveform, Create create, bool complex = false) {
+      FftTestResult result = executeFftTest(params, create(std::make_unique<std::vector<T>>(*waveform)));
+      addResult( fftSize, addNoise, result, measureSnr(*waveform, create, complex) );
+    }
+
+    // Time and verify a complex fft of the real waveform (Q = 0), then
+    // verify it separates the analytic tone from its negative frequency.
+    template <typename T, typename Create> void runComplexFft(unsigned int fftSize, const FftTestParams& params, std::unique_ptr<std::vector<T>> waveform, std::unique_ptr<std::vector<T>> tone, Create create) {
+      runFft(fftSize, false, params, toIq(std::move(waveform)), create, true);
+      verifyComplexFftTone(params, create(toToneIq(std::move(tone))));
     }
     
     void run(unsigned int fftSize, bool addNoise) {
@@ -46,17 +140,120 @@ namespace {
       }
 
       if (fftSize < 8192) {
-	addResult( fftSize, addNoise, executeFftTest(params, std::move(createFloat64Fft(waveform.toFloat64()))) );
-	addResult( fftSize, addNoise, executeFftTest(params, std::move(createFloat32Fft(waveform.toFloat32()))) );
+	runFft(fftSize, addNoise, params, waveform.toFloat64(), [](auto w) { return createFloat64Fft(std::move(w)); });
+	runFft(fftSize, addNoise, params, waveform.toFloat32(), [](auto w) { return createFloat32Fft(std::move(w)); });
       }
 
-      addResult( fftSize, addNoise, executeFftTest(params, std::move(createQ31Fft(waveform.toQ31()))) );
-      addResult( fftSize, addNoise, executeFftTest(params, std::move(createQ15Fft(waveform.toQ15()))) );
+      // in-place, memory budgeted, all sizes
+      runFft(fftSize, addNoise, params, waveform.toFloat64(), createFloat64InPlaceFft);
+      runFft(fftSize, addNoise, params, waveform.toFloat32(), createFloat32InPlaceFft);
+
+      runFft(fftSize, addNoise, params, waveform.toQ31(), [](auto w) { return createQ31Fft(std::move(w)); });
+      runFft(fftSize, addNoise, params, waveform.toQ15(), [](auto w) { return createQ15Fft(std::move(w)); });
+
+      // block floating point, all sizes
+      runFft(fftSize, addNoise, params, waveform.toQ31(), createQ31BfpFft);
+      runFft(fftSize, addNoise, params, waveform.toQ15(), createQ15BfpFft);
+
+      // complex (I/Q) ffts, clean signal, up to 4096 complex points
+      if (!addNoise && fftSize <= 4096) {
+	CmsisTypeFactory tone(std::make_unique<Signal>(fftSize + 1, false));
+	runComplexFft(fftSize, params, waveform.toFloat64(), tone.toFloat64(), createFloat64ComplexFft);
+	runComplexFft(fftSize, params, waveform.toFloat32(), tone.toFloat32(), createFloat32ComplexFft);
+	runComplexFft(fftSize, params, waveform.toQ31(), tone.toQ31(), createQ31ComplexFft);
+	runComplexFft(fftSize, params, waveform.toQ15(), tone.toQ15(), createQ15ComplexFft);
+      }
+
+      // zero copy span ffts
+      if (!addNoise) {
+	if (fftSize < 8192) {
+	  verifySpanFft(*createFloat64SpanFft(fftSize), *waveform.toFloat64());
+	  verifySpanFft(*createFloat32SpanFft(fftSize), *waveform.toFloat32());
+	}
+	verifySpanFft(*createQ31SpanFft(fftSize), *waveform.toQ31());
+	verifySpanFft(*createQ15SpanFft(fftSize), *waveform.toQ15());
+      }
+    }
+
+    // The snr of the fixed point ffts for the noisy signal at
+    // quietShift bits below full scale.
+    void runQuiet(unsigned int fftSize) {
+      CmsisTypeFactory waveform(std::make_unique<Signal>(fftSize, true));
+      auto q31 = waveform.toQ31(quietShift);
+      auto q15 = waveform.toQ15(quietShift);
+
+      const std::string prefix = "quiet_";
+      results->snr[prefix + "q31"][fftSize] = measureSnr(*q31, [](auto w) { return createQ31Fft(std::move(w)); });
+      results->snr[prefix + "q15"][fftSize] = measureSnr(*q15, [](auto w) { return createQ15Fft(std::move(w)); });
+      results->snr[prefix + "q31_bfp"][fftSize] = measureSnr(*q31, createQ31BfpFft);
+      results->snr[prefix + "q15_bfp"][fftSize] = measureSnr(*q15, createQ15BfpFft);
     }
   
+    // Copy the frame batchSize times, back to back.
+    template <typename T> static std::unique_ptr<std::vector<T>> repeat(std::unique_ptr<std::vector<T>> frame, unsigned int batchSize) {
+      auto batch = std::make_unique<std::vector<T>>();
+      batch->reserve(frame->size() * batchSize);
+      for (unsigned int i = 0; i < batchSize; i++) {
+	batch->insert(batch->end(), frame->cbegin(), frame->cend());
+      }
+      return batch;
+    }
+
+    void addBatchResult( unsigned int fftSize, unsigned int batchSize, const FftTestResult& result ) {
+      results->batchTime[result.name][fftSize][batchSize] = result.elapsedTime;
+    }
+
+    // Transform batchSize frames of the clean signal in one call.
+    void runBatch(unsigned int fftSize, unsigned int batchSize) {
+
+      printf("\nfft size %d, batch size %d\n", fftSize, batchSize);
+
+      auto signal = std::make_unique<Signal>(fftSize, false);
+      FftTestParams params(signal->getAmplitude(), withoutNoiseTestTolerance);
+      CmsisTypeFactory waveform(std::move(signal));
+
+      addBatchResult( fftSize, batchSize, executeFftTest(params, createFloat64FftBatch(repeat(waveform.toFloat64(), batchSize), batchSize)) );
+      addBatchResult( fftSize, batchSize, executeFftTest(params, createFloat32FftBatch(repeat(waveform.toFloat32(), batchSize), batchSize)) );
+      addBatchResult( fftSize, batchSize, executeFftTest(params, createQ31FftBatch(repeat(waveform.toQ31(), batchSize), batchSize)) );
+      addBatchResult( fftSize, batchSize, executeFftTest(params, createQ15FftBatch(repeat(waveform.toQ15(), batchSize), batchSize)) );
+    }
+
+    template <typename T> using CreateFft = std::unique_ptr<FFT> (*)(std::unique_ptr<std::vector<T>> waveform, FftOutput output);
+
+    // Time and verify every output mode of one data type, and measure
+    // its error against the MAGNITUDE output.
+    template <typename T> void runOutputs(unsigned int fftSize, double amplitude, const std::vector<T>& waveform, CreateFft<T> create) {
+      auto reference = computeFftMagnitude(create(std::make_unique<std::vector<T>>(waveform), FftOutput::MAGNITUDE));
+
+      for (FftOutput output: outputs) {
+	FftTestParams params(amplitude, outputTestTolerance(output));
+	FftTestResult result = executeFftTest(params, create(std::make_unique<std::vector<T>>(waveform), output));
+	results->outputTime[result.name][fftSize] = result.elapsedTime;
+
+	auto magnitude = computeFftMagnitude(create(std::make_unique<std::vector<T>>(waveform), output));
+	results->outputError[result.name][fftSize] = magnitudeError(*reference, *magnitude);
+      }
+    }
+
+    void runOutputs(unsigned int fftSize) {
+
+      printf("\nfft size %d\n", fftSize);
+
+      auto signal = std::make_unique<Signal>(fftSize, false);
+      double amplitude = signal->getAmplitude();
+      CmsisTypeFactory waveform(std::move(signal));
+
+      if (fftSize < 8192) {
+	runOutputs<float64_t>(fftSize, amplitude, *waveform.toFloat64(), createFloat64Fft);
+	runOutputs<float32_t>(fftSize, amplitude, *waveform.toFloat32(), createFloat32Fft);
+      }
+      runOutputs<q31_t>(fftSize, amplitude, *waveform.toQ31(), createQ31Fft);
+      runOutputs<q15_t>(fftSize, amplitude, *waveform.toQ15(), createQ15Fft);
+    }
+
   public:  
 
-    std::unique_ptr<NameToElapsedTimeMap> runAll() {
+    std::unique_ptr<Results> runAll() {
       printf("\nwithout noise:\n");
       for(unsigned int size: sizes) {
 	run(size, false);
@@ -67,11 +264,29 @@ namespace {
 	run(size, true);
       }
 
-      return std::move(resultMap);
+      for(unsigned int size: sizes) {
+	runQuiet(size);
+      }
+
+      printf("\noutput modes:\n");
+      for(unsigned int size: sizes) {
+	runOutputs(size);
+      }
+
+      printf("\nbatched:\n");
+      for(unsigned int size: batchFftSizes) {
+	for(unsigned int batchSize: batchSizes) {
+	  if (size * batchSize <= maxBatchSamples) {
+	    runBatch(size, batchSize);
+	  }
+	}
+      }
+
+      return std::move(results);
     }
   };
 } // namespace
 
-std::unique_ptr<NameToElapsedTimeMap> runAllFftTests() {
+std::unique_ptr<Results> runAllFftTests() {
   return FftTestRunner().runAll();
 }
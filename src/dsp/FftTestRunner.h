@@ -14,8 +14,59 @@ namespace fft {
 
   // map name to size/time map
   typedef std::map<std::string, SizeToElapsedTimeMap> NameToElapsedTimeMap;
+
+  // map size to bytes
+  typedef std::map<unsigned int, unsigned long> SizeToBytesMap;
+
+  // map name to size/bytes map
+  typedef std::map<std::string, SizeToBytesMap> NameToBytesMap;
+
+  // map size to error (%)
+  typedef std::map<unsigned int, float> SizeToErrorMap;
+
+  // map name to size/error map
+  typedef std::map<std::string, SizeToErrorMap> NameToErrorMap;
+
+  // map size to snr (dB)
+  typedef std::map<unsigned int, float> SizeToSnrMap;
+
+  // map name to size/snr map
+  typedef std::map<std::string, SizeToSnrMap> NameToSnrMap;
+
+  // map batch size to elapsed time in us
+  typedef std::map<unsigned int, unsigned long> BatchSizeToElapsedTimeMap;
+
+  // map fft size to batch size/time map
+  typedef std::map<unsigned int, BatchSizeToElapsedTimeMap> SizeToBatchElapsedTimeMap;
+
+  // map name to fft size/batch size/time map
+  typedef std::map<std::string, SizeToBatchElapsedTimeMap> NameToBatchElapsedTimeMap;
+
+  struct Results {
+    // steady state fft execution time
+    NameToElapsedTimeMap executeTime;
+
+    // one time fft plan init time
+    NameToElapsedTimeMap initTime;
+
+    // peak fft working memory
+    NameToBytesMap peakBytes;
+
+    // magnitude snr against the f64 fft of the same waveform
+    NameToSnrMap snr;
+
+    // batched fft execution time (all frames of the batch)
+    NameToBatchElapsedTimeMap batchTime;
+
+    // fft execution time by output mode (clean signal)
+    NameToElapsedTimeMap outputTime;
+
+    // output mode magnitude error relative to the exact magnitude of
+    // the same data type (% of peak)
+    NameToErrorMap outputError;
+  };
 }
 
-std::unique_ptr<fft::NameToElapsedTimeMap> runAllFftTests();
+std::unique_ptr<fft::Results> runAllFftTests();
 
 #endif
@@ -0,0 +1,468 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "FirDesign.h"
+
+#include "Ex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+
+namespace {
+
+  // Zeroth order modified Bessel function of the first kind (power
+  // series).
+  double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 64; k++) {
+      term *= (x / (2.0 * k)) * (x / (2.0 * k));
+      sum += term;
+      if (term < 1e-12 * sum) {
+	break;
+      }
+    }
+    return sum;
+  }
+
+  // sin(pi*x)/(pi*x)
+  double sinc(double x) {
+    if (x == 0.0) {
+      return 1.0;
+    }
+    return std::sin(M_PI * x) / (M_PI * x);
+  }
+
+  // Window method lowpass, window(r) for r in [-1, 1].
+  template <typename W> std::unique_ptr<std::vector<double>> designWindowLowpass(unsigned int numTaps, double cutoff, W window) {
+    if (numTaps == 0 || !(cutoff > 0.0 && cutoff <= 1.0)) {
+      throw Ex("invalid lowpass filter specification");
+    }
+
+    auto fir = std::make_unique<std::vector<double>>(numTaps);
+
+    const double center = (numTaps - 1) / 2.0;
+    double sum = 0.0;
+
+    for (unsigned int n = 0; n < numTaps; n++) {
+      double r = numTaps > 1 ? (n - center) / center : 0.0;
+      double h = cutoff * sinc(cutoff * (n - center)) * window(r);
+      fir->at(n) = h;
+      sum += h;
+    }
+
+    // unity gain at DC
+    for (double& h: *fir) {
+      h /= sum;
+    }
+
+    return fir;
+  }
+
+  // Solve the symmetric positive definite system A x = b in place by
+  // Gaussian elimination with partial pivoting, A is n x n row major.
+  std::vector<double> solve(std::vector<double>& A, std::vector<double>& b, unsigned int n) {
+    for (unsigned int col = 0; col < n; col++) {
+      unsigned int pivot = col;
+      for (unsigned int row = col + 1; row < n; row++) {
+	if (std::fabs(A[row*n + col]) > std::fabs(A[pivot*n + col])) {
+	  pivot = row;
+	}
+      }
+      if (A[pivot*n + col] == 0.0) {
+	throw Ex("singular equiripple design system");
+      }
+      if (pivot != col) {
+	for (unsigned int j = 0; j < n; j++) {
+	  std::swap(A[col*n + j], A[pivot*n + j]);
+	}
+	std::swap(b[col], b[pivot]);
+      }
+      for (unsigned int row = col + 1; row < n; row++) {
+	double f = A[row*n + col] / A[col*n + col];
+	for (unsigned int j = col; j < n; j++) {
+	  A[row*n + j] -= f * A[col*n + j];
+	}
+	b[row] -= f * b[col];
+      }
+    }
+
+    std::vector<double> x(n);
+    for (int row = n - 1; row >= 0; row--) {
+      double sum = b[row];
+      for (unsigned int j = row + 1; j < n; j++) {
+	sum -= A[row*n + j] * x[j];
+      }
+      x[row] = sum / A[row*n + row];
+    }
+    return x;
+  }
+
+  // Memoized designs.
+  std::map<FirSpec, std::vector<double>> firCache;
+  std::map<FirSpec, std::vector<float32_t>> f32FirCache;
+  std::map<FirSpec, std::vector<q15_t>> q15FirCache;
+  std::map<FirSpec, std::vector<q31_t>> q31FirCache;
+
+  template <typename T> std::map<FirSpec, std::vector<T>>& quantizedFirCache();
+  template <> std::map<FirSpec, std::vector<float32_t>>& quantizedFirCache<float32_t>() { return f32FirCache; }
+  template <> std::map<FirSpec, std::vector<q15_t>>& quantizedFirCache<q15_t>() { return q15FirCache; }
+  template <> std::map<FirSpec, std::vector<q31_t>>& quantizedFirCache<q31_t>() { return q31FirCache; }
+
+  // Fixed point fraction bits.
+  template <typename T> int fractionBits();
+  template <> int fractionBits<q15_t>() { return 15; }
+  template <> int fractionBits<q31_t>() { return 31; }
+
+  template <typename T> std::unique_ptr<std::vector<T>> quantizeFixed(const std::vector<double>& fir) {
+    const double scale = std::ldexp(1.0, fractionBits<T>());
+    const int64_t maxValue = (int64_t)scale - 1;
+    const int64_t minValue = -(int64_t)scale;
+    auto clip = [maxValue, minValue](int64_t x) { return std::min(maxValue, std::max(minValue, x)); };
+
+    std::vector<int64_t> q(fir.size());
+    double sum = 0.0;
+    int64_t qsum = 0;
+    for (unsigned int n = 0; n < fir.size(); n++) {
+      q[n] = clip(std::llround(fir[n] * scale));
+      sum += fir[n];
+      qsum += q[n];
+    }
+
+    // Put the DC gain rounding error in the center tap, or split it
+    // over the two center taps of an even length filter. An odd error
+    // puts the extra LSB on one of them, the DC gain is exact and the
+    // center pair differs by 1 LSB.
+    int64_t error = std::llround(sum * scale) - qsum;
+    if (!fir.empty()) {
+      const unsigned int c = fir.size() / 2;
+      if (fir.size() % 2 == 1) {
+	q[c] = clip(q[c] + error);
+      }
+      else {
+	q[c-1] = clip(q[c-1] + error / 2);
+	q[c] = clip(q[c] + error - error / 2);
+      }
+    }
+
+    auto result = std::make_unique<std::vector<T>>(fir.size());
+    std::transform(q.cbegin(), q.cend(), result->begin(), [](int64_t x) { return (T)x; });
+    return result;
+  }
+
+} // namespace
+
+std::unique_ptr<std::vector<double>> designHammingLowpass(unsigned int numTaps, double cutoff) {
+  return designWindowLowpass(numTaps, cutoff, [](double r) {
+    return 0.54 + 0.46 * std::cos(M_PI * r);
+  });
+}
+
+// The ideal half-band response, sinc(n/2)/2, is zero at even n != 0,
+// the window design is zero there only to within the rounding of
+// sin(pi*n/2). Zero those taps and restore unity gain at DC.
+std::unique_ptr<std::vector<double>> designHalfBandLowpass(unsigned int numTaps) {
+  if (numTaps % 2 == 0) {
+    throw Ex("half-band filter length is not odd");
+  }
+
+  auto fir = designHammingLowpass(numTaps, 0.5);
+
+  const unsigned int c = numTaps / 2;
+  double sum = fir->at(c);
+  for (unsigned int d = 1; d <= c; d++) {
+    if (d % 2 == 0) {
+      fir->at(c-d) = fir->at(c+d) = 0.0;
+    }
+    else {
+      sum += fir->at(c-d) + fir->at(c+d);
+    }
+  }
+
+  for (double& h: *fir) {
+    h /= sum;
+  }
+
+  return fir;
+}
+
+std::unique_ptr<std::vector<double>> designKaiserLowpass(unsigned int numTaps, double cutoff, double beta) {
+  const double i0Beta = besselI0(beta);
+  return designWindowLowpass(numTaps, cutoff, [beta, i0Beta](double r) {
+    return besselI0(beta * std::sqrt(std::fmax(0.0, 1.0 - r*r))) / i0Beta;
+  });
+}
+
+// Lawson's algorithm: weighted least squares on a dense frequency
+// grid, with each iteration multiplying the grid weights by the
+// magnitude of the error. The weights concentrate on the error peaks
+// and the solution converges towards the minimax (equiripple) filter.
+//
+// The amplitude response of a symmetric filter is a cosine series,
+// A(w) = sum a[k] cos(w (k + s)), s = 0 for odd and 1/2 for even
+// length filters.
+std::unique_ptr<std::vector<double>> designEquirippleLowpass(unsigned int numTaps, double passband, double stopband, double stopbandWeight) {
+  if ( numTaps < 3 || !(passband > 0.0 && passband < stopband && stopband < 1.0) || !(stopbandWeight > 0.0) ) {
+    throw Ex("invalid equiripple filter specification");
+  }
+
+  const bool odd = numTaps % 2 == 1;
+  const unsigned int numCoeffs = (numTaps + 1) / 2;
+  const double shift = odd ? 0.0 : 0.5;
+  const unsigned int gridDensity = 16;
+  const unsigned int numIterations = 40;
+
+  // grid frequencies (radians per sample), desired response and
+  // weights, points distributed in proportion to the band widths
+  std::vector<double> w;
+  std::vector<double> desired;
+  std::vector<double> weight;
+  const unsigned int numPoints = gridDensity * numCoeffs;
+  const double bandWidth = passband + (1.0 - stopband);
+  const unsigned int numPassband = std::max(2u, (unsigned int)(numPoints * passband / bandWidth));
+  const unsigned int numStopband = std::max(2u, numPoints - numPassband);
+  for (unsigned int i = 0; i < numPassband; i++) {
+    w.push_back(M_PI * passband * i / (numPassband - 1));
+    desired.push_back(1.0);
+    weight.push_back(1.0);
+  }
+  for (unsigned int i = 0; i < numStopband; i++) {
+    w.push_back(M_PI * (stopband + (1.0 - stopband) * i / (numStopband - 1)));
+    desired.push_back(0.0);
+    weight.push_back(stopbandWeight);
+  }
+
+  // basis functions at the grid points
+  std::vector<double> basis(w.size() * numCoeffs);
+  for (unsigned int i = 0; i < w.size(); i++) {
+    for (unsigned int k = 0; k < numCoeffs; k++) {
+      basis[i*numCoeffs + k] = std::cos(w[i] * (k + shift));
+    }
+  }
+
+  std::vector<double> lawson(w.size(), 1.0);
+  std::vector<double> a;
+
+  for (unsigned int iteration = 0; iteration < numIterations; iteration++) {
+    // normal equations
+    std::vector<double> G(numCoeffs * numCoeffs, 0.0);
+    std::vector<double> r(numCoeffs, 0.0);
+    for (unsigned int i = 0; i < w.size(); i++) {
+      const double W = weight[i] * weight[i] * lawson[i];
+      const double* phi = &basis[i*numCoeffs];
+      for (unsigned int k = 0; k < numCoeffs; k++) {
+	r[k] += W * desired[i] * phi[k];
+	for (unsigned int j = 0; j < numCoeffs; j++) {
+	  G[k*numCoeffs + j] += W * phi[k] * phi[j];
+	}
+      }
+    }
+
+    a = solve(G, r, numCoeffs);
+
+    // reweight by the weighted error magnitude
+    double sum = 0.0;
+    for (unsigned int i = 0; i < w.size(); i++) {
+      double A = 0.0;
+      for (unsigned int k = 0; k < numCoeffs; k++) {
+	A += a[k] * basis[i*numCoeffs + k];
+      }
+      lawson[i] *= weight[i] * std::fabs(A - desired[i]);
+      sum += lawson[i];
+    }
+    if (!(sum > 0.0)) {
+      break;
+    }
+    for (double& l: lawson) {
+      l /= sum;
+    }
+  }
+
+  // cosine series to impulse response
+  auto fir = std::make_unique<std::vector<double>>(numTaps);
+  const unsigned int c = numTaps / 2;
+  if (odd) {
+    fir->at(c) = a[0];
+    for (unsigned int k = 1; k < numCoeffs; k++) {
+      fir->at(c - k) = fir->at(c + k) = a[k] / 2.0;
+    }
+  }
+  else {
+    for (unsigned int k = 0; k < numCoeffs; k++) {
+      fir->at(c - 1 - k) = fir->at(c + k) = a[k] / 2.0;
+    }
+  }
+
+  return fir;
+}
+
+// Window method with the inverse CIC response as the ideal response:
+// h[n] = 2 * integral(0, fc) D(v) cos(2 pi v (n - c)) dv, v in cycles
+// per sample, evaluated by the midpoint rule.
+std::unique_ptr<std::vector<double>> designCicCompensator(unsigned int numTaps, double cutoff, double beta, unsigned int order, unsigned int R) {
+  if (numTaps == 0 || !(cutoff > 0.0 && cutoff < 1.0) || order == 0 || R == 0) {
+    throw Ex("invalid CIC compensator specification");
+  }
+
+  const unsigned int numPoints = 1024;
+  const double fc = cutoff / 2.0;
+  const double dv = fc / numPoints;
+
+  std::vector<double> ideal(numPoints);
+  for (unsigned int i = 0; i < numPoints; i++) {
+    double v = (i + 0.5) * dv;
+    ideal[i] = 1.0 / cicMagnitude(order, R, 2.0 * v);
+  }
+
+  auto fir = std::make_unique<std::vector<double>>(numTaps);
+
+  const double center = (numTaps - 1) / 2.0;
+  const double i0Beta = besselI0(beta);
+  double sum = 0.0;
+
+  for (unsigned int n = 0; n < numTaps; n++) {
+    double h = 0.0;
+    for (unsigned int i = 0; i < numPoints; i++) {
+      double v = (i + 0.5) * dv;
+      h += ideal[i] * std::cos(2.0 * M_PI * v * (n - center));
+    }
+    h *= 2.0 * dv;
+
+    double r = numTaps > 1 ? (n - center) / center : 0.0;
+    double window = besselI0(beta * std::sqrt(std::fmax(0.0, 1.0 - r*r))) / i0Beta;
+    fir->at(n) = h * window;
+    sum += fir->at(n);
+  }
+
+  // unity gain at DC (the CIC response is unity at DC)
+  for (double& h: *fir) {
+    h /= sum;
+  }
+
+  return fir;
+}
+
+double firMagnitude(const std::vector<double>& fir, double f) {
+  double re = 0.0;
+  double im = 0.0;
+  for (unsigned int n = 0; n < fir.size(); n++) {
+    re += fir[n] * std::cos(M_PI * f * n);
+    im -= fir[n] * std::sin(M_PI * f * n);
+  }
+  return std::sqrt(re*re + im*im);
+}
+
+// |sin(pi v R) / (R sin(pi v))|^order, v in cycles per CIC input
+// sample.
+double cicMagnitude(unsigned int order, unsigned int R, double f) {
+  const double v = f / 2.0 / R;
+  if (v == 0.0) {
+    return 1.0;
+  }
+  return std::pow(std::fabs(std::sin(M_PI * v * R) / (R * std::sin(M_PI * v))), order);
+}
+
+double kaiserBeta(double attenuation) {
+  if (attenuation > 50.0) {
+    return 0.1102 * (attenuation - 8.7);
+  }
+  else if (attenuation >= 21.0) {
+    return 0.5842 * std::pow(attenuation - 21.0, 0.4) + 0.07886 * (attenuation - 21.0);
+  }
+  else {
+    return 0.0;
+  }
+}
+
+// Kaiser's estimate: N = (A - 8) / (2.285 * dw) + 1, where dw is the
+// transition width in radians per sample.
+unsigned int kaiserNumTaps(double attenuation, double transitionWidth) {
+  if ( !(transitionWidth > 0.0) ) {
+    throw Ex("invalid transition width");
+  }
+
+  double dw = M_PI * transitionWidth;
+  unsigned int numTaps = (unsigned int)std::ceil((attenuation - 8.0) / (2.285 * dw)) + 1;
+
+  // odd length, symmetric (type I) filter
+  if (numTaps % 2 == 0) {
+    numTaps++;
+  }
+
+  return numTaps < 3 ? 3 : numTaps;
+}
+
+FirSpec FirSpec::decimation(FirMethod method, unsigned int M, unsigned int numTaps, double transitionWidth, double attenuation) {
+  if (M == 0) {
+    throw Ex("invalid decimation factor");
+  }
+  const double cutoff = 1.0 / M;
+  return FirSpec(method, numTaps, cutoff - transitionWidth / 2.0, cutoff + transitionWidth / 2.0, attenuation);
+}
+
+bool FirSpec::operator<(const FirSpec& other) const {
+  return std::tie(method, numTaps, passband, stopband, attenuation) < std::tie(other.method, other.numTaps, other.passband, other.stopband, other.attenuation);
+}
+
+const std::vector<double>& getFir(const FirSpec& spec) {
+  auto cached = firCache.find(spec);
+  if (cached != firCache.end()) {
+    return cached->second;
+  }
+
+  std::unique_ptr<std::vector<double>> fir;
+  const double cutoff = (spec.passband + spec.stopband) / 2.0;
+  switch (spec.method) {
+  case FirMethod::HAMMING:
+    fir = designHammingLowpass(spec.numTaps, cutoff);
+    break;
+  case FirMethod::KAISER:
+    fir = designKaiserLowpass(spec.numTaps, cutoff, kaiserBeta(spec.attenuation));
+    break;
+  case FirMethod::EQUIRIPPLE: {
+    // 0.1 dB passband ripple relative to the stopband attenuation
+    const double passbandDelta = (std::pow(10.0, 0.1 / 20.0) - 1.0) / (std::pow(10.0, 0.1 / 20.0) + 1.0);
+    const double stopbandDelta = std::pow(10.0, -spec.attenuation / 20.0);
+    fir = designEquirippleLowpass(spec.numTaps, spec.passband, spec.stopband, passbandDelta / stopbandDelta);
+    break;
+  }
+  default:
+    throw Ex("unknown FIR design method");
+  }
+
+  return firCache.emplace(spec, std::move(*fir)).first->second;
+}
+
+template <> std::unique_ptr<std::vector<float32_t>> quantizeFir<float32_t>(const std::vector<double>& fir) {
+  return std::make_unique<std::vector<float32_t>>(fir.cbegin(), fir.cend());
+}
+
+template <> std::unique_ptr<std::vector<q15_t>> quantizeFir<q15_t>(const std::vector<double>& fir) {
+  return quantizeFixed<q15_t>(fir);
+}
+
+template <> std::unique_ptr<std::vector<q31_t>> quantizeFir<q31_t>(const std::vector<double>& fir) {
+  return quantizeFixed<q31_t>(fir);
+}
+
+template <typename T> const std::vector<T>& getQuantizedFir(const FirSpec& spec) {
+  auto& cache = quantizedFirCache<T>();
+  auto cached = cache.find(spec);
+  if (cached != cache.end()) {
+    return cached->second;
+  }
+  return cache.emplace(spec, std::move(*quantizeFir<T>(getFir(spec)))).first->second;
+}
+
+template const std::vector<float32_t>& getQuantizedFir<float32_t>(const FirSpec& spec);
+template const std::vector<q15_t>& getQuantizedFir<q15_t>(const FirSpec& spec);
+template const std::vector<q31_t>& getQuantizedFir<q31_t>(const FirSpec& spec);
+
+void clearFirDesignCache() {
+  firCache.clear();
+  f32FirCache.clear();
+  q15FirCache.clear();
+  q31FirCache.clear();
+}
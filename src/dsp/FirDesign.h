@@ -0,0 +1,118 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_FIRDESIGN_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_FIRDESIGN_H_INCLUDED
+
+#include "arm_math.h"
+
+#include <memory>
+#include <vector>
+
+/**
+Linear phase lowpass FIR design.
+
+Frequencies are normalized to the Nyquist frequency, as they are for
+the Octave fir1 command. That is, cutoff=1/M is the cutoff of a
+decimate by M filter.
+
+The window method designs truncate the ideal (sinc) impulse response
+to numTaps samples with a window function and scale it for unity gain
+at DC. The equiripple design approximates a minimax (Parks-McClellan)
+filter with Lawson's iteratively reweighted least squares.
+*/
+
+// Design a lowpass filter with a Hamming window. The same as the
+// Octave command fir1(numTaps-1, cutoff).
+std::unique_ptr<std::vector<double>> designHammingLowpass(unsigned int numTaps, double cutoff);
+
+// Design a lowpass filter with a Kaiser window.
+std::unique_ptr<std::vector<double>> designKaiserLowpass(unsigned int numTaps, double cutoff, double beta);
+
+// Design a half-band lowpass filter, a Hamming window design with
+// cutoff 1/2 whose taps at an even, non zero, distance from the
+// center tap are exactly zero. Throws Ex if numTaps is not odd.
+std::unique_ptr<std::vector<double>> designHalfBandLowpass(unsigned int numTaps);
+
+// Design an equiripple lowpass filter with a passband [0, passband]
+// and a stopband [stopband, 1]. The stopband error is weighted by
+// stopbandWeight relative to the passband error.
+std::unique_ptr<std::vector<double>> designEquirippleLowpass(unsigned int numTaps, double passband, double stopband, double stopbandWeight = 1.0);
+
+// Design a Kaiser window lowpass filter that compensates the passband
+// droop of a CIC decimator of the given order and rate R. The filter
+// runs at the CIC output rate, frequencies are normalized to its
+// Nyquist frequency. The ideal response is the inverse CIC response
+// below cutoff and zero above it.
+std::unique_ptr<std::vector<double>> designCicCompensator(unsigned int numTaps, double cutoff, double beta, unsigned int order, unsigned int R);
+
+// The magnitude response of an FIR filter at frequency f, normalized
+// to the Nyquist frequency.
+double firMagnitude(const std::vector<double>& fir, double f);
+
+// The magnitude response, normalized to unity gain at DC, of a CIC
+// decimator of the given order and rate R (differential delay 1) at
+// frequency f, normalized to the Nyquist frequency of the CIC output.
+double cicMagnitude(unsigned int order, unsigned int R, double f);
+
+// The Kaiser window beta parameter for a stopband attenuation in dB.
+double kaiserBeta(double attenuation);
+
+// Estimate the (odd) number of taps a Kaiser window design needs to
+// achieve the attenuation in dB with the transition width (normalized
+// to the Nyquist frequency).
+unsigned int kaiserNumTaps(double attenuation, double transitionWidth);
+
+enum class FirMethod {
+  HAMMING = 0,
+  KAISER = 1,
+  EQUIRIPPLE = 2
+};
+
+// A lowpass filter specification. The window methods put the cutoff
+// in the middle of the transition band [passband, stopband], the
+// Kaiser window beta is set by the stopband attenuation (dB), and the
+// equiripple stopband weight is set by the attenuation relative to a
+// 0.1 dB passband ripple.
+struct FirSpec {
+  FirMethod method;
+  unsigned int numTaps;
+  double passband;
+  double stopband;
+  double attenuation;
+
+  FirSpec(FirMethod method, unsigned int numTaps, double passband, double stopband, double attenuation)
+    : method(method),
+      numTaps(numTaps),
+      passband(passband),
+      stopband(stopband),
+      attenuation(attenuation)
+  {}
+
+  // A decimate by M filter, cutoff 1/M and a transitionWidth wide
+  // transition band centered on the cutoff.
+  static FirSpec decimation(FirMethod method, unsigned int M, unsigned int numTaps, double transitionWidth = 0.0, double attenuation = 60.0);
+
+  bool operator<(const FirSpec& other) const;
+};
+
+// Design the filter, or return the memoized design of an equal spec.
+// The reference is valid until clearFirDesignCache() is called.
+const std::vector<double>& getFir(const FirSpec& spec);
+
+// The filter quantized to T, one of float32_t, q15_t or q31_t. The
+// fixed point coefficients are rounded to nearest and saturated, and
+// the center tap(s) absorb the rounding error of the DC gain. An odd
+// length filter stays symmetric, an even length one does unless the
+// error is odd, then its center pair differs by 1 LSB. Memoized as
+// getFir() is.
+template <typename T> const std::vector<T>& getQuantizedFir(const FirSpec& spec);
+
+// Quantize a filter to T, see getQuantizedFir().
+template <typename T> std::unique_ptr<std::vector<T>> quantizeFir(const std::vector<double>& fir);
+
+// Release all memoized designs. References obtained prior to this call
+// are invalidated.
+void clearFirDesignCache();
+
+#endif
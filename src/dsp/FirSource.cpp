@@ -4,9 +4,12 @@
 #include "FirSource.h"
 
 #include "Source.h"
+#include "FirDesign.h"
 
 #include "Ex.h"
 
+#include <algorithm>
+
 namespace {
 
   class FirSource : public Source {
@@ -42,6 +45,97 @@ namespace {
 
       return fir->at(n++);
     }
+
+    using Source::fill;
+
+    virtual unsigned int fill(Span<float64_t> out) {
+      return copy(out);
+    }
+
+    virtual unsigned int fill(Span<float32_t> out) {
+      return copy(out);
+    }
+
+  private:
+
+    template <typename T> unsigned int copy(Span<T> out) {
+      const unsigned int count = std::min(out.size(), (unsigned int)fir->size() - n);
+      std::copy(fir->cbegin() + n, fir->cbegin() + n + count, out.begin());
+      n += count;
+      return count;
+    }
+  };
+
+  class FirSpecSource : public Source {
+
+    const FirSpec spec;
+
+    unsigned int n = 0;
+
+  public:
+
+    FirSpecSource(const FirSpec& spec)
+      : spec(spec)
+    {}
+
+    virtual ~FirSpecSource() {};
+
+    virtual unsigned int size() const {
+      return spec.numTaps;
+    }
+
+    virtual bool isEnd() const {
+      return n == spec.numTaps;
+    }
+
+    virtual void reset() {
+      n = 0;
+    }
+
+    virtual double next() {
+      if (isEnd()) {
+	throw Ex("end of FIR");
+      }
+
+      return getFir(spec).at(n++);
+    }
+
+    virtual unsigned int fill(Span<float64_t> out) {
+      return copy(getFir(spec), out, 0);
+    }
+
+    virtual unsigned int fill(Span<float32_t> out) {
+      return copy(getQuantizedFir<float32_t>(spec), out, 0);
+    }
+
+    virtual unsigned int fill(Span<q31_t> out, unsigned int rshift) {
+      return copy(getQuantizedFir<q31_t>(spec), out, rshift);
+    }
+
+    virtual unsigned int fill(Span<q15_t> out, unsigned int rshift) {
+      return copy(getQuantizedFir<q15_t>(spec), out, rshift);
+    }
+
+  private:
+
+    template <typename T> unsigned int copy(const std::vector<T>& fir, Span<T> out, unsigned int rshift) {
+      const unsigned int count = std::min(out.size(), (unsigned int)fir.size() - n);
+      std::transform(fir.cbegin() + n, fir.cbegin() + n + count, out.begin(), [rshift](T x) { return shift(x, rshift); });
+      n += count;
+      return count;
+    }
+
+    template <typename T> static T shift(T x, unsigned int) {
+      return x;
+    }
+
+    static q31_t shift(q31_t x, unsigned int rshift) {
+      return x >> rshift;
+    }
+
+    static q15_t shift(q15_t x, unsigned int rshift) {
+      return (q15_t)(x >> rshift);
+    }
   };
 
 } // namespace
@@ -49,3 +143,7 @@ namespace {
 std::unique_ptr<Source> createFirSource(std::unique_ptr<std::vector<double>> fir) {
   return std::make_unique<FirSource>(std::move(fir));
 }
+
+std::unique_ptr<Source> createFirSource(const FirSpec& spec) {
+  return std::make_unique<FirSpecSource>(spec);
+}
@@ -9,6 +9,16 @@
 #include <memory>
 #include <vector>
 
+struct FirSpec;
+
 std::unique_ptr<Source> createFirSource(std::unique_ptr<std::vector<double>> fir);
 
+// A source of the designed filter coefficients (see FirDesign.h). The
+// float64_t samples are getFir(spec), the float32_t, q31_t and q15_t
+// samples are getQuantizedFir<T>(spec), i.e. the fixed point
+// coefficients are rounded with the DC gain kept, not truncated from
+// float32_t as the other sources are, then right shifted by rshift
+// bits.
+std::unique_ptr<Source> createFirSource(const FirSpec& spec);
+
 #endif
@@ -0,0 +1,397 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "Generator.h"
+
+#include "Ex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+  // the q31 samples generated at a time
+  const unsigned int blockSize = 64;
+
+  // quarter wave sine table size, 2^quarterBits entries plus the
+  // sin(pi/2) entry
+  const unsigned int quarterBits = 8;
+  const unsigned int quarterSize = 1 << quarterBits;
+
+  // The quarter wave table, sin(pi/2 * i/quarterSize) as q31, built on
+  // first use.
+  const std::vector<int32_t>& getQuarterWave() {
+    static std::vector<int32_t> table;
+    if (table.empty()) {
+      table.resize(quarterSize + 1);
+      for (unsigned int i = 0; i <= quarterSize; i++) {
+	table[i] = (int32_t)std::min(2147483647.0, std::round(std::sin(M_PI/2.0 * i / quarterSize) * 2147483648.0));
+      }
+    }
+    return table;
+  }
+
+  // sin(2*pi * phase/2^32) as q31. The upper 2 bits of the phase are the
+  // quadrant, the next quarterBits bits the table index and the
+  // following 16 bits the interpolation fraction.
+  inline int32_t sine(const int32_t* table, uint32_t phase) {
+    const uint32_t quadrant = phase >> 30;
+    uint32_t p = phase & 0x3fffffff;
+    if (quadrant & 1) {
+      p = 0x40000000 - p;
+    }
+    const uint32_t i = p >> (30 - quarterBits);
+    const int32_t fraction = (p >> (30 - quarterBits - 16)) & 0xffff;
+    int32_t s = table[i];
+    if (fraction != 0) {
+      s += (int32_t)(((int64_t)(table[i+1] - s) * fraction) >> 16);
+    }
+    return quadrant & 2 ? -s : s;
+  }
+
+  // (a * gain) >> 31 saturated to q31, gain q31 (0 to 1.0).
+  inline int32_t scale(int64_t a, int32_t gain) {
+    return (int32_t)std::clamp<int64_t>((a * gain) >> 31, INT32_MIN, INT32_MAX);
+  }
+
+  // amplitude, full scale 1.0, as a q31 gain
+  int32_t toGain(double amplitude) {
+    return (int32_t)std::clamp(std::round(std::fabs(amplitude) * 2147483648.0), 0.0, 2147483647.0);
+  }
+
+  // frequency, cycles per sample, as a 2^64 per cycle phase increment
+  uint64_t toIncrement(double frequency) {
+    if (!(frequency >= 0.0 && frequency <= 0.5)) {
+      throw Ex("generator frequency error");
+    }
+    return (uint64_t)std::ldexp(frequency, 64);
+  }
+
+  class GeneratorSource : public Source {
+
+    const unsigned int numSamples;
+
+    unsigned int n = 0;
+
+    // Write the next count q31 samples to out, count <= blockSize.
+    virtual void generate(q31_t* out, unsigned int count) = 0;
+
+    // Restart the waveform.
+    virtual void restart() = 0;
+
+    static void convert(const q31_t* in, float64_t* out, unsigned int count, unsigned int rshift) {
+      for (unsigned int i = 0; i < count; i++) {
+	out[i] = in[i] / 2147483648.0;
+      }
+    }
+
+    static void convert(const q31_t* in, float32_t* out, unsigned int count, unsigned int rshift) {
+      arm_q31_to_float(in, out, count);
+    }
+
+    static void convert(const q31_t* in, q31_t* out, unsigned int count, unsigned int rshift) {
+      for (unsigned int i = 0; i < count; i++) {
+	out[i] = in[i] >> rshift;
+      }
+    }
+
+    static void convert(const q31_t* in, q15_t* out, unsigned int count, unsigned int rshift) {
+      for (unsigned int i = 0; i < count; i++) {
+	out[i] = (q15_t)((in[i] >> 16) >> rshift);
+      }
+    }
+
+    template <typename T> unsigned int generate(Span<T> out, unsigned int rshift) {
+      const unsigned int count = std::min(out.size(), numSamples - n);
+      q31_t block[blockSize];
+      for (unsigned int i = 0; i < count; ) {
+	const unsigned int m = std::min(blockSize, count - i);
+	generate(block, m);
+	convert(block, out.data() + i, m, rshift);
+	i += m;
+	n += m;
+      }
+      return count;
+    }
+
+  protected:
+
+    // the sample counter
+    unsigned int getSampleCount() const {
+      return n;
+    }
+
+    // the waveform length, size() without the virtual call
+    unsigned int getNumSamples() const {
+      return numSamples;
+    }
+
+  public:
+
+    GeneratorSource(unsigned int numSamples)
+      : numSamples(numSamples)
+    {}
+
+    virtual ~GeneratorSource() {}
+
+    virtual unsigned int size() const {
+      return numSamples;
+    }
+
+    virtual bool isEnd() const {
+      return n == numSamples;
+    }
+
+    virtual void reset() {
+      n = 0;
+      restart();
+    }
+
+    virtual double next() {
+      if (isEnd()) {
+	throw Ex("end of generator");
+      }
+
+      q31_t s;
+      generate(&s, 1);
+      n++;
+      return s / 2147483648.0;
+    }
+
+    virtual unsigned int fill(Span<float64_t> out) {
+      return generate(out, 0);
+    }
+
+    virtual unsigned int fill(Span<float32_t> out) {
+      return generate(out, 0);
+    }
+
+    virtual unsigned int fill(Span<q31_t> out, unsigned int rshift) {
+      return generate(out, rshift);
+    }
+
+    virtual unsigned int fill(Span<q15_t> out, unsigned int rshift) {
+      return generate(out, rshift);
+    }
+  };
+
+  class MultitoneSource : public GeneratorSource {
+
+    struct Oscillator {
+      uint64_t increment;
+      int32_t gain;
+      uint64_t phase;
+    };
+
+    const int32_t* table = getQuarterWave().data();
+
+    std::vector<Oscillator> oscillators;
+
+    virtual void generate(q31_t* out, unsigned int count) {
+      int64_t sum[blockSize] = {};
+      for (Oscillator& oscillator: oscillators) {
+	for (unsigned int i = 0; i < count; i++) {
+	  sum[i] += scale(sine(table, oscillator.phase >> 32), oscillator.gain);
+	  oscillator.phase += oscillator.increment;
+	}
+      }
+      for (unsigned int i = 0; i < count; i++) {
+	out[i] = (q31_t)std::clamp<int64_t>(sum[i], INT32_MIN, INT32_MAX);
+      }
+    }
+
+    virtual void restart() {
+      for (Oscillator& oscillator: oscillators) {
+	oscillator.phase = 0;
+      }
+    }
+
+  public:
+
+    MultitoneSource(unsigned int numSamples, const std::vector<Tone>& tones)
+      : GeneratorSource(numSamples)
+    {
+      for (const Tone& tone: tones) {
+	oscillators.push_back({toIncrement(tone.frequency), toGain(tone.amplitude), 0});
+      }
+    }
+  };
+
+  class ChirpSource : public GeneratorSource {
+
+    const int32_t* table = getQuarterWave().data();
+
+    const double startFrequency;
+    const double endFrequency;
+    const ChirpSweep sweep;
+    const int32_t gain;
+
+    uint64_t phase = 0;
+    uint64_t increment = 0;
+    int64_t step = 0;
+
+    // The frequency at sample n (cycles per sample).
+    double getFrequency(unsigned int n) const {
+      const unsigned int numSamples = getNumSamples();
+      const double t = numSamples > 1 ? std::min(1.0, (double)n / (numSamples - 1)) : 0.0;
+      if (sweep == ChirpSweep::LOG) {
+	return startFrequency * std::pow(endFrequency / startFrequency, t);
+      }
+      return startFrequency + (endFrequency - startFrequency) * t;
+    }
+
+    // The increment steps linearly from the frequency at the start of
+    // each blockSize samples to the frequency at the end, exact for the
+    // linear sweep. The steps are computed at sample counts that are a
+    // multiple of blockSize, so next() and fill() produce the same
+    // samples.
+    virtual void generate(q31_t* out, unsigned int count) {
+      const unsigned int n = getSampleCount();
+      for (unsigned int i = 0; i < count; i++) {
+	if ((n + i) % blockSize == 0) {
+	  increment = toIncrement(getFrequency(n + i));
+	  step = ((int64_t)(toIncrement(getFrequency(n + i + blockSize)) - increment)) / (int64_t)blockSize;
+	}
+	out[i] = scale(sine(table, phase >> 32), gain);
+	phase += increment;
+	increment += step;
+      }
+    }
+
+    virtual void restart() {
+      phase = 0;
+    }
+
+  public:
+
+    ChirpSource(unsigned int numSamples, double startFrequency, double endFrequency, ChirpSweep sweep, double amplitude)
+      : GeneratorSource(numSamples),
+	startFrequency(startFrequency),
+	endFrequency(endFrequency),
+	sweep(sweep),
+	gain(toGain(amplitude))
+    {
+      toIncrement(startFrequency);
+      toIncrement(endFrequency);
+      if (sweep == ChirpSweep::LOG && (startFrequency == 0.0 || endFrequency == 0.0)) {
+	throw Ex("log chirp frequency error");
+      }
+    }
+  };
+
+  class ImpulseSource : public GeneratorSource {
+
+    const unsigned int period;
+    const int32_t value;
+
+    virtual void generate(q31_t* out, unsigned int count) {
+      const unsigned int n = getSampleCount();
+      for (unsigned int i = 0; i < count; i++) {
+	const unsigned int k = n + i;
+	out[i] = (period == 0 ? k == 0 : k % period == 0) ? value : 0;
+      }
+    }
+
+    virtual void restart() {}
+
+  public:
+
+    ImpulseSource(unsigned int numSamples, unsigned int period, double amplitude)
+      : GeneratorSource(numSamples),
+	period(period),
+	value(amplitude < 0.0 ? -toGain(amplitude) : toGain(amplitude))
+    {}
+  };
+
+  class NoiseSource : public GeneratorSource {
+
+    // Voss-McCartney rows
+    static const unsigned int numRows = 8;
+
+    const NoiseColor color;
+    const uint32_t seed;
+    const int32_t gain;
+
+    // the pink noise gain, amplitude / (numRows + 1), applied to the
+    // sum of rows shifted down by 4 bits
+    const int32_t pinkGain;
+
+    uint32_t state;
+
+    // pink noise rows, the q31 values shifted down by 4 bits so the
+    // sum of the rows and a white row can't overflow
+    int32_t rows[numRows];
+    int32_t sum;
+    uint32_t counter;
+
+    inline uint32_t xorshift() {
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      return state;
+    }
+
+    virtual void generate(q31_t* out, unsigned int count) {
+      if (color == NoiseColor::WHITE) {
+	for (unsigned int i = 0; i < count; i++) {
+	  out[i] = scale((int32_t)xorshift(), gain);
+	}
+	return;
+      }
+
+      // Update row ctz(counter), i.e. row r every 2^(r+1) samples, and
+      // add a white row. The sum of numRows + 1 rows is scaled down to
+      // the amplitude.
+      for (unsigned int i = 0; i < count; i++) {
+	const unsigned int row = __builtin_ctz(++counter);
+	if (row < numRows) {
+	  const int32_t value = (int32_t)xorshift() >> 4;
+	  sum += value - rows[row];
+	  rows[row] = value;
+	}
+	const int64_t s = (int64_t)sum + ((int32_t)xorshift() >> 4);
+	out[i] = (q31_t)std::clamp<int64_t>((s * pinkGain) >> 27, INT32_MIN, INT32_MAX);
+      }
+    }
+
+    virtual void restart() {
+      // xorshift32 state must be nonzero
+      state = seed == 0 ? 0x9e3779b9 : seed;
+      counter = 0;
+      sum = 0;
+      for (unsigned int r = 0; r < numRows; r++) {
+	rows[r] = (int32_t)xorshift() >> 4;
+	sum += rows[r];
+      }
+    }
+
+  public:
+
+    NoiseSource(unsigned int numSamples, NoiseColor color, double amplitude, uint32_t seed)
+      : GeneratorSource(numSamples),
+	color(color),
+	seed(seed),
+	gain(toGain(amplitude)),
+	pinkGain(toGain(amplitude / (numRows + 1)))
+    {
+      restart();
+    }
+  };
+
+} // namespace
+
+std::unique_ptr<Source> createMultitoneSource(unsigned int numSamples, const std::vector<Tone>& tones) {
+  return std::make_unique<MultitoneSource>(numSamples, tones);
+}
+
+std::unique_ptr<Source> createChirpSource(unsigned int numSamples, double startFrequency, double endFrequency, ChirpSweep sweep, double amplitude) {
+  return std::make_unique<ChirpSource>(numSamples, startFrequency, endFrequency, sweep, amplitude);
+}
+
+std::unique_ptr<Source> createImpulseSource(unsigned int numSamples, unsigned int period, double amplitude) {
+  return std::make_unique<ImpulseSource>(numSamples, period, amplitude);
+}
+
+std::unique_ptr<Source> createNoiseSource(unsigned int numSamples, NoiseColor color, double amplitude, uint32_t seed) {
+  return std::make_unique<NoiseSource>(numSamples, color, amplitude, seed);
+}
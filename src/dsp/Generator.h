@@ -0,0 +1,69 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_GENERATOR_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_GENERATOR_H_INCLUDED
+
+#include "Source.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+Integer synthetic signal generators, test waveforms and on device
+stimulus, with no per sample floating point.
+
+The samples are generated as q31 a block at a time and converted to
+the target type, so fill() of q31, q15 (the upper 16 bits, truncated)
+and f32 (arm_q31_to_float) costs integer operations only, apart from
+the f32 conversion itself. The rshift of the q31 and q15 fill() is
+an arithmetic shift in the same pass, the f32 and f64 fill() have no
+shift. next() returns the same samples one at a time.
+
+Tones and chirps are a numerically controlled oscillator (NCO): a
+phase accumulator of 2^64 per cycle, whose upper 32 bits index a 256
+entry quarter wave q31 sine table with linear interpolation (error
+below 5e-6 of full scale, about -106 dB). Frequencies are in cycles
+per sample, 0 to 0.5 (Nyquist).
+
+Noise is an xorshift32 generator, deterministically seeded. White
+noise is uniform, pink noise (-3 dB per octave) is the Voss-McCartney
+sum of 8 rows updated at octave spaced rates plus a white row.
+
+The output saturates at full scale, e.g. multitone amplitudes summing
+to more than 1.0. reset() restarts the waveform, including the noise
+seed.
+*/
+
+struct Tone {
+  // cycles per sample, 0 to 0.5
+  double frequency;
+
+  // peak amplitude, full scale 1.0
+  double amplitude;
+};
+
+enum class ChirpSweep { LINEAR = 0, LOG = 1 };
+
+enum class NoiseColor { WHITE = 0, PINK = 1 };
+
+// The sum of sine tones, each starting at phase 0. Throws Ex if a
+// frequency is not within [0, 0.5].
+std::unique_ptr<Source> createMultitoneSource(unsigned int numSamples, const std::vector<Tone>& tones);
+
+// A sine sweep from startFrequency to endFrequency at the last sample,
+// linear or logarithmic (exponential) in frequency. The log sweep is
+// linear within 64 sample blocks. Throws Ex if a frequency is not
+// within [0, 0.5], or is 0 for a log sweep.
+std::unique_ptr<Source> createChirpSource(unsigned int numSamples, double startFrequency, double endFrequency, ChirpSweep sweep, double amplitude);
+
+// Impulses of amplitude every period samples, starting at sample 0,
+// or a single impulse at sample 0 if the period is 0.
+std::unique_ptr<Source> createImpulseSource(unsigned int numSamples, unsigned int period, double amplitude);
+
+// White (uniform in [-amplitude, amplitude]) or pink noise with a peak
+// of at most amplitude, from the seed.
+std::unique_ptr<Source> createNoiseSource(unsigned int numSamples, NoiseColor color, double amplitude, uint32_t seed);
+
+#endif
@@ -0,0 +1,400 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "Goertzel.h"
+
+#include "FftPlan.h"
+#include "Instrument.h"
+#include "Ex.h"
+
+#include "Platform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <type_traits>
+
+namespace {
+
+  // The number of detect() calls averaged by the cost measurement, and
+  // the number of bins the Goertzel cost is measured over.
+  const unsigned int costRuns = 4;
+  const unsigned int costBins = 8;
+
+  unsigned int log2Length(unsigned int n) {
+    unsigned int bits = 0;
+    while ((1u << bits) < n) {
+      bits++;
+    }
+    return bits;
+  }
+
+  void cmplxMag(const float32_t* x, float32_t* out, unsigned int n) {
+    arm_cmplx_mag_f32(x, out, n);
+  }
+
+  void cmplxMag(const q31_t* x, q31_t* out, unsigned int n) {
+    arm_cmplx_mag_q31(x, out, n);
+  }
+
+  void cmplxMag(const q15_t* x, q15_t* out, unsigned int n) {
+    arm_cmplx_mag_q15(x, out, n);
+  }
+
+  template <typename T> class CmsisBinDetector : public BinDetector<T> {
+
+    CmsisBinDetector();
+
+  protected:
+
+    const std::string name;
+
+    const unsigned int length;
+
+    const std::vector<unsigned int> bins;
+
+    // the target bin spectrum values, packed complex pairs, the
+    // arm_cmplx_mag_* input
+    std::vector<T> spectrum;
+
+    void checkSize(const char* what, unsigned int actual, unsigned int expected) const {
+      if (actual != expected) {
+	throw Ex(name + " " + what + " span size error");
+      }
+    }
+
+  public:
+
+    CmsisBinDetector(const std::string& name, unsigned int length, const std::vector<unsigned int>& bins)
+      : name(name),
+	length(length),
+	bins(bins),
+	spectrum(2 * bins.size())
+    {
+      if (length < 32 || length > 4096 || (length & (length - 1)) != 0) {
+	throw Ex(this->name + " length not supported");
+      }
+      for (unsigned int bin: bins) {
+	if (bin >= length / 2) {
+	  throw Ex(this->name + " bin out of range");
+	}
+      }
+    }
+
+    virtual const std::string& getName() const {
+      return name;
+    }
+
+    virtual unsigned int getLength() const {
+      return length;
+    }
+
+    virtual const std::vector<unsigned int>& getBins() const {
+      return bins;
+    }
+
+    // see CmsisFft.cpp
+    virtual float getScale() const {
+      if (std::is_floating_point<T>::value) {
+	return 1.0;
+      }
+      return ::powf(2.0, 8.0*sizeof(T) - 2.0 - log2Length(length));
+    }
+  };
+
+  // The Goertzel recurrence of each bin, the floating point state is T.
+  class Float32GoertzelDetector : public CmsisBinDetector<float32_t> {
+
+    // 2*cos(w), cos(w) and sin(w) per bin
+    std::vector<float32_t> coef;
+    std::vector<float32_t> cosine;
+    std::vector<float32_t> sine;
+
+  public:
+
+    Float32GoertzelDetector(unsigned int length, const std::vector<unsigned int>& bins)
+      : CmsisBinDetector<float32_t>("f32_goertzel", length, bins)
+    {
+      for (unsigned int bin: bins) {
+	const double w = 2.0 * M_PI * bin / length;
+	coef.push_back(2.0 * std::cos(w));
+	cosine.push_back(std::cos(w));
+	sine.push_back(std::sin(w));
+      }
+    }
+
+    virtual void detect(Span<const float32_t> in, Span<float32_t> out) {
+      checkSize("input", in.size(), length);
+      checkSize("output", out.size(), bins.size());
+
+      for (unsigned int i = 0; i < bins.size(); i++) {
+	const float32_t c = coef[i];
+	float32_t s1 = 0.0f;
+	float32_t s2 = 0.0f;
+	for (unsigned int n = 0; n < length; n++) {
+	  const float32_t s0 = in[n] + c * s1 - s2;
+	  s2 = s1;
+	  s1 = s0;
+	}
+	spectrum[2*i] = s1 - cosine[i] * s2;
+	spectrum[2*i + 1] = sine[i] * s2;
+      }
+
+      cmplxMag(spectrum.data(), out.data(), bins.size());
+    }
+  };
+
+  // (s * c) >> shift, for a Q30 c and a 64 bit s, without a 128 bit
+  // product: s = hi*2^32 + lo, and the hi*c*2^32 term shifts exactly.
+  inline int64_t mulShift(int64_t s, int32_t c, unsigned int shift) {
+    const int64_t hi = s >> 32;
+    const int64_t lo = (int64_t)(uint32_t)s;
+    return hi * c * ((int64_t)1 << (32 - shift)) + ((lo * c) >> shift);
+  }
+
+  // The fixed point Goertzel recurrence of each bin. The input is
+  // integer q{15,31} values, the state is 64 bits, and the coefficient
+  // cos(w) is Q30 (2*cos(w)*s is a shift of 29). The spectrum is
+  // shifted down by log2(length), the fixed point rfft scaling, and the
+  // magnitude of that is arm_cmplx_mag_q{15,31}, which shifts down by
+  // one more bit, the same as the FFT class magnitude.
+  template <typename T> class FixedGoertzelDetector : public CmsisBinDetector<T> {
+
+    FixedGoertzelDetector();
+
+    // cos(w) and sin(w) per bin, Q30
+    std::vector<int32_t> cosine;
+    std::vector<int32_t> sine;
+
+    const unsigned int shift;
+
+    // Saturate to T, counting the clipped values (see Instrument.h).
+    static q31_t saturate(int64_t x, unsigned long& numClipped, q31_t) {
+      return instrument::clipQ63ToQ31(x, numClipped);
+    }
+
+    static q15_t saturate(int64_t x, unsigned long& numClipped, q15_t) {
+      return instrument::clipQ63ToQ15(x, numClipped);
+    }
+
+    static const char* narrowing(q31_t) {
+      return "q63_to_q31";
+    }
+
+    static const char* narrowing(q15_t) {
+      return "q63_to_q15";
+    }
+
+  public:
+
+    FixedGoertzelDetector(const std::string& name, unsigned int length, const std::vector<unsigned int>& bins)
+      : CmsisBinDetector<T>(name, length, bins),
+	shift(log2Length(length))
+    {
+      for (unsigned int bin: bins) {
+	const double w = 2.0 * M_PI * bin / length;
+	cosine.push_back(std::lround(std::cos(w) * 1073741824.0));
+	sine.push_back(std::lround(std::sin(w) * 1073741824.0));
+      }
+    }
+
+    virtual void detect(Span<const T> in, Span<T> out) {
+      this->checkSize("input", in.size(), this->length);
+      this->checkSize("output", out.size(), this->bins.size());
+
+      instrument::recordInput("goertzel", this->name, in.data(), this->length);
+
+      unsigned long numClipped = 0;
+      for (unsigned int i = 0; i < this->bins.size(); i++) {
+	const int32_t c = cosine[i];
+	int64_t s1 = 0;
+	int64_t s2 = 0;
+	for (unsigned int n = 0; n < this->length; n++) {
+	  const int64_t s0 = in[n] + mulShift(s1, c, 29) - s2;
+	  s2 = s1;
+	  s1 = s0;
+	}
+	this->spectrum[2*i] = saturate((s1 - mulShift(s2, c, 30)) >> shift, numClipped, T());
+	this->spectrum[2*i + 1] = saturate(mulShift(s2, sine[i], 30) >> shift, numClipped, T());
+      }
+      instrument::recordClipped(narrowing(T()), this->name, numClipped, this->spectrum.size());
+      instrument::recordOutput("goertzel", this->name, this->spectrum.data(), this->spectrum.size());
+
+      cmplxMag(this->spectrum.data(), out.data(), this->bins.size());
+    }
+  };
+
+  void rfft(FftPlan<float32_t>& plan, float32_t* in, float32_t* out) {
+    arm_rfft_fast_f32(&plan.getInstance(), in, out, plan.getIfftFlag());
+
+    // drop the Nyquist component packed in with the DC component
+    out[1] = 0.0f;
+  }
+
+  void rfft(FftPlan<q31_t>& plan, q31_t* in, q31_t* out) {
+    arm_rfft_q31(&plan.getInstance(), in, out);
+  }
+
+  void rfft(FftPlan<q15_t>& plan, q15_t* in, q15_t* out) {
+    arm_rfft_q15(&plan.getInstance(), in, out);
+  }
+
+  // The real fft of the block, and the magnitude of the target bins.
+  template <typename T> class FftDetector : public CmsisBinDetector<T> {
+
+    FftDetector();
+
+    // the cached forward fft plan (owned by the plan registry)
+    FftPlan<T>& plan;
+
+    // the fft input, a copy of the block (the fft modifies it)
+    std::vector<T> frame;
+
+    // the fft output
+    std::vector<T> fft;
+
+  public:
+
+    FftDetector(const std::string& name, unsigned int length, const std::vector<unsigned int>& bins, unsigned int fftOutputWidth)
+      : CmsisBinDetector<T>(name, length, bins),
+	plan(getFftPlan<T>(length, FftDirection::FORWARD)),
+	frame(length),
+	fft(length * fftOutputWidth)
+    {}
+
+    virtual void detect(Span<const T> in, Span<T> out) {
+      this->checkSize("input", in.size(), this->length);
+      this->checkSize("output", out.size(), this->bins.size());
+
+      std::copy(in.begin(), in.end(), frame.begin());
+      instrument::recordInput("goertzel", this->name, frame.data(), this->length);
+      rfft(plan, frame.data(), fft.data());
+      instrument::recordOutput("goertzel", this->name, fft.data(), fft.size());
+
+      for (unsigned int i = 0; i < this->bins.size(); i++) {
+	this->spectrum[2*i] = fft[2*this->bins[i]];
+	this->spectrum[2*i + 1] = fft[2*this->bins[i] + 1];
+      }
+
+      cmplxMag(this->spectrum.data(), out.data(), this->bins.size());
+    }
+  };
+
+  // Time costRuns detect() calls over a block of zeros (us per call).
+  template <typename T> float measure(BinDetector<T>& detector) {
+    std::vector<T> in(detector.getLength());
+    std::vector<T> out(detector.getBins().size());
+
+    platform::profiling_time_t start = platform::get_profiling_time();
+    for (unsigned int i = 0; i < costRuns; i++) {
+      detector.detect(in, out);
+    }
+    platform::profiling_time_t end = platform::get_profiling_time();
+
+    return (float)platform::profiling_time_diff(start, end) / costRuns;
+  }
+
+  template <typename T> using CostMap = std::map<unsigned int, BinDetectorCost>;
+
+  // One cost cache per data type, the map key is the length.
+  template <typename T> CostMap<T>& getCostCache() {
+    static CostMap<T> cache;
+    return cache;
+  }
+
+  template <typename T> using CreateDetector = std::unique_ptr<BinDetector<T>> (*)(unsigned int length, const std::vector<unsigned int>& bins);
+
+  template <typename T> BinDetectorCost measureCost(unsigned int length, CreateDetector<T> createGoertzel, CreateDetector<T> createFft) {
+    const std::vector<unsigned int> bins(costBins, 1);
+    BinDetectorCost cost;
+    cost.goertzelPerBin = measure(*createGoertzel(length, bins)) / costBins;
+    cost.fft = measure(*createFft(length, bins));
+    return cost;
+  }
+
+  template <typename T> BinDetectorCost measureCost(unsigned int length);
+
+  template <> BinDetectorCost measureCost<float32_t>(unsigned int length) {
+    return measureCost<float32_t>(length, createFloat32GoertzelDetector, createFloat32FftDetector);
+  }
+
+  template <> BinDetectorCost measureCost<q31_t>(unsigned int length) {
+    return measureCost<q31_t>(length, createQ31GoertzelDetector, createQ31FftDetector);
+  }
+
+  template <> BinDetectorCost measureCost<q15_t>(unsigned int length) {
+    return measureCost<q15_t>(length, createQ15GoertzelDetector, createQ15FftDetector);
+  }
+
+  template <typename T> bool preferGoertzel(unsigned int length, unsigned int numBins) {
+    const BinDetectorCost& cost = getBinDetectorCost<T>(length);
+    return numBins * cost.goertzelPerBin < cost.fft;
+  }
+
+} // namespace
+
+template <typename T> const BinDetectorCost& getBinDetectorCost(unsigned int length) {
+  CostMap<T>& cache = getCostCache<T>();
+
+  auto it = cache.find(length);
+  if (it == cache.end()) {
+    it = cache.emplace(length, measureCost<T>(length)).first;
+  }
+
+  return it->second;
+}
+
+void clearBinDetectorCostCache() {
+  getCostCache<float32_t>().clear();
+  getCostCache<q31_t>().clear();
+  getCostCache<q15_t>().clear();
+}
+
+std::unique_ptr<BinDetector<float32_t>> createFloat32GoertzelDetector(unsigned int length, const std::vector<unsigned int>& bins) {
+  return std::unique_ptr<BinDetector<float32_t>>(new Float32GoertzelDetector(length, bins));
+}
+
+std::unique_ptr<BinDetector<q31_t>> createQ31GoertzelDetector(unsigned int length, const std::vector<unsigned int>& bins) {
+  return std::unique_ptr<BinDetector<q31_t>>(new FixedGoertzelDetector<q31_t>("q31_goertzel", length, bins));
+}
+
+std::unique_ptr<BinDetector<q15_t>> createQ15GoertzelDetector(unsigned int length, const std::vector<unsigned int>& bins) {
+  return std::unique_ptr<BinDetector<q15_t>>(new FixedGoertzelDetector<q15_t>("q15_goertzel", length, bins));
+}
+
+std::unique_ptr<BinDetector<float32_t>> createFloat32FftDetector(unsigned int length, const std::vector<unsigned int>& bins) {
+  return std::unique_ptr<BinDetector<float32_t>>(new FftDetector<float32_t>("f32_fftbins", length, bins, 1));
+}
+
+std::unique_ptr<BinDetector<q31_t>> createQ31FftDetector(unsigned int length, const std::vector<unsigned int>& bins) {
+  return std::unique_ptr<BinDetector<q31_t>>(new FftDetector<q31_t>("q31_fftbins", length, bins, 2));
+}
+
+std::unique_ptr<BinDetector<q15_t>> createQ15FftDetector(unsigned int length, const std::vector<unsigned int>& bins) {
+  return std::unique_ptr<BinDetector<q15_t>>(new FftDetector<q15_t>("q15_fftbins", length, bins, 2));
+}
+
+std::unique_ptr<BinDetector<float32_t>> createFloat32BinDetector(unsigned int length, const std::vector<unsigned int>& bins) {
+  if (preferGoertzel<float32_t>(length, bins.size())) {
+    return createFloat32GoertzelDetector(length, bins);
+  }
+  return createFloat32FftDetector(length, bins);
+}
+
+std::unique_ptr<BinDetector<q31_t>> createQ31BinDetector(unsigned int length, const std::vector<unsigned int>& bins) {
+  if (preferGoertzel<q31_t>(length, bins.size())) {
+    return createQ31GoertzelDetector(length, bins);
+  }
+  return createQ31FftDetector(length, bins);
+}
+
+std::unique_ptr<BinDetector<q15_t>> createQ15BinDetector(unsigned int length, const std::vector<unsigned int>& bins) {
+  if (preferGoertzel<q15_t>(length, bins.size())) {
+    return createQ15GoertzelDetector(length, bins);
+  }
+  return createQ15FftDetector(length, bins);
+}
+
+template const BinDetectorCost& getBinDetectorCost<float32_t>(unsigned int length);
+template const BinDetectorCost& getBinDetectorCost<q31_t>(unsigned int length);
+template const BinDetectorCost& getBinDetectorCost<q15_t>(unsigned int length);
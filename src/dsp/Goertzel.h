@@ -0,0 +1,95 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_GOERTZEL_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_GOERTZEL_H_INCLUDED
+
+#include "Span.h"
+
+#include "arm_math.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+Sparse bin spectral detector, the magnitude of a few fft bins of a
+block of samples, e.g. known tone frequencies.
+
+The Goertzel detector runs the Goertzel recurrence once per target
+bin, one multiply per sample per bin:
+
+s[n] = x[n] + 2*cos(w)*s[n-1] - s[n-2], w = 2*pi*bin/length
+
+and |X[bin]| = |s[N-1] - exp(-j*w)*s[N-2]|. The fixed point state is
+64 bits wide with a Q30 coefficient, so it can't overflow for any
+supported length. The fft detector transforms the whole block with the
+cached real fft plan (see FftPlan.h) and takes the magnitude of the
+target bins only. Goertzel costs length multiplies per bin, the fft
+costs the same for every bin count, so Goertzel wins for few bins.
+
+The magnitudes have the same scaling as the FFT class magnitudes: the
+normalized magnitude is the output value divided by getScale(), and
+matches FFT::getNormalizedMagnitude() at the same bin.
+*/
+template <typename T> class BinDetector {
+ public:
+
+  virtual ~BinDetector() {}
+
+  // the name of the detector implementation
+  virtual const std::string& getName() const = 0;
+
+  // the block length
+  virtual unsigned int getLength() const = 0;
+
+  // the target bins
+  virtual const std::vector<unsigned int>& getBins() const = 0;
+
+  // The normalized magnitude is an output value divided by the scale,
+  // 1.0 for floating point, 2^(8*sizeof(T) - 2 - log2(length)) for
+  // fixed point (see CmsisFft.cpp).
+  virtual float getScale() const = 0;
+
+  // Compute the magnitude of each target bin over the getLength()
+  // samples of in into out (getBins().size() values). The input is not
+  // modified. Does no heap allocation, throws Ex if a span has the
+  // wrong size.
+  virtual void detect(Span<const T> in, Span<T> out) = 0;
+};
+
+// The measured cost of the two detectors for one data type and length,
+// in us.
+struct BinDetectorCost {
+  // Goertzel cost per target bin
+  float goertzelPerBin = 0.0;
+
+  // fft cost, independent of the bin count
+  float fft = 0.0;
+};
+
+// Create detectors. The length must be a power of two from 32 to 4096
+// (the arm_rfft_fast_f32 lengths) and the bins less than length/2.
+// Throws Ex if not.
+std::unique_ptr<BinDetector<float32_t>> createFloat32GoertzelDetector(unsigned int length, const std::vector<unsigned int>& bins);
+std::unique_ptr<BinDetector<q31_t>> createQ31GoertzelDetector(unsigned int length, const std::vector<unsigned int>& bins);
+std::unique_ptr<BinDetector<q15_t>> createQ15GoertzelDetector(unsigned int length, const std::vector<unsigned int>& bins);
+
+std::unique_ptr<BinDetector<float32_t>> createFloat32FftDetector(unsigned int length, const std::vector<unsigned int>& bins);
+std::unique_ptr<BinDetector<q31_t>> createQ31FftDetector(unsigned int length, const std::vector<unsigned int>& bins);
+std::unique_ptr<BinDetector<q15_t>> createQ15FftDetector(unsigned int length, const std::vector<unsigned int>& bins);
+
+// Create the cheaper of the two detectors for the bin count and
+// length, Goertzel if bins.size() * goertzelPerBin < fft.
+std::unique_ptr<BinDetector<float32_t>> createFloat32BinDetector(unsigned int length, const std::vector<unsigned int>& bins);
+std::unique_ptr<BinDetector<q31_t>> createQ31BinDetector(unsigned int length, const std::vector<unsigned int>& bins);
+std::unique_ptr<BinDetector<q15_t>> createQ15BinDetector(unsigned int length, const std::vector<unsigned int>& bins);
+
+// Get the detector costs for (T, length). They are measured on first
+// use, timing both detectors over a block of zeros, and cached.
+template <typename T> const BinDetectorCost& getBinDetectorCost(unsigned int length);
+
+// Release the cached costs.
+void clearBinDetectorCostCache();
+
+#endif
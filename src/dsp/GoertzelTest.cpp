@@ -0,0 +1,61 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "GoertzelTest.h"
+
+#include "Goertzel.h"
+#include "Ex.h"
+
+#include "Platform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+
+namespace {
+
+  template <typename T> BinDetectorTestResult executeTest(BinDetector<T>& detector, const std::vector<T>& waveform, const std::vector<float>& reference, float tolerance) {
+    const std::vector<unsigned int>& bins = detector.getBins();
+    std::vector<T> out(bins.size());
+
+    platform::profiling_time_t start = platform::get_profiling_time();
+    detector.detect(waveform, out);
+    platform::profiling_time_t end = platform::get_profiling_time();
+    unsigned long elapsedTime = profiling_time_diff(start,end);
+
+    float peak = 0.0;
+    for (float mag: reference) {
+      peak = std::max(peak, std::fabs(mag));
+    }
+    if ( !(peak > 0.0) ) {
+      throw Fail("bin detector reference sanity");
+    }
+
+    for (unsigned int i = 0; i < bins.size(); i++) {
+      float expected = reference.at(bins[i]);
+      float actual = out[i] / detector.getScale();
+      float error = 100.0 * std::fabs(actual - expected) / peak;
+      if ( error > tolerance ) {
+	printf("FAIL %s bin %d error=%.9g%% (%f vs %f)\n", detector.getName().c_str(), bins[i], error, actual, expected);
+	throw Fail("bin detector magnitude error");
+      }
+    }
+
+    printf("%s length %d, %d bins %lu us\n", detector.getName().c_str(), detector.getLength(), (int)bins.size(), elapsedTime);
+
+    return BinDetectorTestResult(detector.getName(), elapsedTime);
+  }
+
+} // namespace
+
+BinDetectorTestResult executeBinDetectorTest(BinDetector<float32_t>& detector, const std::vector<float32_t>& waveform, const std::vector<float>& reference, float tolerance) {
+  return executeTest(detector, waveform, reference, tolerance);
+}
+
+BinDetectorTestResult executeBinDetectorTest(BinDetector<q31_t>& detector, const std::vector<q31_t>& waveform, const std::vector<float>& reference, float tolerance) {
+  return executeTest(detector, waveform, reference, tolerance);
+}
+
+BinDetectorTestResult executeBinDetectorTest(BinDetector<q15_t>& detector, const std::vector<q15_t>& waveform, const std::vector<float>& reference, float tolerance) {
+  return executeTest(detector, waveform, reference, tolerance);
+}
@@ -0,0 +1,35 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_GOERTZELTEST_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_GOERTZELTEST_H_INCLUDED
+
+#include "arm_math.h"
+
+#include <string>
+#include <vector>
+
+template <typename T> class BinDetector;
+
+struct BinDetectorTestResult {
+  const std::string name;
+
+  // detect() execution time (us)
+  const unsigned long elapsedTime;
+
+  BinDetectorTestResult(const std::string& name, unsigned long elapsedTime)
+    :name(name),
+     elapsedTime(elapsedTime)
+  {}
+};
+
+// Profile the detector over the waveform, then verify the normalized
+// magnitude of every bin against the reference, the normalized fft
+// magnitude (FFT::getNormalizedMagnitude()) of the same waveform. The
+// tolerance is a percentage of the peak reference magnitude. Throws
+// Fail if a bin is out of tolerance.
+BinDetectorTestResult executeBinDetectorTest(BinDetector<float32_t>& detector, const std::vector<float32_t>& waveform, const std::vector<float>& reference, float tolerance);
+BinDetectorTestResult executeBinDetectorTest(BinDetector<q31_t>& detector, const std::vector<q31_t>& waveform, const std::vector<float>& reference, float tolerance);
+BinDetectorTestResult executeBinDetectorTest(BinDetector<q15_t>& detector, const std::vector<q15_t>& waveform, const std::vector<float>& reference, float tolerance);
+
+#endif
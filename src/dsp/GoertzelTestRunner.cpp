@@ -0,0 +1,94 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "GoertzelTestRunner.h"
+
+#include "GoertzelTest.h"
+#include "Goertzel.h"
+#include "FftTest.h"
+#include "CmsisFft.h"
+#include "CmsisTypeFactory.h"
+#include "Signal.h"
+
+#include <vector>
+
+using namespace goertzel;
+
+namespace {
+
+  class GoertzelTestRunner {
+
+    const std::vector<unsigned int> lengths = {256, 1024, 4096};
+
+    const std::vector<unsigned int> binCounts = {1, 2, 4, 8, 16, 32, 64};
+
+    // The tolerance against the fft magnitude, % of the peak. The
+    // fixed point fft rounds at every stage, the Goertzel state is 64
+    // bits, the difference is mostly fft rounding noise.
+    const float float32Tolerance = 0.01;
+    const float q31Tolerance = 0.01;
+    const float q15Tolerance = 1.0;
+
+    std::unique_ptr<Results> results = std::make_unique<Results>();
+
+    // Target bins spread over the band, starting at the signal tone
+    // (length/4).
+    static std::vector<unsigned int> getBins(unsigned int length, unsigned int numBins) {
+      std::vector<unsigned int> bins;
+      for (unsigned int i = 0; i < numBins; i++) {
+	bins.push_back((length / 4 + 7 * i) % (length / 2));
+      }
+      return bins;
+    }
+
+    template <typename T> using CreateFft = std::unique_ptr<FFT> (*)(std::unique_ptr<std::vector<T>> waveform, FftOutput output);
+
+    template <typename T> using CreateDetector = std::unique_ptr<BinDetector<T>> (*)(unsigned int length, const std::vector<unsigned int>& bins);
+
+    void addResult(unsigned int length, unsigned int numBins, const BinDetectorTestResult& result) {
+      results->elapsedTime[result.name][length][numBins] = result.elapsedTime;
+    }
+
+    // Time and verify the Goertzel and fft detectors for every bin
+    // count, and record the detector the selector picks.
+    template <typename T> void run(const char* type, const std::vector<T>& waveform, float tolerance, CreateFft<T> createFft, CreateDetector<T> createGoertzel, CreateDetector<T> createFftDetector, CreateDetector<T> createSelected) {
+      const unsigned int length = waveform.size();
+      auto reference = computeFftMagnitude(createFft(std::make_unique<std::vector<T>>(waveform), FftOutput::MAGNITUDE));
+
+      const BinDetectorCost& cost = getBinDetectorCost<T>(length);
+      printf("%s length %d cost: goertzel %.2f us per bin, fft %.2f us\n", type, length, cost.goertzelPerBin, cost.fft);
+
+      for (unsigned int numBins: binCounts) {
+	std::vector<unsigned int> bins = getBins(length, numBins);
+	addResult(length, numBins, executeBinDetectorTest(*createGoertzel(length, bins), waveform, *reference, tolerance));
+	addResult(length, numBins, executeBinDetectorTest(*createFftDetector(length, bins), waveform, *reference, tolerance));
+	results->selected[type][length][numBins] = createSelected(length, bins)->getName();
+      }
+    }
+
+    void run(unsigned int length) {
+      printf("\nbin detector length %d\n", length);
+
+      CmsisTypeFactory waveform(std::make_unique<Signal>(length, true));
+
+      run<float32_t>("f32", *waveform.toFloat32(), float32Tolerance, createFloat32Fft, createFloat32GoertzelDetector, createFloat32FftDetector, createFloat32BinDetector);
+      run<q31_t>("q31", *waveform.toQ31(), q31Tolerance, createQ31Fft, createQ31GoertzelDetector, createQ31FftDetector, createQ31BinDetector);
+      run<q15_t>("q15", *waveform.toQ15(), q15Tolerance, createQ15Fft, createQ15GoertzelDetector, createQ15FftDetector, createQ15BinDetector);
+    }
+
+  public:
+
+    std::unique_ptr<Results> runAll() {
+      for (unsigned int length: lengths) {
+	run(length);
+      }
+
+      return std::move(results);
+    }
+  };
+
+} // namespace
+
+std::unique_ptr<Results> runAllGoertzelTests() {
+  return GoertzelTestRunner().runAll();
+}
@@ -0,0 +1,41 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_GOERTZELTESTRUNNER_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_GOERTZELTESTRUNNER_H_INCLUDED
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace goertzel {
+  // map bin count to elapsed time in us
+  typedef std::map<unsigned int, unsigned long> BinsToElapsedTimeMap;
+
+  // map length to bin count/time map
+  typedef std::map<unsigned int, BinsToElapsedTimeMap> LengthToBinsElapsedTimeMap;
+
+  // map detector name to length/bin count/time map
+  typedef std::map<std::string, LengthToBinsElapsedTimeMap> NameToLengthBinsElapsedTimeMap;
+
+  // map bin count to the selected detector name
+  typedef std::map<unsigned int, std::string> BinsToNameMap;
+
+  // map length to bin count/name map
+  typedef std::map<unsigned int, BinsToNameMap> LengthToBinsNameMap;
+
+  // map data type name to length/bin count/name map
+  typedef std::map<std::string, LengthToBinsNameMap> TypeToLengthBinsNameMap;
+
+  struct Results {
+    // Goertzel and fft detector execution time
+    NameToLengthBinsElapsedTimeMap elapsedTime;
+
+    // the detector selected by create*BinDetector()
+    TypeToLengthBinsNameMap selected;
+  };
+}
+
+std::unique_ptr<goertzel::Results> runAllGoertzelTests();
+
+#endif
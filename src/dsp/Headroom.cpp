@@ -0,0 +1,68 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "Headroom.h"
+
+#include "Ex.h"
+
+#include <cmath>
+
+namespace {
+
+  // the largest filter output, full scale less a q15 LSB
+  const double maxOutputPeak = 1.0 - 1.0/32768.0;
+
+  // the largest shift, no q15 bits left
+  const unsigned int maxRShift = 15;
+
+  template <typename T> double l1Norm(const std::vector<T>& fir, double fullScale) {
+    double sum = 0.0;
+    for (T b: fir) {
+      sum += std::fabs((double)b);
+    }
+    return sum / fullScale;
+  }
+
+} // namespace
+
+double Headroom::getOutputPeak() const {
+  return std::ldexp(l1Norm * inputPeak, -(int)rshift);
+}
+
+double Headroom::getGain() const {
+  return std::ldexp(1.0, rshift);
+}
+
+double getL1Norm(const std::vector<float64_t>& fir) {
+  return l1Norm(fir, 1.0);
+}
+
+double getL1Norm(const std::vector<q31_t>& fir) {
+  return l1Norm(fir, 2147483648.0);
+}
+
+double getL1Norm(const std::vector<q15_t>& fir) {
+  return l1Norm(fir, 32768.0);
+}
+
+Headroom computeHeadroom(double l1Norm, double inputPeak) {
+  if (!(inputPeak >= 0.0) || !(l1Norm >= 0.0)) {
+    throw Ex("headroom peak error");
+  }
+
+  Headroom headroom = {l1Norm, inputPeak, 0};
+  while (headroom.getOutputPeak() > maxOutputPeak) {
+    if (++headroom.rshift > maxRShift) {
+      throw Ex("headroom shift error");
+    }
+  }
+  return headroom;
+}
+
+void compensate(Span<q31_t> out, const Headroom& headroom) {
+  arm_shift_q31(out.data(), (int8_t)headroom.rshift, out.data(), out.size());
+}
+
+void compensate(Span<q15_t> out, const Headroom& headroom) {
+  arm_shift_q15(out.data(), (int8_t)headroom.rshift, out.data(), out.size());
+}
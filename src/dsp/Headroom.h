@@ -0,0 +1,71 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_HEADROOM_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_HEADROOM_H_INCLUDED
+
+#include "Span.h"
+
+#include "arm_math.h"
+
+#include <vector>
+
+/**
+Input scaling for fixed point FIR filters from the filter's actual
+gain rather than its length.
+
+The arm_fir_decimate_* documentation asks for the input to be scaled
+down by log2(numTaps) bits, the bound for a filter of numTaps
+coefficients of magnitude up to 1. The largest output of a filter, and
+the largest partial sum of its accumulator, for an input of peak |x|
+is l1Norm * peak, where l1Norm = sum |b[k]|. A normalized low pass
+filter has an l1Norm not much larger than 1, so a full scale input
+needs 1 bit of scaling rather than the 5 bits of a 31 tap filter.
+
+The shift is the smallest right shift s for which l1Norm * peak * 2^-s
+stays below full scale, less a q15 LSB margin for the coefficient
+quantization. This bounds the output of arm_fir_decimate_fast_q15
+(saturated to q15) and arm_fir_decimate_fast_q31 (a 2.30 accumulator
+shifted up to 1.31 without saturation) as well as the non fast
+functions. It also bounds the folded and half-band streams
+(CmsisDecimate.h), which add the two samples of a symmetric tap pair
+before the multiply. Their pair sums are formed wider than the
+samples, so an input of peak |x| up to full scale doesn't overflow
+the pre-add, only the l1Norm * peak bound of the output applies.
+
+The filter output keeps the input scaling, compensate() shifts it
+back up by rshift bits (the output gain) with saturation.
+*/
+struct Headroom {
+  // filter coefficient l1 norm, sum |b[k]|
+  double l1Norm;
+
+  // input peak, observed or declared, full scale 1.0
+  double inputPeak;
+
+  // input right shift
+  unsigned int rshift;
+
+  // the output bound, l1Norm * inputPeak * 2^-rshift
+  double getOutputPeak() const;
+
+  // the compensating output gain, 2^rshift
+  double getGain() const;
+};
+
+// The filter coefficient l1 norm, sum |b[k]|, full scale 1.0.
+double getL1Norm(const std::vector<float64_t>& fir);
+double getL1Norm(const std::vector<q31_t>& fir);
+double getL1Norm(const std::vector<q15_t>& fir);
+
+// The minimal input right shift for a filter with the l1 norm and an
+// input peak (full scale 1.0). Throws Ex if the peak is negative or
+// the shift would exceed 15 bits.
+Headroom computeHeadroom(double l1Norm, double inputPeak);
+
+// Shift filter output up by the headroom right shift, in place, with
+// saturation.
+void compensate(Span<q31_t> out, const Headroom& headroom);
+void compensate(Span<q15_t> out, const Headroom& headroom);
+
+#endif
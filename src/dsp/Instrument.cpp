@@ -0,0 +1,106 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "Instrument.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+
+  instrument::Results results;
+
+#if SANDBOX_INSTRUMENT
+
+  double fullScale(q31_t) {
+    return 2147483648.0;
+  }
+
+  double fullScale(q15_t) {
+    return 32768.0;
+  }
+
+  // The peak |x|, full scale 1.0.
+  template <typename T> double peak(const T* x, unsigned int n) {
+    int64_t peak = 0;
+    for (unsigned int i = 0; i < n; i++) {
+      peak = std::max(peak, std::abs((int64_t)x[i]));
+    }
+    return peak / fullScale(T());
+  }
+
+  // The number of samples at the rail, the largest or smallest value.
+  template <typename T> unsigned long rail(const T* x, unsigned int n) {
+    unsigned long count = 0;
+    for (unsigned int i = 0; i < n; i++) {
+      if (x[i] == std::numeric_limits<T>::max() || x[i] == std::numeric_limits<T>::min()) {
+	count++;
+      }
+    }
+    return count;
+  }
+
+  instrument::KernelPeaks& getPeaks(const char* kind, const std::string& name) {
+    return results.kernels[std::string(kind) + " " + name];
+  }
+
+  template <typename T> void recordIn(const char* kind, const std::string& name, const T* in, unsigned int n) {
+    instrument::KernelPeaks& peaks = getPeaks(kind, name);
+    peaks.numCalls++;
+    peaks.inputPeak = std::max(peaks.inputPeak, peak(in, n));
+  }
+
+  template <typename T> void recordOut(const char* kind, const std::string& name, const T* out, unsigned int n) {
+    instrument::KernelPeaks& peaks = getPeaks(kind, name);
+    peaks.outputPeak = std::max(peaks.outputPeak, peak(out, n));
+    peaks.outputRail += rail(out, n);
+  }
+
+#endif
+
+} // namespace
+
+const instrument::Results& instrument::getResults() {
+  return results;
+}
+
+void instrument::reset() {
+  results = Results();
+}
+
+#if SANDBOX_INSTRUMENT
+
+void instrument::recordInput(const char* kind, const std::string& name, const q31_t* in, unsigned int n) {
+  recordIn(kind, name, in, n);
+}
+
+void instrument::recordInput(const char* kind, const std::string& name, const q15_t* in, unsigned int n) {
+  recordIn(kind, name, in, n);
+}
+
+void instrument::recordOutput(const char* kind, const std::string& name, const q31_t* out, unsigned int n) {
+  recordOut(kind, name, out, n);
+}
+
+void instrument::recordOutput(const char* kind, const std::string& name, const q15_t* out, unsigned int n) {
+  recordOut(kind, name, out, n);
+}
+
+void instrument::recordClipped(const char* conversion, const float32_t* in, unsigned int n) {
+  ConversionClips& clips = results.conversions[conversion];
+  clips.numSamples += n;
+  for (unsigned int i = 0; i < n; i++) {
+    if (!(in[i] >= -1.0f && in[i] < 1.0f)) {
+      clips.numClipped++;
+    }
+  }
+}
+
+void instrument::recordClipped(const char* conversion, const std::string& name, unsigned long numClipped, unsigned int n) {
+  ConversionClips& clips = results.conversions[std::string(conversion) + " " + name];
+  clips.numSamples += n;
+  clips.numClipped += numClipped;
+}
+
+#endif
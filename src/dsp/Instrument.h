@@ -0,0 +1,140 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_INSTRUMENT_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_INSTRUMENT_H_INCLUDED
+
+#include "arm_math.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+
+/**
+Opt-in fixed point overflow instrumentation, enabled by building with
+SANDBOX_INSTRUMENT=1 (the cmake SANDBOX_INSTRUMENT option).
+
+The fixed point kernels, each fft, decimation (arm, folded, half-band
+and CIC), resampling and fast FIR stream, and the fixed point STFT,
+Welch and Goertzel stages, record the peak |x| of their input and
+output and the number of output samples at the q15 or q31 rail
+(saturated, or an overflow that happened to land there). The float
+to fixed point conversions count the samples they clip, and so do the
+kernels that narrow a q63 accumulator themselves (the q31 folded and
+half-band decimators and polyphase resampler, and the Goertzel
+detector) with clipQ63ToQ31() or clipQ63ToQ15(). The report
+gives each kernel's headroom in bits, i.e. how much larger its input
+could be before its output reaches full scale, which a failed
+Parseval or frequency check doesn't.
+
+The arm_* functions narrow their accumulators internally, and the fast
+q31 variants keep a 32 bit accumulator, an overflow there wraps
+uncounted and only shows in the output peak and rail count. The Welch
+q63 power accumulators aren't narrowed, they're converted to double.
+
+When disabled the record functions are empty inline functions, and
+the call sites pass only pointers, counts and name members (not a
+virtual getName() call), so the instrumentation compiles to nothing.
+The floating point overloads are always empty, they let a kernel template
+record its input and output whatever its sample type.
+*/
+
+#ifndef SANDBOX_INSTRUMENT
+#define SANDBOX_INSTRUMENT 0
+#endif
+
+namespace instrument {
+
+  constexpr bool enabled = SANDBOX_INSTRUMENT != 0;
+
+  struct KernelPeaks {
+    unsigned long numCalls = 0;
+
+    // the peak |x|, full scale 1.0
+    double inputPeak = 0.0;
+    double outputPeak = 0.0;
+
+    // output samples at the q15/q31 rail
+    unsigned long outputRail = 0;
+  };
+
+  struct ConversionClips {
+    unsigned long numSamples = 0;
+
+    // samples outside [-1.0, 1.0), saturated
+    unsigned long numClipped = 0;
+  };
+
+  struct Results {
+    // map kernel name, e.g. "decimate q15_fast", to peaks
+    std::map<std::string, KernelPeaks> kernels;
+
+    // map conversion name, e.g. "f32_to_q15" or "q63_to_q31
+    // q31_folded", to clip count
+    std::map<std::string, ConversionClips> conversions;
+  };
+
+  // The instrumentation results, empty if disabled.
+  const Results& getResults();
+
+  // Clear the instrumentation results.
+  void reset();
+
+#if SANDBOX_INSTRUMENT
+
+  // Record the input peak of one call of a fixed point kernel, before
+  // the call (some kernels modify their input), and the output peak
+  // after the call. kind is the kernel kind, e.g. "rfft", and name the
+  // kernel's name.
+  void recordInput(const char* kind, const std::string& name, const q31_t* in, unsigned int n);
+  void recordInput(const char* kind, const std::string& name, const q15_t* in, unsigned int n);
+  void recordOutput(const char* kind, const std::string& name, const q31_t* out, unsigned int n);
+  void recordOutput(const char* kind, const std::string& name, const q15_t* out, unsigned int n);
+
+  // Count the float32_t samples clipped by a fixed point conversion.
+  void recordClipped(const char* conversion, const float32_t* in, unsigned int n);
+
+  // Record numClipped of n accumulator values clipped by a kernel
+  // narrowing them, e.g. "q63_to_q31", and name the kernel's name.
+  void recordClipped(const char* conversion, const std::string& name, unsigned long numClipped, unsigned int n);
+
+#else
+
+  inline void recordInput(const char* kind, const std::string& name, const q31_t* in, unsigned int n) {}
+  inline void recordInput(const char* kind, const std::string& name, const q15_t* in, unsigned int n) {}
+  inline void recordOutput(const char* kind, const std::string& name, const q31_t* out, unsigned int n) {}
+  inline void recordOutput(const char* kind, const std::string& name, const q15_t* out, unsigned int n) {}
+
+  inline void recordClipped(const char* conversion, const float32_t* in, unsigned int n) {}
+  inline void recordClipped(const char* conversion, const std::string& name, unsigned long numClipped, unsigned int n) {}
+
+#endif
+
+  // Saturate a q63_t accumulator to q31_t (clip_q63_to_q31()) or
+  // q15_t, and count it in numClipped if it clipped. When disabled
+  // only the saturation is left.
+  inline q31_t clipQ63ToQ31(q63_t x, unsigned long& numClipped) {
+    const q31_t y = clip_q63_to_q31(x);
+    if (enabled && y != x) {
+      numClipped++;
+    }
+    return y;
+  }
+
+  inline q15_t clipQ63ToQ15(q63_t x, unsigned long& numClipped) {
+    const q15_t y = (q15_t)std::clamp<q63_t>(x, INT16_MIN, INT16_MAX);
+    if (enabled && y != x) {
+      numClipped++;
+    }
+    return y;
+  }
+
+  // Floating point kernels aren't instrumented.
+  inline void recordInput(const char* kind, const std::string& name, const float32_t* in, unsigned int n) {}
+  inline void recordInput(const char* kind, const std::string& name, const float64_t* in, unsigned int n) {}
+  inline void recordOutput(const char* kind, const std::string& name, const float32_t* out, unsigned int n) {}
+  inline void recordOutput(const char* kind, const std::string& name, const float64_t* out, unsigned int n) {}
+
+}
+
+#endif
@@ -3,10 +3,13 @@
 
 #include "Report.h"
 
+#include <cmath>
+#include <map>
 #include <set>
+#include <string>
 
-// Table of fft execution times.
-void reportFftResults(const fft::NameToElapsedTimeMap& fftResultMap) {
+// Table of fft times (or bytes) by name and fft size.
+static void reportFftTimes(const char* title, const fft::NameToElapsedTimeMap& fftResultMap) {
   std::set<unsigned int> sizes;
 
   for (auto const& [name, sizeMap] : fftResultMap) {
@@ -15,55 +18,719 @@ void reportFftResults(const fft::NameToElapsedTimeMap& fftResultMap) {
     }
   }
 
-  printf("\nfft execution time (us)\n\n");
-  printf("%10s", "");
+  printf("\n%s\n\n", title);
+  printf("%18s", "");
   for (auto size: sizes) {
     printf("%7d", size);
   }
   printf("\n");
   
   for (auto const& [name, sizeMap] : fftResultMap) {
-    printf("%10s", name.c_str());
+    printf("%18s", name.c_str());
     for (auto const& [size, elapsedTime] : sizeMap) {
-      printf("%7d", elapsedTime);
+      printf("%7lu", elapsedTime);
     }
-    printf("\n", name.c_str());
+    printf("\n");
   }
 }
 
-// Table of decimation execution times.
-void reportDecimateResults(const decimate::NameToFactorElapsedTimeMap& decimateResultMap) {
+// Table of fft errors (%) by name and fft size.
+static void reportFftErrors(const char* title, const fft::NameToErrorMap& fftErrorMap) {
+  std::set<unsigned int> sizes;
+
+  for (auto const& [name, sizeMap] : fftErrorMap) {
+    for (auto const& [size, error] : sizeMap) {
+      sizes.insert(size);
+    }
+  }
+
+  printf("\n%s\n\n", title);
+  printf("%18s", "");
+  for (auto size: sizes) {
+    printf("%7d", size);
+  }
+  printf("\n");
 
+  for (auto const& [name, sizeMap] : fftErrorMap) {
+    printf("%18s", name.c_str());
+    for (auto const& [size, error] : sizeMap) {
+      printf("%7.3f", error);
+    }
+    printf("\n");
+  }
+}
+
+// Table of fft magnitude snr by size.
+static void reportFftSnr(const char* title, const fft::NameToSnrMap& fftSnrMap) {
   std::set<unsigned int> sizes;
-  std::set<unsigned int> factors;
 
-  // gather sizes and decimation factors
+  for (auto const& [name, sizeMap] : fftSnrMap) {
+    for (auto const& [size, snr] : sizeMap) {
+      sizes.insert(size);
+    }
+  }
+
+  printf("\n%s\n\n", title);
+  printf("%18s", "");
+  for (auto size: sizes) {
+    printf("%7d", size);
+  }
+  printf("\n");
+
+  for (auto const& [name, sizeMap] : fftSnrMap) {
+    printf("%18s", name.c_str());
+    for (auto size: sizes) {
+      auto snr = sizeMap.find(size);
+      if (snr == sizeMap.end()) {
+	printf("%7s", "");
+      }
+      else {
+	printf("%7.1f", snr->second);
+      }
+    }
+    printf("\n");
+  }
+}
+
+// Table of batched fft execution time per frame, by fft size and batch
+// size.
+static void reportFftBatchTimes(const fft::NameToBatchElapsedTimeMap& batchResultMap) {
+  if (batchResultMap.empty()) {
+    return;
+  }
+
+  std::set<unsigned int> batchSizes;
+  for (auto const& [name, sizeMap] : batchResultMap) {
+    for (auto const& [size, batchMap] : sizeMap) {
+      for (auto const& [batchSize, elapsedTime] : batchMap) {
+	batchSizes.insert(batchSize);
+      }
+    }
+  }
+
+  printf("\nbatched fft execution time per frame (us)\n\n");
+
+  for (auto const& [name, sizeMap] : batchResultMap) {
+    printf("%s\n", name.c_str());
+    printf("%18s", "size \\ batch");
+    for (auto batchSize: batchSizes) {
+      printf("%9d", batchSize);
+    }
+    printf("\n");
+
+    for (auto const& [size, batchMap] : sizeMap) {
+      printf("%18d", size);
+      for (auto batchSize: batchSizes) {
+	auto elapsedTime = batchMap.find(batchSize);
+	if (elapsedTime == batchMap.end()) {
+	  printf("%9s", "");
+	}
+	else {
+	  printf("%9.1f", (double)elapsedTime->second / batchSize);
+	}
+      }
+      printf("\n");
+    }
+    printf("\n");
+  }
+}
+
+// Tables of fft steady state execution times, plan init times, peak
+// working memory, output mode times and errors, and batched fft
+// execution times.
+void reportFftResults(const fft::Results& fftResults) {
+  reportFftTimes("fft execution time (us)", fftResults.executeTime);
+  reportFftTimes("fft plan init time (us)", fftResults.initTime);
+  reportFftTimes("fft peak working memory (bytes)", fftResults.peakBytes);
+  reportFftSnr("fft magnitude snr vs f64 (dB)", fftResults.snr);
+  reportFftTimes("fft execution time by output mode (us)", fftResults.outputTime);
+  reportFftErrors("fft output mode magnitude error (% of peak)", fftResults.outputError);
+  reportFftBatchTimes(fftResults.batchTime);
+}
+
+// Table of decimation execution times.
+static void reportDecimateTimes(const decimate::NameToFactorElapsedTimeMap& decimateResultMap) {
+
+  // gather sizes by decimation factor
+  std::map<unsigned int, std::set<unsigned int>> factorSizes;
   for(auto const& [name, factorMap]: decimateResultMap) {
     for(auto const& [M, elapsedTimeMap]: factorMap) {
-      factors.insert(M);
       for(auto const& [size, elapsedTime]: elapsedTimeMap) {
-	sizes.insert(size);
+	factorSizes[M].insert(size);
       }
     }
   }
 
   printf("\ndecimation execution time (us)\n\n");
 
-  for (const unsigned int M: factors) {
+  for (auto const& [M, sizes]: factorSizes) {
     printf("M=%d\n", M);
-    printf("%10s", "");
+    printf("%18s", "");
     for (unsigned int size: sizes) {
       printf("%7d", size);
     }
     printf("\n");
     
     for(const auto& [name, factorMap]: decimateResultMap) {
-      printf("%10s", name.c_str());
-      for(const auto& [size, elapsedTime]: factorMap.at(M)) {
-	printf("%7d", elapsedTime);
+      auto elapsedTimeMap = factorMap.find(M);
+      if (elapsedTimeMap == factorMap.end()) {
+	continue;
+      }
+
+      printf("%18s", name.c_str());
+      for (unsigned int size: sizes) {
+	auto elapsedTime = elapsedTimeMap->second.find(size);
+	if (elapsedTime == elapsedTimeMap->second.end()) {
+	  printf("%7s", "");
+	}
+	else {
+	  printf("%7lu", elapsedTime->second);
+	}
       }
       printf("\n");
     }
     printf("\n");
   }
 }
+
+// Table of multistage decimation chain stages, and the execution time
+// of each stage.
+static void reportDecimateStageCosts(const decimate::Results& decimateResults) {
+  std::set<unsigned int> factors;
+  for (auto const& [name, factorMap]: decimateResults.stageCost) {
+    for (auto const& [M, stages]: factorMap) {
+      factors.insert(M);
+    }
+  }
+
+  if (factors.empty()) {
+    return;
+  }
+
+  printf("\nmultistage decimation stage execution time (us)\n\n");
+
+  for (unsigned int M: factors) {
+    // All chains of a decimation factor share the same plan, take the
+    // stage layout from the first.
+    const std::vector<DecimateStageCost>* plan = nullptr;
+    for (auto const& [name, factorMap]: decimateResults.stageCost) {
+      if (factorMap.count(M) > 0) {
+	plan = &factorMap.at(M);
+	break;
+      }
+    }
+
+    double macsPerOutput = 0.0;
+    for (auto const& stage: *plan) {
+      macsPerOutput += stage.macsPerOutput;
+    }
+
+    printf("M=%d, %.0f MACs per output", M, macsPerOutput);
+    auto singleStage = decimateResults.singleStageMacsPerOutput.find(M);
+    if (singleStage != decimateResults.singleStageMacsPerOutput.end()) {
+      printf(" (single stage %.0f)", singleStage->second);
+    }
+    printf("\n");
+
+    printf("%18s", "stage M");
+    for (auto const& stage: *plan) {
+      printf("%7d", stage.M);
+    }
+    printf("\n%18s", "taps");
+    for (auto const& stage: *plan) {
+      printf("%7d", stage.numTaps);
+    }
+    printf("\n%18s", "MACs/output");
+    for (auto const& stage: *plan) {
+      printf("%7.0f", stage.macsPerOutput);
+    }
+    printf("\n");
+
+    for (auto const& [name, factorMap]: decimateResults.stageCost) {
+      auto stages = factorMap.find(M);
+      if (stages == factorMap.end()) {
+	continue;
+      }
+      printf("%18s", name.c_str());
+      for (auto const& stage: stages->second) {
+	printf("%7lu", stage.elapsedTime);
+      }
+      printf("\n");
+    }
+    printf("\n");
+  }
+}
+
+// Table of multistage decimator passband edge gains.
+static void reportDecimatePassbandDroop(const decimate::Results& decimateResults) {
+  std::set<std::string> names;
+  for (auto const& [M, droopMap]: decimateResults.passbandDroop) {
+    for (auto const& [name, droop]: droopMap) {
+      names.insert(name);
+    }
+  }
+
+  if (names.empty()) {
+    return;
+  }
+
+  printf("\nmultistage decimation passband edge gain (dB)\n\n");
+
+  printf("%18s", "");
+  for (auto const& name: names) {
+    printf("%12s", name.c_str());
+  }
+  printf("\n");
+
+  for (auto const& [M, droopMap]: decimateResults.passbandDroop) {
+    printf("%18s", ("M=" + std::to_string(M)).c_str());
+    for (auto const& name: names) {
+      auto droop = droopMap.find(name);
+      if (droop == droopMap.end()) {
+	printf("%12s", "");
+      }
+      else {
+	printf("%12.3f", droop->second);
+      }
+    }
+    printf("\n");
+  }
+}
+
+// Tables of the filter length and block size sweep: the execution time
+// per output sample of each decimator by filter length and block size,
+// and the execution time per output sample per filter tap of each
+// decimator at the largest block size.
+static void reportDecimateSweep(const decimate::Sweep& sweep) {
+  if (sweep.elapsedTime.empty()) {
+    return;
+  }
+
+  std::set<unsigned int> taps;
+  std::set<unsigned int> blockSizes;
+  for (auto const& [name, tapsMap]: sweep.elapsedTime) {
+    for (auto const& [numTaps, blockSizeMap]: tapsMap) {
+      taps.insert(numTaps);
+      for (auto const& [blockSize, elapsedTime]: blockSizeMap) {
+	blockSizes.insert(blockSize);
+      }
+    }
+  }
+
+  const double numOutputs = sweep.waveformSize / sweep.M;
+
+  printf("\ndecimation execution time per output sample (ns), M=%d, waveform size %d\n\n", sweep.M, sweep.waveformSize);
+
+  for (auto const& [name, tapsMap]: sweep.elapsedTime) {
+    printf("%s\n", name.c_str());
+    printf("%18s", "taps \\ block size");
+    for (unsigned int blockSize: blockSizes) {
+      printf("%8d", blockSize);
+    }
+    printf("\n");
+
+    for (auto const& [numTaps, blockSizeMap]: tapsMap) {
+      printf("%18d", numTaps);
+      for (unsigned int blockSize: blockSizes) {
+	auto elapsedTime = blockSizeMap.find(blockSize);
+	if (elapsedTime == blockSizeMap.end()) {
+	  printf("%8s", "");
+	}
+	else {
+	  printf("%8.0f", elapsedTime->second * 1000.0 / numOutputs);
+	}
+      }
+      printf("\n");
+    }
+    printf("\n");
+  }
+
+  const unsigned int blockSize = *blockSizes.rbegin();
+
+  printf("\ndecimation execution time per output sample per tap (ns), block size %d\n\n", blockSize);
+
+  printf("%18s", "");
+  for (unsigned int numTaps: taps) {
+    printf("%8d", numTaps);
+  }
+  printf("\n");
+
+  for (auto const& [name, tapsMap]: sweep.elapsedTime) {
+    printf("%18s", name.c_str());
+    for (unsigned int numTaps: taps) {
+      auto blockSizeMap = tapsMap.find(numTaps);
+      if (blockSizeMap == tapsMap.end() || blockSizeMap->second.count(blockSize) == 0) {
+	printf("%8s", "");
+      }
+      else {
+	printf("%8.2f", blockSizeMap->second.at(blockSize) * 1000.0 / numOutputs / numTaps);
+      }
+    }
+    printf("\n");
+  }
+}
+
+// Table of fixed point decimator SNR by filter length, the input
+// scaled down by log2(numTaps) bits and by the headroom shift.
+static void reportDecimateHeadroom(const decimate::Results& decimateResults) {
+  if (decimateResults.headroomSnr.empty()) {
+    return;
+  }
+
+  printf("\ndecimation snr (dB) by input scaling, M=%d, waveform size %d\n\n", decimateResults.sweep.M, decimateResults.sweep.waveformSize);
+  printf("%18s%8s%9s%8s%9s%8s%9s%9s\n", "name", "taps", "l1 norm", "log2", "snr", "shift", "snr", "delta");
+
+  for (auto const& [name, tapsMap]: decimateResults.headroomSnr) {
+    for (auto const& [numTaps, snr]: tapsMap) {
+      printf("%18s%8d%9.4f%8d%9.1f%8d%9.1f%9.1f\n", name.c_str(), numTaps, snr.l1Norm,
+	     snr.worstCaseShift, snr.worstCaseSnr, snr.headroomShift, snr.headroomSnr, snr.headroomSnr - snr.worstCaseSnr);
+    }
+  }
+}
+
+// Tables of decimation execution times, the filter length and block
+// size sweep, input scaling SNR, multistage decimation stage costs,
+// and multistage decimation passband droop.
+void reportDecimateResults(const decimate::Results& decimateResults) {
+  reportDecimateTimes(decimateResults.executeTime);
+  reportDecimateSweep(decimateResults.sweep);
+  reportDecimateHeadroom(decimateResults);
+  reportDecimateStageCosts(decimateResults);
+  reportDecimatePassbandDroop(decimateResults);
+}
+
+// Table of resampling execution times.
+void reportResampleResults(const resample::NameToRatioElapsedTimeMap& resampleResultMap) {
+
+  // gather sizes by resampling ratio
+  std::map<resample::Ratio, std::set<unsigned int>> ratioSizes;
+  for(auto const& [name, ratioMap]: resampleResultMap) {
+    for(auto const& [ratio, elapsedTimeMap]: ratioMap) {
+      for(auto const& [size, elapsedTime]: elapsedTimeMap) {
+	ratioSizes[ratio].insert(size);
+      }
+    }
+  }
+
+  printf("\nresampling execution time (us)\n\n");
+
+  for (auto const& [ratio, sizes]: ratioSizes) {
+    printf("L/M=%d/%d\n", ratio.first, ratio.second);
+    printf("%18s", "");
+    for (unsigned int size: sizes) {
+      printf("%7d", size);
+    }
+    printf("\n");
+
+    for(const auto& [name, ratioMap]: resampleResultMap) {
+      auto elapsedTimeMap = ratioMap.find(ratio);
+      if (elapsedTimeMap == ratioMap.end()) {
+	continue;
+      }
+
+      printf("%18s", name.c_str());
+      for (unsigned int size: sizes) {
+	auto elapsedTime = elapsedTimeMap->second.find(size);
+	if (elapsedTime == elapsedTimeMap->second.end()) {
+	  printf("%7s", "");
+	}
+	else {
+	  printf("%7lu", elapsedTime->second);
+	}
+      }
+      printf("\n");
+    }
+    printf("\n");
+  }
+}
+
+// Table of stft frames per second, or of the real-time headroom, by
+// fft size and hop size.
+static void reportStftTable(const stft::Results& stftResults, bool headroom) {
+  std::set<stft::Shape> shapes;
+  for (auto const& [name, shapeMap]: stftResults.timing) {
+    for (auto const& [shape, timing]: shapeMap) {
+      shapes.insert(shape);
+    }
+  }
+
+  printf("%18s", "fft size/hop");
+  for (auto const& shape: shapes) {
+    printf("%11s", (std::to_string(shape.first) + "/" + std::to_string(shape.second)).c_str());
+  }
+  printf("\n");
+
+  for (auto const& [name, shapeMap]: stftResults.timing) {
+    printf("%18s", name.c_str());
+    for (auto const& shape: shapes) {
+      auto timing = shapeMap.find(shape);
+      if (timing == shapeMap.end() || timing->second.elapsedTime == 0) {
+	printf("%11s", "");
+      }
+      else if (headroom) {
+	double realTime = timing->second.numSamples / stftResults.sampleRate;
+	printf("%11.2f", realTime / (timing->second.elapsedTime * 1e-6));
+      }
+      else {
+	printf("%11.0f", timing->second.numFrames / (timing->second.elapsedTime * 1e-6));
+      }
+    }
+    printf("\n");
+  }
+}
+
+// Tables of stft frames per second, and of the real-time headroom (the
+// time the input waveform spans at the sample rate divided by the
+// processing time, greater than 1 keeps up with the input).
+void reportStftResults(const stft::Results& stftResults) {
+  if (stftResults.timing.empty()) {
+    return;
+  }
+
+  printf("\nstft frames per second\n\n");
+  reportStftTable(stftResults, false);
+
+  printf("\nstft real-time headroom at %.0f samples per second\n\n", stftResults.sampleRate);
+  reportStftTable(stftResults, true);
+}
+
+// Tables of bin detector execution times by length and bin count, and
+// the detector selected for each.
+void reportGoertzelResults(const goertzel::Results& goertzelResults) {
+  std::set<unsigned int> binCounts;
+  for (auto const& [name, lengthMap] : goertzelResults.elapsedTime) {
+    for (auto const& [length, binsMap] : lengthMap) {
+      for (auto const& [numBins, elapsedTime] : binsMap) {
+	binCounts.insert(numBins);
+      }
+    }
+  }
+
+  printf("\nbin detector execution time (us)\n\n");
+
+  for (auto const& [name, lengthMap] : goertzelResults.elapsedTime) {
+    printf("%s\n", name.c_str());
+    printf("%18s", "length \\ bins");
+    for (auto numBins: binCounts) {
+      printf("%9d", numBins);
+    }
+    printf("\n");
+
+    for (auto const& [length, binsMap] : lengthMap) {
+      printf("%18d", length);
+      for (auto numBins: binCounts) {
+	auto elapsedTime = binsMap.find(numBins);
+	if (elapsedTime == binsMap.end()) {
+	  printf("%9s", "");
+	}
+	else {
+	  printf("%9lu", elapsedTime->second);
+	}
+      }
+      printf("\n");
+    }
+    printf("\n");
+  }
+
+  printf("\nbin detector selection\n\n");
+
+  for (auto const& [type, lengthMap] : goertzelResults.selected) {
+    printf("%s\n", type.c_str());
+    printf("%18s", "length \\ bins");
+    for (auto numBins: binCounts) {
+      printf("%13d", numBins);
+    }
+    printf("\n");
+
+    for (auto const& [length, binsMap] : lengthMap) {
+      printf("%18d", length);
+      for (auto numBins: binCounts) {
+	auto name = binsMap.find(numBins);
+	printf("%13s", name == binsMap.end() ? "" : name->second.c_str());
+      }
+      printf("\n");
+    }
+    printf("\n");
+  }
+}
+
+// Table of Welch execution time, noise floor error and noise floor
+// spread by segment size.
+void reportWelchResults(const welch::Results& welchResults) {
+  if (welchResults.measurement.empty()) {
+    return;
+  }
+
+  printf("\nwelch psd, %d segment average\n\n", welchResults.averageCount);
+  printf("%18s%9s%9s%12s%12s%12s\n", "name", "segment", "time", "noise err", "spread", "1st spread");
+  printf("%18s%9s%9s%12s%12s%12s\n", "", "", "(us)", "(%)", "(%)", "(%)");
+
+  for (auto const& [name, segmentMap] : welchResults.measurement) {
+    for (auto const& [segmentSize, measurement] : segmentMap) {
+      printf("%18s%9d%9lu%12.2f%12.1f%12.1f\n", name.c_str(), segmentSize, measurement.elapsedTime, measurement.noiseError, measurement.spread, measurement.firstSpread);
+    }
+  }
+}
+
+// Table of execution time per input sample by filter length.
+static void reportFastFirTimes(const char* title, const fastfir::Results& fastFirResults, const fastfir::NameToTapsMeasurementMap& measurementMap) {
+  printf("\n%s, execution time per input sample (ns)\n\n", title);
+
+  printf("%24s", "fft length");
+  for (auto const& [numTaps, fftLength]: fastFirResults.fftLength) {
+    printf("%8d", fftLength);
+  }
+  printf("\n");
+
+  printf("%24s", "taps");
+  for (auto const& [numTaps, fftLength]: fastFirResults.fftLength) {
+    printf("%8d", numTaps);
+  }
+  printf("\n");
+
+  for (auto const& [name, tapsMap]: measurementMap) {
+    printf("%24s", name.c_str());
+    for (auto const& [numTaps, fftLength]: fastFirResults.fftLength) {
+      auto measurement = tapsMap.find(numTaps);
+      if (measurement == tapsMap.end()) {
+	printf("%8s", "");
+      }
+      else {
+	printf("%8.0f", measurement->second.elapsedTime * 1000.0 / measurement->second.numSamples);
+      }
+    }
+    printf("\n");
+  }
+}
+
+// The shortest filter length at which the fastest fast FIR (name
+// contains "_ol", overlap save or add) beats the fastest direct form
+// filter of the data type. 0 if there's none.
+static unsigned int fastFirCrossover(const std::string& type, const fastfir::NameToTapsMeasurementMap& measurementMap) {
+  std::map<unsigned int, double> direct;
+  std::map<unsigned int, double> fast;
+  for (auto const& [name, tapsMap]: measurementMap) {
+    if (name.compare(0, type.size(), type) != 0) {
+      continue;
+    }
+    auto& times = name.find("_ol") == std::string::npos ? direct : fast;
+    for (auto const& [numTaps, measurement]: tapsMap) {
+      const double time = (double)measurement.elapsedTime / measurement.numSamples;
+      auto t = times.find(numTaps);
+      if (t == times.end() || time < t->second) {
+	times[numTaps] = time;
+      }
+    }
+  }
+
+  for (auto const& [numTaps, time]: fast) {
+    auto directTime = direct.find(numTaps);
+    if (directTime != direct.end() && time < directTime->second) {
+      return numTaps;
+    }
+  }
+  return 0;
+}
+
+static void reportFastFirCrossover(const char* title, const fastfir::NameToTapsMeasurementMap& measurementMap) {
+  printf("\n%s crossover (taps)", title);
+  for (const char* type: {"f32", "q31", "q15"}) {
+    const unsigned int crossover = fastFirCrossover(type, measurementMap);
+    if (crossover == 0) {
+      printf(", %s none", type);
+    }
+    else {
+      printf(", %s %d", type, crossover);
+    }
+  }
+  printf("\n");
+}
+
+// Tables of direct form and fast FIR execution time by filter length,
+// and the filter length at which the fast FIR becomes faster.
+void reportFastFirResults(const fastfir::Results& fastFirResults) {
+  if (fastFirResults.filter.empty()) {
+    return;
+  }
+
+  reportFastFirTimes("fir filter", fastFirResults, fastFirResults.filter);
+  reportFastFirCrossover("fir filter", fastFirResults.filter);
+
+  char title[64];
+  snprintf(title, sizeof(title), "decimate by %d", fastFirResults.M);
+  reportFastFirTimes(title, fastFirResults, fastFirResults.decimate);
+  reportFastFirCrossover(title, fastFirResults.decimate);
+}
+
+// Tables of waveform preparation time, per sample next() and block
+// fill(), and of fixed point conversion time, two pass and fused.
+void reportSourceResults(const source::Results& sourceResults) {
+  if (sourceResults.prepTime.empty()) {
+    return;
+  }
+
+  printf("\nwaveform preparation time\n\n");
+  printf("%18s%9s%12s%12s%9s\n", "name", "samples", "next", "fill", "speedup");
+  printf("%18s%9s%12s%12s%9s\n", "", "", "(us)", "(us)", "");
+
+  for (auto const& [name, measurement] : sourceResults.prepTime) {
+    const double speedup = measurement.fillTime > 0 ? (double)measurement.nextTime / measurement.fillTime : 0.0;
+    printf("%18s%9d%12lu%12lu%9.1f\n", name.c_str(), measurement.numSamples, measurement.nextTime, measurement.fillTime, speedup);
+  }
+
+  if (sourceResults.conversionTime.empty()) {
+    return;
+  }
+
+  printf("\nfixed point conversion time, rshift %d\n\n", sourceResults.conversionShift);
+  printf("%18s%9s%12s%12s%9s\n", "name", "samples", "two pass", "fused", "speedup");
+  printf("%18s%9s%12s%12s%9s\n", "", "", "(us)", "(us)", "");
+
+  for (auto const& [name, measurement] : sourceResults.conversionTime) {
+    const double speedup = measurement.fusedTime > 0 ? (double)measurement.twoPassTime / measurement.fusedTime : 0.0;
+    printf("%18s%9d%12lu%12lu%9.1f\n", name.c_str(), measurement.numSamples, measurement.twoPassTime, measurement.fusedTime, speedup);
+  }
+}
+
+// The headroom (bits) of a peak, full scale 1.0, how many times the
+// signal could double before reaching full scale.
+static int headroomBits(double peak) {
+  return (int)std::floor(-std::log2(peak));
+}
+
+// Tables of fixed point kernel input and output peaks, and their
+// headroom in bits, and of float to fixed point and q63 accumulator
+// conversion clipping (see Instrument.h).
+void reportInstrumentResults(const instrument::Results& instrumentResults) {
+  if (!instrument::enabled) {
+    return;
+  }
+
+  printf("\nfixed point kernel peaks (full scale 1.0) and headroom (bits)\n\n");
+  printf("%32s%8s%10s%6s%10s%6s%10s\n", "kernel", "calls", "in peak", "bits", "out peak", "bits", "out rail");
+
+  for (auto const& [name, peaks] : instrumentResults.kernels) {
+    printf("%32s%8lu%10.6f", name.c_str(), peaks.numCalls, peaks.inputPeak);
+    if (peaks.inputPeak > 0.0) {
+      printf("%6d", headroomBits(peaks.inputPeak));
+    }
+    else {
+      printf("%6s", "-");
+    }
+    printf("%10.6f", peaks.outputPeak);
+    if (peaks.outputPeak > 0.0) {
+      printf("%6d", headroomBits(peaks.outputPeak));
+    }
+    else {
+      printf("%6s", "-");
+    }
+    printf("%10lu\n", peaks.outputRail);
+  }
+
+  printf("\nfixed point conversion clipping\n\n");
+  printf("%32s%12s%10s\n", "conversion", "samples", "clipped");
+
+  for (auto const& [name, clips] : instrumentResults.conversions) {
+    printf("%32s%12lu%10lu\n", name.c_str(), clips.numSamples, clips.numClipped);
+  }
+}
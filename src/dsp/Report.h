@@ -6,8 +6,22 @@
 
 #include "FftTestRunner.h"
 #include "DecimateTestRunner.h"
+#include "ResampleTestRunner.h"
+#include "StftTestRunner.h"
+#include "GoertzelTestRunner.h"
+#include "WelchTestRunner.h"
+#include "FastFirTestRunner.h"
+#include "SourceTestRunner.h"
+#include "Instrument.h"
 
-void reportFftResults(const fft::NameToElapsedTimeMap& fftResultMap);
-void reportDecimateResults(const decimate::NameToFactorElapsedTimeMap& decimateResultMap);
+void reportFftResults(const fft::Results& fftResults);
+void reportDecimateResults(const decimate::Results& decimateResults);
+void reportResampleResults(const resample::NameToRatioElapsedTimeMap& resampleResultMap);
+void reportStftResults(const stft::Results& stftResults);
+void reportGoertzelResults(const goertzel::Results& goertzelResults);
+void reportWelchResults(const welch::Results& welchResults);
+void reportFastFirResults(const fastfir::Results& fastFirResults);
+void reportSourceResults(const source::Results& sourceResults);
+void reportInstrumentResults(const instrument::Results& instrumentResults);
 
 #endif
@@ -0,0 +1,119 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "ResampleTest.h"
+
+#include "CmsisResample.h"
+#include "CmsisFft.h"
+#include "WindowFunction.h"
+#include "StreamTest.h"
+#include "Ex.h"
+
+#include "Platform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+
+namespace {
+
+  class ResampleTest {
+
+    // the largest arm_rfft_fast_f32 length
+    static const unsigned int maxFftSize = 4096;
+
+    double k;
+    std::unique_ptr<Resample> resampler;
+
+    // Return the index of the maximum value in the first half (below
+    // the nyquist frequency) of the magnitude vector.
+    unsigned int findMaxIndex(const std::vector<float>& mag) {
+      float maxValue = mag.at(0);
+      int maxIndex = 0;
+    
+      for(int i = 0; i < mag.size()/2; i++) {
+	if (mag.at(i) > maxValue) {
+	  maxValue = mag.at(i);
+	  maxIndex = i;
+	}
+      }
+
+      return maxIndex;
+    }
+  
+    void verify() {
+      unsigned int L = resampler->getL();
+      unsigned int M = resampler->getM();
+      std::unique_ptr<std::vector<float>> result = resampler->getResult();
+
+      // The resampled waveform length is generally not a power of
+      // two. Take the end of it (past the filter startup transient)
+      // for the fft.
+      unsigned int fftSize = 1;
+      while (2*fftSize <= std::min((unsigned int)result->size(), maxFftSize)) {
+	fftSize *= 2;
+      }
+      auto tail = std::make_unique<std::vector<float32_t>>(result->end() - fftSize, result->end());
+
+      std::unique_ptr<WindowFunction> hanning = createHanningWindow(tail->size());
+      for(int i = 0; i < tail->size(); i++) {
+	tail->at(i) = tail->at(i) * hanning->at(i);
+      }
+    
+      auto fft = createFloat32Fft(std::move(tail));
+      fft->execute();
+      auto mag = fft->getNormalizedMagnitude();
+
+      // The input frequency is 1/2k cycles per sample, resampling
+      // scales it by M/L cycles per output sample. The expected index
+      // is the nearest fft bin, the frequency isn't generally bin
+      // centered.
+      unsigned int expectedMaxIndex = (unsigned int)std::lround(fftSize * M / (2.0 * k * L));
+
+      // And the actual is the max magnitude component.
+      unsigned int actualMaxIndex = findMaxIndex(*mag);
+
+      if ( actualMaxIndex != expectedMaxIndex ) {
+	printf("FAIL actualMaxIndex != expectedMaxIndex (%d != %d)\n", actualMaxIndex, expectedMaxIndex);
+	throw Fail("actualMaxIndex != expectedMaxIndex");
+      }
+    }
+  
+  public:
+
+    ResampleTest(double k, std::unique_ptr<Resample> resampler)
+      : k(k),
+	resampler(std::move(resampler))
+    {}
+  
+    ResampleTestResult execute() {
+      platform::profiling_time_t start = platform::get_profiling_time();
+      resampler->execute();
+      platform::profiling_time_t end = platform::get_profiling_time();
+      unsigned long elapsedTime = profiling_time_diff(start,end);
+
+      verify();
+
+      printf("%s %d/%d %lu us\n", resampler->getName().c_str(), resampler->getL(), resampler->getM(), elapsedTime);
+
+      return ResampleTestResult(resampler->getName(), elapsedTime);
+    }
+  };
+
+} // namespace
+
+ResampleTestResult executeResampleTest(double k, std::unique_ptr<Resample> resampler) {
+  return ResampleTest(k, std::move(resampler)).execute();
+}
+
+void verifyResampleStream(ResampleStream<float32_t>& stream, ResampleStream<float32_t>& reference, const std::vector<float32_t>& waveform) {
+  verifyStreamBlocks(stream, reference, waveform);
+}
+
+void verifyResampleStream(ResampleStream<q15_t>& stream, ResampleStream<q15_t>& reference, const std::vector<q15_t>& waveform) {
+  verifyStreamBlocks(stream, reference, waveform);
+}
+
+void verifyResampleStream(ResampleStream<q31_t>& stream, ResampleStream<q31_t>& reference, const std::vector<q31_t>& waveform) {
+  verifyStreamBlocks(stream, reference, waveform);
+}
@@ -0,0 +1,38 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_RESAMPLETEST_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_RESAMPLETEST_H_INCLUDED
+
+#include "arm_math.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class Resample;
+template <typename T> class ResampleStream;
+
+struct ResampleTestResult {
+  const std::string name;
+  const unsigned long elapsedTime;
+  
+  ResampleTestResult(const std::string& name, unsigned long elapsedTime)
+    :name(name),
+     elapsedTime(elapsedTime)
+  {}
+};
+
+// Profile the resampler, then verify that the input waveform
+// frequency, sin(n*M_PI/k), appears at the expected frequency in the
+// resampled waveform. Throws Fail if not.
+ResampleTestResult executeResampleTest(double k, std::unique_ptr<Resample> resampler);
+
+// Verify that the stream, fed the waveform in irregular block sizes,
+// produces bit for bit the same output as the reference stream
+// resampling the whole waveform in one block. Throws Fail if not.
+void verifyResampleStream(ResampleStream<float32_t>& stream, ResampleStream<float32_t>& reference, const std::vector<float32_t>& waveform);
+void verifyResampleStream(ResampleStream<q15_t>& stream, ResampleStream<q15_t>& reference, const std::vector<q15_t>& waveform);
+void verifyResampleStream(ResampleStream<q31_t>& stream, ResampleStream<q31_t>& reference, const std::vector<q31_t>& waveform);
+
+#endif
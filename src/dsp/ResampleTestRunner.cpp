@@ -0,0 +1,143 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "ResampleTestRunner.h"
+
+#include "ResampleTest.h"
+#include "CmsisResample.h"
+#include "CmsisTypeFactory.h"
+#include "FirSource.h"
+#include "FirDesign.h"
+#include "Signal.h"
+#include "Ex.h"
+
+#include <arm_math.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace resample;
+
+namespace {
+
+  class ResampleTestRunner {
+
+    const std::vector<unsigned int> sizes = {1024, 2048, 4096};
+
+    // Interpolation (M=1) and rational resampling ratios.
+    const std::vector<Ratio> ratios = { {2, 1}, {4, 1}, {3, 2}, {2, 3}, {160, 147}, {147, 160} };
+
+    // The zero stuffing resampler buffers L times the input block and
+    // filters with all L*phaseLength taps, only run it for the small
+    // ratios.
+    const unsigned int maxUpDownL = 4;
+
+    // Polyphase branch length, the filter has L*phaseLength taps.
+    const unsigned int phaseLength = 16;
+
+    // Streaming input block size, e.g. an ADC DMA block.
+    const unsigned int streamBlockSize = 64;
+
+    // The test signal is sin(n*M_PI/k), 1/8 cycles per input sample,
+    // which is below the output nyquist frequency of every ratio.
+    const double k = 4.0;
+
+    std::unique_ptr<NameToRatioElapsedTimeMap> resultMap = std::make_unique<NameToRatioElapsedTimeMap>();
+
+    void addResult(unsigned int waveformSize, const Ratio& ratio, const ResampleTestResult& result) {
+      (*resultMap)[result.name][ratio][waveformSize] = result.elapsedTime;
+    }
+
+    // Lowpass filter at the upsampled rate with gain L, 60 dB
+    // stopband attenuation.
+    std::unique_ptr<std::vector<double>> designFilter(unsigned int L, unsigned int M) {
+      const double cutoff = 0.9 / std::max(L, M);
+      auto fir = designKaiserLowpass(L * phaseLength, cutoff, kaiserBeta(60.0));
+      std::for_each(fir->begin(), fir->end(), [L](double& h) { h *= L; });
+      return fir;
+    }
+
+    // Verify the stream against a single block reference, then profile
+    // it resampling the waveform in streamBlockSize blocks.
+    template <typename T> void runStream(unsigned int waveformSize, const Ratio& ratio, std::unique_ptr<ResampleStream<T>> stream, std::unique_ptr<ResampleStream<T>> reference, std::unique_ptr<std::vector<T>> waveform) {
+      verifyResampleStream(*stream, *reference, *waveform);
+
+      auto resampler = createBlockResample(std::move(stream), std::move(waveform), streamBlockSize);
+      addResult( waveformSize, ratio, executeResampleTest(k, std::move(resampler)) );
+    }
+
+    void run(unsigned int waveformSize, const Ratio& ratio) {
+      const unsigned int L = ratio.first;
+      const unsigned int M = ratio.second;
+
+      CmsisTypeFactory firFactory(createFirSource(designFilter(L, M)));
+
+      // See arm_fir_interpolate_q31() scaling requirements, the
+      // accumulator sums phaseLength products.
+      const unsigned int rshift = (unsigned int)std::ceil(std::log2(phaseLength));
+
+      printf("\nresample waveform size %d, filter size %d, L/M=%d/%d\n", waveformSize, firFactory.getSource().size(), L, M);
+
+      CmsisTypeFactory signalFactory(std::make_unique<Signal>(waveformSize, k, false));
+
+      if (M == 1) {
+	runStream(waveformSize, ratio,
+		  createFloat32InterpolateStream(firFactory.toFloat32(), L, streamBlockSize),
+		  createFloat32InterpolateStream(firFactory.toFloat32(), L, waveformSize),
+		  signalFactory.toFloat32());
+
+	runStream(waveformSize, ratio,
+		  createQ31InterpolateStream(firFactory.toQ31(), L, streamBlockSize),
+		  createQ31InterpolateStream(firFactory.toQ31(), L, waveformSize),
+		  signalFactory.toQ31(rshift));
+
+	// arm_fir_interpolate_q15() has a 64 bit accumulator, no
+	// scaling requirement.
+	runStream(waveformSize, ratio,
+		  createQ15InterpolateStream(firFactory.toQ15(), L, streamBlockSize),
+		  createQ15InterpolateStream(firFactory.toQ15(), L, waveformSize),
+		  signalFactory.toQ15());
+      }
+
+      runStream(waveformSize, ratio,
+		createFloat32ResampleStream(firFactory.toFloat32(), L, M, streamBlockSize),
+		createFloat32ResampleStream(firFactory.toFloat32(), L, M, waveformSize),
+		signalFactory.toFloat32());
+
+      runStream(waveformSize, ratio,
+		createQ31ResampleStream(firFactory.toQ31(), L, M, streamBlockSize),
+		createQ31ResampleStream(firFactory.toQ31(), L, M, waveformSize),
+		signalFactory.toQ31(rshift));
+
+      runStream(waveformSize, ratio,
+		createQ15ResampleStream(firFactory.toQ15(), L, M, streamBlockSize),
+		createQ15ResampleStream(firFactory.toQ15(), L, M, waveformSize),
+		signalFactory.toQ15());
+
+      if (L <= maxUpDownL) {
+	runStream(waveformSize, ratio,
+		  createFloat32UpDownResampleStream(firFactory.toFloat32(), L, M, streamBlockSize),
+		  createFloat32UpDownResampleStream(firFactory.toFloat32(), L, M, waveformSize),
+		  signalFactory.toFloat32());
+      }
+    }
+  
+  public:
+
+    std::unique_ptr<NameToRatioElapsedTimeMap> runAll() {
+      for(unsigned int size: sizes) {
+	for (const Ratio& ratio: ratios) {
+	  run(size, ratio);
+	}
+      }
+
+      return std::move(resultMap);
+    }
+  };
+
+} // namespace
+
+std::unique_ptr<NameToRatioElapsedTimeMap> runAllResampleTests() {
+  return ResampleTestRunner().runAll();
+}
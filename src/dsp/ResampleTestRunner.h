@@ -0,0 +1,28 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_RESAMPLETESTRUNNER_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_RESAMPLETESTRUNNER_H_INCLUDED
+
+#include <memory>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace resample {
+  // map input size to elapsed time
+  typedef std::map<unsigned int, unsigned long> SizeToElapsedTimeMap;
+
+  // resampling ratio L/M
+  typedef std::pair<unsigned int, unsigned int> Ratio;
+
+  // map resampling ratio to elapsed time map
+  typedef std::map<Ratio, SizeToElapsedTimeMap> RatioToElapsedTimeMap;
+
+  // map resampler name to ratio map
+  typedef std::map<std::string, RatioToElapsedTimeMap> NameToRatioElapsedTimeMap;
+}
+
+std::unique_ptr<resample::NameToRatioElapsedTimeMap> runAllResampleTests();
+
+#endif
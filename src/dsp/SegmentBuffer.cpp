@@ -0,0 +1,107 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "SegmentBuffer.h"
+
+#include "WindowFunction.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+  // Window values converted to T, fixed point values are rounded and
+  // saturated at 1.0.
+  template <typename T> T toWindowValue(float w);
+
+  template <> float64_t toWindowValue<float64_t>(float w) {
+    return w;
+  }
+
+  template <> float32_t toWindowValue<float32_t>(float w) {
+    return w;
+  }
+
+  template <> q15_t toWindowValue<q15_t>(float w) {
+    return (q15_t)std::min(32767L, std::lround(w * 32768.0));
+  }
+
+  template <> q31_t toWindowValue<q31_t>(float w) {
+    return (q31_t)std::min(2147483647LL, std::llround(w * 2147483648.0));
+  }
+
+  // A window value as a real number.
+  template <typename T> double fromWindowValue(T w) {
+    return w;
+  }
+
+  template <> double fromWindowValue<q15_t>(q15_t w) {
+    return w / 32768.0;
+  }
+
+  template <> double fromWindowValue<q31_t>(q31_t w) {
+    return w / 2147483648.0;
+  }
+
+  void multiply(const float64_t* a, const float64_t* b, float64_t* out, unsigned int n) {
+    arm_mult_f64(a, b, out, n);
+  }
+
+  void multiply(const float32_t* a, const float32_t* b, float32_t* out, unsigned int n) {
+    arm_mult_f32(a, b, out, n);
+  }
+
+  void multiply(const q15_t* a, const q15_t* b, q15_t* out, unsigned int n) {
+    arm_mult_q15(a, b, out, n);
+  }
+
+  void multiply(const q31_t* a, const q31_t* b, q31_t* out, unsigned int n) {
+    arm_mult_q31(a, b, out, n);
+  }
+
+} // namespace
+
+template <typename T> SegmentBuffer<T>::SegmentBuffer(const WindowFunction& windowFunction, unsigned int hopSize)
+  : segmentSize(windowFunction.getWindow().size()),
+    hopSize(hopSize),
+    window(segmentSize),
+    ring(segmentSize),
+    untilSegment(segmentSize)
+{
+  std::transform(windowFunction.getWindow().cbegin(), windowFunction.getWindow().cend(), window.begin(), toWindowValue<T>);
+  for (T w: window) {
+    double x = fromWindowValue(w);
+    windowPower += x * x;
+  }
+}
+
+template <typename T> unsigned int SegmentBuffer<T>::write(const T* in, unsigned int numSamples) {
+  const unsigned int n = std::min(numSamples, untilSegment);
+
+  // write n samples to the ring buffer, wrapping at the end
+  const unsigned int first = std::min(n, segmentSize - writeIndex);
+  std::copy(in, in + first, ring.data() + writeIndex);
+  std::copy(in + first, in + n, ring.data());
+  writeIndex = (writeIndex + n) % segmentSize;
+
+  untilSegment -= n;
+  return n;
+}
+
+template <typename T> void SegmentBuffer<T>::windowSegment(T* out) {
+  const unsigned int n = segmentSize - writeIndex;
+  multiply(ring.data() + writeIndex, window.data(), out, n);
+  multiply(ring.data(), window.data() + n, out + n, writeIndex);
+  untilSegment = hopSize;
+}
+
+template <typename T> void SegmentBuffer<T>::reset() {
+  std::fill(ring.begin(), ring.end(), 0);
+  writeIndex = 0;
+  untilSegment = segmentSize;
+}
+
+template class SegmentBuffer<float64_t>;
+template class SegmentBuffer<float32_t>;
+template class SegmentBuffer<q31_t>;
+template class SegmentBuffer<q15_t>;
@@ -0,0 +1,92 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_SEGMENTBUFFER_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_SEGMENTBUFFER_H_INCLUDED
+
+#include "arm_math.h"
+
+#include <vector>
+
+class WindowFunction;
+
+/**
+The windowed ring buffer of the streaming spectral estimators, the
+STFT (see Stft.h) and Welch (see Welch.h).
+
+Input samples of any block size are written to a ring buffer of the
+last segmentSize samples. The first segment completes after
+segmentSize samples, every next one after hopSize more. A complete
+segment is windowed (arm_mult_*) oldest sample first into the
+caller's fft input buffer, with no copy of the ring buffer.
+
+The window is converted to T once, at construction. Fixed point
+window values are rounded and saturated at 1.0.
+*/
+template <typename T> class SegmentBuffer {
+
+  const unsigned int segmentSize;
+
+  const unsigned int hopSize;
+
+  // the window converted to T
+  std::vector<T> window;
+
+  // sum(w[n]^2) of the converted window
+  double windowPower = 0.0;
+
+  // The last segmentSize input samples, the oldest sample is at
+  // writeIndex once the buffer is full.
+  std::vector<T> ring;
+  unsigned int writeIndex = 0;
+
+  // input samples until the next segment
+  unsigned int untilSegment;
+
+  SegmentBuffer();
+  SegmentBuffer(const SegmentBuffer&);
+  SegmentBuffer& operator=(const SegmentBuffer&);
+
+public:
+
+  // The segment size is the window size. The hop size must be 1 to
+  // segmentSize, the caller checks it.
+  SegmentBuffer(const WindowFunction& windowFunction, unsigned int hopSize);
+
+  unsigned int getSegmentSize() const {
+    return segmentSize;
+  }
+
+  unsigned int getHopSize() const {
+    return hopSize;
+  }
+
+  // sum(w[n]^2) of the window as converted to T, as a real number.
+  double getWindowPower() const {
+    return windowPower;
+  }
+
+  // The number of segments that numSamples more input samples
+  // complete.
+  unsigned int getNumSegments(unsigned int numSamples) const {
+    return numSamples < untilSegment ? 0 : 1 + (numSamples - untilSegment) / hopSize;
+  }
+
+  // Write input samples up to the end of the next segment. Returns the
+  // number of samples written, at most numSamples.
+  unsigned int write(const T* in, unsigned int numSamples);
+
+  // True when a segment is complete, until it's windowed.
+  bool isSegmentReady() const {
+    return untilSegment == 0;
+  }
+
+  // Window the complete segment (oldest sample first) into out,
+  // segmentSize values, and start the next hop.
+  void windowSegment(T* out);
+
+  // Clear the ring buffer, the next segment is the first.
+  void reset();
+};
+
+#endif
@@ -5,6 +5,7 @@
 
 #include "Ex.h"
 
+#include <algorithm>
 #include <cmath>
 
 /*
@@ -68,6 +69,10 @@ k = 2 produces a waveform at half the nyquist frequency
 
 namespace {
 
+  // the number of samples generated by the sine recurrence before it
+  // restarts from exact values
+  const unsigned int recurrenceLength = 64;
+
   static double clampK(int N, double k) {
     if (k < 1.0d) {
       return 1.0d;
@@ -133,6 +138,37 @@ double Signal::next() {
   }
 }
 
+template <typename T> unsigned int Signal::generate(Span<T> out) {
+  const unsigned int count = std::min(out.size(), numSamples - n);
+  const double twoCos = 2.0*cos(M_PI/k);
+  const std::uniform_real_distribution<double>::param_type range(-0.25, 0.25);
+
+  for (unsigned int i = 0; i < count; ) {
+    double s0 = sin(n*M_PI/k);
+    double s1 = sin((n+1)*M_PI/k);
+
+    const unsigned int end = std::min(count, i + recurrenceLength);
+    for (; i < end; i++, n++) {
+      const double signal = amplitude*s0;
+      out[i] = addNoise ? signal + dist(rand,range) : signal;
+
+      const double s2 = twoCos*s1 - s0;
+      s0 = s1;
+      s1 = s2;
+    }
+  }
+
+  return count;
+}
+
+unsigned int Signal::fill(Span<float64_t> out) {
+  return generate(out);
+}
+
+unsigned int Signal::fill(Span<float32_t> out) {
+  return generate(out);
+}
+
 bool Signal::isEnd() const {
   return n == numSamples;
 }
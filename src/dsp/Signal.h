@@ -27,6 +27,9 @@ class Signal : public Source {
 
   // sample counter
   unsigned int n=0;
+
+  // Write the next samples to out, see fill().
+  template <typename T> unsigned int generate(Span<T> out);
   
  public:
 
@@ -69,7 +72,16 @@ class Signal : public Source {
   // numSamples times.
   virtual double next();
 
-  // True after next() called numSamples times.
+  // Write the next samples to out. The sine wave is generated with
+  // the recurrence s[n+1] = 2*cos(w)*s[n] - s[n-1], restarted from
+  // exact sin() values every 64 samples, rather than a sin() call per
+  // sample. The samples are the same as next() samples to within
+  // double precision rounding, and the noise is drawn the same way.
+  using Source::fill;
+  virtual unsigned int fill(Span<float64_t> out);
+  virtual unsigned int fill(Span<float32_t> out);
+
+  // True after numSamples samples are read.
   virtual bool isEnd() const;
 
   // Reset the sample counter to zero.
@@ -0,0 +1,61 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "Source.h"
+
+#include "CmsisTypeFactory.h"
+
+#include <algorithm>
+
+namespace {
+
+  // the float32_t block converted to fixed point at a time
+  const unsigned int conversionBlockSize = 64;
+
+  void fromFloat(const float32_t* in, q31_t* out, unsigned int n, unsigned int rshift) {
+    convertFloat32ToQ31(in, out, n, rshift);
+  }
+
+  void fromFloat(const float32_t* in, q15_t* out, unsigned int n, unsigned int rshift) {
+    convertFloat32ToQ15(in, out, n, rshift);
+  }
+
+  template <typename T> unsigned int fillFloat(Source& source, Span<T> out) {
+    unsigned int n = 0;
+    while (n < out.size() && !source.isEnd()) {
+      out[n++] = source.next();
+    }
+    return n;
+  }
+
+  template <typename T> unsigned int fillFixed(Source& source, Span<T> out, unsigned int rshift) {
+    float32_t block[conversionBlockSize];
+    unsigned int n = 0;
+    while (n < out.size()) {
+      const unsigned int count = source.fill(Span<float32_t>(block, std::min(conversionBlockSize, out.size() - n)));
+      if (count == 0) {
+	break;
+      }
+      fromFloat(block, out.data() + n, count, rshift);
+      n += count;
+    }
+    return n;
+  }
+
+} // namespace
+
+unsigned int Source::fill(Span<float64_t> out) {
+  return fillFloat(*this, out);
+}
+
+unsigned int Source::fill(Span<float32_t> out) {
+  return fillFloat(*this, out);
+}
+
+unsigned int Source::fill(Span<q31_t> out, unsigned int rshift) {
+  return fillFixed(*this, out, rshift);
+}
+
+unsigned int Source::fill(Span<q15_t> out, unsigned int rshift) {
+  return fillFixed(*this, out, rshift);
+}
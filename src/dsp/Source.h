@@ -4,6 +4,27 @@
 #ifndef PICO_CMSIS_SANDBOX_SOURCE_INCLUDED
 #define PICO_CMSIS_SANDBOX_SOURCE_INCLUDED
 
+#include "Span.h"
+
+#include "arm_math.h"
+
+/**
+A source of samples, e.g. a test signal or filter coefficients.
+
+Samples are read one at a time with next(), or a block at a time with
+fill(). fill() writes the next samples straight into a span of the
+target type, with no per sample virtual call or bounds check. On the
+RP2040, where doubles are soft float, the per sample path costs more
+than many of the kernels under test.
+
+The floating point fill() defaults read next() and are overridden by
+sources that can generate a block natively. The fixed point fill()
+converts the float32_t samples a block at a time, and right shifts
+them by rshift bits in the same pass, with
+convertFloat32ToQ{31,15} (see CmsisTypeFactory.h), the same values as
+arm_float_to_q{31,15} (truncated and saturated) of the float32_t
+samples.
+*/
 class Source {
  public:
 
@@ -16,6 +37,14 @@ class Source {
   virtual void reset() = 0;
 
   virtual double next() = 0;
+
+  // Write the next samples to out, at most out.size() samples and at
+  // most the remaining samples, fixed point samples right shifted by
+  // rshift bits. Returns the number of samples written.
+  virtual unsigned int fill(Span<float64_t> out);
+  virtual unsigned int fill(Span<float32_t> out);
+  virtual unsigned int fill(Span<q31_t> out, unsigned int rshift = 0);
+  virtual unsigned int fill(Span<q15_t> out, unsigned int rshift = 0);
 };
 
 #endif
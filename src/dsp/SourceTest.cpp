@@ -0,0 +1,256 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "SourceTest.h"
+
+#include "Source.h"
+#include "Generator.h"
+#include "CmsisTypeFactory.h"
+#include "Ex.h"
+
+#include "Platform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+
+namespace {
+
+  // Read the source one sample at a time, the way CmsisTypeFactory
+  // converted sources before fill().
+  void readNext(Source& source, std::vector<float64_t>& out) {
+    for (int i = 0; !source.isEnd(); i++) {
+      out.at(i) = source.next();
+    }
+  }
+
+  void readNext(Source& source, std::vector<float32_t>& out) {
+    for (int i = 0; !source.isEnd(); i++) {
+      out.at(i) = source.next();
+    }
+  }
+
+  void readNext(Source& source, std::vector<q31_t>& out) {
+    for (int i = 0; !source.isEnd(); i++) {
+      float s = source.next();
+      out.at(i) = clip_q63_to_q31((q63_t) (s * 2147483648.0f));
+    }
+  }
+
+  void readNext(Source& source, std::vector<q15_t>& out) {
+    std::vector<float32_t> f32(out.size());
+    readNext(source, f32);
+    arm_float_to_q15(f32.data(), out.data(), f32.size());
+  }
+
+  const char* typeName(float64_t) {
+    return "f64";
+  }
+
+  const char* typeName(float32_t) {
+    return "f32";
+  }
+
+  const char* typeName(q31_t) {
+    return "q31";
+  }
+
+  const char* typeName(q15_t) {
+    return "q15";
+  }
+
+  // The largest difference between the paths. Signal fill() computes
+  // the sine with a recurrence, anchored every few samples, that drifts
+  // from std::sin by a few double ulps, and a float32_t sample may
+  // round the other way: 2 ulp of a float32_t in [-1, 1].
+  template <typename T> double tolerance() {
+    return 1e-9;
+  }
+
+  template <> double tolerance<float32_t>() {
+    return 2.4e-7;
+  }
+
+  template <> double tolerance<q31_t>() {
+    return 256.0;
+  }
+
+  template <> double tolerance<q15_t>() {
+    return 1.0;
+  }
+
+  template <typename T> SourceTestResult execute(const std::string& sourceName, const std::function<std::unique_ptr<Source>()>& createSource) {
+    const std::string name = sourceName + "_" + typeName(T());
+
+    auto source = createSource();
+    std::vector<T> expected(source->size());
+    platform::profiling_time_t start = platform::get_profiling_time();
+    readNext(*source, expected);
+    platform::profiling_time_t end = platform::get_profiling_time();
+    unsigned long nextTime = profiling_time_diff(start,end);
+
+    source = createSource();
+    std::vector<T> actual(source->size());
+    start = platform::get_profiling_time();
+    const unsigned int count = source->fill(actual);
+    end = platform::get_profiling_time();
+    unsigned long fillTime = profiling_time_diff(start,end);
+
+    if (count != actual.size() || !source->isEnd()) {
+      printf("FAIL %s fill count %d != %d\n", name.c_str(), count, (unsigned int)actual.size());
+      throw Fail("source fill count error");
+    }
+
+    for (unsigned int i = 0; i < count; i++) {
+      if (std::fabs((double)actual[i] - (double)expected[i]) > tolerance<T>()) {
+	printf("FAIL %s sample %d fill %g != next %g\n", name.c_str(), i, (double)actual[i], (double)expected[i]);
+	throw Fail("source fill sample error");
+      }
+    }
+
+    printf("%s %d samples, next %lu us, fill %lu us\n", name.c_str(), count, nextTime, fillTime);
+
+    return SourceTestResult(name, count, nextTime, fillTime);
+  }
+
+  void toFixed(const float32_t* in, q31_t* out, unsigned int n) {
+    arm_float_to_q31(in, out, n);
+  }
+
+  void toFixed(const float32_t* in, q15_t* out, unsigned int n) {
+    arm_float_to_q15(in, out, n);
+  }
+
+  void convert(const float32_t* in, q31_t* out, unsigned int n, unsigned int rshift) {
+    convertFloat32ToQ31(in, out, n, rshift);
+  }
+
+  void convert(const float32_t* in, q15_t* out, unsigned int n, unsigned int rshift) {
+    convertFloat32ToQ15(in, out, n, rshift);
+  }
+
+  void convert(const uint16_t* in, q31_t* out, unsigned int n, unsigned int rshift) {
+    convertAdc12ToQ31(in, out, n, rshift);
+  }
+
+  void convert(const uint16_t* in, q15_t* out, unsigned int n, unsigned int rshift) {
+    convertAdc12ToQ15(in, out, n, rshift);
+  }
+
+  // The float32_t waveform, or the ADC samples converted to float32_t
+  // as the two pass path would, (adc - 2048) / 2048.
+  const std::vector<float32_t>& toFloat(const std::vector<float32_t>& waveform) {
+    return waveform;
+  }
+
+  std::vector<float32_t> toFloat(const std::vector<uint16_t>& adc) {
+    std::vector<float32_t> f32(adc.size());
+    for (unsigned int i = 0; i < adc.size(); i++) {
+      f32[i] = ((int)(adc[i] & 0xfff) - 2048) / 2048.0f;
+    }
+    return f32;
+  }
+
+  template <typename T, typename In> ConversionTestResult executeConversion(const std::string& name, const std::vector<In>& in, unsigned int rshift) {
+    const unsigned int n = in.size();
+    std::vector<T> expected(n);
+    std::vector<T> actual(n);
+
+    platform::profiling_time_t start = platform::get_profiling_time();
+    {
+      const auto& f32 = toFloat(in);
+      toFixed(f32.data(), expected.data(), n);
+      if (rshift > 0) {
+	std::for_each(expected.begin(), expected.end(), [rshift](T& x) {x = x >> rshift;});
+      }
+    }
+    platform::profiling_time_t end = platform::get_profiling_time();
+    unsigned long twoPassTime = profiling_time_diff(start,end);
+
+    start = platform::get_profiling_time();
+    convert(in.data(), actual.data(), n, rshift);
+    end = platform::get_profiling_time();
+    unsigned long fusedTime = profiling_time_diff(start,end);
+
+    for (unsigned int i = 0; i < n; i++) {
+      if (actual[i] != expected[i]) {
+	printf("FAIL %s sample %d fused %d != two pass %d\n", name.c_str(), i, (int)actual[i], (int)expected[i]);
+	throw Fail("fixed point conversion error");
+      }
+    }
+
+    printf("%s %d samples rshift %d, two pass %lu us, fused %lu us\n", name.c_str(), n, rshift, twoPassTime, fusedTime);
+
+    return ConversionTestResult(name, n, twoPassTime, fusedTime);
+  }
+
+} // namespace
+
+std::vector<SourceTestResult> executeSourceTest(const std::string& name, const std::function<std::unique_ptr<Source>()>& createSource) {
+  return {
+    execute<float64_t>(name, createSource),
+    execute<float32_t>(name, createSource),
+    execute<q31_t>(name, createSource),
+    execute<q15_t>(name, createSource)
+  };
+}
+
+void verifyToneSource(const std::string& name, Source& source, const std::vector<Tone>& tones, double tolerance) {
+  std::vector<float64_t> actual(source.size());
+  source.reset();
+  source.fill(Span<float64_t>(actual));
+  source.reset();
+
+  double error = 0.0;
+  for (unsigned int n = 0; n < actual.size(); n++) {
+    double expected = 0.0;
+    for (const Tone& tone: tones) {
+      expected += tone.amplitude * std::sin(2.0 * M_PI * std::fmod(tone.frequency * n, 1.0));
+    }
+    error = std::max(error, std::fabs(actual[n] - std::clamp(expected, -1.0, 1.0)));
+  }
+
+  printf("%s max error %g\n", name.c_str(), error);
+  if (error > tolerance) {
+    printf("FAIL %s max error %g > %g\n", name.c_str(), error, tolerance);
+    throw Fail("tone source error");
+  }
+}
+
+void verifySourcePeak(const std::string& name, Source& source, double amplitude) {
+  std::vector<float64_t> actual(source.size());
+  source.reset();
+  source.fill(Span<float64_t>(actual));
+  source.reset();
+
+  double peak = 0.0;
+  for (float64_t x: actual) {
+    peak = std::max(peak, std::fabs(x));
+  }
+
+  printf("%s peak %g\n", name.c_str(), peak);
+  if (peak > amplitude || peak == 0.0) {
+    printf("FAIL %s peak %g, amplitude %g\n", name.c_str(), peak, amplitude);
+    throw Fail("source peak error");
+  }
+}
+
+std::vector<ConversionTestResult> executeConversionTest(const std::vector<float32_t>& waveform, unsigned int rshift) {
+  // the saturation and rounding edge cases, then the waveform
+  std::vector<float32_t> f32 = {1.0f, -1.0f, 2.0f, -2.0f, 0.99999994f, -0.99999994f, 0.0f, -0.0f, 1e-40f, -1e-40f, 3.0517578e-05f, -3.0517578e-05f, 4.656613e-10f, -4.656613e-10f};
+  f32.insert(f32.end(), waveform.begin(), waveform.end());
+
+  // the waveform as 12 bit ADC samples, the full ADC range then the
+  // waveform
+  std::vector<uint16_t> adc = {0, 1, 2047, 2048, 2049, 4095, 0xf000};
+  for (float32_t x: waveform) {
+    adc.push_back((uint16_t)std::clamp((int)std::lround(2048.0f + 2047.0f * x), 0, 4095));
+  }
+
+  return {
+    executeConversion<q31_t>("f32_to_q31", f32, rshift),
+    executeConversion<q15_t>("f32_to_q15", f32, rshift),
+    executeConversion<q31_t>("adc12_to_q31", adc, rshift),
+    executeConversion<q15_t>("adc12_to_q15", adc, rshift)
+  };
+}
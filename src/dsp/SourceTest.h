@@ -0,0 +1,79 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_SOURCETEST_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_SOURCETEST_H_INCLUDED
+
+#include "arm_math.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Source;
+struct Tone;
+
+struct SourceTestResult {
+  // the source name and data type, e.g. signal_q15
+  const std::string name;
+
+  const unsigned int numSamples;
+
+  // elapsed time (us) of the per sample and the block path
+  const unsigned long nextTime;
+  const unsigned long fillTime;
+
+  SourceTestResult(const std::string& name, unsigned int numSamples, unsigned long nextTime, unsigned long fillTime)
+    : name(name),
+      numSamples(numSamples),
+      nextTime(nextTime),
+      fillTime(fillTime)
+  {}
+};
+
+// Profile the preparation of a waveform of each data type (f64, f32,
+// q31 and q15) from a source, one sample at a time with next() and a
+// bounds checked write, and with a single fill(). Every pass reads a
+// new source from createSource, so sources with noise produce the same
+// samples on both paths. The two waveforms must be the same within
+// rounding (see SourceTest.cpp). Throws Fail if not.
+std::vector<SourceTestResult> executeSourceTest(const std::string& name, const std::function<std::unique_ptr<Source>()>& createSource);
+
+// Verify a tone generator (see Generator.h) against the double
+// precision sum of the tones' sines, within tolerance (full scale
+// 1.0). Throws Fail if not.
+void verifyToneSource(const std::string& name, Source& source, const std::vector<Tone>& tones, double tolerance);
+
+// Verify that the source peak |x| is at most amplitude and that the
+// source is not silent. Throws Fail if not.
+void verifySourcePeak(const std::string& name, Source& source, double amplitude);
+
+struct ConversionTestResult {
+  // the conversion name, e.g. f32_to_q15
+  const std::string name;
+
+  const unsigned int numSamples;
+
+  // elapsed time (us) of the conversion followed by a right shift
+  // pass, and of the fused conversion
+  const unsigned long twoPassTime;
+  const unsigned long fusedTime;
+
+  ConversionTestResult(const std::string& name, unsigned int numSamples, unsigned long twoPassTime, unsigned long fusedTime)
+    : name(name),
+      numSamples(numSamples),
+      twoPassTime(twoPassTime),
+      fusedTime(fusedTime)
+  {}
+};
+
+// Profile the conversion of the float32_t waveform to q31 and q15 and
+// right shift by rshift bits, arm_float_to_q{31,15} followed by a
+// shift pass against convertFloat32ToQ{31,15}. Also profile the
+// conversion of the waveform as 12 bit ADC samples, via float32_t
+// against convertAdc12ToQ{31,15}. The outputs must be the same.
+// Throws Fail if not.
+std::vector<ConversionTestResult> executeConversionTest(const std::vector<float32_t>& waveform, unsigned int rshift);
+
+#endif
@@ -0,0 +1,106 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "SourceTestRunner.h"
+
+#include "SourceTest.h"
+#include "Signal.h"
+#include "Generator.h"
+#include "FirSource.h"
+#include "DecimateFIR.h"
+#include "CmsisTypeFactory.h"
+
+#include <vector>
+
+using namespace source;
+
+namespace {
+
+  class SourceTestRunner {
+
+    // the largest fft test waveform
+    const unsigned int waveformSize = 8192;
+
+    // the longest fast FIR test filter
+    const unsigned int M = 4;
+    const unsigned int numTaps = 255;
+
+    // generator test tones, the test signal's frequency (k = 2), and
+    // three tones summing to 0.9 of full scale
+    const std::vector<Tone> tone = {{0.25, 1.0}};
+    const std::vector<Tone> multitone = {{0.05, 0.4}, {0.1234, 0.3}, {0.3, 0.2}};
+
+    // generator tone accuracy, full scale 1.0
+    const double toneTolerance = 1e-5;
+
+    const uint32_t noiseSeed = 12345;
+
+    // the fast FIR and decimation test scaling
+    const unsigned int rshift = 1;
+
+    std::unique_ptr<Results> results = std::make_unique<Results>();
+
+    void run(const std::string& name, const std::function<std::unique_ptr<Source>()>& createSource) {
+      for (const SourceTestResult& result: executeSourceTest(name, createSource)) {
+	Measurement& measurement = results->prepTime[result.name];
+	measurement.numSamples = result.numSamples;
+	measurement.nextTime = result.nextTime;
+	measurement.fillTime = result.fillTime;
+      }
+    }
+
+  public:
+
+    std::unique_ptr<Results> runAll() {
+      printf("\nwaveform preparation, signal size %d, filter size %d\n", waveformSize, numTaps);
+
+      run("signal", [this]() { return std::make_unique<Signal>(waveformSize, 2.0, false); });
+      run("noisy_signal", [this]() { return std::make_unique<Signal>(waveformSize, 2.0, true); });
+      run("fir", [this]() { return createFirSource(getDecimationFIR(M, numTaps)); });
+
+      // The NCO and noise generators, the tones are verified against
+      // double precision sines, and the others against their amplitude.
+      auto toneSource = [this]() { return createMultitoneSource(waveformSize, tone); };
+      auto multitoneSource = [this]() { return createMultitoneSource(waveformSize, multitone); };
+      auto linearChirpSource = [this]() { return createChirpSource(waveformSize, 0.001, 0.45, ChirpSweep::LINEAR, 0.9); };
+      auto logChirpSource = [this]() { return createChirpSource(waveformSize, 0.001, 0.45, ChirpSweep::LOG, 0.9); };
+      auto impulseSource = [this]() { return createImpulseSource(waveformSize, 256, 0.9); };
+      auto whiteNoiseSource = [this]() { return createNoiseSource(waveformSize, NoiseColor::WHITE, 0.9, noiseSeed); };
+      auto pinkNoiseSource = [this]() { return createNoiseSource(waveformSize, NoiseColor::PINK, 0.9, noiseSeed); };
+
+      verifyToneSource("nco_tone", *toneSource(), tone, toneTolerance);
+      verifyToneSource("nco_multitone", *multitoneSource(), multitone, toneTolerance);
+      verifySourcePeak("chirp_linear", *linearChirpSource(), 0.9);
+      verifySourcePeak("chirp_log", *logChirpSource(), 0.9);
+      verifySourcePeak("impulse", *impulseSource(), 0.9);
+      verifySourcePeak("white_noise", *whiteNoiseSource(), 0.9);
+      verifySourcePeak("pink_noise", *pinkNoiseSource(), 0.9);
+
+      run("nco_tone", toneSource);
+      run("nco_multitone", multitoneSource);
+      run("chirp_linear", linearChirpSource);
+      run("chirp_log", logChirpSource);
+      run("impulse", impulseSource);
+      run("white_noise", whiteNoiseSource);
+      run("pink_noise", pinkNoiseSource);
+
+      printf("\nfixed point conversion, signal size %d, rshift %d\n", waveformSize, rshift);
+
+      CmsisTypeFactory signalFactory(std::make_unique<Signal>(waveformSize, 2.0, true));
+      results->conversionShift = rshift;
+      for (const ConversionTestResult& result: executeConversionTest(*signalFactory.toFloat32(), rshift)) {
+	ConversionMeasurement& measurement = results->conversionTime[result.name];
+	measurement.numSamples = result.numSamples;
+	measurement.twoPassTime = result.twoPassTime;
+	measurement.fusedTime = result.fusedTime;
+      }
+
+      return std::move(results);
+    }
+  };
+
+} // namespace
+
+std::unique_ptr<Results> runAllSourceTests() {
+  return SourceTestRunner().runAll();
+}
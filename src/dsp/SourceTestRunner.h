@@ -0,0 +1,46 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_SOURCETESTRUNNER_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_SOURCETESTRUNNER_H_INCLUDED
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace source {
+  struct Measurement {
+    unsigned int numSamples;
+
+    // elapsed time in us, per sample next() and block fill()
+    unsigned long nextTime;
+    unsigned long fillTime;
+  };
+
+  // map source and data type name to measurement
+  typedef std::map<std::string, Measurement> NameToMeasurementMap;
+
+  struct ConversionMeasurement {
+    unsigned int numSamples;
+
+    // elapsed time in us, conversion then right shift, and fused
+    unsigned long twoPassTime;
+    unsigned long fusedTime;
+  };
+
+  // map conversion name to measurement
+  typedef std::map<std::string, ConversionMeasurement> NameToConversionMeasurementMap;
+
+  struct Results {
+    // waveform preparation time
+    NameToMeasurementMap prepTime;
+
+    // fixed point conversion time, and its right shift
+    NameToConversionMeasurementMap conversionTime;
+    unsigned int conversionShift = 0;
+  };
+}
+
+std::unique_ptr<source::Results> runAllSourceTests();
+
+#endif
@@ -0,0 +1,89 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_SPAN_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_SPAN_H_INCLUDED
+
+#include "Ex.h"
+
+#include <type_traits>
+#include <vector>
+
+/**
+A non-owning view of size contiguous T values, e.g. a DMA buffer. A
+minimal stand-in for C++20 std::span (the project is C++17). Span<T>
+converts to Span<const T>.
+*/
+template <typename T> class Span {
+
+  T* ptr;
+  unsigned int length;
+
+ public:
+
+  Span()
+    : ptr(nullptr),
+      length(0)
+  {}
+
+  Span(T* data, unsigned int size)
+    : ptr(data),
+      length(size)
+  {}
+
+  // view a vector (the vector must outlive the span and not be
+  // resized)
+  template <typename U, typename = std::enable_if_t<std::is_same_v<std::remove_const_t<T>, U>>>
+  Span(std::vector<U>& v)
+    : ptr(v.data()),
+      length(v.size())
+  {}
+
+  template <typename U, typename = std::enable_if_t<std::is_const_v<T> && std::is_same_v<std::remove_const_t<T>, U>>>
+  Span(const std::vector<U>& v)
+    : ptr(v.data()),
+      length(v.size())
+  {}
+
+  // Span<U> to Span<const U>
+  template <typename U, typename = std::enable_if_t<std::is_const_v<T> && std::is_same_v<std::remove_const_t<T>, U>>>
+  Span(const Span<U>& other)
+    : ptr(other.data()),
+      length(other.size())
+  {}
+
+  T* data() const {
+    return ptr;
+  }
+
+  unsigned int size() const {
+    return length;
+  }
+
+  bool empty() const {
+    return length == 0;
+  }
+
+  T* begin() const {
+    return ptr;
+  }
+
+  T* end() const {
+    return ptr + length;
+  }
+
+  // unchecked, as std::span
+  T& operator[](unsigned int i) const {
+    return ptr[i];
+  }
+
+  // The count values starting at offset. Throws Ex if out of range.
+  Span<T> subspan(unsigned int offset, unsigned int count) const {
+    if (offset > length || count > length - offset) {
+      throw Ex("span range error");
+    }
+    return Span<T>(ptr + offset, count);
+  }
+};
+
+#endif
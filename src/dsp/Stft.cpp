@@ -0,0 +1,183 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "Stft.h"
+
+#include "FftPlan.h"
+#include "Instrument.h"
+#include "SegmentBuffer.h"
+#include "WindowFunction.h"
+#include "Ex.h"
+
+#include <vector>
+
+namespace {
+
+  template <typename T> class CmsisStft : public Stft<T> {
+
+    CmsisStft();
+
+    // the implementation name
+    const std::string name;
+
+    const unsigned int fftSize;
+
+    // the last fftSize input samples and the window
+    SegmentBuffer<T> buffer;
+
+  protected:
+
+    // the windowed frame, the fft input (modified by the fft)
+    std::vector<T> frame;
+
+    // the fft output, fftSize values for arm_rfft_fast_f32 and
+    // 2*fftSize values for arm_rfft_q{15,31}
+    std::vector<T> fft;
+
+    // the cached forward fft plan (owned by the plan registry)
+    FftPlan<T>& plan;
+
+    CmsisStft(const char* name, const WindowFunction& windowFunction, unsigned int hopSize, unsigned int fftOutputWidth)
+      : name(name),
+	fftSize(windowFunction.getWindow().size()),
+	buffer(windowFunction, hopSize),
+	frame(fftSize),
+	fft(fftSize * fftOutputWidth),
+	plan(getFftPlan<T>(fftSize, FftDirection::FORWARD))
+    {
+      if (hopSize == 0 || hopSize > fftSize) {
+	throw Ex("stft " + this->name + " invalid hop size");
+      }
+    }
+
+    // Transform the frame buffer and write fftSize/2 magnitudes to
+    // out.
+    virtual void transform(T* out) = 0;
+
+  private:
+
+    // Window the ring buffer (oldest sample first) into the frame
+    // buffer, and transform it.
+    void emitFrame(T* out) {
+      buffer.windowSegment(frame.data());
+      transform(out);
+      instrument::recordOutput("stft", name, fft.data(), fft.size());
+    }
+
+  public:
+
+    virtual const std::string& getName() const {
+      return name;
+    }
+
+    virtual unsigned int getFftSize() const {
+      return fftSize;
+    }
+
+    virtual unsigned int getHopSize() const {
+      return buffer.getHopSize();
+    }
+
+    virtual unsigned int getFrameSize() const {
+      return fftSize / 2;
+    }
+
+    virtual unsigned int getNumFrames(unsigned int numSamples) const {
+      return buffer.getNumSegments(numSamples);
+    }
+
+    virtual unsigned int process(const T* in, unsigned int numSamples, T* frames) {
+      unsigned int numFrames = 0;
+
+      instrument::recordInput("stft", name, in, numSamples);
+
+      while (numSamples > 0) {
+	const unsigned int n = buffer.write(in, numSamples);
+	in += n;
+	numSamples -= n;
+
+	if (buffer.isSegmentReady()) {
+	  emitFrame(frames + numFrames * getFrameSize());
+	  numFrames++;
+	}
+      }
+
+      return numFrames;
+    }
+
+    virtual void reset() {
+      buffer.reset();
+    }
+  };
+
+  class Float32Stft : public CmsisStft<float32_t> {
+
+    Float32Stft();
+
+  public:
+
+    Float32Stft(const WindowFunction& window, unsigned int hopSize)
+      : CmsisStft<float32_t>("f32_stft", window, hopSize, 1)
+    {}
+
+  protected:
+
+    virtual void transform(float32_t* out) {
+      arm_rfft_fast_f32(&plan.getInstance(), frame.data(), fft.data(), plan.getIfftFlag());
+
+      // drop the Nyquist component packed in with the DC component
+      fft[1] = 0.0f;
+
+      arm_cmplx_mag_f32(fft.data(), out, getFrameSize());
+    }
+  };
+
+  class Q15Stft : public CmsisStft<q15_t> {
+
+    Q15Stft();
+
+  public:
+
+    Q15Stft(const WindowFunction& window, unsigned int hopSize)
+      : CmsisStft<q15_t>("q15_stft", window, hopSize, 2)
+    {}
+
+  protected:
+
+    virtual void transform(q15_t* out) {
+      arm_rfft_q15(&plan.getInstance(), frame.data(), fft.data());
+      arm_cmplx_mag_q15(fft.data(), out, getFrameSize());
+    }
+  };
+
+  class Q31Stft : public CmsisStft<q31_t> {
+
+    Q31Stft();
+
+  public:
+
+    Q31Stft(const WindowFunction& window, unsigned int hopSize)
+      : CmsisStft<q31_t>("q31_stft", window, hopSize, 2)
+    {}
+
+  protected:
+
+    virtual void transform(q31_t* out) {
+      arm_rfft_q31(&plan.getInstance(), frame.data(), fft.data());
+      arm_cmplx_mag_q31(fft.data(), out, getFrameSize());
+    }
+  };
+
+} // namespace
+
+std::unique_ptr<Stft<float32_t>> createFloat32Stft(const WindowFunction& window, unsigned int hopSize) {
+  return std::unique_ptr<Stft<float32_t>>(new Float32Stft(window, hopSize));
+}
+
+std::unique_ptr<Stft<q15_t>> createQ15Stft(const WindowFunction& window, unsigned int hopSize) {
+  return std::unique_ptr<Stft<q15_t>>(new Q15Stft(window, hopSize));
+}
+
+std::unique_ptr<Stft<q31_t>> createQ31Stft(const WindowFunction& window, unsigned int hopSize) {
+  return std::unique_ptr<Stft<q31_t>>(new Q31Stft(window, hopSize));
+}
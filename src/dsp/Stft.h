@@ -0,0 +1,71 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_STFT_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_STFT_H_INCLUDED
+
+#include "arm_math.h"
+
+#include <memory>
+#include <string>
+
+class WindowFunction;
+
+/**
+Streaming short-time Fourier transform (spectrogram).
+
+Input samples of any block size are written to a ring buffer of the
+last fftSize samples. Once the ring buffer is full, and then every
+hopSize samples, a frame is emitted: the ring buffer is multiplied by
+the window into the fft input buffer, transformed with the cached real
+fft plan (see FftPlan.h), and the magnitude of bins 0 to fftSize/2-1
+is written to the caller's frame storage. All buffers are allocated
+at construction, process() does not allocate.
+
+A hop of fftSize/2 is 50% overlap, fftSize/4 is 75% overlap.
+
+The magnitude frames have the same scaling as the FFT class
+magnitudes. The floating point magnitudes are the arm_cmplx_mag_f32
+output, the DC bin excludes the Nyquist component that
+arm_rfft_fast_f32 packs with it. The fixed point magnitudes are the
+arm_cmplx_mag_q{15,31} output of arm_rfft_q{15,31}, i.e. fixed point
+Qm.n where m = 2 + log2(fftSize) (see CmsisFft.cpp).
+*/
+template <typename T> class Stft {
+ public:
+
+  virtual ~Stft() {}
+
+  // the name of the stft implementation
+  virtual const std::string& getName() const = 0;
+
+  virtual unsigned int getFftSize() const = 0;
+
+  virtual unsigned int getHopSize() const = 0;
+
+  // The number of magnitude values per frame (fftSize/2).
+  virtual unsigned int getFrameSize() const = 0;
+
+  // The number of frames the next process() call will emit for
+  // numSamples input samples.
+  virtual unsigned int getNumFrames(unsigned int numSamples) const = 0;
+
+  // Consume numSamples input samples. The frames buffer must have room
+  // for getNumFrames(numSamples) * getFrameSize() values. Returns the
+  // number of frames written to frames.
+  virtual unsigned int process(const T* in, unsigned int numSamples, T* frames) = 0;
+
+  // Clear the ring buffer, the next frame is emitted after fftSize
+  // samples.
+  virtual void reset() = 0;
+};
+
+// Create streaming STFTs. The window length must be fftSize, and 0 <
+// hopSize <= fftSize. The fftSize must be a supported arm_rfft_fast_f32
+// or arm_rfft_q{15,31} length. The fixed point window is the window
+// rounded to T (saturated at 1.0).
+std::unique_ptr<Stft<float32_t>> createFloat32Stft(const WindowFunction& window, unsigned int hopSize);
+std::unique_ptr<Stft<q15_t>> createQ15Stft(const WindowFunction& window, unsigned int hopSize);
+std::unique_ptr<Stft<q31_t>> createQ31Stft(const WindowFunction& window, unsigned int hopSize);
+
+#endif
@@ -0,0 +1,95 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "StftTest.h"
+
+#include "Stft.h"
+#include "StreamTest.h"
+#include "Ex.h"
+
+#include "Platform.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdio.h>
+
+namespace {
+
+  template <typename T> StftTestResult executeTest(unsigned int expectedBin, Stft<T>& stft, const std::vector<T>& waveform, unsigned int blockSize) {
+    stft.reset();
+
+    const unsigned int frameSize = stft.getFrameSize();
+    const unsigned int expectedNumFrames = stft.getNumFrames(waveform.size());
+    std::vector<T> frames(expectedNumFrames * frameSize);
+
+    platform::profiling_time_t start = platform::get_profiling_time();
+    unsigned int numFrames = 0;
+    for (unsigned int n = 0; n < waveform.size(); n += blockSize) {
+      unsigned int numSamples = std::min(blockSize, (unsigned int)waveform.size() - n);
+      numFrames += stft.process(waveform.data() + n, numSamples, frames.data() + numFrames * frameSize);
+    }
+    platform::profiling_time_t end = platform::get_profiling_time();
+    unsigned long elapsedTime = profiling_time_diff(start,end);
+
+    if (numFrames != expectedNumFrames) {
+      printf("FAIL %s numFrames != expectedNumFrames (%d != %d)\n", stft.getName().c_str(), numFrames, expectedNumFrames);
+      throw Fail("numFrames != expectedNumFrames");
+    }
+
+    for (unsigned int i = 0; i < numFrames; i++) {
+      auto frame = frames.cbegin() + i * frameSize;
+      unsigned int actualBin = std::distance(frame, std::max_element(frame, frame + frameSize));
+      if (actualBin != expectedBin) {
+	printf("FAIL %s frame %d actualBin != expectedBin (%d != %d)\n", stft.getName().c_str(), i, actualBin, expectedBin);
+	throw Fail("actualBin != expectedBin");
+      }
+    }
+
+    printf("%s fft size %d hop %d, %d frames %lu us\n", stft.getName().c_str(), stft.getFftSize(), stft.getHopSize(), numFrames, elapsedTime);
+
+    return StftTestResult(stft.getName(), waveform.size(), numFrames, elapsedTime);
+  }
+
+  template <typename T> void verifyStream(Stft<T>& stft, const std::vector<T>& waveform) {
+    const unsigned int frameSize = stft.getFrameSize();
+
+    stft.reset();
+    std::vector<T> expected(stft.getNumFrames(waveform.size()) * frameSize);
+    unsigned int expectedNumFrames = stft.process(waveform.data(), waveform.size(), expected.data());
+
+    stft.reset();
+    std::vector<T> actual(expected.size());
+    const unsigned int actualNumFrames = processInBlocks(waveform.size(), [&](unsigned int n, unsigned int blockSize, unsigned int numFrames) {
+      return stft.process(waveform.data() + n, blockSize, actual.data() + numFrames * frameSize);
+    });
+
+    verifySameOutput(stft.getName(), "stream frames", actualNumFrames * frameSize, actual.data(), expectedNumFrames * frameSize, expected);
+
+    stft.reset();
+  }
+
+} // namespace
+
+StftTestResult executeStftTest(unsigned int expectedBin, Stft<float32_t>& stft, const std::vector<float32_t>& waveform, unsigned int blockSize) {
+  return executeTest(expectedBin, stft, waveform, blockSize);
+}
+
+StftTestResult executeStftTest(unsigned int expectedBin, Stft<q15_t>& stft, const std::vector<q15_t>& waveform, unsigned int blockSize) {
+  return executeTest(expectedBin, stft, waveform, blockSize);
+}
+
+StftTestResult executeStftTest(unsigned int expectedBin, Stft<q31_t>& stft, const std::vector<q31_t>& waveform, unsigned int blockSize) {
+  return executeTest(expectedBin, stft, waveform, blockSize);
+}
+
+void verifyStftStream(Stft<float32_t>& stft, const std::vector<float32_t>& waveform) {
+  verifyStream(stft, waveform);
+}
+
+void verifyStftStream(Stft<q15_t>& stft, const std::vector<q15_t>& waveform) {
+  verifyStream(stft, waveform);
+}
+
+void verifyStftStream(Stft<q31_t>& stft, const std::vector<q31_t>& waveform) {
+  verifyStream(stft, waveform);
+}
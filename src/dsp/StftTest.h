@@ -0,0 +1,42 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_STFTTEST_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_STFTTEST_H_INCLUDED
+
+#include "arm_math.h"
+
+#include <string>
+#include <vector>
+
+template <typename T> class Stft;
+
+struct StftTestResult {
+  const std::string name;
+  const unsigned int numSamples;
+  const unsigned int numFrames;
+  const unsigned long elapsedTime;
+
+  StftTestResult(const std::string& name, unsigned int numSamples, unsigned int numFrames, unsigned long elapsedTime)
+    :name(name),
+     numSamples(numSamples),
+     numFrames(numFrames),
+     elapsedTime(elapsedTime)
+  {}
+};
+
+// Profile the stft processing the waveform in blockSize sample blocks
+// into a frame buffer sized for the whole waveform, then verify that
+// the peak of every frame is at expectedBin. Throws Fail if not.
+StftTestResult executeStftTest(unsigned int expectedBin, Stft<float32_t>& stft, const std::vector<float32_t>& waveform, unsigned int blockSize);
+StftTestResult executeStftTest(unsigned int expectedBin, Stft<q15_t>& stft, const std::vector<q15_t>& waveform, unsigned int blockSize);
+StftTestResult executeStftTest(unsigned int expectedBin, Stft<q31_t>& stft, const std::vector<q31_t>& waveform, unsigned int blockSize);
+
+// Verify that the stft, fed the waveform in irregular block sizes,
+// produces bit for bit the same frames as when fed the whole waveform
+// in one block. Throws Fail if not.
+void verifyStftStream(Stft<float32_t>& stft, const std::vector<float32_t>& waveform);
+void verifyStftStream(Stft<q15_t>& stft, const std::vector<q15_t>& waveform);
+void verifyStftStream(Stft<q31_t>& stft, const std::vector<q31_t>& waveform);
+
+#endif
@@ -0,0 +1,84 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "StftTestRunner.h"
+
+#include "StftTest.h"
+#include "Stft.h"
+#include "CmsisTypeFactory.h"
+#include "WindowFunction.h"
+#include "Signal.h"
+
+#include <vector>
+
+using namespace stft;
+
+namespace {
+
+  class StftTestRunner {
+
+    const std::vector<unsigned int> fftSizes = {256, 512, 1024, 2048};
+
+    // Hop sizes as fft size divisors, 50% and 75% overlap.
+    const std::vector<unsigned int> hopDivisors = {2, 4};
+
+    const unsigned int waveformSize = 4096;
+
+    // Streaming input block size, e.g. an ADC DMA block.
+    const unsigned int streamBlockSize = 64;
+
+    // The real-time headroom is computed for the RP2040 ADC maximum
+    // sample rate.
+    const double sampleRate = 500000.0;
+
+    // The test signal is sin(n*M_PI/k), it's centered on fft bin
+    // fftSize/(2*k) for all fft sizes.
+    const unsigned int k = 8;
+
+    std::unique_ptr<Results> results = std::make_unique<Results>();
+
+    void addResult(unsigned int fftSize, unsigned int hopSize, const StftTestResult& result) {
+      Timing& timing = results->timing[result.name][Shape(fftSize, hopSize)];
+      timing.numSamples = result.numSamples;
+      timing.numFrames = result.numFrames;
+      timing.elapsedTime = result.elapsedTime;
+    }
+
+    // Verify the stft in irregular blocks, then profile it processing
+    // the waveform in streamBlockSize blocks.
+    template <typename T> void runStft(unsigned int fftSize, unsigned int hopSize, Stft<T>& stft, const std::vector<T>& waveform) {
+      verifyStftStream(stft, waveform);
+      addResult( fftSize, hopSize, executeStftTest(fftSize / (2*k), stft, waveform, streamBlockSize) );
+    }
+
+    void run(unsigned int fftSize, unsigned int hopSize) {
+      printf("\nstft waveform size %d, fft size %d, hop size %d\n", waveformSize, fftSize, hopSize);
+
+      auto hanning = createHanningWindow(fftSize);
+      CmsisTypeFactory signalFactory(std::make_unique<Signal>(waveformSize, (double)k, false));
+
+      runStft(fftSize, hopSize, *createFloat32Stft(*hanning, hopSize), *signalFactory.toFloat32());
+      runStft(fftSize, hopSize, *createQ31Stft(*hanning, hopSize), *signalFactory.toQ31());
+      runStft(fftSize, hopSize, *createQ15Stft(*hanning, hopSize), *signalFactory.toQ15());
+    }
+
+  public:
+
+    std::unique_ptr<Results> runAll() {
+      results->sampleRate = sampleRate;
+
+      for (unsigned int fftSize: fftSizes) {
+	for (unsigned int hopDivisor: hopDivisors) {
+	  run(fftSize, fftSize / hopDivisor);
+	}
+      }
+
+      return std::move(results);
+    }
+  };
+
+} // namespace
+
+std::unique_ptr<Results> runAllStftTests() {
+  return StftTestRunner().runAll();
+}
@@ -0,0 +1,41 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_STFTTESTRUNNER_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_STFTTESTRUNNER_H_INCLUDED
+
+#include <memory>
+#include <map>
+#include <string>
+#include <utility>
+
+namespace stft {
+  struct Timing {
+    unsigned int numSamples;
+    unsigned int numFrames;
+
+    // elapsed time in us
+    unsigned long elapsedTime;
+  };
+
+  // fft size and hop size
+  typedef std::pair<unsigned int, unsigned int> Shape;
+
+  // map stft shape to timing
+  typedef std::map<Shape, Timing> ShapeToTimingMap;
+
+  // map stft name to shape map
+  typedef std::map<std::string, ShapeToTimingMap> NameToShapeTimingMap;
+
+  struct Results {
+    // The input sample rate (samples per second) the real-time
+    // headroom is computed for.
+    double sampleRate = 0.0;
+
+    NameToShapeTimingMap timing;
+  };
+}
+
+std::unique_ptr<stft::Results> runAllStftTests();
+
+#endif
@@ -0,0 +1,70 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_STREAMTEST_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_STREAMTEST_H_INCLUDED
+
+#include "Ex.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/**
+The block size independence check shared by the streaming stage tests
+(decimation, resampling, STFT): a stream fed the waveform in
+irregular blocks must produce bit for bit the output of one block.
+*/
+
+// Block sizes chosen to split decimation groups, polyphase branch
+// sequences, frames and hops at varying offsets.
+const unsigned int streamBlockSizes[] = {1, 7, 61, 2, 200, 13, 64, 3};
+
+// Feed numSamples input samples in the streamBlockSizes blocks, in
+// turn, to process(offset, blockSize, numOutputs), which returns the
+// number of outputs of the block. Returns the total number of outputs.
+template <typename Process> unsigned int processInBlocks(unsigned int numSamples, Process process) {
+  unsigned int numOutputs = 0;
+  unsigned int n = 0;
+  for (unsigned int i = 0; n < numSamples; i++) {
+    const unsigned int blockSize = std::min(streamBlockSizes[i % std::size(streamBlockSizes)], numSamples - n);
+    numOutputs += process(n, blockSize, numOutputs);
+    n += blockSize;
+  }
+  return numOutputs;
+}
+
+// Throws Fail if the actual output (what, e.g. "stream result") is not
+// the same size and values as the single block output.
+template <typename T> void verifySameOutput(const std::string& name, const char* what, unsigned int actualSize, const T* actual, unsigned int expectedSize, const std::vector<T>& expected) {
+  if ( actualSize != expectedSize || !std::equal(expected.cbegin(), expected.cend(), actual) ) {
+    printf("FAIL %s %s differs from single block result\n", name.c_str(), what);
+    throw Fail(std::string(what) + " != single block result");
+  }
+}
+
+// Verify a stream with the process(in, numSamples, out) and
+// getOutputSize(numSamples) interface against the reference stream
+// processing the whole waveform in one block. Both are reset before
+// and after.
+template <typename Stream, typename T> void verifyStreamBlocks(Stream& stream, Stream& reference, const std::vector<T>& waveform) {
+  stream.reset();
+  reference.reset();
+
+  std::vector<T> expected(reference.getOutputSize(waveform.size()));
+  const unsigned int expectedSize = reference.process(waveform.data(), waveform.size(), expected.data());
+
+  std::vector<T> actual(stream.getOutputSize(waveform.size()));
+  const unsigned int actualSize = processInBlocks(waveform.size(), [&](unsigned int n, unsigned int blockSize, unsigned int numOutputs) {
+    return stream.process(waveform.data() + n, blockSize, actual.data() + numOutputs);
+  });
+
+  verifySameOutput(stream.getName(), "stream result", actualSize, actual.data(), expectedSize, expected);
+
+  stream.reset();
+  reference.reset();
+}
+
+#endif
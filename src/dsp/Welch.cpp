@@ -0,0 +1,263 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "Welch.h"
+
+#include "CmsisFft.h"
+#include "Instrument.h"
+#include "SegmentBuffer.h"
+#include "WindowFunction.h"
+#include "Ex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+  // Map the data type to its power accumulator type, q63 for q15 and
+  // q31.
+  template <typename T> struct WelchAccumulator { typedef T type; };
+  template <> struct WelchAccumulator<q15_t> { typedef q63_t type; };
+  template <> struct WelchAccumulator<q31_t> { typedef q63_t type; };
+
+  // The accumulator guard bits, the power shift that keeps the sum of
+  // averageCount powers within q63. The q15 power is at most 2^31, it
+  // sums unshifted for any averageCount. The q31 power is at most 2^63,
+  // it needs log2(averageCount) + 1 bits.
+  template <typename T> unsigned int guardBits(unsigned int averageCount);
+
+  template <> unsigned int guardBits<q15_t>(unsigned int) {
+    return 0;
+  }
+
+  template <> unsigned int guardBits<q31_t>(unsigned int averageCount) {
+    unsigned int bits = 1;
+    while ((1u << (bits - 1)) < averageCount) {
+      bits++;
+    }
+    return bits;
+  }
+
+  template <typename T> class CmsisWelch : public Welch<T> {
+
+    CmsisWelch();
+
+  protected:
+
+    typedef typename WelchAccumulator<T>::type Accumulator;
+
+    // the implementation name
+    const std::string name;
+
+    const unsigned int segmentSize;
+
+    const unsigned int averageCount;
+
+    // the last segmentSize input samples and the window
+    SegmentBuffer<T> buffer;
+
+    // the windowed segment, the fft input (modified by the fft)
+    std::vector<T> segment;
+
+    // the fft output
+    std::vector<T> spectrum;
+
+    // the power sum of each bin
+    std::vector<Accumulator> accumulator;
+
+    unsigned int numSegments = 0;
+
+    std::unique_ptr<SpanFft<T>> fft;
+
+    CmsisWelch(const char* name, const WindowFunction& windowFunction, unsigned int overlap, unsigned int averageCount, std::unique_ptr<SpanFft<T>> fft)
+      : name(name),
+	segmentSize(windowFunction.getWindow().size()),
+	averageCount(averageCount),
+	buffer(windowFunction, segmentSize - overlap),
+	segment(segmentSize),
+	spectrum(fft->getSpectrumSize()),
+	accumulator(segmentSize / 2),
+	fft(std::move(fft))
+    {
+      if (overlap >= segmentSize) {
+	throw Ex("welch " + this->name + " invalid overlap");
+      }
+      if (averageCount == 0) {
+	throw Ex("welch " + this->name + " invalid average count");
+      }
+    }
+
+    // Add the power of each bin of the spectrum to the accumulator.
+    virtual void accumulate() = 0;
+
+    // The normalized (floating point fft scale) power of an
+    // accumulator value, before the average and window power division.
+    virtual double toPower(Accumulator sum) const = 0;
+
+  private:
+
+    // Window the ring buffer (oldest sample first) into the segment
+    // buffer, transform it, and add it to the average.
+    void addSegment() {
+      buffer.windowSegment(segment.data());
+
+      fft->spectrum(segment, spectrum);
+      instrument::recordOutput("welch", name, spectrum.data(), spectrum.size());
+
+      if (numSegments == averageCount) {
+	std::fill(accumulator.begin(), accumulator.end(), 0);
+	numSegments = 0;
+      }
+      accumulate();
+      numSegments++;
+    }
+
+  public:
+
+    virtual const std::string& getName() const {
+      return name;
+    }
+
+    virtual unsigned int getSegmentSize() const {
+      return segmentSize;
+    }
+
+    virtual unsigned int getHopSize() const {
+      return buffer.getHopSize();
+    }
+
+    virtual unsigned int getAverageCount() const {
+      return averageCount;
+    }
+
+    virtual unsigned int getNumBins() const {
+      return segmentSize / 2;
+    }
+
+    virtual unsigned int process(const T* in, unsigned int numSamples) {
+      const unsigned int n = buffer.write(in, numSamples);
+
+      instrument::recordInput("welch", name, in, n);
+
+      if (buffer.isSegmentReady()) {
+	addSegment();
+      }
+
+      return n;
+    }
+
+    virtual unsigned int getNumSegments() const {
+      return numSegments;
+    }
+
+    virtual void getPsd(Span<float> out) const {
+      if (out.size() != getNumBins()) {
+	throw Ex("welch " + name + " psd span size error");
+      }
+      if (numSegments == 0) {
+	throw Ex("welch " + name + " no segments");
+      }
+      for (unsigned int i = 0; i < getNumBins(); i++) {
+	out[i] = toPower(accumulator[i]) / numSegments / buffer.getWindowPower();
+      }
+    }
+
+    virtual void reset() {
+      buffer.reset();
+      std::fill(accumulator.begin(), accumulator.end(), 0);
+      numSegments = 0;
+    }
+  };
+
+  // The arm_rfft_fast_f{32,64} spectrum power, accumulated as T. The
+  // DC bin excludes the Nyquist component packed in with it.
+  template <typename T> class FloatWelch : public CmsisWelch<T> {
+
+    FloatWelch();
+
+  protected:
+
+    virtual void accumulate() {
+      this->spectrum[1] = 0.0;
+      for (unsigned int i = 0; i < this->getNumBins(); i++) {
+	const T re = this->spectrum[2*i];
+	const T im = this->spectrum[2*i + 1];
+	this->accumulator[i] += re * re + im * im;
+      }
+    }
+
+    virtual double toPower(T sum) const {
+      return sum;
+    }
+
+  public:
+
+    FloatWelch(const char* name, const WindowFunction& window, unsigned int overlap, unsigned int averageCount, std::unique_ptr<SpanFft<T>> fft)
+      : CmsisWelch<T>(name, window, overlap, averageCount, std::move(fft))
+    {}
+  };
+
+  // The arm_rfft_q{15,31} spectrum power re^2 + im^2, a Q2.30 (q15) or
+  // Q2.62 (q31) value, accumulated as q63. The q15 power is exact, the
+  // q31 power is shifted down once by the guard bits, it loses the
+  // bits below 2^guardBits LSB of Q2.62.
+  //
+  // The fixed point spectrum is scaled down by the fft length N (see
+  // CmsisFft.cpp), i.e. the real spectrum value is the fixed point
+  // value as a fraction of full scale times N. Therefore the normalized
+  // power is:
+  //
+  // sum * 2^guardBits / 2^(2*(8*sizeof(T)-1)) * N^2
+  template <typename T> class FixedWelch : public CmsisWelch<T> {
+
+    FixedWelch();
+
+    typedef typename CmsisWelch<T>::Accumulator Accumulator;
+
+    const unsigned int guard;
+
+    const double powerScale;
+
+  protected:
+
+    virtual void accumulate() {
+      for (unsigned int i = 0; i < this->getNumBins(); i++) {
+	const q63_t re = this->spectrum[2*i];
+	const q63_t im = this->spectrum[2*i + 1];
+	// unsigned, the q31 power of a -1.0 re and im is 2^63
+	const uint64_t power = (uint64_t)(re * re) + (uint64_t)(im * im);
+	this->accumulator[i] += (q63_t)(power >> guard);
+      }
+    }
+
+    virtual double toPower(Accumulator sum) const {
+      return sum * powerScale;
+    }
+
+  public:
+
+    FixedWelch(const char* name, const WindowFunction& window, unsigned int overlap, unsigned int averageCount, std::unique_ptr<SpanFft<T>> fft)
+      : CmsisWelch<T>(name, window, overlap, averageCount, std::move(fft)),
+	guard(guardBits<T>(averageCount)),
+	powerScale(::pow(2.0, (double)guard - 2.0*(8*sizeof(T) - 1)) * this->segmentSize * this->segmentSize)
+    {}
+  };
+
+} // namespace
+
+std::unique_ptr<Welch<float64_t>> createFloat64Welch(const WindowFunction& window, unsigned int overlap, unsigned int averageCount) {
+  return std::unique_ptr<Welch<float64_t>>(new FloatWelch<float64_t>("f64_welch", window, overlap, averageCount, createFloat64SpanFft(window.getWindow().size())));
+}
+
+std::unique_ptr<Welch<float32_t>> createFloat32Welch(const WindowFunction& window, unsigned int overlap, unsigned int averageCount) {
+  return std::unique_ptr<Welch<float32_t>>(new FloatWelch<float32_t>("f32_welch", window, overlap, averageCount, createFloat32SpanFft(window.getWindow().size())));
+}
+
+std::unique_ptr<Welch<q31_t>> createQ31Welch(const WindowFunction& window, unsigned int overlap, unsigned int averageCount) {
+  return std::unique_ptr<Welch<q31_t>>(new FixedWelch<q31_t>("q31_welch", window, overlap, averageCount, createQ31SpanFft(window.getWindow().size())));
+}
+
+std::unique_ptr<Welch<q15_t>> createQ15Welch(const WindowFunction& window, unsigned int overlap, unsigned int averageCount) {
+  return std::unique_ptr<Welch<q15_t>>(new FixedWelch<q15_t>("q15_welch", window, overlap, averageCount, createQ15SpanFft(window.getWindow().size())));
+}
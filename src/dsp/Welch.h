@@ -0,0 +1,84 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_WELCH_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_WELCH_H_INCLUDED
+
+#include "Span.h"
+
+#include "arm_math.h"
+
+#include <memory>
+#include <string>
+
+class WindowFunction;
+
+/**
+Welch power spectral density estimator, the average of the windowed
+periodograms of overlapping segments.
+
+Input samples of any block size are written to a ring buffer of the
+last segmentSize samples, as the streaming STFT (see Stft.h). Every
+hopSize = segmentSize - overlap samples a segment is windowed and
+transformed with a span fft (see CmsisFft.h), and its power |X[k]|^2
+is added to the accumulator of each bin 0 to segmentSize/2-1. After
+averageCount segments the average is complete, the next segment
+starts a new average.
+
+The fixed point power is computed from the fft spectrum values rather
+than arm_cmplx_mag_squared_q{15,31}, whose Q3.13 output drops the
+noise floor of a q15 fft to zero. Both are accumulated as q63. The q15
+power is summed exactly. The q31 power is shifted down once by
+log2(averageCount) + 1 guard bits so the sum never overflows, which
+truncates each segment's power to a multiple of 2^guardBits LSB of
+Q2.62 (about 2^-57 of full scale for averageCount 16), far below the
+q31 fft rounding noise. The floating point power is accumulated as T.
+
+The PSD is the average power normalized to the floating point fft
+scale and divided by the window power sum(w[n]^2). For white noise of
+variance v, every bin's PSD is v.
+*/
+template <typename T> class Welch {
+ public:
+
+  virtual ~Welch() {}
+
+  // the name of the Welch implementation
+  virtual const std::string& getName() const = 0;
+
+  virtual unsigned int getSegmentSize() const = 0;
+
+  virtual unsigned int getHopSize() const = 0;
+
+  virtual unsigned int getAverageCount() const = 0;
+
+  // The number of PSD bins (segmentSize/2).
+  virtual unsigned int getNumBins() const = 0;
+
+  // Consume input samples until a segment completes, or the input is
+  // exhausted. Returns the number of samples consumed. Call it again
+  // with the rest of the input to continue, the running average is
+  // updated after every segment.
+  virtual unsigned int process(const T* in, unsigned int numSamples) = 0;
+
+  // The number of segments in the running average, 0 to
+  // averageCount.
+  virtual unsigned int getNumSegments() const = 0;
+
+  // Write the running average PSD to out (getNumBins() values). Throws
+  // Ex if the span has the wrong size or there are no segments.
+  virtual void getPsd(Span<float> out) const = 0;
+
+  // Clear the ring buffer and the average.
+  virtual void reset() = 0;
+};
+
+// Create Welch estimators. The window length is the segment size, a
+// supported span fft length (see FftPlan.h). 0 <= overlap <
+// segmentSize and averageCount > 0. Throws Ex if not.
+std::unique_ptr<Welch<float64_t>> createFloat64Welch(const WindowFunction& window, unsigned int overlap, unsigned int averageCount);
+std::unique_ptr<Welch<float32_t>> createFloat32Welch(const WindowFunction& window, unsigned int overlap, unsigned int averageCount);
+std::unique_ptr<Welch<q31_t>> createQ31Welch(const WindowFunction& window, unsigned int overlap, unsigned int averageCount);
+std::unique_ptr<Welch<q15_t>> createQ15Welch(const WindowFunction& window, unsigned int overlap, unsigned int averageCount);
+
+#endif
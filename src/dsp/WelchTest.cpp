@@ -0,0 +1,123 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "WelchTest.h"
+
+#include "Welch.h"
+#include "Ex.h"
+
+#include "Platform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdio.h>
+
+namespace {
+
+  // Bins either side of the tone excluded from the noise floor, the
+  // Hanning window main lobe plus margin.
+  const unsigned int toneWidth = 4;
+
+  struct NoiseFloor {
+    float mean = 0.0;
+
+    // relative standard deviation (%)
+    float spread = 0.0;
+  };
+
+  // The noise floor statistics, excluding DC and the tone.
+  NoiseFloor getNoiseFloor(const std::vector<float>& psd, unsigned int toneBin) {
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    unsigned int count = 0;
+    for (unsigned int i = 1; i < psd.size(); i++) {
+      if (i + toneWidth >= toneBin && i <= toneBin + toneWidth) {
+	continue;
+      }
+      sum += psd[i];
+      sumSquares += (double)psd[i] * psd[i];
+      count++;
+    }
+
+    NoiseFloor floor;
+    floor.mean = sum / count;
+    floor.spread = 100.0 * std::sqrt(std::max(0.0, sumSquares / count - floor.mean * floor.mean)) / floor.mean;
+    return floor;
+  }
+
+  template <typename T> WelchTestResult executeTest(unsigned int expectedBin, float noiseVariance, float tolerance, Welch<T>& welch, const std::vector<T>& waveform, unsigned int blockSize) {
+    welch.reset();
+
+    std::vector<float> psd(welch.getNumBins());
+    float firstSpread = 0.0;
+
+    // untimed pass, verify the running average after every segment
+    unsigned int expectedNumSegments = 0;
+    for (unsigned int n = 0; n < waveform.size(); ) {
+      n += welch.process(waveform.data() + n, std::min(blockSize, (unsigned int)waveform.size() - n));
+      if (welch.getNumSegments() != expectedNumSegments) {
+	expectedNumSegments = expectedNumSegments % welch.getAverageCount() + 1;
+	if (welch.getNumSegments() != expectedNumSegments) {
+	  printf("FAIL %s numSegments != expectedNumSegments (%d != %d)\n", welch.getName().c_str(), welch.getNumSegments(), expectedNumSegments);
+	  throw Fail("numSegments != expectedNumSegments");
+	}
+	welch.getPsd(psd);
+	if (expectedNumSegments == 1 && firstSpread == 0.0) {
+	  firstSpread = getNoiseFloor(psd, expectedBin).spread;
+	}
+      }
+    }
+
+    welch.reset();
+
+    platform::profiling_time_t start = platform::get_profiling_time();
+    for (unsigned int n = 0; n < waveform.size(); ) {
+      n += welch.process(waveform.data() + n, std::min(blockSize, (unsigned int)waveform.size() - n));
+    }
+    platform::profiling_time_t end = platform::get_profiling_time();
+    unsigned long elapsedTime = profiling_time_diff(start,end);
+
+    welch.getPsd(psd);
+
+    unsigned int actualBin = std::distance(psd.cbegin(), std::max_element(psd.cbegin(), psd.cend()));
+    if (actualBin != expectedBin) {
+      printf("FAIL %s actualBin != expectedBin (%d != %d)\n", welch.getName().c_str(), actualBin, expectedBin);
+      throw Fail("welch actualBin != expectedBin");
+    }
+
+    NoiseFloor floor = getNoiseFloor(psd, expectedBin);
+    float noiseError = 100.0 * std::fabs(floor.mean - noiseVariance) / noiseVariance;
+    if (noiseError > tolerance) {
+      printf("FAIL %s noise floor error=%.3f%% (%g vs %g)\n", welch.getName().c_str(), noiseError, floor.mean, noiseVariance);
+      throw Fail("welch noise floor error");
+    }
+
+    if ( !(floor.spread < firstSpread) ) {
+      printf("FAIL %s noise floor spread %.1f%% not below first segment spread %.1f%%\n", welch.getName().c_str(), floor.spread, firstSpread);
+      throw Fail("welch average spread");
+    }
+
+    printf("%s segment %d hop %d, %d segments %lu us, noise error %.2f%%, spread %.1f%% (first %.1f%%)\n",
+	   welch.getName().c_str(), welch.getSegmentSize(), welch.getHopSize(), welch.getNumSegments(), elapsedTime, noiseError, floor.spread, firstSpread);
+
+    return WelchTestResult(welch.getName(), welch.getNumSegments(), elapsedTime, noiseError, firstSpread, floor.spread);
+  }
+
+} // namespace
+
+WelchTestResult executeWelchTest(unsigned int expectedBin, float noiseVariance, float tolerance, Welch<float64_t>& welch, const std::vector<float64_t>& waveform, unsigned int blockSize) {
+  return executeTest(expectedBin, noiseVariance, tolerance, welch, waveform, blockSize);
+}
+
+WelchTestResult executeWelchTest(unsigned int expectedBin, float noiseVariance, float tolerance, Welch<float32_t>& welch, const std::vector<float32_t>& waveform, unsigned int blockSize) {
+  return executeTest(expectedBin, noiseVariance, tolerance, welch, waveform, blockSize);
+}
+
+WelchTestResult executeWelchTest(unsigned int expectedBin, float noiseVariance, float tolerance, Welch<q31_t>& welch, const std::vector<q31_t>& waveform, unsigned int blockSize) {
+  return executeTest(expectedBin, noiseVariance, tolerance, welch, waveform, blockSize);
+}
+
+WelchTestResult executeWelchTest(unsigned int expectedBin, float noiseVariance, float tolerance, Welch<q15_t>& welch, const std::vector<q15_t>& waveform, unsigned int blockSize) {
+  return executeTest(expectedBin, noiseVariance, tolerance, welch, waveform, blockSize);
+}
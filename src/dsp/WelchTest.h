@@ -0,0 +1,50 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_WELCHTEST_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_WELCHTEST_H_INCLUDED
+
+#include "arm_math.h"
+
+#include <string>
+#include <vector>
+
+template <typename T> class Welch;
+
+struct WelchTestResult {
+  const std::string name;
+  const unsigned int numSegments;
+
+  // process() execution time over the whole waveform (us)
+  const unsigned long elapsedTime;
+
+  // the noise floor error, % of the expected noise variance
+  const float noiseError;
+
+  // the noise floor relative standard deviation (%) of the first
+  // segment and of the full average
+  const float firstSpread;
+  const float spread;
+
+  WelchTestResult(const std::string& name, unsigned int numSegments, unsigned long elapsedTime, float noiseError, float firstSpread, float spread)
+    :name(name),
+     numSegments(numSegments),
+     elapsedTime(elapsedTime),
+     noiseError(noiseError),
+     firstSpread(firstSpread),
+     spread(spread)
+  {}
+};
+
+// Profile the estimator processing the waveform, a tone at
+// expectedBin plus white noise of variance noiseVariance, in blockSize
+// sample blocks. Verify the running segment count, that the PSD peak
+// is at expectedBin, that the mean noise floor (away from the tone) is
+// within tolerance (% of noiseVariance), and that averaging reduced the
+// noise floor spread of the first segment. Throws Fail if not.
+WelchTestResult executeWelchTest(unsigned int expectedBin, float noiseVariance, float tolerance, Welch<float64_t>& welch, const std::vector<float64_t>& waveform, unsigned int blockSize);
+WelchTestResult executeWelchTest(unsigned int expectedBin, float noiseVariance, float tolerance, Welch<float32_t>& welch, const std::vector<float32_t>& waveform, unsigned int blockSize);
+WelchTestResult executeWelchTest(unsigned int expectedBin, float noiseVariance, float tolerance, Welch<q31_t>& welch, const std::vector<q31_t>& waveform, unsigned int blockSize);
+WelchTestResult executeWelchTest(unsigned int expectedBin, float noiseVariance, float tolerance, Welch<q15_t>& welch, const std::vector<q15_t>& waveform, unsigned int blockSize);
+
+#endif
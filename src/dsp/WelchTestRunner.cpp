@@ -0,0 +1,107 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "WelchTestRunner.h"
+
+#include "WelchTest.h"
+#include "Welch.h"
+#include "CmsisTypeFactory.h"
+#include "WindowFunction.h"
+#include "Signal.h"
+
+#include <vector>
+
+using namespace welch;
+
+namespace {
+
+  class WelchTestRunner {
+
+    const std::vector<unsigned int> segmentSizes = {256, 1024};
+
+    // 50% overlap
+    const unsigned int overlapDivisor = 2;
+
+    const unsigned int averageCount = 16;
+
+    // Streaming input block size, e.g. an ADC DMA block.
+    const unsigned int streamBlockSize = 64;
+
+    // The test signal is sin(n*M_PI/k), it's centered on bin
+    // segmentSize/(2*k) for all segment sizes.
+    const unsigned int k = 8;
+
+    // The Signal noise is uniform over [-0.25, 0.25].
+    const float noiseVariance = 0.25 * 0.25 / 3.0;
+
+    // The noise floor tolerance, % of the noise variance. The floor is
+    // the mean over all noise bins of the average, its statistical
+    // error is a few percent at these sizes. The q15 fft rounding
+    // noise adds to it.
+    const float floatTolerance = 10.0;
+    const float q31Tolerance = 10.0;
+    const float q15Tolerance = 15.0;
+
+    // The low level pass scales the signal down by 2^lowLevelShift
+    // (24 dB). The q15 noise bins' power is then a few tens of LSB^2,
+    // the fft rounding noise is a larger fraction of it.
+    const unsigned int lowLevelShift = 4;
+    const float lowLevelQ15Tolerance = 20.0;
+
+    std::unique_ptr<Results> results = std::make_unique<Results>();
+
+    void addResult(unsigned int segmentSize, const WelchTestResult& result) {
+      Measurement& measurement = results->measurement[result.name][segmentSize];
+      measurement.numSegments = result.numSegments;
+      measurement.elapsedTime = result.elapsedTime;
+      measurement.noiseError = result.noiseError;
+      measurement.firstSpread = result.firstSpread;
+      measurement.spread = result.spread;
+    }
+
+    template <typename T> void runWelch(unsigned int segmentSize, float tolerance, Welch<T>& welch, const std::vector<T>& waveform) {
+      addResult(segmentSize, executeWelchTest(segmentSize / (2*k), noiseVariance, tolerance, welch, waveform, streamBlockSize));
+    }
+
+    void run(unsigned int segmentSize) {
+      const unsigned int overlap = segmentSize / overlapDivisor;
+
+      // exactly averageCount segments
+      const unsigned int waveformSize = segmentSize + (averageCount - 1) * (segmentSize - overlap);
+
+      printf("\nwelch waveform size %d, segment size %d, overlap %d, average count %d\n", waveformSize, segmentSize, overlap, averageCount);
+
+      auto hanning = createHanningWindow(segmentSize);
+      CmsisTypeFactory signalFactory(std::make_unique<Signal>(waveformSize, (double)k, true));
+
+      runWelch(segmentSize, floatTolerance, *createFloat64Welch(*hanning, overlap, averageCount), *signalFactory.toFloat64());
+      runWelch(segmentSize, floatTolerance, *createFloat32Welch(*hanning, overlap, averageCount), *signalFactory.toFloat32());
+      runWelch(segmentSize, q31Tolerance, *createQ31Welch(*hanning, overlap, averageCount), *signalFactory.toQ31());
+      runWelch(segmentSize, q15Tolerance, *createQ15Welch(*hanning, overlap, averageCount), *signalFactory.toQ15());
+
+      // Verify the fixed point noise floor of a low level signal, it's
+      // lost if the power is truncated before the sum. Not reported.
+      const float lowLevelVariance = noiseVariance / (1u << (2*lowLevelShift));
+      printf("welch low level, signal scaled down by 2^%d\n", lowLevelShift);
+      executeWelchTest(segmentSize / (2*k), lowLevelVariance, q31Tolerance, *createQ31Welch(*hanning, overlap, averageCount), *signalFactory.toQ31(lowLevelShift), streamBlockSize);
+      executeWelchTest(segmentSize / (2*k), lowLevelVariance, lowLevelQ15Tolerance, *createQ15Welch(*hanning, overlap, averageCount), *signalFactory.toQ15(lowLevelShift), streamBlockSize);
+    }
+
+  public:
+
+    std::unique_ptr<Results> runAll() {
+      results->averageCount = averageCount;
+
+      for (unsigned int segmentSize: segmentSizes) {
+	run(segmentSize);
+      }
+
+      return std::move(results);
+    }
+  };
+
+} // namespace
+
+std::unique_ptr<Results> runAllWelchTests() {
+  return WelchTestRunner().runAll();
+}
@@ -0,0 +1,42 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_WELCHTESTRUNNER_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_WELCHTESTRUNNER_H_INCLUDED
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace welch {
+  struct Measurement {
+    unsigned int numSegments;
+
+    // elapsed time in us
+    unsigned long elapsedTime;
+
+    // noise floor error, % of the noise variance
+    float noiseError;
+
+    // noise floor relative standard deviation (%), first segment and
+    // full average
+    float firstSpread;
+    float spread;
+  };
+
+  // map segment size to measurement
+  typedef std::map<unsigned int, Measurement> SegmentSizeToMeasurementMap;
+
+  // map welch name to segment size map
+  typedef std::map<std::string, SegmentSizeToMeasurementMap> NameToSegmentSizeMeasurementMap;
+
+  struct Results {
+    unsigned int averageCount = 0;
+
+    NameToSegmentSizeMeasurementMap measurement;
+  };
+}
+
+std::unique_ptr<welch::Results> runAllWelchTests();
+
+#endif
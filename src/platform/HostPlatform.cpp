@@ -0,0 +1,27 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#include "HostPlatform.h"
+
+#include <stdio.h>
+
+namespace platform {
+
+  void init() {
+    // Line buffer stdout so that benchmark progress is visible when
+    // the output is piped to a file or another process.
+    setvbuf(stdout, NULL, _IOLBF, 0);
+  }
+
+  // timestamp in us (steady_clock is monotonic)
+  profiling_time_t get_profiling_time() {
+    profiling_time_t prof;
+    prof.t = std::chrono::steady_clock::now();
+    return prof;
+  }
+
+  // timestamp delta in us
+  unsigned long profiling_time_diff(const profiling_time_t& start, const profiling_time_t& end) {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(end.t - start.t).count();
+  }
+}
@@ -0,0 +1,24 @@
+//  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
+//  SPDX-License-Identifier: Apache-2.0
+
+#ifndef PICO_CMSIS_SANDBOX_HOSTPLATFORM_H_INCLUDED
+#define PICO_CMSIS_SANDBOX_HOSTPLATFORM_H_INCLUDED
+
+#include <chrono>
+
+namespace platform {
+  struct profiling_time_t {
+    std::chrono::steady_clock::time_point t;
+  };
+
+  // platform dependent init
+  void init();
+
+  // timestamp in us
+  profiling_time_t get_profiling_time();
+
+  // timestamp delta in us
+  unsigned long profiling_time_diff(const profiling_time_t& start, const profiling_time_t& end); 
+}
+
+#endif
@@ -1,9 +1,14 @@
 //  SPDX-FileCopyrightText: 2024 Jim Trainor <https://github.com/jptrainor/cmsis-sandbox/issues>
 //  SPDX-License-Identifier: Apache-2.0
 
-#if  SANDBOX_PLATFORM == RP2040
+// Values of the SANDBOX_PLATFORM compile definition.
+#define SANDBOX_PLATFORM_RP2040 1
+#define SANDBOX_PLATFORM_HOST 2
+
+#if SANDBOX_PLATFORM == SANDBOX_PLATFORM_RP2040
 #include "PicoPlatform.h"
+#elif SANDBOX_PLATFORM == SANDBOX_PLATFORM_HOST
+#include "HostPlatform.h"
+#else
+#error "SANDBOX_PLATFORM must be SANDBOX_PLATFORM_RP2040 or SANDBOX_PLATFORM_HOST"
 #endif
-
-
-